@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+"""
+Carbon Trading Telemetry
+Loads what a run measured for the dashboards: the windowed flow metrics
+(<name>-metrics.csv) and the per-flow totals (<name>-flows.csv) that both
+scenarios write with --tracing=metrics or above. See
+scenarios/flow-metrics-collector.h for the columns.
+
+Three sources, all feeding the same WindowSeries:
+- a finished run: read both files
+- a running one: follow the metrics file as windows are appended to it, until
+  the run writes its flows file
+- a streamed one: listen for the rows a run sends with --telemetryPort (see
+  scenarios/telemetry-stream.h)
+
+add_arguments() and run() give both visualizers the same command line and
+redraw loop, and the plot_* helpers the panels they share.
+"""
+
+import csv
+import os
+import socket
+import time
+
+import matplotlib.pyplot as plt
+
+METRIC_COLUMNS = ['windowEnd', 'zone', 'readingsSent', 'readingsReceived', 'bytesReceived',
+                  'throughputKbps', 'co2MeanPpm', 'latencyMeanMs', 'latencyP50Ms',
+                  'latencyP99Ms', 'latencyMaxMs']
+FLOW_COLUMNS = ['sensorId', 'zone', 'readingsSent', 'readingsReceived', 'bytesReceived',
+                'throughputKbps', 'meanLatencyMs', 'co2MeanPpm', 'co2MinPpm', 'co2MaxPpm']
+
+MAX_SENSOR_BARS = 40  # Larger fleets get a histogram of the sensor means
+
+
+def parse_row(fields, columns):
+    """Map one CSV row to its columns: ints and floats converted, empty fields None"""
+    if len(fields) != len(columns):
+        return None
+    row = {}
+    for column, field in zip(columns, fields):
+        if field == '':
+            row[column] = None
+        elif field == 'all':
+            row[column] = field
+        else:
+            try:
+                row[column] = int(field)
+            except ValueError:
+                try:
+                    row[column] = float(field)
+                except ValueError:
+                    return None
+    return row
+
+
+class WindowSeries:
+    """Window rows of a run: the site-wide series, and running totals per zone"""
+
+    def __init__(self):
+        self.time = []
+        self.sent = []
+        self.received = []
+        self.throughput_kbps = []
+        self.co2_ppm = []
+        self.latency_p50_ms = []
+        self.latency_p99_ms = []
+        self.latency_max_ms = []
+        self.delivery_ratio = []  # Cumulative, in percent
+        self.zones = {}  # zone -> {'sent', 'received', 'co2Sum'}
+        self._sent_total = 0
+        self._received_total = 0
+
+    def add(self, row):
+        if row['zone'] != 'all':
+            zone = self.zones.setdefault(row['zone'], {'sent': 0, 'received': 0, 'co2Sum': 0.0})
+            zone['sent'] += row['readingsSent']
+            zone['received'] += row['readingsReceived']
+            if row['co2MeanPpm'] is not None:
+                zone['co2Sum'] += row['co2MeanPpm'] * row['readingsReceived']
+            return
+        self._sent_total += row['readingsSent']
+        self._received_total += row['readingsReceived']
+        self.time.append(row['windowEnd'])
+        self.sent.append(row['readingsSent'])
+        self.received.append(row['readingsReceived'])
+        self.throughput_kbps.append(row['throughputKbps'])
+        self.co2_ppm.append(row['co2MeanPpm'])
+        self.latency_p50_ms.append(row['latencyP50Ms'])
+        self.latency_p99_ms.append(row['latencyP99Ms'])
+        self.latency_max_ms.append(row['latencyMaxMs'])
+        self.delivery_ratio.append(100.0 * self._received_total / self._sent_total
+                                   if self._sent_total else None)
+
+    def add_line(self, line):
+        """Add one CSV row of text; headers and malformed rows are skipped"""
+        row = parse_row(line.strip().split(','), METRIC_COLUMNS)
+        if row is not None and row['zone'] is not None:
+            self.add(row)
+
+    @property
+    def readings_sent(self):
+        return self._sent_total
+
+    @property
+    def readings_received(self):
+        return self._received_total
+
+    def zone_co2(self):
+        """Mean CO2 of every zone with receptions, by zone"""
+        return {zone: z['co2Sum'] / z['received']
+                for zone, z in sorted(self.zones.items()) if z['received']}
+
+
+def read_metrics(path, series):
+    """Read a whole metrics file into series"""
+    with open(path) as f:
+        for line in f:
+            series.add_line(line)
+    return series
+
+
+def read_flows(path):
+    """Per-flow rows of a flows file, or [] if the run has not written it"""
+    if not os.path.exists(path):
+        return []
+    with open(path, newline='') as f:
+        reader = csv.reader(f)
+        next(reader, None)
+        return [row for row in (parse_row(fields, FLOW_COLUMNS) for fields in reader) if row]
+
+
+def follow_metrics(path, series, done_path=None, poll=0.5):
+    """
+    Add the rows of a metrics file as a run appends them, yielding after each
+    batch. Waits for the file to appear; stops once done_path is written after
+    the start (the flows file, written when the run is over).
+    """
+    start = time.time()
+    while not os.path.exists(path):
+        time.sleep(poll)
+        yield series
+    with open(path) as f:
+        pending = ''
+        while True:
+            chunk = f.read()
+            if chunk:
+                pending += chunk
+                lines = pending.split('\n')
+                pending = lines.pop()  # Partial last row, completed by a later read
+                for line in lines:
+                    series.add_line(line)
+                yield series
+            elif done_path and os.path.exists(done_path) and \
+                    os.path.getmtime(done_path) >= start:
+                return
+            else:
+                time.sleep(poll)
+
+
+def listen_metrics(port, series, host='127.0.0.1', poll=0.5):
+    """
+    Add the rows streamed to host:port, yielding after each datagram and at
+    least every poll seconds, so a dashboard can redraw while the run is quiet
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((host, port))
+    sock.settimeout(poll)
+    try:
+        while True:
+            try:
+                data = sock.recv(65535)
+            except socket.timeout:
+                yield series
+                continue
+            for line in data.decode('ascii', errors='replace').splitlines():
+                series.add_line(line)
+            yield series
+    finally:
+        sock.close()
+
+
+def add_arguments(parser, name):
+    """Add the source options; name is the scenario's file prefix, e.g. hierarchical"""
+    parser.add_argument('--prefix', default=name,
+                        help=f"Path of the run files without -metrics.csv (default {name}, "
+                             "i.e. the ns-3 root files with the default --outputPrefix)")
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument('--follow', action='store_true',
+                        help='Redraw as the run appends windows, until it writes its flows file')
+    source.add_argument('--listen', type=int, metavar='PORT',
+                        help='Redraw from the rows a run streams with --telemetryPort=PORT')
+    parser.add_argument('--host', default='127.0.0.1', help='Address to listen on')
+    parser.add_argument('--refresh', type=float, default=2.0,
+                        help='Seconds between redraws when following or listening')
+    parser.add_argument('--output', help='Image file to save the final dashboard to')
+    parser.add_argument('--no-show', action='store_true', help='Do not open a window')
+
+
+def run(args, draw):
+    """
+    Load or follow the run named by args and hand it to draw(series, flows,
+    final) whenever there is something new; the final call gets the flows,
+    which only exist once the run is over. Following and listening end on
+    Ctrl-C, following also when the run completes.
+    """
+    metrics_path = f"{args.prefix}-metrics.csv"
+    flows_path = f"{args.prefix}-flows.csv"
+    series = WindowSeries()
+    if not args.follow and args.listen is None:
+        if not os.path.exists(metrics_path):
+            raise SystemExit(f"{metrics_path} not found: run the scenario with "
+                             "--tracing=metrics (or above) first, or pass --prefix")
+        draw(read_metrics(metrics_path, series), read_flows(flows_path), True)
+        return series
+    if args.follow:
+        source = follow_metrics(metrics_path, series, done_path=flows_path)
+    else:
+        source = listen_metrics(args.listen, series, host=args.host)
+    last = 0.0
+    try:
+        for series in source:
+            if time.time() - last >= args.refresh:
+                draw(series, [], False)
+                last = time.time()
+    except KeyboardInterrupt:
+        pass
+    draw(series, read_flows(flows_path) if args.follow else [], True)
+    return series
+
+
+def plot_sensors(ax, flows):
+    """Mean CO2 per sensor, coloured by zone, with the min-max range"""
+    flows = [f for f in flows if f['co2MeanPpm'] is not None]
+    ax.set_title('CO2 by Sensor', fontweight='bold', fontsize=12)
+    if not flows:
+        ax.text(0.5, 0.5, 'Per-sensor CO2 is written\nwhen the run ends', ha='center',
+                va='center', transform=ax.transAxes)
+        return
+    means = [f['co2MeanPpm'] for f in flows]
+    if len(flows) > MAX_SENSOR_BARS:
+        ax.hist(means, bins=50, color='#45B7D1', edgecolor='black', alpha=0.8)
+        ax.set_xlabel('Mean CO2 (ppm)', fontweight='bold', fontsize=11)
+        ax.set_ylabel('Sensors', fontweight='bold', fontsize=11)
+        ax.set_title(f'CO2 by Sensor ({len(flows)} sensors)', fontweight='bold', fontsize=12)
+        return
+    zones = sorted({f['zone'] for f in flows})
+    zone_color = {zone: plt.cm.tab10(i % 10) for i, zone in enumerate(zones)}
+    errors = [[f['co2MeanPpm'] - f['co2MinPpm'] for f in flows],
+              [f['co2MaxPpm'] - f['co2MeanPpm'] for f in flows]]
+    ax.bar(range(len(flows)), means, yerr=errors, capsize=2,
+           color=[zone_color[f['zone']] for f in flows], alpha=0.8, edgecolor='black')
+    ax.set_xticks(range(len(flows)))
+    ax.set_xticklabels([f"S{f['sensorId']}\n(Z{f['zone']})" for f in flows], fontsize=7)
+    ax.set_ylabel('Mean CO2 (ppm), min-max', fontweight='bold', fontsize=11)
+    ax.axhline(y=400, color='green', linestyle='--', linewidth=1.5, alpha=0.5)
+    ax.grid(axis='y', alpha=0.3)
+
+
+def plot_zones(ax, zones, values, title, ylabel, color):
+    ax.set_title(title, fontweight='bold', fontsize=12)
+    ax.bar([str(z) for z in zones], values, color=color, alpha=0.7, edgecolor='black')
+    ax.set_xlabel('Zone', fontweight='bold', fontsize=11)
+    ax.set_ylabel(ylabel, fontweight='bold', fontsize=11)
+    if len(zones) > 20:
+        ax.set_xticks([])
+    ax.grid(axis='y', alpha=0.3)
+
+
+def plot_series(ax, series, lines, title, ylabel):
+    ax.set_title(title, fontweight='bold', fontsize=12)
+    for values, label in lines:
+        points = [(t, v) for t, v in zip(series.time, values) if v is not None]
+        if points:
+            ax.plot(*zip(*points), label=label)
+    ax.set_xlabel('Simulation time (s)', fontweight='bold', fontsize=11)
+    ax.set_ylabel(ylabel, fontweight='bold', fontsize=11)
+    if len(lines) > 1:
+        ax.legend()
+    ax.grid(alpha=0.3)
@@ -0,0 +1,239 @@
+/*
+ * Allocation Counter
+ *
+ * Counts heap allocations on the per-reading paths, to check that a reading
+ * costs no allocation beyond its ns-3 Packet. It is compiled in only with
+ * -DCARBON_ALLOC_COUNTER (CXXFLAGS="-DCARBON_ALLOC_COUNTER" ./ns3 configure):
+ * the scenario then replaces the global operator new and delete, so every
+ * allocation of the process is counted, the ns-3 libraries' included. The
+ * replacement is defined in this header because each scenario is a single
+ * translation unit, so it exists exactly once per program. Without the flag
+ * nothing is replaced and AllocScope is an empty object.
+ *
+ * An AllocScope charges the allocations made during its lifetime to a
+ * section, one call per scope:
+ * - ALLOC_SENSOR_ENCODE: a sensor building the datagram of one unbatched
+ *   reading (text or binary payload, and its Packet), before it is sent
+ * - ALLOC_GATEWAY_DECODE: a gateway decoding one unbatched reading from its
+ *   datagram, before it is recorded
+ *
+ * The floor of ALLOC_SENSOR_ENCODE is ns-3's own: the Packet object and,
+ * when the Buffer free list has none to hand out, its data. Decoding works
+ * on the received Packet and a stack copy, so ALLOC_GATEWAY_DECODE should
+ * stay at 0. Counts are those of the local process (rank 0 in distributed
+ * runs).
+ */
+
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include "run-summary.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * Code paths charged by an AllocScope
+ */
+enum AllocSection
+{
+    ALLOC_SENSOR_ENCODE,
+    ALLOC_GATEWAY_DECODE,
+    ALLOC_SECTION_COUNT
+};
+
+#ifdef CARBON_ALLOC_COUNTER
+
+/** Heap allocations of the process so far */
+inline std::atomic<uint64_t> g_allocationCount{0};
+
+/**
+ * Calls of the sections and the allocations charged to them
+ */
+class AllocCounter
+{
+  public:
+    /**
+     * Charge allocations to a section
+     * @param section Section that made them
+     * @param allocations Allocations of one call
+     */
+    static void Charge(AllocSection section, uint64_t allocations)
+    {
+        GetSection(section).calls++;
+        GetSection(section).allocations += allocations;
+    }
+
+    /**
+     * Print the allocations of each section
+     * @param os Output stream
+     */
+    static void Print(std::ostream& os)
+    {
+        os << "  Process allocations: " << g_allocationCount.load(std::memory_order_relaxed)
+           << "\n";
+        for (uint32_t s = 0; s < ALLOC_SECTION_COUNT; ++s)
+        {
+            const Section& section = GetSection(static_cast<AllocSection>(s));
+            os << "  " << GetLabel(static_cast<AllocSection>(s)) << ": " << std::fixed
+               << std::setprecision(2) << GetPerCall(section) << " per call (" << section.calls
+               << " calls)\n";
+        }
+    }
+
+    /**
+     * Add the per-section metrics to a run summary
+     * @param summary Run summary
+     */
+    static void AddMetrics(RunSummary& summary)
+    {
+        summary.AddMetric("processAllocations",
+                          g_allocationCount.load(std::memory_order_relaxed));
+        for (uint32_t s = 0; s < ALLOC_SECTION_COUNT; ++s)
+        {
+            AllocSection id = static_cast<AllocSection>(s);
+            const Section& section = GetSection(id);
+            summary.AddMetric(std::string(GetKey(id)) + "Calls", section.calls);
+            summary.AddMetric(std::string(GetKey(id)) + "AllocsPerCall", GetPerCall(section));
+        }
+    }
+
+  private:
+    struct Section
+    {
+        uint64_t calls = 0;
+        uint64_t allocations = 0;
+    };
+
+    static Section& GetSection(AllocSection section)
+    {
+        static Section sections[ALLOC_SECTION_COUNT];
+        return sections[section];
+    }
+
+    static double GetPerCall(const Section& section)
+    {
+        return section.calls ? static_cast<double>(section.allocations) / section.calls : 0.0;
+    }
+
+    static const char* GetLabel(AllocSection section)
+    {
+        return section == ALLOC_SENSOR_ENCODE ? "Sensor encode" : "Gateway decode";
+    }
+
+    static const char* GetKey(AllocSection section)
+    {
+        return section == ALLOC_SENSOR_ENCODE ? "sensorEncode" : "gatewayDecode";
+    }
+};
+
+/**
+ * Charges the allocations made during its lifetime to a section
+ */
+class AllocScope
+{
+  public:
+    /**
+     * @param section Section to charge
+     */
+    explicit AllocScope(AllocSection section)
+        : m_section(section),
+          m_start(g_allocationCount.load(std::memory_order_relaxed))
+    {
+    }
+
+    ~AllocScope()
+    {
+        AllocCounter::Charge(m_section,
+                             g_allocationCount.load(std::memory_order_relaxed) - m_start);
+    }
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+  private:
+    AllocSection m_section;
+    uint64_t m_start;
+};
+
+#else
+
+/**
+ * Without CARBON_ALLOC_COUNTER a scope compiles to nothing
+ */
+class AllocScope
+{
+  public:
+    explicit AllocScope(AllocSection)
+    {
+    }
+};
+
+#endif /* CARBON_ALLOC_COUNTER */
+
+} // namespace ns3
+
+#ifdef CARBON_ALLOC_COUNTER
+
+// The array, nothrow and sized forms forward to these by default
+
+void*
+operator new(std::size_t size)
+{
+    ns3::g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+    ns3::g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc needs a non-zero multiple of the alignment
+    std::size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void* p = std::aligned_alloc(align, rounded))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+#endif /* CARBON_ALLOC_COUNTER */
+
+#endif /* ALLOC_COUNTER_H */
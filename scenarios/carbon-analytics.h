@@ -0,0 +1,513 @@
+/*
+ * Carbon Analytics
+ *
+ * Incremental analytics stage of the gateway, run inline on every recorded
+ * reading like the ingest path of the real platform:
+ *
+ * - Anomaly flags: each sensor keeps an exponentially weighted mean and
+ *   variance of its readings (--ewmaAlpha). Once it has seen 1/alpha
+ *   readings, a reading more than --anomalySigma deviations away from the
+ *   mean is anomalous, and so is any reading above --anomalyPpm (0 = no
+ *   absolute limit). The baseline keeps adapting, so a lasting level shift
+ *   is flagged until the mean catches up. A sensor going from normal to
+ *   anomalous counts as an onset and is logged through the
+ *   "CarbonAnalytics" log component.
+ * - Tumbling windows: readings add up per sensor for --analyticsWindowS of
+ *   simulated time. At each window boundary the per-sensor sums are rolled
+ *   up into zone and company totals against the --creditCapPpm cap:
+ *   balance = cap * readings - sum of readings (positive = credits earned,
+ *   negative = debits), excess = ppm above the cap. The closing pass runs
+ *   over dense per-sensor arrays (one array per field), so the balance
+ *   loop is branch-free and vectorizes; only the scatter into the zone and
+ *   company tables is scalar.
+ *
+ * Every closed window appends one row per site, zone and company with
+ * readings to a CSV file:
+ *
+ *   windowEnd,scope,id,readings,meanPpm,excessPpm,balancePpm,anomalies
+ *
+ * (scope site has id 0, and zone 0 is the single-tier network). Per-reading
+ * work is O(1); reading and closing are timed on the wall clock, and
+ * --analyticsCostUs models the CPU time per reading of the real platform.
+ * That cost delays the readings: with ingest workers it is added to every
+ * reading's service time, otherwise each gateway runs its readings one
+ * after the other on an AnalyticsCore, and a reading's latency ends when
+ * its analytics are done. Past one core's worth of load the backlog, and
+ * the latency, grow without bound.
+ */
+
+#ifndef CARBON_ANALYTICS_H
+#define CARBON_ANALYTICS_H
+
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+static LogComponent g_carbonAnalyticsLog("CarbonAnalytics", __FILE__);
+
+/**
+ * Settings of the analytics stage
+ */
+struct AnalyticsConfig
+{
+    Time window = Seconds(60);       // Tumbling window length
+    double ewmaAlpha = 0.1;          // Weight of the newest reading in the EWMA
+    double anomalySigma = 4.0;       // Deviations from the EWMA mean that flag a reading
+    double anomalyPpm = 0.0;         // Absolute limit (0 = none)
+    double creditCapPpm = 1000.0;    // Emission cap of the credit balance
+    Time costPerReading = Seconds(0); // Modeled CPU time per reading
+};
+
+/**
+ * Modeled analytics CPU of one gateway without ingest workers
+ */
+struct AnalyticsCore
+{
+    Time busyUntil; // End of the last reading handed to the core
+
+    /**
+     * Run one reading after those already queued on the core
+     * @param ready When the reading is decoded and can start
+     * @param cost CPU time of the reading
+     * @return When its analytics are done
+     */
+    Time Run(Time ready, Time cost)
+    {
+        busyUntil = std::max(busyUntil, ready) + cost;
+        return busyUntil;
+    }
+};
+
+class CarbonAnalytics : public SimpleRefCount<CarbonAnalytics>
+{
+  public:
+    /**
+     * Open the window file (aborts if it cannot be created)
+     * @param path Window rollup file
+     * @param config Window, detector and cap settings
+     */
+    CarbonAnalytics(const std::string& path, const AnalyticsConfig& config)
+        : NS_LOG_TEMPLATE_DEFINE("CarbonAnalytics"),
+          m_path(path),
+          m_config(config),
+          m_sigma2(config.anomalySigma * config.anomalySigma),
+          m_warmup(static_cast<uint32_t>(std::ceil(1.0 / config.ewmaAlpha))),
+          m_readings(0),
+          m_rejected(0),
+          m_anomalies(0),
+          m_onsets(0),
+          m_windowsClosed(0),
+          m_recordWallSeconds(0.0),
+          m_closeWallSeconds(0.0)
+    {
+        NS_ABORT_MSG_IF(!config.window.IsStrictlyPositive(), "The analytics window must be positive");
+        NS_ABORT_MSG_IF(config.ewmaAlpha <= 0 || config.ewmaAlpha > 1, "ewmaAlpha must be in (0, 1]");
+        NS_ABORT_MSG_IF(config.anomalySigma <= 0, "anomalySigma must be positive");
+        m_file = std::fopen(path.c_str(), "w");
+        NS_ABORT_MSG_IF(!m_file, "Cannot create analytics file " << path);
+        std::fprintf(m_file, "windowEnd,scope,id,readings,meanPpm,excessPpm,balancePpm,anomalies\n");
+    }
+
+    ~CarbonAnalytics()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+        }
+    }
+
+    CarbonAnalytics(const CarbonAnalytics&) = delete;
+    CarbonAnalytics& operator=(const CarbonAnalytics&) = delete;
+
+    /**
+     * Preallocate the tables so that no reallocation happens during the run
+     * @param nSensors Highest expected sensor ID
+     * @param nZones Highest expected zone ID
+     * @param nCompanies Highest expected company ID
+     */
+    void Reserve(uint32_t nSensors, uint32_t nZones, uint32_t nCompanies)
+    {
+        GrowSensors(nSensors);
+        GrowTable(m_zones, nZones);
+        GrowTable(m_companies, nCompanies);
+    }
+
+    /**
+     * Schedule the first window boundary
+     * @param at Start of the first window
+     */
+    void Start(Time at)
+    {
+        m_windowEnd = at + m_config.window;
+        m_closeEvent = Simulator::Schedule(m_windowEnd - Simulator::Now(),
+                                           &CarbonAnalytics::CloseWindow,
+                                           this);
+    }
+
+    /**
+     * Run one reading through the detector and the open window; readings with
+     * an ID beyond the reserved tables are counted as rejected and ignored
+     * @param sensorId Sensor ID
+     * @param zoneId Zone ID (0 if none)
+     * @param companyId Company ID (0 if none)
+     * @param co2Value CO2 level in ppm
+     */
+    void Record(uint32_t sensorId, uint32_t zoneId, uint32_t companyId, double co2Value)
+    {
+        // IDs come off the wire: only Reserve() sizes the tables
+        if (sensorId >= m_ewmaMean.size() || zoneId >= m_zones.size() ||
+            companyId >= m_companies.size())
+        {
+            m_rejected++;
+            return;
+        }
+        Clock::time_point begin = Clock::now();
+        m_sensorZone[sensorId] = zoneId;
+        m_sensorCompany[sensorId] = companyId;
+
+        // EWMA mean and variance (West 1979); the variance has a 1 ppm^2 floor so
+        // that a perfectly flat series does not flag every rounding step
+        double mean = m_ewmaMean[sensorId];
+        double variance = m_ewmaVariance[sensorId];
+        double diff = co2Value - mean;
+        bool anomalous = (m_config.anomalyPpm > 0 && co2Value > m_config.anomalyPpm) ||
+                         (m_seen[sensorId] >= m_warmup &&
+                          diff * diff > m_sigma2 * std::max(variance, 1.0));
+        if (m_seen[sensorId] == 0)
+        {
+            m_ewmaMean[sensorId] = co2Value;
+        }
+        else
+        {
+            double increment = m_config.ewmaAlpha * diff;
+            m_ewmaMean[sensorId] = mean + increment;
+            m_ewmaVariance[sensorId] = (1.0 - m_config.ewmaAlpha) * (variance + diff * increment);
+        }
+        m_seen[sensorId]++;
+
+        if (anomalous)
+        {
+            m_anomalies++;
+            m_windowAnomalies[sensorId] += 1.0;
+            if (!m_flagged[sensorId])
+            {
+                m_onsets++;
+                NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: Sensor " << sensorId
+                                    << " anomalous at " << co2Value << " ppm (EWMA " << mean
+                                    << " ppm)");
+            }
+        }
+        m_flagged[sensorId] = anomalous;
+
+        m_windowSum[sensorId] += co2Value;
+        m_windowExcess[sensorId] += std::max(co2Value - m_config.creditCapPpm, 0.0);
+        m_windowCount[sensorId] += 1.0;
+        m_readings++;
+        m_recordWallSeconds += std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    /**
+     * Close the partial last window (call once the run is over) and the file
+     */
+    void Close(void)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        Simulator::Cancel(m_closeEvent);
+        if (Simulator::Now() > m_windowEnd - m_config.window)
+        {
+            // Stamped with the time it was closed
+            Roll(Simulator::Now());
+        }
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    /** @return Window rollup file */
+    const std::string& GetPath(void) const
+    {
+        return m_path;
+    }
+
+    /** @return Windows closed so far */
+    uint64_t GetWindowsClosed(void) const
+    {
+        return m_windowsClosed;
+    }
+
+    /** @return Readings flagged as anomalous */
+    uint64_t GetAnomalies(void) const
+    {
+        return m_anomalies;
+    }
+
+    /** @return Transitions of a sensor from normal to anomalous */
+    uint64_t GetOnsets(void) const
+    {
+        return m_onsets;
+    }
+
+    /** @return Wall-clock time per recorded reading, in nanoseconds */
+    double GetRecordNsPerReading(void) const
+    {
+        return m_readings > 0 ? m_recordWallSeconds * 1e9 / m_readings : 0.0;
+    }
+
+    /** @return Wall-clock time per window close, in microseconds */
+    double GetCloseUsPerWindow(void) const
+    {
+        return m_windowsClosed > 0 ? m_closeWallSeconds * 1e6 / m_windowsClosed : 0.0;
+    }
+
+    /** @return Modeled CPU time of one reading */
+    Time GetCostPerReading(void) const
+    {
+        return m_config.costPerReading;
+    }
+
+    /** @return Modeled CPU time of every reading so far */
+    Time GetModeledCost(void) const
+    {
+        return m_config.costPerReading * static_cast<int64_t>(m_readings);
+    }
+
+    /**
+     * Print the detector counters, the credit balance of each company and the cost
+     * @param os Output stream
+     * @param period Time the gateway was receiving (for the modeled CPU load)
+     */
+    void Print(std::ostream& os, Time period) const
+    {
+        os << "  Windows closed: " << m_windowsClosed << " (" << m_config.window.GetSeconds()
+           << " s each)\n";
+        os << "  Anomalous readings: " << m_anomalies << " of " << m_readings << " (" << m_onsets
+           << " onsets)\n";
+        if (m_rejected > 0)
+        {
+            os << "  Rejected readings: " << m_rejected << " (ID beyond the reserved tables)\n";
+        }
+        for (uint32_t id = 1; id < m_companies.size(); ++id)
+        {
+            if (m_companies[id].runReadings > 0)
+            {
+                os << "  Company " << id << " balance: " << m_companies[id].runBalance
+                   << " ppm-readings under the " << m_config.creditCapPpm << " ppm cap\n";
+            }
+        }
+        os << "  Cost: " << GetRecordNsPerReading() << " ns/reading, " << GetCloseUsPerWindow()
+           << " us/window close (wall)";
+        if (m_config.costPerReading.IsStrictlyPositive())
+        {
+            os << ", modeled load " << GetModeledLoad(period) * 100.0 << "% of one core";
+        }
+        os << "\n";
+    }
+
+    /**
+     * Add the analytics metrics to a run summary, with company<N>CreditBalance for
+     * every company with readings
+     * @param summary Summary of this run
+     * @param period Time the gateway was receiving (for the modeled CPU load)
+     */
+    void AddMetrics(RunSummary& summary, Time period) const
+    {
+        summary.AddMetric("analyticsWindows", m_windowsClosed);
+        summary.AddMetric("anomalousReadings", m_anomalies);
+        summary.AddMetric("anomalyOnsets", m_onsets);
+        summary.AddMetric("analyticsRejectedReadings", m_rejected);
+        summary.AddMetric("analyticsNsPerReading", GetRecordNsPerReading());
+        summary.AddMetric("analyticsCloseUs", GetCloseUsPerWindow());
+        summary.AddMetric("analyticsModeledSeconds", GetModeledCost().GetSeconds());
+        summary.AddMetric("analyticsModeledLoad", GetModeledLoad(period));
+        for (uint32_t id = 1; id < m_companies.size(); ++id)
+        {
+            if (m_companies[id].runReadings > 0)
+            {
+                summary.AddMetric("company" + std::to_string(id) + "CreditBalance",
+                                  m_companies[id].runBalance);
+            }
+        }
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    /** Window and run totals of a zone or company */
+    struct Rollup
+    {
+        double readings = 0.0;
+        double sum = 0.0;
+        double excess = 0.0;
+        double balance = 0.0;
+        double anomalies = 0.0;
+        uint64_t runReadings = 0;
+        double runBalance = 0.0;
+    };
+
+    void GrowSensors(uint32_t id)
+    {
+        size_t size = std::max<size_t>(m_ewmaMean.size(), id + 1);
+        m_ewmaMean.resize(size, 0.0);
+        m_ewmaVariance.resize(size, 0.0);
+        m_seen.resize(size, 0);
+        m_flagged.resize(size, 0);
+        m_sensorZone.resize(size, 0);
+        m_sensorCompany.resize(size, 0);
+        m_windowSum.resize(size, 0.0);
+        m_windowExcess.resize(size, 0.0);
+        m_windowCount.resize(size, 0.0);
+        m_windowAnomalies.resize(size, 0.0);
+        m_balance.resize(size, 0.0);
+    }
+
+    static void GrowTable(std::vector<Rollup>& table, uint32_t id)
+    {
+        if (id >= table.size())
+        {
+            table.resize(id + 1);
+        }
+    }
+
+    void CloseWindow(void)
+    {
+        Roll(m_windowEnd);
+        m_windowEnd += m_config.window;
+        m_closeEvent = Simulator::Schedule(m_config.window, &CarbonAnalytics::CloseWindow, this);
+    }
+
+    /** Roll the open window up into the zone and company tables, write it and reset it */
+    void Roll(Time end)
+    {
+        Clock::time_point begin = Clock::now();
+        size_t n = m_windowSum.size();
+        double cap = m_config.creditCapPpm;
+        const double* sum = m_windowSum.data();
+        const double* count = m_windowCount.data();
+        double* balance = m_balance.data();
+        for (size_t i = 0; i < n; ++i)
+        {
+            balance[i] = cap * count[i] - sum[i];
+        }
+
+        Rollup site;
+        for (size_t i = 0; i < n; ++i)
+        {
+            Rollup& zone = m_zones[m_sensorZone[i]];
+            Rollup& company = m_companies[m_sensorCompany[i]];
+            Add(zone, i);
+            Add(company, i);
+            Add(site, i);
+        }
+
+        double t = end.GetSeconds();
+        WriteRow(t, "site", 0, site);
+        WriteTable(t, "zone", m_zones);
+        WriteTable(t, "company", m_companies);
+
+        std::fill(m_windowSum.begin(), m_windowSum.end(), 0.0);
+        std::fill(m_windowExcess.begin(), m_windowExcess.end(), 0.0);
+        std::fill(m_windowCount.begin(), m_windowCount.end(), 0.0);
+        std::fill(m_windowAnomalies.begin(), m_windowAnomalies.end(), 0.0);
+        m_windowsClosed++;
+        m_closeWallSeconds += std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    void Add(Rollup& rollup, size_t sensor) const
+    {
+        rollup.readings += m_windowCount[sensor];
+        rollup.sum += m_windowSum[sensor];
+        rollup.excess += m_windowExcess[sensor];
+        rollup.balance += m_balance[sensor];
+        rollup.anomalies += m_windowAnomalies[sensor];
+    }
+
+    void WriteTable(double time, const char* scope, std::vector<Rollup>& table)
+    {
+        for (uint32_t id = 0; id < table.size(); ++id)
+        {
+            Rollup& rollup = table[id];
+            if (rollup.readings > 0)
+            {
+                WriteRow(time, scope, id, rollup);
+                rollup.runReadings += static_cast<uint64_t>(rollup.readings);
+                rollup.runBalance += rollup.balance;
+            }
+            uint64_t runReadings = rollup.runReadings;
+            double runBalance = rollup.runBalance;
+            rollup = Rollup();
+            rollup.runReadings = runReadings;
+            rollup.runBalance = runBalance;
+        }
+    }
+
+    void WriteRow(double time, const char* scope, uint32_t id, const Rollup& rollup)
+    {
+        std::fprintf(m_file,
+                     "%.3f,%s,%u,%.0f,%.3f,%.3f,%.3f,%.0f\n",
+                     time,
+                     scope,
+                     id,
+                     rollup.readings,
+                     rollup.readings > 0 ? rollup.sum / rollup.readings : 0.0,
+                     rollup.excess,
+                     rollup.balance,
+                     rollup.anomalies);
+    }
+
+    double GetModeledLoad(Time period) const
+    {
+        return period.IsStrictlyPositive() ? GetModeledCost().GetSeconds() / period.GetSeconds()
+                                           : 0.0;
+    }
+
+    NS_LOG_TEMPLATE_DECLARE; // Header-only class: log through g_carbonAnalyticsLog
+
+    std::string m_path;
+    std::FILE* m_file;
+    AnalyticsConfig m_config;
+    double m_sigma2;   // anomalySigma squared
+    uint32_t m_warmup; // Readings before a sensor's deviations are judged
+    Time m_windowEnd;  // End of the open window
+    EventId m_closeEvent;
+
+    // Per-sensor state indexed by sensor ID, one array per field
+    std::vector<double> m_ewmaMean;
+    std::vector<double> m_ewmaVariance;
+    std::vector<uint32_t> m_seen;
+    std::vector<uint8_t> m_flagged; // Last reading was anomalous
+    std::vector<uint32_t> m_sensorZone;
+    std::vector<uint32_t> m_sensorCompany;
+    std::vector<double> m_windowSum;
+    std::vector<double> m_windowExcess;
+    std::vector<double> m_windowCount; // double, so the closing pass has a single element type
+    std::vector<double> m_windowAnomalies;
+    std::vector<double> m_balance; // Scratch of the closing pass
+
+    std::vector<Rollup> m_zones;     // Indexed by zone ID
+    std::vector<Rollup> m_companies; // Indexed by company ID
+    uint64_t m_readings;
+    uint64_t m_rejected; // Readings with an ID beyond the reserved tables
+    uint64_t m_anomalies;
+    uint64_t m_onsets;
+    uint64_t m_windowsClosed;
+    double m_recordWallSeconds;
+    double m_closeWallSeconds;
+};
+
+} // namespace ns3
+
+#endif /* CARBON_ANALYTICS_H */
@@ -0,0 +1,370 @@
+/*
+ * Carbon Ledger
+ *
+ * Optional append-only ledger stage behind the main gateway, standing in
+ * for the "written to blockchain for immutable record" step of the real
+ * platform. Every recorded reading is appended to an in-memory log. The
+ * log is cut into blocks, sealed when --ledgerBlockEntries readings are
+ * waiting or --ledgerBlockMs after the first of them, whichever comes
+ * first. A single committer takes the sealed blocks in order. It hashes
+ * the entries into a Merkle root (ns-3's Hash64, an odd node paired with
+ * itself) and chains it to the previous block:
+ *
+ *   leaf  = Hash64([CompanyID:2][ZoneID:2][SensorID:4][CO2:4][Timestamp:8])
+ *   node  = Hash64([Left:8][Right:8])
+ *   block = Hash64([PreviousBlock:8][MerkleRoot:8][FirstEntry:8][Count:4])
+ *
+ * all big-endian. The commit then takes --ledgerBlockCostMs plus
+ * --ledgerEntryCostUs per entry of simulated time, the modeled cost of
+ * consensus and persistence. Blocks sealed meanwhile wait, so the queue
+ * depth (readings appended but not committed) shows whether a block size
+ * keeps up with ingest: the committer cannot keep up once its utilization
+ * reaches 1. The measured hashing time is reported separately.
+ *
+ * The committer never allocates once Reserve() has sized the log.
+ */
+
+#ifndef CARBON_LEDGER_H
+#define CARBON_LEDGER_H
+
+#include "co2-batch-codec.h"
+#include "co2-reading-header.h"
+#include "latency-histogram.h"
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Block cutting and modeled commit cost of the ledger
+ */
+struct LedgerConfig
+{
+    uint32_t blockEntries = 256;         // Seal a block once this many readings wait
+    Time blockInterval = Seconds(1);     // Seal at most this long after the block's first reading
+    Time blockCost = MilliSeconds(5);    // Commit time per block
+    Time entryCost = MicroSeconds(20);   // Commit time per reading
+};
+
+class CarbonLedger : public SimpleRefCount<CarbonLedger>
+{
+  public:
+    /**
+     * @param config Block cutting and commit cost
+     */
+    CarbonLedger(const LedgerConfig& config)
+        : m_config(config),
+          m_openFirst(0),
+          m_nextCommit(0),
+          m_committedEntries(0),
+          m_committing(false),
+          m_headHash(0),
+          m_peakQueue(0),
+          m_peakBlocks(0),
+          m_queueIntegral(0.0),
+          m_hashWallSeconds(0.0)
+    {
+        NS_ABORT_MSG_IF(config.blockEntries == 0, "Ledger blocks need at least one entry");
+        NS_ABORT_MSG_IF(!config.blockInterval.IsStrictlyPositive(),
+                        "The ledger block interval must be positive");
+        NS_ABORT_MSG_IF(config.blockCost.IsNegative() || config.entryCost.IsNegative(),
+                        "Ledger commit costs must not be negative");
+        m_hashes.reserve(config.blockEntries);
+    }
+
+    /**
+     * Preallocate the log so that appends do not reallocate during the run
+     * @param entries Expected readings
+     */
+    void Reserve(uint64_t entries)
+    {
+        m_entries.reserve(entries);
+        m_blocks.reserve(entries / m_config.blockEntries + 1);
+    }
+
+    /**
+     * Append one reading to the open block
+     * @param reading Reading recorded by the gateway
+     */
+    void Append(const CO2ReadingHeader& reading)
+    {
+        UpdateQueue();
+        Entry entry;
+        entry.timestamp = reading.GetTimestamp();
+        entry.appended = Simulator::Now();
+        entry.sensorId = reading.GetSensorId();
+        entry.companyId = reading.GetCompanyId();
+        entry.zoneId = reading.GetZoneId();
+        entry.co2CentiPpm = reading.GetCo2CentiPpm();
+        m_entries.push_back(entry);
+        m_peakQueue = std::max(m_peakQueue, GetQueueDepth());
+
+        uint64_t open = m_entries.size() - m_openFirst;
+        if (open == 1)
+        {
+            m_sealEvent =
+                Simulator::Schedule(m_config.blockInterval, &CarbonLedger::Seal, this);
+        }
+        if (open >= m_config.blockEntries)
+        {
+            Seal();
+        }
+    }
+
+    /** Seal the open block, if it has entries, and queue it for commit */
+    void Seal(void)
+    {
+        Simulator::Cancel(m_sealEvent);
+        uint64_t count = m_entries.size() - m_openFirst;
+        if (count == 0)
+        {
+            return;
+        }
+        Block block;
+        block.first = m_openFirst;
+        block.count = static_cast<uint32_t>(count);
+        block.sealed = Simulator::Now();
+        m_blocks.push_back(block);
+        m_openFirst = m_entries.size();
+        m_peakBlocks = std::max<uint64_t>(m_peakBlocks, m_blocks.size() - m_nextCommit);
+        if (!m_committing)
+        {
+            StartCommit();
+        }
+    }
+
+    /** @return Readings appended but not committed yet */
+    uint64_t GetQueueDepth(void) const
+    {
+        return m_entries.size() - m_committedEntries;
+    }
+
+    /** @return Blocks committed */
+    uint64_t GetBlocksCommitted(void) const
+    {
+        return m_nextCommit;
+    }
+
+    /** @return Readings in committed blocks */
+    uint64_t GetEntriesCommitted(void) const
+    {
+        return m_committedEntries;
+    }
+
+    /** @return Chain hash of the last committed block (0 before the first) */
+    uint64_t GetHeadHash(void) const
+    {
+        return m_headHash;
+    }
+
+    /** @return Time from append to commit of every committed reading */
+    const LatencyHistogram& GetCommitLatency(void) const
+    {
+        return m_commitLatency;
+    }
+
+    /**
+     * Print the block rate, queue depth, commit latency and committer load
+     * @param os Output stream
+     * @param period Time the gateway was receiving
+     */
+    void Print(std::ostream& os, Time period) const
+    {
+        os << "  Blocks committed: " << m_nextCommit << " (" << GetBlocksPerSecond(period)
+           << "/s, " << GetEntriesPerBlock() << " readings each)\n";
+        os << "  Readings: " << m_entries.size() << " appended, " << m_committedEntries
+           << " committed, " << GetQueueDepth() << " still queued\n";
+        os << "  Queue depth: mean " << GetMeanQueue() << ", peak " << m_peakQueue
+           << " readings (peak " << m_peakBlocks << " sealed blocks)\n";
+        os << "  Commit latency: p50 " << m_commitLatency.GetQuantile(0.5) * 1000.0 << " ms, p99 "
+           << m_commitLatency.GetQuantile(0.99) * 1000.0 << " ms, max "
+           << m_commitLatency.GetMax() * 1000.0 << " ms\n";
+        os << "  Committer utilization: " << GetUtilization(period) * 100.0 << "%, hashing "
+           << GetHashNsPerEntry() << " ns/reading (wall)\n";
+        os << "  Head block: " << std::hex << std::setw(16) << std::setfill('0') << m_headHash
+           << std::dec << std::setfill(' ') << "\n";
+    }
+
+    /**
+     * Add the ledger metrics to a run summary
+     * @param summary Summary of this run
+     * @param period Time the gateway was receiving
+     */
+    void AddMetrics(RunSummary& summary, Time period) const
+    {
+        summary.AddMetric("ledgerBlocks", m_nextCommit);
+        summary.AddMetric("ledgerBlocksPerSecond", GetBlocksPerSecond(period));
+        summary.AddMetric("ledgerEntriesPerBlock", GetEntriesPerBlock());
+        summary.AddMetric("ledgerCommitted", m_committedEntries);
+        summary.AddMetric("ledgerBacklog", GetQueueDepth());
+        summary.AddMetric("ledgerQueueMean", GetMeanQueue());
+        summary.AddMetric("ledgerQueuePeak", m_peakQueue);
+        summary.AddMetric("ledgerCommitP50Ms", m_commitLatency.GetQuantile(0.5) * 1000.0);
+        summary.AddMetric("ledgerCommitP99Ms", m_commitLatency.GetQuantile(0.99) * 1000.0);
+        summary.AddMetric("ledgerCommitMaxMs", m_commitLatency.GetMax() * 1000.0);
+        summary.AddMetric("ledgerUtilization", GetUtilization(period));
+        summary.AddMetric("ledgerHashNsPerEntry", GetHashNsPerEntry());
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        uint64_t timestamp; // Sensor send time (us)
+        Time appended;
+        uint32_t sensorId;
+        uint32_t companyId;
+        uint32_t zoneId;
+        uint32_t co2CentiPpm;
+    };
+
+    struct Block
+    {
+        uint64_t first = 0; // Index of the first entry in the log
+        uint32_t count = 0;
+        uint64_t merkleRoot = 0;
+        uint64_t hash = 0; // Chained to the previous block
+        Time sealed;
+        Time committed;
+    };
+
+    void StartCommit(void)
+    {
+        Block& block = m_blocks[m_nextCommit];
+        Clock::time_point begin = Clock::now();
+        block.merkleRoot = GetMerkleRoot(block.first, block.count);
+        uint8_t header[28];
+        batchcodec::WriteBigEndian(header, m_headHash, 8);
+        batchcodec::WriteBigEndian(header + 8, block.merkleRoot, 8);
+        batchcodec::WriteBigEndian(header + 16, block.first, 8);
+        batchcodec::WriteBigEndian(header + 24, block.count, 4);
+        block.hash = Hash64(reinterpret_cast<const char*>(header), sizeof(header));
+        m_hashWallSeconds += std::chrono::duration<double>(Clock::now() - begin).count();
+
+        Time service = m_config.blockCost + m_config.entryCost * static_cast<int64_t>(block.count);
+        m_busy += service;
+        m_committing = true;
+        Simulator::Schedule(service, &CarbonLedger::FinishCommit, this);
+    }
+
+    void FinishCommit(void)
+    {
+        UpdateQueue();
+        Block& block = m_blocks[m_nextCommit];
+        block.committed = Simulator::Now();
+        for (uint64_t i = block.first; i < block.first + block.count; ++i)
+        {
+            m_commitLatency.Add(block.committed - m_entries[i].appended);
+        }
+        m_headHash = block.hash;
+        m_committedEntries += block.count;
+        m_nextCommit++;
+        m_committing = false;
+        if (m_nextCommit < m_blocks.size())
+        {
+            StartCommit();
+        }
+    }
+
+    uint64_t GetMerkleRoot(uint64_t first, uint32_t count)
+    {
+        m_hashes.clear();
+        uint8_t leaf[20];
+        for (uint64_t i = first; i < first + count; ++i)
+        {
+            const Entry& entry = m_entries[i];
+            batchcodec::WriteBigEndian(leaf, entry.companyId, 2);
+            batchcodec::WriteBigEndian(leaf + 2, entry.zoneId, 2);
+            batchcodec::WriteBigEndian(leaf + 4, entry.sensorId, 4);
+            batchcodec::WriteBigEndian(leaf + 8, entry.co2CentiPpm, 4);
+            batchcodec::WriteBigEndian(leaf + 12, entry.timestamp, 8);
+            m_hashes.push_back(Hash64(reinterpret_cast<const char*>(leaf), sizeof(leaf)));
+        }
+        // Reduce level by level in place; an odd last node is paired with itself
+        size_t level = m_hashes.size();
+        uint8_t pair[16];
+        while (level > 1)
+        {
+            size_t next = 0;
+            for (size_t i = 0; i < level; i += 2)
+            {
+                uint64_t right = (i + 1 < level) ? m_hashes[i + 1] : m_hashes[i];
+                batchcodec::WriteBigEndian(pair, m_hashes[i], 8);
+                batchcodec::WriteBigEndian(pair + 8, right, 8);
+                m_hashes[next++] = Hash64(reinterpret_cast<const char*>(pair), sizeof(pair));
+            }
+            level = next;
+        }
+        return m_hashes[0];
+    }
+
+    /** Integrate the queue depth up to now (call before it changes) */
+    void UpdateQueue(void)
+    {
+        Time now = Simulator::Now();
+        m_queueIntegral += GetQueueDepth() * (now - m_queueUpdated).GetSeconds();
+        m_queueUpdated = now;
+    }
+
+    /** @return Time-weighted mean queue depth since the start of the run */
+    double GetMeanQueue(void) const
+    {
+        double elapsed = Simulator::Now().GetSeconds();
+        double integral =
+            m_queueIntegral + GetQueueDepth() * (Simulator::Now() - m_queueUpdated).GetSeconds();
+        return elapsed > 0 ? integral / elapsed : 0.0;
+    }
+
+    double GetBlocksPerSecond(Time period) const
+    {
+        return period.IsStrictlyPositive() ? m_nextCommit / period.GetSeconds() : 0.0;
+    }
+
+    double GetEntriesPerBlock(void) const
+    {
+        return m_nextCommit > 0 ? (double)m_committedEntries / m_nextCommit : 0.0;
+    }
+
+    double GetUtilization(Time period) const
+    {
+        return period.IsStrictlyPositive() ? m_busy.GetSeconds() / period.GetSeconds() : 0.0;
+    }
+
+    double GetHashNsPerEntry(void) const
+    {
+        uint64_t hashed = m_committedEntries + (m_committing ? m_blocks[m_nextCommit].count : 0);
+        return hashed > 0 ? m_hashWallSeconds * 1e9 / hashed : 0.0;
+    }
+
+    LedgerConfig m_config;
+    std::vector<Entry> m_entries; // The append-only log
+    std::vector<Block> m_blocks;  // Sealed blocks; m_nextCommit onwards wait for the committer
+    std::vector<uint64_t> m_hashes; // Merkle scratch, one block wide
+    uint64_t m_openFirst;         // First entry of the open block
+    uint64_t m_nextCommit;        // Blocks committed so far
+    uint64_t m_committedEntries;
+    bool m_committing;
+    EventId m_sealEvent;
+    uint64_t m_headHash;
+    Time m_busy; // Modeled commit time, including the commit in progress
+    uint64_t m_peakQueue;
+    uint64_t m_peakBlocks;
+    double m_queueIntegral; // Readings x seconds
+    Time m_queueUpdated;
+    double m_hashWallSeconds;
+    LatencyHistogram m_commitLatency;
+};
+
+} // namespace ns3
+
+#endif /* CARBON_LEDGER_H */
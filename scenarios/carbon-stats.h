@@ -0,0 +1,315 @@
+/*
+ * Carbon Statistics Store
+ *
+ * Dense, per-gateway accumulator for CO2 readings. Sensors, zones and
+ * companies are indexed directly by their numeric ID into contiguous
+ * vectors, so recording a reading is O(1) with no tree lookups or node
+ * allocations in the receive path. Each slot keeps streaming statistics
+ * (count, sum, min/max and Welford mean/variance).
+ *
+ * The store also keeps the end-to-end latency (sensor send time to gateway
+ * record) of the readings in a LatencyHistogram per zone and per company
+ * plus one for the site, so tail percentiles are available per tenant in
+ * fixed memory (2 KiB per zone or company, whatever the reading count).
+ *
+ * IDs are expected to be small and dense (1..N as assigned by the scenarios);
+ * slot 0 collects readings without a zone or company. The tables are sized
+ * once by Reserve(): IDs come off the wire, so a reading with an ID beyond
+ * them is counted as rejected and ignored rather than growing the tables.
+ */
+
+#ifndef CARBON_STATS_H
+#define CARBON_STATS_H
+
+#include "latency-histogram.h"
+#include "run-summary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Streaming statistics for one series of CO2 readings
+ */
+struct RunningStats
+{
+    uint64_t count = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double mean = 0.0;
+    double m2 = 0.0; // Sum of squared deviations from the mean (Welford)
+
+    void Add(double value)
+    {
+        count++;
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    /**
+     * Combine another series into this one (Chan et al. parallel update)
+     * @param other Statistics to merge
+     */
+    void Merge(const RunningStats& other)
+    {
+        if (other.count == 0)
+        {
+            return;
+        }
+        if (count == 0)
+        {
+            *this = other;
+            return;
+        }
+        uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * ((double)count * other.count / total);
+        count = total;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    double GetVariance(void) const
+    {
+        return (count > 1) ? m2 / (count - 1) : 0.0;
+    }
+
+    double GetStdDev(void) const
+    {
+        return std::sqrt(GetVariance());
+    }
+};
+
+class CarbonStatsStore
+{
+  public:
+    /**
+     * Preallocate slots so that no reallocation happens during the run
+     * @param nSensors Highest expected sensor ID
+     * @param nZones Highest expected zone ID
+     * @param nCompanies Highest expected company ID
+     */
+    void Reserve(uint32_t nSensors, uint32_t nZones, uint32_t nCompanies)
+    {
+        m_sensors.resize(std::max<size_t>(m_sensors.size(), nSensors + 1));
+        m_zones.resize(std::max<size_t>(m_zones.size(), nZones + 1));
+        m_companies.resize(std::max<size_t>(m_companies.size(), nCompanies + 1));
+        m_zoneLatency.resize(m_zones.size());
+        m_companyLatency.resize(m_companies.size());
+    }
+
+    /**
+     * Record one reading, or reject it if an ID is beyond the reserved range
+     * @param sensorId Sensor ID
+     * @param zoneId Zone ID (0 if none)
+     * @param companyId Company ID (0 if none)
+     * @param co2Value CO2 level in ppm
+     */
+    void Record(uint32_t sensorId, uint32_t zoneId, uint32_t companyId, double co2Value)
+    {
+        if (sensorId >= m_sensors.size() || zoneId >= m_zones.size() ||
+            companyId >= m_companies.size())
+        {
+            m_rejectedReadings++;
+            return;
+        }
+        m_sensors[sensorId].Add(co2Value);
+        m_zones[zoneId].Add(co2Value);
+        m_companies[companyId].Add(co2Value);
+        m_totalReadings++;
+    }
+
+    /**
+     * Record the end-to-end latency of one reading; zones and companies beyond
+     * the reserved range only count towards the site
+     * @param zoneId Zone ID (0 if none)
+     * @param companyId Company ID (0 if none)
+     * @param latency Time from the sensor send to the gateway record
+     */
+    void RecordLatency(uint32_t zoneId, uint32_t companyId, Time latency)
+    {
+        if (zoneId < m_zoneLatency.size())
+        {
+            m_zoneLatency[zoneId].Add(latency);
+        }
+        if (companyId < m_companyLatency.size())
+        {
+            m_companyLatency[companyId].Add(latency);
+        }
+        m_latency.Add(latency);
+    }
+
+    /**
+     * Fold another gateway's statistics into this store
+     * @param other Store to merge
+     */
+    void Merge(const CarbonStatsStore& other)
+    {
+        MergeTable(m_sensors, other.m_sensors);
+        MergeTable(m_zones, other.m_zones);
+        MergeTable(m_companies, other.m_companies);
+        MergeTable(m_zoneLatency, other.m_zoneLatency);
+        MergeTable(m_companyLatency, other.m_companyLatency);
+        m_latency.Merge(other.m_latency);
+        m_totalReadings += other.m_totalReadings;
+        m_rejectedReadings += other.m_rejectedReadings;
+    }
+
+    /** @return Per-sensor statistics indexed by sensor ID */
+    const std::vector<RunningStats>& GetSensors(void) const
+    {
+        return m_sensors;
+    }
+
+    /** @return Per-zone statistics indexed by zone ID */
+    const std::vector<RunningStats>& GetZones(void) const
+    {
+        return m_zones;
+    }
+
+    /** @return Per-company statistics indexed by company ID */
+    const std::vector<RunningStats>& GetCompanies(void) const
+    {
+        return m_companies;
+    }
+
+    /** @return Per-zone latencies indexed by zone ID */
+    const std::vector<LatencyHistogram>& GetZoneLatency(void) const
+    {
+        return m_zoneLatency;
+    }
+
+    /** @return Per-company latencies indexed by company ID */
+    const std::vector<LatencyHistogram>& GetCompanyLatency(void) const
+    {
+        return m_companyLatency;
+    }
+
+    /** @return Latencies of every reading with a recorded latency */
+    const LatencyHistogram& GetLatency(void) const
+    {
+        return m_latency;
+    }
+
+    /**
+     * Print p50/p99/p99.9 of the site and of every zone and company with readings
+     * @param os Output stream
+     */
+    void PrintLatency(std::ostream& os) const
+    {
+        PrintQuantiles(os, "  Site", m_latency);
+        PrintTable(os, "  Zone ", m_zoneLatency);
+        PrintTable(os, "  Company ", m_companyLatency);
+    }
+
+    /**
+     * Add the latency percentiles to a run summary: latencyP50Ms, latencyP99Ms,
+     * latencyP999Ms and latencyMaxMs for the site, zone<N>LatencyP50Ms ... and
+     * company<N>LatencyP50Ms ... for every zone and company with readings
+     * @param summary Summary of this run
+     */
+    void AddLatencyMetrics(RunSummary& summary) const
+    {
+        AddQuantiles(summary, "latency", m_latency);
+        summary.AddMetric("latencyMaxMs", m_latency.GetMax() * 1000.0);
+        AddTable(summary, "zone", m_zoneLatency);
+        AddTable(summary, "company", m_companyLatency);
+    }
+
+    uint64_t GetTotalReadings(void) const
+    {
+        return m_totalReadings;
+    }
+
+    /** @return Readings ignored for an ID beyond the reserved tables */
+    uint64_t GetRejectedReadings(void) const
+    {
+        return m_rejectedReadings;
+    }
+
+  private:
+    template <typename T>
+    static void MergeTable(std::vector<T>& table, const std::vector<T>& other)
+    {
+        if (other.size() > table.size())
+        {
+            table.resize(other.size());
+        }
+        for (size_t i = 0; i < other.size(); ++i)
+        {
+            table[i].Merge(other[i]);
+        }
+    }
+
+    static void PrintQuantiles(std::ostream& os,
+                               const std::string& label,
+                               const LatencyHistogram& latency)
+    {
+        os << label << ": " << latency.GetCount() << " readings, p50 "
+           << latency.GetQuantile(0.5) * 1000.0 << " ms, p99 " << latency.GetQuantile(0.99) * 1000.0
+           << " ms, p99.9 " << latency.GetQuantile(0.999) * 1000.0 << " ms\n";
+    }
+
+    static void PrintTable(std::ostream& os,
+                           const std::string& label,
+                           const std::vector<LatencyHistogram>& table)
+    {
+        // Slot 0 (no zone or company) is part of the site line
+        for (uint32_t id = 1; id < table.size(); ++id)
+        {
+            if (table[id].GetCount() > 0)
+            {
+                PrintQuantiles(os, label + std::to_string(id), table[id]);
+            }
+        }
+    }
+
+    static void AddQuantiles(RunSummary& summary,
+                             const std::string& prefix,
+                             const LatencyHistogram& latency)
+    {
+        summary.AddMetric(prefix + "P50Ms", latency.GetQuantile(0.5) * 1000.0);
+        summary.AddMetric(prefix + "P99Ms", latency.GetQuantile(0.99) * 1000.0);
+        summary.AddMetric(prefix + "P999Ms", latency.GetQuantile(0.999) * 1000.0);
+    }
+
+    static void AddTable(RunSummary& summary,
+                         const std::string& prefix,
+                         const std::vector<LatencyHistogram>& table)
+    {
+        for (uint32_t id = 1; id < table.size(); ++id)
+        {
+            if (table[id].GetCount() > 0)
+            {
+                AddQuantiles(summary, prefix + std::to_string(id) + "Latency", table[id]);
+            }
+        }
+    }
+
+    std::vector<RunningStats> m_sensors;
+    std::vector<RunningStats> m_zones;
+    std::vector<RunningStats> m_companies;
+    std::vector<LatencyHistogram> m_zoneLatency;
+    std::vector<LatencyHistogram> m_companyLatency;
+    LatencyHistogram m_latency;
+    uint64_t m_totalReadings = 0;
+    uint64_t m_rejectedReadings = 0;
+};
+
+} // namespace ns3
+
+#endif /* CARBON_STATS_H */
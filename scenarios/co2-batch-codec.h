@@ -0,0 +1,615 @@
+/*
+ * CO2 Batch Codec
+ *
+ * Compact encoding of the readings that follow a CO2BatchHeader. The
+ * readings of one batch are highly redundant: the sensor IDs of a zone are
+ * close together, timestamps fall within the batching window and CO2 levels
+ * stay near the sensor baselines. The DELTA codec stores every field as the
+ * difference to the previous reading of the batch:
+ *
+ *   [Quantum:v]  once, then per reading
+ *   [SensorDelta << 2 | Changed:v][CompanyID:v]?[ZoneID:v]?[CO2Delta:v][TimestampDelta:v]
+ *
+ * - v: LEB128 varint (7 bits per byte, least significant group first);
+ *   deltas are zigzag-encoded so small negative steps stay short
+ * - Changed bit 0 / bit 1: the company / zone ID differs from the previous
+ *   reading and follows as an absolute varint
+ * - CO2 is quantized to Quantum steps of 0.01 ppm before taking the delta
+ *   (Quantum 1 is lossless at the CO2ReadingHeader resolution)
+ * - the first reading is coded against an all-zero reading
+ *
+ * The RAW codec is the plain sequence of CO2ReadingHeaders. Typical AP
+ * batches shrink from 22 to 5-7 bytes per reading.
+ *
+ * CO2BatchEncoder builds a batch incrementally, so the byte limit of a
+ * datagram can be checked before each reading. CO2BatchDecoder decodes a
+ * whole batch in one pass over a flat copy of the payload into a reused
+ * array, without per-reading Packet operations.
+ */
+
+#ifndef CO2_BATCH_CODEC_H
+#define CO2_BATCH_CODEC_H
+
+#include "co2-batch-header.h"
+#include "co2-reading-header.h"
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Encoding of the readings of a batch (the CO2BatchHeader codec byte)
+ */
+enum class BatchCodec : uint8_t
+{
+    RAW = 0,
+    DELTA = 1
+};
+
+/**
+ * Parse a batch codec name ("raw" or "delta")
+ * @param name Codec name from the command line
+ * @return The matching BatchCodec (aborts on unknown names)
+ */
+inline BatchCodec
+ParseBatchCodec(const std::string& name)
+{
+    if (name == "raw")
+    {
+        return BatchCodec::RAW;
+    }
+    if (name == "delta")
+    {
+        return BatchCodec::DELTA;
+    }
+    NS_ABORT_MSG("Unknown batch codec '" << name << "' (expected raw or delta)");
+    return BatchCodec::RAW;
+}
+
+/**
+ * How batches are encoded, and the modeled CPU cost of the codec
+ */
+struct BatchCodecConfig
+{
+    BatchCodec codec = BatchCodec::RAW;
+    uint32_t quantum = 1; // CO2 quantization step of DELTA in 0.01 ppm units
+    Time encodeCost;      // Simulated encoding time per reading (delays the send)
+    Time decodeCost;      // Simulated decoding time per reading (adds to the latency)
+};
+
+/**
+ * Codec work of a run, shared by every encoder and decoder: batch and reading
+ * counts, the RAW and encoded sizes behind the compression ratio, and the
+ * wall-clock and simulated time spent on each side
+ */
+struct BatchCodecStats : public SimpleRefCount<BatchCodecStats>
+{
+    uint64_t batchesEncoded = 0;
+    uint64_t readingsEncoded = 0;
+    uint64_t rawBytes = 0;     // Size of the encoded batches as RAW, headers included
+    uint64_t encodedBytes = 0; // Size actually sent, headers included
+    double encodeWallSeconds = 0.0;
+    double encodeSimSeconds = 0.0;
+    uint64_t batchesDecoded = 0;
+    uint64_t readingsDecoded = 0;
+    double decodeWallSeconds = 0.0;
+    double decodeSimSeconds = 0.0;
+
+    /** @return RAW size over encoded size (1 when nothing was encoded) */
+    double GetCompressionRatio(void) const
+    {
+        return encodedBytes > 0 ? (double)rawBytes / encodedBytes : 1.0;
+    }
+
+    /** @return Wall-clock encoding time per reading in nanoseconds */
+    double GetEncodeNsPerReading(void) const
+    {
+        return readingsEncoded > 0 ? encodeWallSeconds * 1e9 / readingsEncoded : 0.0;
+    }
+
+    /** @return Wall-clock decoding time per reading in nanoseconds */
+    double GetDecodeNsPerReading(void) const
+    {
+        return readingsDecoded > 0 ? decodeWallSeconds * 1e9 / readingsDecoded : 0.0;
+    }
+
+    /**
+     * Print the batch sizes, compression ratio and codec cost
+     * @param os Output stream
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "  Batches encoded: " << batchesEncoded << " (" << readingsEncoded << " readings)\n";
+        os << "  Batch bytes: " << encodedBytes << " (" << rawBytes << " raw, ratio "
+           << GetCompressionRatio() << ")\n";
+        os << "  Encode: " << GetEncodeNsPerReading() << " ns/reading wall, " << encodeSimSeconds
+           << " s simulated\n";
+        os << "  Decode: " << GetDecodeNsPerReading() << " ns/reading wall, " << decodeSimSeconds
+           << " s simulated (" << readingsDecoded << " readings)\n";
+    }
+
+    /**
+     * Add the codec metrics to a run summary
+     * @param summary Run summary
+     */
+    void AddMetrics(RunSummary& summary) const
+    {
+        summary.AddMetric("batchBytes", encodedBytes);
+        summary.AddMetric("batchRawBytes", rawBytes);
+        summary.AddMetric("compressionRatio", GetCompressionRatio());
+        summary.AddMetric("encodeNsPerReading", GetEncodeNsPerReading());
+        summary.AddMetric("decodeNsPerReading", GetDecodeNsPerReading());
+        summary.AddMetric("encodeSimSeconds", encodeSimSeconds);
+        summary.AddMetric("decodeSimSeconds", decodeSimSeconds);
+    }
+};
+
+namespace batchcodec
+{
+
+typedef std::chrono::steady_clock Clock;
+
+/** Longest varint of a 64-bit value */
+static constexpr uint32_t MAX_VARINT_SIZE = 10;
+
+/** Longest DELTA reading: sensor 5, company 3, zone 3, CO2 5, timestamp 10 bytes */
+static constexpr uint32_t MAX_DELTA_READING_SIZE = 26;
+
+inline uint64_t
+ZigZag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t
+UnZigZag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @param out Destination (at least MAX_VARINT_SIZE bytes)
+ * @param value Value to encode
+ * @return Bytes written
+ */
+inline uint32_t
+WriteVarint(uint8_t* out, uint64_t value)
+{
+    uint32_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+/**
+ * @param data Encoded bytes
+ * @param size Number of bytes in data
+ * @param pos Read position, advanced past the varint
+ * @param value Decoded value
+ * @return false if the data ends inside the varint or it is too long
+ */
+inline bool
+ReadVarint(const uint8_t* data, uint32_t size, uint32_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 7 * MAX_VARINT_SIZE && pos < size; shift += 7)
+    {
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Write the low 'bytes' bytes of value in network byte order */
+inline void
+WriteBigEndian(uint8_t* out, uint64_t value, uint32_t bytes)
+{
+    for (uint32_t i = bytes; i-- > 0;)
+    {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+inline uint64_t
+ReadBigEndian(const uint8_t* in, uint32_t bytes)
+{
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < bytes; ++i)
+    {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+} // namespace batchcodec
+
+class CO2BatchEncoder
+{
+  public:
+    CO2BatchEncoder()
+    {
+        Clear();
+    }
+
+    /**
+     * Select the codec; clears the pending batch
+     * @param config Codec and quantization step
+     * @param stats Shared counters (null = not recorded)
+     */
+    void SetCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+    {
+        NS_ABORT_MSG_IF(config.quantum == 0, "The CO2 quantization step must be positive");
+        m_config = config;
+        m_stats = stats;
+        Clear();
+    }
+
+    const BatchCodecConfig& GetConfig(void) const
+    {
+        return m_config;
+    }
+
+    /**
+     * Largest body a batch of this many readings can need
+     * @param codec Batch codec
+     * @param readings Readings in the batch
+     * @return Bytes after the CO2BatchHeader
+     */
+    static uint32_t GetMaxBodySize(BatchCodec codec, uint32_t readings)
+    {
+        if (codec == BatchCodec::DELTA)
+        {
+            return 5 + readings * batchcodec::MAX_DELTA_READING_SIZE;
+        }
+        return readings * CO2ReadingHeader::SERIALIZED_SIZE;
+    }
+
+    /** Drop the pending readings */
+    void Clear(void)
+    {
+        m_body.clear();
+        m_count = 0;
+        m_prevSensor = 0;
+        m_prevCompany = 0;
+        m_prevZone = 0;
+        m_prevCo2 = 0;
+        m_prevTimestamp = 0;
+        if (m_config.codec == BatchCodec::DELTA)
+        {
+            uint8_t prefix[batchcodec::MAX_VARINT_SIZE];
+            m_body.insert(m_body.end(),
+                          prefix,
+                          prefix + batchcodec::WriteVarint(prefix, m_config.quantum));
+        }
+    }
+
+    /** @return Readings in the pending batch */
+    uint32_t GetCount(void) const
+    {
+        return m_count;
+    }
+
+    /** @return Encoded body size of the pending batch, without the CO2BatchHeader */
+    uint32_t GetSize(void) const
+    {
+        return m_body.size();
+    }
+
+    /**
+     * @param reading Next reading
+     * @return Bytes Append(reading) would add to the body
+     */
+    uint32_t GetEncodedSize(const CO2ReadingHeader& reading) const
+    {
+        uint8_t scratch[batchcodec::MAX_DELTA_READING_SIZE];
+        DeltaState state = {m_prevSensor, m_prevCompany, m_prevZone, m_prevCo2, m_prevTimestamp};
+        return Encode(reading, scratch, state);
+    }
+
+    /**
+     * Add a reading to the pending batch
+     * @param reading Reading to encode
+     */
+    void Append(const CO2ReadingHeader& reading)
+    {
+        batchcodec::Clock::time_point start;
+        if (m_stats)
+        {
+            start = batchcodec::Clock::now();
+        }
+        uint8_t encoded[batchcodec::MAX_DELTA_READING_SIZE];
+        DeltaState state = {m_prevSensor, m_prevCompany, m_prevZone, m_prevCo2, m_prevTimestamp};
+        uint32_t size = Encode(reading, encoded, state);
+        m_body.insert(m_body.end(), encoded, encoded + size);
+        m_prevSensor = state.sensor;
+        m_prevCompany = state.company;
+        m_prevZone = state.zone;
+        m_prevCo2 = state.co2;
+        m_prevTimestamp = state.timestamp;
+        m_count++;
+        if (m_stats)
+        {
+            m_stats->encodeWallSeconds +=
+                std::chrono::duration<double>(batchcodec::Clock::now() - start).count();
+        }
+    }
+
+    /**
+     * Turn the pending readings into a batch datagram and clear them
+     * @param zoneId Zone of the batch header
+     * @return CO2BatchHeader followed by the encoded readings
+     */
+    Ptr<Packet> Finish(uint16_t zoneId)
+    {
+        batchcodec::Clock::time_point start;
+        if (m_stats)
+        {
+            start = batchcodec::Clock::now();
+        }
+        Ptr<Packet> packet = Create<Packet>(m_body.data(), m_body.size());
+        CO2BatchHeader header;
+        header.SetCodec(static_cast<uint8_t>(m_config.codec));
+        header.SetZoneId(zoneId);
+        header.SetCount(m_count);
+        packet->AddHeader(header);
+        if (m_stats)
+        {
+            m_stats->encodeWallSeconds +=
+                std::chrono::duration<double>(batchcodec::Clock::now() - start).count();
+            m_stats->batchesEncoded++;
+            m_stats->readingsEncoded += m_count;
+            m_stats->rawBytes +=
+                CO2BatchHeader::SERIALIZED_SIZE + m_count * CO2ReadingHeader::SERIALIZED_SIZE;
+            m_stats->encodedBytes += packet->GetSize();
+            m_stats->encodeSimSeconds += (m_config.encodeCost * m_count).GetSeconds();
+        }
+        Clear();
+        return packet;
+    }
+
+  private:
+    struct DeltaState
+    {
+        uint32_t sensor;
+        uint16_t company;
+        uint16_t zone;
+        int64_t co2; // Quantized
+        uint64_t timestamp;
+    };
+
+    /**
+     * Encode one reading after the reading described by state
+     * @param reading Reading to encode
+     * @param out Destination (MAX_DELTA_READING_SIZE bytes)
+     * @param state Previous reading, updated to this one
+     * @return Bytes written
+     */
+    uint32_t Encode(const CO2ReadingHeader& reading, uint8_t* out, DeltaState& state) const
+    {
+        using namespace batchcodec;
+        if (m_config.codec == BatchCodec::RAW)
+        {
+            out[0] = CO2ReadingHeader::VERSION;
+            out[1] = 0; // Flags, reserved
+            WriteBigEndian(out + 2, reading.GetCompanyId(), 2);
+            WriteBigEndian(out + 4, reading.GetZoneId(), 2);
+            WriteBigEndian(out + 6, reading.GetSensorId(), 4);
+            WriteBigEndian(out + 10, reading.GetCo2CentiPpm(), 4);
+            WriteBigEndian(out + 14, reading.GetTimestamp(), 8);
+            return CO2ReadingHeader::SERIALIZED_SIZE;
+        }
+
+        int64_t co2 = (reading.GetCo2CentiPpm() + m_config.quantum / 2) / m_config.quantum;
+        uint64_t changed = (reading.GetCompanyId() != state.company ? 1 : 0) |
+                           (reading.GetZoneId() != state.zone ? 2 : 0);
+        int64_t sensorDelta = static_cast<int64_t>(reading.GetSensorId()) - state.sensor;
+        uint32_t n = WriteVarint(out, (ZigZag(sensorDelta) << 2) | changed);
+        if (changed & 1)
+        {
+            n += WriteVarint(out + n, reading.GetCompanyId());
+        }
+        if (changed & 2)
+        {
+            n += WriteVarint(out + n, reading.GetZoneId());
+        }
+        n += WriteVarint(out + n, ZigZag(co2 - state.co2));
+        n += WriteVarint(out + n,
+                         ZigZag(static_cast<int64_t>(reading.GetTimestamp() - state.timestamp)));
+
+        state.sensor = reading.GetSensorId();
+        state.company = reading.GetCompanyId();
+        state.zone = reading.GetZoneId();
+        state.co2 = co2;
+        state.timestamp = reading.GetTimestamp();
+        return n;
+    }
+
+    BatchCodecConfig m_config;
+    Ptr<BatchCodecStats> m_stats; // Null = not recorded
+    std::vector<uint8_t> m_body;  // Encoded readings, capacity reused across batches
+    uint32_t m_count;
+
+    // Last appended reading, the DELTA reference of the next one
+    uint32_t m_prevSensor;
+    uint16_t m_prevCompany;
+    uint16_t m_prevZone;
+    int64_t m_prevCo2;
+    uint64_t m_prevTimestamp;
+};
+
+class CO2BatchDecoder
+{
+  public:
+    CO2BatchDecoder()
+        : m_truncated(false)
+    {
+    }
+
+    /**
+     * @param config Modeled decoding cost
+     * @param stats Shared counters (null = not recorded)
+     */
+    void SetCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+    {
+        m_config = config;
+        m_stats = stats;
+    }
+
+    const BatchCodecConfig& GetConfig(void) const
+    {
+        return m_config;
+    }
+
+    /**
+     * Decode a batch datagram into GetReadings()
+     * Decoding stops at the first incomplete reading; IsTruncated() then
+     * tells that fewer readings than announced were recovered.
+     * @param packet Datagram starting with a CO2BatchHeader
+     * @return Readings decoded
+     */
+    uint32_t Decode(Ptr<const Packet> packet)
+    {
+        batchcodec::Clock::time_point start;
+        if (m_stats)
+        {
+            start = batchcodec::Clock::now();
+        }
+        m_readings.clear();
+        packet->PeekHeader(m_header);
+        m_data.resize(packet->GetSize());
+        packet->CopyData(m_data.data(), m_data.size());
+
+        uint32_t count = m_header.GetCount();
+        m_readings.reserve(count);
+        const uint8_t* data = m_data.data();
+        uint32_t size = m_data.size();
+        uint32_t pos = CO2BatchHeader::SERIALIZED_SIZE;
+        if (m_header.GetCodec() == static_cast<uint8_t>(BatchCodec::RAW))
+        {
+            DecodeRaw(data, size, pos, count);
+        }
+        else if (m_header.GetCodec() == static_cast<uint8_t>(BatchCodec::DELTA))
+        {
+            DecodeDelta(data, size, pos, count);
+        }
+        m_truncated = m_readings.size() < count;
+
+        if (m_stats)
+        {
+            m_stats->decodeWallSeconds +=
+                std::chrono::duration<double>(batchcodec::Clock::now() - start).count();
+            m_stats->batchesDecoded++;
+            m_stats->readingsDecoded += m_readings.size();
+            m_stats->decodeSimSeconds +=
+                (m_config.decodeCost * static_cast<uint64_t>(m_readings.size())).GetSeconds();
+        }
+        return m_readings.size();
+    }
+
+    /** @return Header of the last decoded batch */
+    const CO2BatchHeader& GetHeader(void) const
+    {
+        return m_header;
+    }
+
+    /** @return Readings of the last decoded batch */
+    const std::vector<CO2ReadingHeader>& GetReadings(void) const
+    {
+        return m_readings;
+    }
+
+    /** @return true if the last batch had fewer readings than announced, or an unknown codec */
+    bool IsTruncated(void) const
+    {
+        return m_truncated;
+    }
+
+  private:
+    void DecodeRaw(const uint8_t* data, uint32_t size, uint32_t pos, uint32_t count)
+    {
+        using namespace batchcodec;
+        CO2ReadingHeader reading;
+        for (uint32_t i = 0; i < count && pos + CO2ReadingHeader::SERIALIZED_SIZE <= size; ++i)
+        {
+            const uint8_t* in = data + pos;
+            reading.SetCompanyId(ReadBigEndian(in + 2, 2));
+            reading.SetZoneId(ReadBigEndian(in + 4, 2));
+            reading.SetSensorId(ReadBigEndian(in + 6, 4));
+            reading.SetCo2CentiPpm(ReadBigEndian(in + 10, 4));
+            reading.SetTimestamp(ReadBigEndian(in + 14, 8));
+            m_readings.push_back(reading);
+            pos += CO2ReadingHeader::SERIALIZED_SIZE;
+        }
+    }
+
+    void DecodeDelta(const uint8_t* data, uint32_t size, uint32_t pos, uint32_t count)
+    {
+        using namespace batchcodec;
+        uint64_t quantum = 0;
+        if (!ReadVarint(data, size, pos, quantum) || quantum == 0)
+        {
+            return;
+        }
+
+        CO2ReadingHeader reading;
+        uint32_t sensor = 0;
+        uint64_t company = 0;
+        uint64_t zone = 0;
+        int64_t co2 = 0;
+        uint64_t timestamp = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t head = 0;
+            uint64_t co2Delta = 0;
+            uint64_t timeDelta = 0;
+            if (!ReadVarint(data, size, pos, head) ||
+                ((head & 1) && !ReadVarint(data, size, pos, company)) ||
+                ((head & 2) && !ReadVarint(data, size, pos, zone)) ||
+                !ReadVarint(data, size, pos, co2Delta) || !ReadVarint(data, size, pos, timeDelta))
+            {
+                return;
+            }
+            sensor += static_cast<uint32_t>(UnZigZag(head >> 2));
+            co2 += UnZigZag(co2Delta);
+            timestamp += static_cast<uint64_t>(UnZigZag(timeDelta));
+
+            int64_t centiPpm = std::min<int64_t>(co2 * static_cast<int64_t>(quantum), UINT32_MAX);
+            reading.SetSensorId(sensor);
+            reading.SetCompanyId(static_cast<uint16_t>(company));
+            reading.SetZoneId(static_cast<uint16_t>(zone));
+            reading.SetCo2CentiPpm(centiPpm > 0 ? static_cast<uint32_t>(centiPpm) : 0);
+            reading.SetTimestamp(timestamp);
+            m_readings.push_back(reading);
+        }
+    }
+
+    BatchCodecConfig m_config;
+    Ptr<BatchCodecStats> m_stats; // Null = not recorded
+    CO2BatchHeader m_header;
+    std::vector<uint8_t> m_data; // Flat copy of the datagram, capacity reused
+    std::vector<CO2ReadingHeader> m_readings;
+    bool m_truncated;
+};
+
+} // namespace ns3
+
+#endif /* CO2_BATCH_CODEC_H */
@@ -0,0 +1,152 @@
+/*
+ * CO2 Batch Header
+ *
+ * Prefix for datagrams that carry several CO2 readings at once, e.g. when a
+ * Local AP aggregates the readings of its zone before forwarding them over
+ * the backbone. The header is followed by Count readings, encoded as
+ * selected by the codec byte (see co2-batch-codec.h; RAW is Count plain
+ * CO2ReadingHeaders).
+ *
+ * Wire format (network byte order, 7 bytes):
+ * [Magic:1][Version:1][Codec:1][ZoneID:2][Count:2]
+ *
+ * Version 1 had no codec byte and always carried RAW readings.
+ *
+ * The magic byte never collides with the CO2ReadingHeader version byte or
+ * with the first character of the legacy text payload, so receivers can
+ * tell single readings and batches apart by peeking one byte.
+ */
+
+#ifndef CO2_BATCH_HEADER_H
+#define CO2_BATCH_HEADER_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <ostream>
+
+namespace ns3
+{
+
+class CO2BatchHeader : public Header
+{
+  public:
+    static constexpr uint8_t MAGIC = 0xB1;         //!< Identifies a batch datagram
+    static constexpr uint8_t VERSION = 2;          //!< Current wire format version
+    static constexpr uint32_t SERIALIZED_SIZE = 7; //!< Bytes on the wire
+
+    CO2BatchHeader()
+        : m_version(VERSION),
+          m_codec(0),
+          m_zoneId(0),
+          m_count(0)
+    {
+    }
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::CO2BatchHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<CO2BatchHeader>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId(void) const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize(void) const override
+    {
+        return SERIALIZED_SIZE;
+    }
+
+    void Serialize(Buffer::Iterator start) const override
+    {
+        start.WriteU8(MAGIC);
+        start.WriteU8(m_version);
+        start.WriteU8(m_codec);
+        start.WriteHtonU16(m_zoneId);
+        start.WriteHtonU16(m_count);
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override
+    {
+        start.ReadU8(); // Magic, checked by IsBatchPayload()
+        m_version = start.ReadU8();
+        m_codec = start.ReadU8();
+        m_zoneId = start.ReadNtohU16();
+        m_count = start.ReadNtohU16();
+        return SERIALIZED_SIZE;
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "batch v=" << static_cast<uint32_t>(m_version)
+           << " codec=" << static_cast<uint32_t>(m_codec) << " zone=" << m_zoneId
+           << " count=" << m_count;
+    }
+
+    /**
+     * Check whether a packet starts with a batch header
+     * @param packet Received packet
+     * @return true if the first byte is the batch magic
+     */
+    static bool IsBatchPayload(Ptr<const Packet> packet)
+    {
+        uint8_t first = 0;
+        return packet->GetSize() >= SERIALIZED_SIZE && packet->CopyData(&first, 1) == 1 &&
+               first == MAGIC;
+    }
+
+    uint8_t GetVersion(void) const
+    {
+        return m_version;
+    }
+
+    /**
+     * Set the encoding of the readings that follow
+     * @param codec A BatchCodec value
+     */
+    void SetCodec(uint8_t codec)
+    {
+        m_codec = codec;
+    }
+
+    uint8_t GetCodec(void) const
+    {
+        return m_codec;
+    }
+
+    void SetZoneId(uint16_t zoneId)
+    {
+        m_zoneId = zoneId;
+    }
+
+    uint16_t GetZoneId(void) const
+    {
+        return m_zoneId;
+    }
+
+    void SetCount(uint16_t count)
+    {
+        m_count = count;
+    }
+
+    uint16_t GetCount(void) const
+    {
+        return m_count;
+    }
+
+  private:
+    uint8_t m_version;
+    uint8_t m_codec; // Encoding of the readings (BatchCodec)
+    uint16_t m_zoneId;
+    uint16_t m_count; // Number of readings following the header
+};
+
+} // namespace ns3
+
+#endif /* CO2_BATCH_HEADER_H */
@@ -0,0 +1,318 @@
+/*
+ * CO2 Reading Header
+ *
+ * Fixed-width binary encoding of a single CO2 sensor reading, shared by both
+ * carbon trading scenarios. It replaces the ASCII
+ * "SENSOR:..,COMPANY:..,ZONE:..,CO2:..,TIME:.." payload (still available
+ * through FormatTextReading() and ParseTextReading()), which is expensive to
+ * format and parse and wastes airtime on the 1 Mbps 802.11b links.
+ *
+ * Wire format (network byte order, 22 bytes):
+ * [Version:1][Flags:1][CompanyID:2][ZoneID:2][SensorID:4][CO2:4][Timestamp:8]
+ *
+ * - CO2 is carried as fixed-point centi-ppm (0.01 ppm resolution)
+ * - Timestamp is the sensor send time in microseconds
+ *
+ * Copy this file next to the scenario sources in the ns-3 scratch/ folder.
+ */
+
+#ifndef CO2_READING_HEADER_H
+#define CO2_READING_HEADER_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * Format used by sensors when encoding readings.
+ * TEXT keeps the legacy ASCII payload available for comparison runs.
+ */
+enum class PayloadFormat
+{
+    BINARY,
+    TEXT
+};
+
+/**
+ * Parse a payload format name ("binary" or "text")
+ * @param name Format name from the command line
+ * @return The matching PayloadFormat (aborts on unknown names)
+ */
+inline PayloadFormat
+ParsePayloadFormat(const std::string& name)
+{
+    if (name == "binary")
+    {
+        return PayloadFormat::BINARY;
+    }
+    if (name == "text")
+    {
+        return PayloadFormat::TEXT;
+    }
+    NS_ABORT_MSG("Unknown payload format '" << name << "' (expected binary or text)");
+    return PayloadFormat::BINARY;
+}
+
+class CO2ReadingHeader : public Header
+{
+  public:
+    static constexpr uint8_t VERSION = 1;          //!< Current wire format version
+    static constexpr uint32_t SERIALIZED_SIZE = 22; //!< Bytes on the wire
+
+    CO2ReadingHeader()
+        : m_version(VERSION),
+          m_flags(0),
+          m_companyId(0),
+          m_zoneId(0),
+          m_sensorId(0),
+          m_co2CentiPpm(0),
+          m_timestamp(0)
+    {
+    }
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::CO2ReadingHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<CO2ReadingHeader>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId(void) const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize(void) const override
+    {
+        return SERIALIZED_SIZE;
+    }
+
+    void Serialize(Buffer::Iterator start) const override
+    {
+        start.WriteU8(m_version);
+        start.WriteU8(m_flags);
+        start.WriteHtonU16(m_companyId);
+        start.WriteHtonU16(m_zoneId);
+        start.WriteHtonU32(m_sensorId);
+        start.WriteHtonU32(m_co2CentiPpm);
+        start.WriteHtonU64(m_timestamp);
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override
+    {
+        m_version = start.ReadU8();
+        m_flags = start.ReadU8();
+        m_companyId = start.ReadNtohU16();
+        m_zoneId = start.ReadNtohU16();
+        m_sensorId = start.ReadNtohU32();
+        m_co2CentiPpm = start.ReadNtohU32();
+        m_timestamp = start.ReadNtohU64();
+        return SERIALIZED_SIZE;
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "v=" << static_cast<uint32_t>(m_version) << " sensor=" << m_sensorId
+           << " zone=" << m_zoneId << " company=" << m_companyId << " co2=" << GetCo2Ppm()
+           << "ppm time=" << m_timestamp << "us";
+    }
+
+    /**
+     * Check whether a packet starts with a binary reading header
+     * The legacy text payload always starts with an ASCII letter, so the
+     * version byte is enough to tell the two formats apart.
+     * @param packet Received packet
+     * @return true if the first byte matches the current header version
+     */
+    static bool IsBinaryPayload(Ptr<const Packet> packet)
+    {
+        uint8_t first = 0;
+        return packet->GetSize() >= SERIALIZED_SIZE && packet->CopyData(&first, 1) == 1 &&
+               first == VERSION;
+    }
+
+    uint8_t GetVersion(void) const
+    {
+        return m_version;
+    }
+
+    void SetSensorId(uint32_t sensorId)
+    {
+        m_sensorId = sensorId;
+    }
+
+    uint32_t GetSensorId(void) const
+    {
+        return m_sensorId;
+    }
+
+    void SetZoneId(uint16_t zoneId)
+    {
+        m_zoneId = zoneId;
+    }
+
+    uint16_t GetZoneId(void) const
+    {
+        return m_zoneId;
+    }
+
+    void SetCompanyId(uint16_t companyId)
+    {
+        m_companyId = companyId;
+    }
+
+    uint16_t GetCompanyId(void) const
+    {
+        return m_companyId;
+    }
+
+    /**
+     * Set the CO2 level, rounded to the 0.01 ppm wire resolution
+     * @param ppm CO2 level in ppm (negative values are clamped to 0)
+     */
+    void SetCo2Ppm(double ppm)
+    {
+        m_co2CentiPpm = (ppm > 0.0) ? static_cast<uint32_t>(std::lround(ppm * 100.0)) : 0;
+    }
+
+    double GetCo2Ppm(void) const
+    {
+        return m_co2CentiPpm / 100.0;
+    }
+
+    /**
+     * Set the CO2 level in wire units
+     * @param centiPpm CO2 level in 0.01 ppm units
+     */
+    void SetCo2CentiPpm(uint32_t centiPpm)
+    {
+        m_co2CentiPpm = centiPpm;
+    }
+
+    /** @return CO2 level in 0.01 ppm units */
+    uint32_t GetCo2CentiPpm(void) const
+    {
+        return m_co2CentiPpm;
+    }
+
+    /**
+     * Set the send timestamp
+     * @param timestamp Sensor send time in microseconds
+     */
+    void SetTimestamp(uint64_t timestamp)
+    {
+        m_timestamp = timestamp;
+    }
+
+    uint64_t GetTimestamp(void) const
+    {
+        return m_timestamp;
+    }
+
+  private:
+    uint8_t m_version;
+    uint8_t m_flags; // Reserved, always 0 in version 1
+    uint16_t m_companyId;
+    uint16_t m_zoneId;
+    uint32_t m_sensorId;
+    uint32_t m_co2CentiPpm; // CO2 level in 0.01 ppm units
+    uint64_t m_timestamp;   // Send time in microseconds
+};
+
+/**
+ * Longest legacy ASCII payload: ten-digit sensor ID, five-digit company and
+ * zone IDs, six significant CO2 digits with an exponent and a 20-digit
+ * timestamp take 84 bytes. Longer payloads are not readings.
+ */
+static constexpr uint32_t MAX_TEXT_READING_SIZE = 96;
+
+/**
+ * Encode a reading in the legacy ASCII payload
+ * "SENSOR:<id>,COMPANY:<id>,ZONE:<id>,CO2:<ppm>,TIME:<us>"
+ * Formats into the caller's buffer, so a sensor can build the payload on its
+ * stack without touching the heap.
+ * @param reading Reading to encode (zone 0 in the single-tier network)
+ * @param buffer Output buffer; the payload is NUL-terminated in it
+ * @return Payload length, without the terminating NUL
+ */
+inline uint32_t
+FormatTextReading(const CO2ReadingHeader& reading, char (&buffer)[MAX_TEXT_READING_SIZE + 1])
+{
+    int length = std::snprintf(buffer,
+                               sizeof(buffer),
+                               "SENSOR:%u,COMPANY:%u,ZONE:%u,CO2:%g,TIME:%" PRIu64,
+                               reading.GetSensorId(),
+                               static_cast<uint32_t>(reading.GetCompanyId()),
+                               static_cast<uint32_t>(reading.GetZoneId()),
+                               reading.GetCo2Ppm(),
+                               reading.GetTimestamp());
+    NS_ASSERT(length > 0 && static_cast<uint32_t>(length) <= MAX_TEXT_READING_SIZE);
+    return static_cast<uint32_t>(length);
+}
+
+/**
+ * Decode a legacy ASCII payload (see FormatTextReading())
+ * Fields are looked up by key, so their order does not matter. The payload
+ * is copied to the stack once; one longer than MAX_TEXT_READING_SIZE is
+ * rejected rather than cut short, which could leave a truncated number.
+ * @param packet Received packet
+ * @param reading Decoded reading
+ * @return false if the payload is too long, or a field is missing or not a number
+ */
+inline bool
+ParseTextReading(Ptr<const Packet> packet, CO2ReadingHeader& reading)
+{
+    if (packet->GetSize() > MAX_TEXT_READING_SIZE)
+    {
+        return false;
+    }
+    char buffer[MAX_TEXT_READING_SIZE + 1];
+    uint32_t size = packet->CopyData(reinterpret_cast<uint8_t*>(buffer), MAX_TEXT_READING_SIZE);
+    buffer[size] = '\0';
+
+    // Each field runs from its key to the next ',' (or the end of the payload)
+    auto field = [&buffer](const char* key, double& value) {
+        const char* start = std::strstr(buffer, key);
+        if (!start)
+        {
+            return false;
+        }
+        start += std::strlen(key);
+        char* end = nullptr;
+        value = std::strtod(start, &end);
+        return end != start && (*end == ',' || *end == '\0');
+    };
+    double sensorId = 0;
+    double companyId = 0;
+    double zoneId = 0;
+    double co2 = 0;
+    double timestamp = 0;
+    if (!field("SENSOR:", sensorId) || !field("COMPANY:", companyId) || !field("ZONE:", zoneId) ||
+        !field("CO2:", co2) || !field("TIME:", timestamp))
+    {
+        return false;
+    }
+    reading.SetSensorId(static_cast<uint32_t>(sensorId));
+    reading.SetCompanyId(static_cast<uint16_t>(companyId));
+    reading.SetZoneId(static_cast<uint16_t>(zoneId));
+    reading.SetCo2Ppm(co2);
+    reading.SetTimestamp(static_cast<uint64_t>(timestamp));
+    return true;
+}
+
+} // namespace ns3
+
+#endif /* CO2_READING_HEADER_H */
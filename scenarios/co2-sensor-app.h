@@ -0,0 +1,645 @@
+/*
+ * CO2 Sensor Application
+ *
+ * IoT CO2 sensor shared by both carbon trading scenarios. It:
+ * - Periodically generates CO2 readings (emission model or trace replay)
+ * - Packages them with sensor, company and zone IDs
+ * - Transmits them via UDP to its sink: the gateway in the single-tier
+ *   network, the zone's local AP in the hierarchical one
+ * - Optionally numbers its datagrams and retransmits those the sink does
+ *   not acknowledge (see reliable-delivery.h)
+ *
+ * In a real carbon trading scenario, these sensors would be deployed at:
+ * - Manufacturing facilities
+ * - Transportation hubs
+ * - Energy production sites
+ * - Agricultural operations
+ *
+ * Log messages go to the "CO2SensorApplication" log component.
+ */
+
+#ifndef CO2_SENSOR_APP_H
+#define CO2_SENSOR_APP_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include "alloc-counter.h"
+#include "co2-batch-codec.h"
+#include "co2-reading-header.h"
+#include "co2-trace.h"
+#include "emission-model.h"
+#include "event-log.h"
+#include "flow-metrics-collector.h"
+#include "reliable-delivery.h"
+#include "sensor-tick-scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace ns3
+{
+
+static LogComponent g_co2SensorApplicationLog("CO2SensorApplication", __FILE__);
+
+/**
+ * Transmissions of a sensor fleet: readings, the datagrams carrying them
+ * (equal unless sensors batch), and the sensors that sent at least one, so a
+ * run too short for the start spread shows it. Received-side accounting lives
+ * in the gateways.
+ */
+struct SensorSendStats : public SimpleRefCount<SensorSendStats>
+{
+    uint64_t readings = 0;
+    uint64_t datagrams = 0;
+    uint64_t activeSensors = 0;
+};
+
+class CO2SensorApplication : public Application
+{
+  public:
+    CO2SensorApplication()
+        : NS_LOG_TEMPLATE_DEFINE("CO2SensorApplication"),
+          m_socket(0),
+          m_sensorId(0),
+          m_companyId(0),
+          m_zoneId(0),
+          m_baselineCO2(400.0),     // Normal atmospheric CO2 ~400 ppm
+          m_interval(Seconds(5.0)), // Send reading every 5 seconds
+          m_running(false),
+          m_transmitted(false),
+          m_payloadFormat(PayloadFormat::BINARY),
+          m_batchMaxReadings(1),
+          m_ackSocket(0),
+          m_ackPort(0)
+    {
+    }
+
+    ~CO2SensorApplication() override
+    {
+        m_socket = 0;
+        m_ackSocket = 0;
+    }
+
+    /**
+     * Setup the sensor application
+     * @param socket UDP socket for transmission
+     * @param sinkAddress Gateway or local AP address and port
+     * @param sensorId Unique sensor identifier
+     * @param companyId Company/organization identifier
+     * @param zoneId Zone of the sensor (0 in the single-tier network)
+     * @param baselineCO2 Baseline CO2 level for this sensor location
+     */
+    void Setup(Ptr<Socket> socket,
+               Address sinkAddress,
+               uint32_t sensorId,
+               uint32_t companyId,
+               uint32_t zoneId,
+               double baselineCO2)
+    {
+        m_socket = socket;
+        m_sinkAddress = sinkAddress;
+        m_sensorId = sensorId;
+        m_companyId = companyId;
+        m_zoneId = zoneId;
+        m_baselineCO2 = baselineCO2;
+    }
+
+    /**
+     * Select the payload encoding (binary header by default)
+     * @param format BINARY for CO2ReadingHeader, TEXT for the legacy ASCII payload
+     */
+    void SetPayloadFormat(PayloadFormat format)
+    {
+        m_payloadFormat = format;
+    }
+
+    /**
+     * Select the emission model that produces this sensor's readings
+     * @param model Model instance owned by this sensor (uniform jitter if never set)
+     */
+    void SetEmissionModel(Ptr<EmissionModel> model)
+    {
+        m_emissionModel = model;
+    }
+
+    /**
+     * Replay recorded readings instead of using the emission model
+     * Send times come from the trace; records before the start time are skipped.
+     * @param trace Mapped trace file (shared by all sensors)
+     * @param slice This sensor's readings within the trace
+     * @param offset Simulation time at which the trace start is replayed
+     */
+    void SetTrace(Ptr<CO2TraceFile> trace, CO2TraceSlice slice, Time offset)
+    {
+        m_trace = trace;
+        m_traceSlice = slice;
+        m_traceOffset = offset;
+    }
+
+    /**
+     * Drive periodic readings from a shared tick scheduler instead of a
+     * per-sensor event (trace replay keeps its own schedule)
+     * @param scheduler Scheduler shared by the sensor fleet
+     */
+    void SetTickScheduler(Ptr<SensorTickScheduler> scheduler)
+    {
+        m_tickScheduler = scheduler;
+    }
+
+    /**
+     * Set the reading period (trace replay keeps the recorded timestamps)
+     * @param interval Time between readings
+     */
+    void SetInterval(Time interval)
+    {
+        m_interval = interval;
+    }
+
+    /**
+     * Count the transmissions of this sensor
+     * @param stats Counters shared by the sensor fleet (null = off)
+     */
+    void SetSendStats(Ptr<SensorSendStats> stats)
+    {
+        m_sendStats = stats;
+    }
+
+    /**
+     * Report sends to the windowed flow metrics
+     * @param metrics Collector shared by all applications (null = off)
+     */
+    void SetMetrics(Ptr<FlowMetricsCollector> metrics)
+    {
+        m_metrics = metrics;
+    }
+
+    /**
+     * Record sends in a binary event log
+     * @param log Log shared by all applications (null = off)
+     */
+    void SetEventLog(Ptr<EventLog> log)
+    {
+        m_eventLog = log;
+    }
+
+    /**
+     * Buffer binary readings and send them as one CO2BatchHeader datagram,
+     * trading latency for fewer frames on the shared medium
+     * Readings still buffered when the sensor stops are discarded.
+     * @param maxReadings Send once this many readings are buffered (<= 1 disables batching)
+     * @param maxAge Send at most this long after the first buffered reading (zero = no limit)
+     */
+    void SetBatching(uint32_t maxReadings, Time maxAge)
+    {
+        m_batchMaxReadings = maxReadings;
+        m_batchMaxAge = maxAge;
+    }
+
+    /**
+     * Encoding of the sensor batches
+     * @param config Codec and its modeled cost
+     * @param stats Counters shared by all encoders and decoders (null = off)
+     */
+    void SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+    {
+        m_batch.SetCodec(config, stats);
+    }
+
+    /**
+     * Number every datagram and retransmit it until the sink acknowledges it
+     * @param ackSocket UDP socket the sink's ACK broadcasts are received on
+     * @param ackPort Port of the ACK broadcasts
+     * @param config Retransmission timeout and retry limit
+     * @param stats Counters shared by all senders and receivers (null = off)
+     */
+    void SetReliability(Ptr<Socket> ackSocket,
+                        uint16_t ackPort,
+                        const ReliabilityConfig& config,
+                        Ptr<ReliabilityStats> stats)
+    {
+        m_ackSocket = ackSocket;
+        m_ackPort = ackPort;
+        m_window.SetConfig(config, stats);
+    }
+
+  private:
+    void StartApplication(void) override
+    {
+        m_running = true;
+        m_socket->Bind();
+        m_socket->Connect(m_sinkAddress);
+        m_batch.Clear();
+        if (m_ackSocket)
+        {
+            m_ackSocket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_ackPort));
+            m_ackSocket->SetRecvCallback(MakeCallback(&CO2SensorApplication::HandleAck, this));
+        }
+
+        NS_LOG_INFO("CO2 Sensor " << m_sensorId << " (Company " << m_companyId << ", Zone "
+                                  << m_zoneId << ") started at " << Simulator::Now().GetSeconds()
+                                  << "s");
+
+        if (m_trace)
+        {
+            // Replay mode: skip records older than the start time, then follow the trace
+            while (!m_traceSlice.IsEmpty() &&
+                   m_trace->GetReplayTime(*m_traceSlice.begin) + m_traceOffset < Simulator::Now())
+            {
+                ++m_traceSlice.begin;
+            }
+            ScheduleNextReading();
+            return;
+        }
+
+        if (!m_emissionModel)
+        {
+            m_emissionModel = CreateObject<UniformEmissionModel>();
+        }
+        m_emissionModel->Start(m_baselineCO2, Simulator::Now(), m_interval);
+
+        // Send first reading immediately
+        SendCO2Reading();
+    }
+
+    void StopApplication(void) override
+    {
+        m_running = false;
+
+        if (m_sendEvent.IsPending())
+        {
+            Simulator::Cancel(m_sendEvent);
+        }
+        if (m_flushEvent.IsPending())
+        {
+            Simulator::Cancel(m_flushEvent);
+        }
+        if (m_encodeEvent.IsPending())
+        {
+            // A batch still encoding is not sent once the socket is closed
+            Simulator::Cancel(m_encodeEvent);
+        }
+        if (m_retransmitEvent.IsPending())
+        {
+            Simulator::Cancel(m_retransmitEvent);
+        }
+        if (m_tickScheduler)
+        {
+            m_tickScheduler->Unregister(m_tickHandle);
+        }
+        if (m_socket)
+        {
+            m_socket->Close();
+        }
+        if (m_ackSocket)
+        {
+            m_ackSocket->Close();
+            m_ackSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        }
+
+        NS_LOG_INFO("CO2 Sensor " << m_sensorId << " stopped at " << Simulator::Now().GetSeconds()
+                                  << "s");
+    }
+
+    /**
+     * Generate realistic CO2 value
+     * Pulls the next sample from the sensor's emission model, which adds the
+     * variation (±50 ppm uniform by default) and keeps the value in the
+     * realistic 300-3000 ppm range. In replay mode the recorded value is used as-is.
+     */
+    double GenerateCO2Value(void)
+    {
+        if (m_trace)
+        {
+            return (m_traceSlice.begin++)->co2;
+        }
+        return m_emissionModel->NextValue();
+    }
+
+    /**
+     * Generate and send CO2 sensor reading
+     * Simulates reading from physical CO2 sensor and transmitting to the sink
+     */
+    void SendCO2Reading(void)
+    {
+        /*
+         * Carbon Trading Data Packet Format (see CO2ReadingHeader):
+         * [Version:1][Flags:1][CompanyID:2][ZoneID:2][SensorID:4][CO2:4][Timestamp:8]
+         *
+         * This packet contains all necessary information for carbon accounting:
+         * - Which sensor detected the emission (location tracking)
+         * - Which company/facility owns the sensor (accountability)
+         * - CO2 level in ppm (carbon footprint data)
+         * - When the reading was taken (temporal tracking)
+         */
+        double co2Value = GenerateCO2Value();
+
+        NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: Sensor " << m_sensorId
+                             << " (Company " << m_companyId << ", Zone " << m_zoneId
+                             << ") read CO2: " << co2Value << " ppm");
+
+        CO2ReadingHeader reading;
+        reading.SetSensorId(m_sensorId);
+        reading.SetCompanyId(m_companyId);
+        reading.SetZoneId(m_zoneId);
+        reading.SetCo2Ppm(co2Value);
+        reading.SetTimestamp(Simulator::Now().GetMicroSeconds());
+
+        // Transmit the reading, or buffer it for the next batch
+        if (m_batchMaxReadings > 1)
+        {
+            AddToBatch(reading);
+        }
+        else
+        {
+            Transmit(EncodeReading(reading), 1);
+        }
+
+        // Schedule next reading
+        if (m_running)
+        {
+            ScheduleNextReading();
+        }
+    }
+
+    /**
+     * Build the datagram of a single reading
+     * The text payload is formatted on the stack, so the Packet is the only
+     * allocation either format makes.
+     * @param reading Reading to send
+     * @return Datagram payload
+     */
+    Ptr<Packet> EncodeReading(const CO2ReadingHeader& reading)
+    {
+        AllocScope scope(ALLOC_SENSOR_ENCODE);
+        if (m_payloadFormat == PayloadFormat::TEXT)
+        {
+            char text[MAX_TEXT_READING_SIZE + 1];
+            uint32_t size = FormatTextReading(reading, text);
+            return Create<Packet>(reinterpret_cast<const uint8_t*>(text), size);
+        }
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(reading);
+        return packet;
+    }
+
+    /**
+     * Send one datagram to the sink and update the counters
+     * @param packet Single reading or batch
+     * @param readings Readings in the datagram
+     */
+    void Transmit(Ptr<Packet> packet, uint32_t readings)
+    {
+        if (!m_running)
+        {
+            // An earlier batch whose encoding outlived the application
+            return;
+        }
+        bool sent;
+        if (m_ackSocket)
+        {
+            // Failed sends stay in the window and are retried like losses
+            sent = SendSequenced(packet, m_window.Push(packet));
+            ScheduleRetransmission();
+        }
+        else
+        {
+            sent = m_socket->Send(packet) > 0;
+        }
+        if (sent)
+        {
+            if (m_sendStats)
+            {
+                m_sendStats->readings += readings;
+                m_sendStats->datagrams++;
+                if (!m_transmitted)
+                {
+                    m_sendStats->activeSensors++;
+                }
+            }
+            m_transmitted = true;
+            if (m_metrics)
+            {
+                m_metrics->RecordSend(m_sensorId, m_zoneId, readings);
+            }
+            NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: Sensor " << m_sensorId
+                                 << " transmitted " << readings << " reading(s) in "
+                                 << packet->GetSize() << " bytes");
+        }
+        else
+        {
+            NS_LOG_WARN("Sensor " << m_sensorId << " failed to send packet");
+        }
+        if (m_eventLog)
+        {
+            m_eventLog->Record(sent ? EVENT_SENSOR_SEND : EVENT_SENSOR_SEND_FAIL,
+                               GetNode()->GetId(),
+                               m_sensorId,
+                               m_zoneId,
+                               packet->GetSize());
+        }
+    }
+
+    /**
+     * Send a copy of a tracked datagram behind its sequence header
+     * @param packet Datagram as kept in the retransmit window
+     * @param sequence Its sequence number
+     * @return true if the socket accepted it
+     */
+    bool SendSequenced(Ptr<Packet> packet, uint32_t sequence)
+    {
+        CO2SequenceHeader header;
+        header.SetSensorId(m_sensorId);
+        header.SetSequence(sequence);
+        Ptr<Packet> copy = packet->Copy();
+        copy->AddHeader(header);
+        return m_socket->Send(copy) > 0;
+    }
+
+    /**
+     * Resend every datagram whose timeout expired, then wait for the next one
+     */
+    void Retransmit(void)
+    {
+        uint32_t sequence = 0;
+        Ptr<Packet> packet;
+        while ((packet = m_window.NextRetransmission(sequence)))
+        {
+            NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: Sensor " << m_sensorId
+                                 << " retransmitting datagram " << sequence);
+            SendSequenced(packet, sequence);
+        }
+        ScheduleRetransmission();
+    }
+
+    /**
+     * Arm the retransmission timer for the earliest pending timeout. A pending
+     * timer is kept unless that timeout comes before it (a new datagram's RTO
+     * can be shorter than what is left of a backed-off one).
+     */
+    void ScheduleRetransmission(void)
+    {
+        Time next = m_window.GetNextDeadline();
+        if (next == Time::Max() || !m_running)
+        {
+            return;
+        }
+        if (m_retransmitEvent.IsPending())
+        {
+            if (next >= Simulator::Now() + Simulator::GetDelayLeft(m_retransmitEvent))
+            {
+                return;
+            }
+            Simulator::Cancel(m_retransmitEvent);
+        }
+        Time delay = std::max(next - Simulator::Now(), Seconds(0.0));
+        m_retransmitEvent = Simulator::Schedule(delay, &CO2SensorApplication::Retransmit, this);
+    }
+
+    /**
+     * Release the datagrams acknowledged by the sink's ACK broadcasts
+     */
+    void HandleAck(Ptr<Socket> socket)
+    {
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from)))
+        {
+            AckEntry entry;
+            if (CO2AckHeader::FindEntry(packet, m_sensorId, entry))
+            {
+                m_window.Acknowledge(entry);
+            }
+        }
+    }
+
+    /**
+     * Append a binary reading to the pending batch, sending it when full
+     * @param reading Reading to buffer
+     */
+    void AddToBatch(const CO2ReadingHeader& reading)
+    {
+        m_batch.Append(reading);
+
+        if (m_batch.GetCount() == 1 && !m_batchMaxAge.IsZero())
+        {
+            m_flushEvent =
+                Simulator::Schedule(m_batchMaxAge, &CO2SensorApplication::FlushBatch, this);
+        }
+        if (m_batch.GetCount() >= m_batchMaxReadings)
+        {
+            FlushBatch();
+        }
+    }
+
+    /**
+     * Send the pending batch, if any
+     */
+    void FlushBatch(void)
+    {
+        if (m_flushEvent.IsPending())
+        {
+            Simulator::Cancel(m_flushEvent);
+        }
+        uint32_t count = m_batch.GetCount();
+        if (count == 0)
+        {
+            return;
+        }
+
+        // The datagram leaves once the modeled encoding time has passed
+        Time encodeTime = m_batch.GetConfig().encodeCost * count;
+        Ptr<Packet> batch = m_batch.Finish(m_zoneId);
+        if (encodeTime.IsZero())
+        {
+            Transmit(batch, count);
+        }
+        else
+        {
+            m_encodeEvent =
+                Simulator::Schedule(encodeTime, &CO2SensorApplication::Transmit, this, batch, count);
+        }
+    }
+
+    /**
+     * Schedule the next reading: m_interval later, or at the next trace record
+     */
+    void ScheduleNextReading(void)
+    {
+        if (!m_trace && m_tickScheduler)
+        {
+            // Register once; the scheduler keeps ticking every m_interval from now on
+            if (!m_tickHandle.IsValid())
+            {
+                m_tickHandle = m_tickScheduler->Register(
+                    m_interval,
+                    Simulator::Now() + m_interval,
+                    MakeCallback(&CO2SensorApplication::SendCO2Reading, this));
+            }
+            return;
+        }
+
+        if (!m_trace)
+        {
+            m_sendEvent =
+                Simulator::Schedule(m_interval, &CO2SensorApplication::SendCO2Reading, this);
+            return;
+        }
+
+        if (m_traceSlice.IsEmpty())
+        {
+            NS_LOG_INFO("CO2 Sensor " << m_sensorId << " reached the end of its trace");
+            return;
+        }
+
+        Time sendTime = m_trace->GetReplayTime(*m_traceSlice.begin) + m_traceOffset;
+        Time delay = std::max(sendTime - Simulator::Now(), Seconds(0.0));
+        m_sendEvent = Simulator::Schedule(delay, &CO2SensorApplication::SendCO2Reading, this);
+    }
+
+    NS_LOG_TEMPLATE_DECLARE; // Header-only class: log through g_co2SensorApplicationLog
+
+    Ptr<Socket> m_socket;
+    Address m_sinkAddress;
+    uint32_t m_sensorId;
+    uint32_t m_companyId;
+    uint32_t m_zoneId;
+    double m_baselineCO2; // Baseline CO2 level (ppm)
+    EventId m_sendEvent;
+    Time m_interval; // Time between sensor readings
+    bool m_running;
+    bool m_transmitted; // A datagram has been sent (counted once in m_sendStats)
+    PayloadFormat m_payloadFormat;
+    Ptr<EmissionModel> m_emissionModel; // Source of CO2 readings
+
+    // Trace replay state (m_trace is null when the emission model is used)
+    Ptr<CO2TraceFile> m_trace;
+    CO2TraceSlice m_traceSlice; // Remaining records of this sensor
+    Time m_traceOffset;
+
+    // Shared tick scheduler (null when the sensor schedules its own events)
+    Ptr<SensorTickScheduler> m_tickScheduler;
+    SensorTickScheduler::Handle m_tickHandle;
+
+    Ptr<SensorSendStats> m_sendStats;    // Fleet-wide transmission counters
+    Ptr<FlowMetricsCollector> m_metrics; // Null unless the tracing profile collects metrics
+    Ptr<EventLog> m_eventLog;            // Null unless --eventLog is set
+
+    // Sensor-side batching (one datagram per reading unless m_batchMaxReadings > 1)
+    uint32_t m_batchMaxReadings;
+    Time m_batchMaxAge;
+    CO2BatchEncoder m_batch; // Readings buffered so far
+    EventId m_flushEvent;
+    EventId m_encodeEvent; // Send of the last batch handed to the encoder
+
+    // Reliable delivery (m_ackSocket is null unless --reliable is set)
+    Ptr<Socket> m_ackSocket;
+    uint16_t m_ackPort;
+    RetransmitWindow m_window; // Datagrams waiting for an ACK
+    EventId m_retransmitEvent;
+};
+
+} // namespace ns3
+
+#endif /* CO2_SENSOR_APP_H */
@@ -0,0 +1,222 @@
+/*
+ * CO2 Trace Files
+ *
+ * Compact binary format for recorded CO2 telemetry and a memory-mapped
+ * reader, so CO2SensorApplication can replay real plant data instead of an
+ * emission model. The file is mapped read-only and never copied: each
+ * sensor walks its own contiguous slice and the OS pages records in lazily
+ * as the replay advances, so start-up cost does not grow with trace size.
+ *
+ * File layout (host byte order, written by tools/co2_trace_convert.py):
+ *
+ *   CO2TraceFileHeader            (40 bytes)
+ *   CO2TraceIndexEntry[nSensors]  (24 bytes each, sorted by sensor ID)
+ *   CO2TraceRecord[nRecords]      (16 bytes each, grouped by sensor, time-sorted)
+ *
+ * Timestamps are microseconds; replay time is (timestamp - startTime), so
+ * the earliest reading of the whole trace maps to simulation time zero.
+ */
+
+#ifndef CO2_TRACE_H
+#define CO2_TRACE_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+struct CO2TraceFileHeader
+{
+    char magic[8];        // "CO2TRACE"
+    uint32_t byteOrder;   // 0x01020304 in the writer's byte order
+    uint32_t version;     // Format version (1)
+    uint32_t sensorCount; // Number of index entries
+    uint32_t reserved;
+    uint64_t recordCount; // Total number of records
+    uint64_t startTime;   // Earliest timestamp in the trace (us)
+};
+
+struct CO2TraceIndexEntry
+{
+    uint32_t sensorId;
+    uint32_t reserved;
+    uint64_t firstRecord; // Index of the sensor's first record
+    uint64_t recordCount; // Number of records of this sensor
+};
+
+struct CO2TraceRecord
+{
+    uint64_t timestamp; // Reading time (us)
+    uint32_t sensorId;
+    float co2;          // CO2 level (ppm)
+};
+
+static_assert(sizeof(CO2TraceFileHeader) == 40, "unexpected trace header layout");
+static_assert(sizeof(CO2TraceIndexEntry) == 24, "unexpected trace index layout");
+static_assert(sizeof(CO2TraceRecord) == 16, "unexpected trace record layout");
+
+/**
+ * Contiguous, time-ordered readings of one sensor inside a mapped trace
+ */
+struct CO2TraceSlice
+{
+    const CO2TraceRecord* begin = nullptr;
+    const CO2TraceRecord* end = nullptr;
+
+    bool IsEmpty(void) const
+    {
+        return begin == end;
+    }
+};
+
+class CO2TraceFile : public SimpleRefCount<CO2TraceFile>
+{
+  public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+    /**
+     * Map a trace file read-only (aborts if the file is missing or invalid)
+     * @param path Trace file written by tools/co2_trace_convert.py
+     */
+    explicit CO2TraceFile(const std::string& path)
+        : m_data(nullptr),
+          m_size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Cannot open CO2 trace " << path);
+
+        struct stat st;
+        NS_ABORT_MSG_IF(fstat(fd, &st) != 0, "Cannot stat CO2 trace " << path);
+        m_size = static_cast<size_t>(st.st_size);
+        NS_ABORT_MSG_IF(m_size < sizeof(CO2TraceFileHeader), "CO2 trace " << path << " is truncated");
+
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping stays valid after the descriptor is closed
+        NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot mmap CO2 trace " << path);
+        m_data = static_cast<const uint8_t*>(data);
+
+        const CO2TraceFileHeader* header = GetHeader();
+        NS_ABORT_MSG_IF(std::memcmp(header->magic, "CO2TRACE", 8) != 0,
+                        path << " is not a CO2 trace file");
+        NS_ABORT_MSG_IF(header->byteOrder != BYTE_ORDER_TAG,
+                        "CO2 trace " << path << " was written with a different byte order");
+        NS_ABORT_MSG_IF(header->version != VERSION,
+                        "Unsupported CO2 trace version " << header->version);
+        size_t expected = sizeof(CO2TraceFileHeader) +
+                          header->sensorCount * sizeof(CO2TraceIndexEntry) +
+                          header->recordCount * sizeof(CO2TraceRecord);
+        NS_ABORT_MSG_IF(m_size < expected, "CO2 trace " << path << " is truncated");
+
+        // Sensors replay their slices front to back
+        madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+
+    ~CO2TraceFile()
+    {
+        if (m_data)
+        {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+    }
+
+    CO2TraceFile(const CO2TraceFile&) = delete;
+    CO2TraceFile& operator=(const CO2TraceFile&) = delete;
+
+    uint32_t GetSensorCount(void) const
+    {
+        return GetHeader()->sensorCount;
+    }
+
+    uint64_t GetRecordCount(void) const
+    {
+        return GetHeader()->recordCount;
+    }
+
+    /**
+     * @param record Trace record
+     * @return Replay time of the record relative to the start of the trace
+     */
+    Time GetReplayTime(const CO2TraceRecord& record) const
+    {
+        return MicroSeconds(static_cast<double>(record.timestamp - GetHeader()->startTime));
+    }
+
+    /**
+     * Look up the readings of a recorded sensor ID
+     * @param sensorId Sensor ID as stored in the trace
+     * @return The sensor's slice (empty if the ID is not in the trace)
+     */
+    CO2TraceSlice GetSlice(uint32_t sensorId) const
+    {
+        const CO2TraceIndexEntry* first = GetIndex();
+        const CO2TraceIndexEntry* last = first + GetSensorCount();
+        const CO2TraceIndexEntry* entry =
+            std::lower_bound(first,
+                             last,
+                             sensorId,
+                             [](const CO2TraceIndexEntry& e, uint32_t id) { return e.sensorId < id; });
+        if (entry == last || entry->sensorId != sensorId)
+        {
+            return CO2TraceSlice();
+        }
+        return MakeSlice(*entry);
+    }
+
+    /**
+     * Slice of the n-th recorded sensor, so any fleet size can replay any trace
+     * @param index Position in the index (taken modulo the sensor count)
+     * @return The sensor's slice
+     */
+    CO2TraceSlice GetSliceAt(uint32_t index) const
+    {
+        if (GetSensorCount() == 0)
+        {
+            return CO2TraceSlice();
+        }
+        return MakeSlice(GetIndex()[index % GetSensorCount()]);
+    }
+
+  private:
+    const CO2TraceFileHeader* GetHeader(void) const
+    {
+        return reinterpret_cast<const CO2TraceFileHeader*>(m_data);
+    }
+
+    const CO2TraceIndexEntry* GetIndex(void) const
+    {
+        return reinterpret_cast<const CO2TraceIndexEntry*>(m_data + sizeof(CO2TraceFileHeader));
+    }
+
+    const CO2TraceRecord* GetRecords(void) const
+    {
+        return reinterpret_cast<const CO2TraceRecord*>(
+            m_data + sizeof(CO2TraceFileHeader) + GetSensorCount() * sizeof(CO2TraceIndexEntry));
+    }
+
+    CO2TraceSlice MakeSlice(const CO2TraceIndexEntry& entry) const
+    {
+        CO2TraceSlice slice;
+        uint64_t first = std::min(entry.firstRecord, GetRecordCount());
+        uint64_t last = std::min(entry.firstRecord + entry.recordCount, GetRecordCount());
+        slice.begin = GetRecords() + first;
+        slice.end = GetRecords() + last;
+        return slice;
+    }
+
+    const uint8_t* m_data;
+    size_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* CO2_TRACE_H */
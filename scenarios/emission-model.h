@@ -0,0 +1,468 @@
+/*
+ * CO2 Emission Models
+ *
+ * Pluggable generators for the CO2 values reported by CO2SensorApplication.
+ * Every sensor owns one model instance. The model draws its samples in blocks
+ * of BLOCK_SIZE into a small per-sensor ring buffer, using random variables
+ * that are created once and bound to deterministic streams. This keeps RNG
+ * object creation out of the per-reading path and makes runs reproducible.
+ *
+ * Available models (see CreateEmissionModel()):
+ * - uniform: baseline +/- Amplitude uniform jitter (original behaviour)
+ * - diurnal: sinusoidal day/night curve around the baseline
+ * - shift:   industrial shift pattern (elevated level during working hours)
+ * - ar1:     AR(1) drift around the baseline with Gaussian innovations
+ * - step:    step events (e.g. furnace start-up) on top of uniform jitter
+ *
+ * Model parameters are ns-3 attributes, so they can be changed from the
+ * command line, e.g. --ns3::DiurnalEmissionModel::Period=60s
+ */
+
+#ifndef EMISSION_MODEL_H
+#define EMISSION_MODEL_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+namespace ns3
+{
+
+class EmissionModel : public Object
+{
+  public:
+    static constexpr uint32_t BLOCK_SIZE = 64; //!< Samples generated per refill
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::EmissionModel")
+                                .SetParent<Object>()
+                                .SetGroupName("EcoLedger")
+                                .AddAttribute("MinCO2",
+                                              "Lower clamp for generated values (ppm)",
+                                              DoubleValue(300.0),
+                                              MakeDoubleAccessor(&EmissionModel::m_minCO2),
+                                              MakeDoubleChecker<double>())
+                                .AddAttribute("MaxCO2",
+                                              "Upper clamp for generated values (ppm)",
+                                              DoubleValue(3000.0),
+                                              MakeDoubleAccessor(&EmissionModel::m_maxCO2),
+                                              MakeDoubleChecker<double>());
+        return tid;
+    }
+
+    EmissionModel()
+        : m_baseline(400.0),
+          m_interval(Seconds(5.0)),
+          m_nextBlockTime(Seconds(0.0)),
+          m_next(BLOCK_SIZE)
+    {
+        m_uniform = CreateObject<UniformRandomVariable>();
+        m_normal = CreateObject<NormalRandomVariable>();
+    }
+
+    /**
+     * Configure the sampling schedule of this model
+     * @param baseline Baseline CO2 level for the sensor location (ppm)
+     * @param firstSample Time of the first reading
+     * @param interval Time between readings
+     */
+    void Start(double baseline, Time firstSample, Time interval)
+    {
+        m_baseline = baseline;
+        m_nextBlockTime = firstSample;
+        m_interval = interval;
+        m_next = BLOCK_SIZE; // Force a refill on the first NextValue()
+        Reset();
+    }
+
+    /**
+     * @return The next CO2 reading (ppm), clamped to [MinCO2, MaxCO2]
+     */
+    double NextValue(void)
+    {
+        if (m_next == BLOCK_SIZE)
+        {
+            GenerateBlock(m_samples.data(), BLOCK_SIZE, m_nextBlockTime);
+            for (double& value : m_samples)
+            {
+                value = std::max(m_minCO2, std::min(m_maxCO2, value));
+            }
+            m_nextBlockTime += m_interval * static_cast<int64_t>(BLOCK_SIZE);
+            m_next = 0;
+        }
+        return m_samples[m_next++];
+    }
+
+    /**
+     * Bind the model's random variables to fixed streams
+     * @param stream First stream index to use
+     * @return Number of streams consumed
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        m_uniform->SetStream(stream);
+        m_normal->SetStream(stream + 1);
+        return 2;
+    }
+
+  protected:
+    /**
+     * Fill a block of raw (unclamped) samples
+     * @param out Destination array
+     * @param n Number of samples
+     * @param firstTime Time of the first sample; sample k is at firstTime + k * interval
+     */
+    virtual void GenerateBlock(double* out, uint32_t n, Time firstTime) = 0;
+
+    /** Reset model state when the sampling schedule is (re)started */
+    virtual void Reset(void)
+    {
+    }
+
+    double m_baseline;
+    Time m_interval;
+    Ptr<UniformRandomVariable> m_uniform;
+    Ptr<NormalRandomVariable> m_normal;
+
+  private:
+    Time m_nextBlockTime;
+    double m_minCO2;
+    double m_maxCO2;
+    std::array<double, BLOCK_SIZE> m_samples;
+    uint32_t m_next; // Index of the next unread sample in m_samples
+};
+
+/*
+ * Baseline +/- Amplitude uniform jitter (the original sensor behaviour)
+ */
+class UniformEmissionModel : public EmissionModel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::UniformEmissionModel")
+                                .SetParent<EmissionModel>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<UniformEmissionModel>()
+                                .AddAttribute("Amplitude",
+                                              "Half-width of the uniform jitter (ppm)",
+                                              DoubleValue(50.0),
+                                              MakeDoubleAccessor(&UniformEmissionModel::m_amplitude),
+                                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+  protected:
+    void GenerateBlock(double* out, uint32_t n, Time /* firstTime */) override
+    {
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            out[k] = m_baseline + m_uniform->GetValue(-m_amplitude, m_amplitude);
+        }
+    }
+
+  private:
+    double m_amplitude;
+};
+
+/*
+ * Sinusoidal day/night curve: baseline + Amplitude * cos(2*pi*(t - PeakTime)/Period),
+ * plus uniform jitter
+ */
+class DiurnalEmissionModel : public EmissionModel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid =
+            TypeId("ns3::DiurnalEmissionModel")
+                .SetParent<EmissionModel>()
+                .SetGroupName("EcoLedger")
+                .AddConstructor<DiurnalEmissionModel>()
+                .AddAttribute("Amplitude",
+                              "Peak deviation from the baseline (ppm)",
+                              DoubleValue(150.0),
+                              MakeDoubleAccessor(&DiurnalEmissionModel::m_amplitude),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("Period",
+                              "Length of one day/night cycle",
+                              TimeValue(Seconds(86400.0)),
+                              MakeTimeAccessor(&DiurnalEmissionModel::m_period),
+                              MakeTimeChecker())
+                .AddAttribute("PeakTime",
+                              "Offset of the daily maximum within the period",
+                              TimeValue(Seconds(14 * 3600.0)),
+                              MakeTimeAccessor(&DiurnalEmissionModel::m_peakTime),
+                              MakeTimeChecker())
+                .AddAttribute("Jitter",
+                              "Half-width of the uniform measurement jitter (ppm)",
+                              DoubleValue(20.0),
+                              MakeDoubleAccessor(&DiurnalEmissionModel::m_jitter),
+                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+  protected:
+    void GenerateBlock(double* out, uint32_t n, Time firstTime) override
+    {
+        const double omega = 2.0 * M_PI / m_period.GetSeconds();
+        double t = (firstTime - m_peakTime).GetSeconds();
+        const double dt = m_interval.GetSeconds();
+        for (uint32_t k = 0; k < n; ++k, t += dt)
+        {
+            out[k] = m_baseline + m_amplitude * std::cos(omega * t) +
+                     m_uniform->GetValue(-m_jitter, m_jitter);
+        }
+    }
+
+  private:
+    double m_amplitude;
+    Time m_period;
+    Time m_peakTime;
+    double m_jitter;
+};
+
+/*
+ * Industrial shift pattern: the level rises by ShiftIncrease during working
+ * shifts, with linear ramps of RampTime at shift start and end
+ */
+class ShiftEmissionModel : public EmissionModel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid =
+            TypeId("ns3::ShiftEmissionModel")
+                .SetParent<EmissionModel>()
+                .SetGroupName("EcoLedger")
+                .AddConstructor<ShiftEmissionModel>()
+                .AddAttribute("ShiftIncrease",
+                              "Additional CO2 while a shift is running (ppm)",
+                              DoubleValue(600.0),
+                              MakeDoubleAccessor(&ShiftEmissionModel::m_increase),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("Period",
+                              "Length of one shift cycle (e.g. one day)",
+                              TimeValue(Seconds(86400.0)),
+                              MakeTimeAccessor(&ShiftEmissionModel::m_period),
+                              MakeTimeChecker())
+                .AddAttribute("ShiftStart",
+                              "Offset of the shift start within the period",
+                              TimeValue(Seconds(6 * 3600.0)),
+                              MakeTimeAccessor(&ShiftEmissionModel::m_shiftStart),
+                              MakeTimeChecker())
+                .AddAttribute("ShiftLength",
+                              "Duration of the working shift(s)",
+                              TimeValue(Seconds(16 * 3600.0)),
+                              MakeTimeAccessor(&ShiftEmissionModel::m_shiftLength),
+                              MakeTimeChecker())
+                .AddAttribute("RampTime",
+                              "Ramp-up/ramp-down time at shift boundaries",
+                              TimeValue(Seconds(1800.0)),
+                              MakeTimeAccessor(&ShiftEmissionModel::m_rampTime),
+                              MakeTimeChecker())
+                .AddAttribute("Jitter",
+                              "Half-width of the uniform measurement jitter (ppm)",
+                              DoubleValue(30.0),
+                              MakeDoubleAccessor(&ShiftEmissionModel::m_jitter),
+                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+  protected:
+    void GenerateBlock(double* out, uint32_t n, Time firstTime) override
+    {
+        const double period = m_period.GetSeconds();
+        const double start = m_shiftStart.GetSeconds();
+        const double length = m_shiftLength.GetSeconds();
+        const double ramp = std::max(m_rampTime.GetSeconds(), 1e-9);
+        const double dt = m_interval.GetSeconds();
+        double t = firstTime.GetSeconds();
+        for (uint32_t k = 0; k < n; ++k, t += dt)
+        {
+            double phase = std::fmod(t - start, period);
+            if (phase < 0.0)
+            {
+                phase += period;
+            }
+            // Trapezoid: ramp up, plateau, ramp down, then off-shift
+            double level = 0.0;
+            if (phase < length)
+            {
+                level = std::min(1.0, std::min(phase, length - phase) / ramp);
+            }
+            out[k] = m_baseline + m_increase * level + m_uniform->GetValue(-m_jitter, m_jitter);
+        }
+    }
+
+  private:
+    double m_increase;
+    Time m_period;
+    Time m_shiftStart;
+    Time m_shiftLength;
+    Time m_rampTime;
+    double m_jitter;
+};
+
+/*
+ * AR(1) drift: x[k] = baseline + Phi * (x[k-1] - baseline) + N(0, Sigma^2)
+ */
+class Ar1EmissionModel : public EmissionModel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::Ar1EmissionModel")
+                                .SetParent<EmissionModel>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<Ar1EmissionModel>()
+                                .AddAttribute("Phi",
+                                              "Autoregressive coefficient (|Phi| < 1)",
+                                              DoubleValue(0.9),
+                                              MakeDoubleAccessor(&Ar1EmissionModel::m_phi),
+                                              // |Phi| = 1 is a random walk that never returns
+                                              // to the baseline, so keep the bounds open
+                                              MakeDoubleChecker<double>(std::nextafter(-1.0, 0.0),
+                                                                        std::nextafter(1.0, 0.0)))
+                                .AddAttribute("Sigma",
+                                              "Standard deviation of the innovations (ppm)",
+                                              DoubleValue(15.0),
+                                              MakeDoubleAccessor(&Ar1EmissionModel::m_sigma),
+                                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+  protected:
+    void GenerateBlock(double* out, uint32_t n, Time /* firstTime */) override
+    {
+        const double variance = m_sigma * m_sigma;
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            m_deviation = m_phi * m_deviation + m_normal->GetValue(0.0, variance);
+            out[k] = m_baseline + m_deviation;
+        }
+    }
+
+    void Reset(void) override
+    {
+        m_deviation = 0.0;
+    }
+
+  private:
+    double m_phi;
+    double m_sigma;
+    double m_deviation = 0.0; // Current offset from the baseline
+};
+
+/*
+ * Step events: with EventProbability per reading a step of StepMagnitude
+ * starts and lasts EventDuration, on top of uniform jitter
+ */
+class StepEventEmissionModel : public EmissionModel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid =
+            TypeId("ns3::StepEventEmissionModel")
+                .SetParent<EmissionModel>()
+                .SetGroupName("EcoLedger")
+                .AddConstructor<StepEventEmissionModel>()
+                .AddAttribute("EventProbability",
+                              "Probability that a step event starts at a given reading",
+                              DoubleValue(0.02),
+                              MakeDoubleAccessor(&StepEventEmissionModel::m_probability),
+                              MakeDoubleChecker<double>(0.0, 1.0))
+                .AddAttribute("StepMagnitude",
+                              "CO2 increase during a step event (ppm)",
+                              DoubleValue(400.0),
+                              MakeDoubleAccessor(&StepEventEmissionModel::m_magnitude),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("EventDuration",
+                              "Duration of a step event",
+                              TimeValue(Seconds(30.0)),
+                              MakeTimeAccessor(&StepEventEmissionModel::m_duration),
+                              MakeTimeChecker())
+                .AddAttribute("Jitter",
+                              "Half-width of the uniform measurement jitter (ppm)",
+                              DoubleValue(50.0),
+                              MakeDoubleAccessor(&StepEventEmissionModel::m_jitter),
+                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+  protected:
+    void GenerateBlock(double* out, uint32_t n, Time firstTime) override
+    {
+        Time t = firstTime;
+        for (uint32_t k = 0; k < n; ++k, t += m_interval)
+        {
+            if (t >= m_eventEnd && m_uniform->GetValue(0.0, 1.0) < m_probability)
+            {
+                m_eventEnd = t + m_duration;
+            }
+            double step = (t < m_eventEnd) ? m_magnitude : 0.0;
+            out[k] = m_baseline + step + m_uniform->GetValue(-m_jitter, m_jitter);
+        }
+    }
+
+    void Reset(void) override
+    {
+        m_eventEnd = Seconds(0.0);
+    }
+
+  private:
+    double m_probability;
+    double m_magnitude;
+    Time m_duration;
+    double m_jitter;
+    Time m_eventEnd; // End of the current step event
+};
+
+NS_OBJECT_ENSURE_REGISTERED(UniformEmissionModel);
+NS_OBJECT_ENSURE_REGISTERED(DiurnalEmissionModel);
+NS_OBJECT_ENSURE_REGISTERED(ShiftEmissionModel);
+NS_OBJECT_ENSURE_REGISTERED(Ar1EmissionModel);
+NS_OBJECT_ENSURE_REGISTERED(StepEventEmissionModel);
+
+/**
+ * Create an emission model by short name
+ * @param name One of uniform, diurnal, shift, ar1, step
+ * @return New model instance (aborts on unknown names)
+ */
+inline Ptr<EmissionModel>
+CreateEmissionModel(const std::string& name)
+{
+    if (name == "uniform")
+    {
+        return CreateObject<UniformEmissionModel>();
+    }
+    if (name == "diurnal")
+    {
+        return CreateObject<DiurnalEmissionModel>();
+    }
+    if (name == "shift")
+    {
+        return CreateObject<ShiftEmissionModel>();
+    }
+    if (name == "ar1")
+    {
+        return CreateObject<Ar1EmissionModel>();
+    }
+    if (name == "step")
+    {
+        return CreateObject<StepEventEmissionModel>();
+    }
+    NS_ABORT_MSG("Unknown emission model '" << name
+                                            << "' (expected uniform, diurnal, shift, ar1 or step)");
+    return nullptr;
+}
+
+} // namespace ns3
+
+#endif /* EMISSION_MODEL_H */
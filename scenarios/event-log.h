@@ -0,0 +1,242 @@
+/*
+ * Binary Event Log
+ *
+ * Per-packet observability without string formatting in the send, forward
+ * and receive paths. Applications append fixed-size records (time, event
+ * type, node, sensor, zone, bytes) to a preallocated buffer; the file is
+ * turned into text offline by tools/decode_event_log.py.
+ *
+ * Two modes:
+ *
+ *   ring  - keep the newest <capacity> records in memory, written once at Close()
+ *   file  - stream every record to disk in chunks of <capacity> records
+ *
+ * File layout (host byte order):
+ *
+ *   EventLogFileHeader  (40 bytes)
+ *   EventRecord[n]      (24 bytes each, in time order)
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "ns3/core-module.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+enum EventType : uint8_t
+{
+    EVENT_SENSOR_SEND = 1,     // Sensor handed a reading to its socket
+    EVENT_SENSOR_SEND_FAIL,    // Socket refused the reading
+    EVENT_AP_RECEIVE,          // Local AP received a sensor datagram
+    EVENT_AP_FORWARD,          // Local AP forwarded a single reading
+    EVENT_AP_BATCH,            // Local AP flushed a batch (sensor = reading count)
+    EVENT_GATEWAY_RECEIVE,     // Gateway recorded a reading
+    EVENT_GATEWAY_MALFORMED    // Gateway dropped an unparsable or truncated datagram
+};
+
+struct EventLogFileHeader
+{
+    char magic[8];        // "EVENTLOG"
+    uint32_t byteOrder;   // 0x01020304 in the writer's byte order
+    uint32_t version;     // Format version (1)
+    uint32_t recordSize;  // sizeof(EventRecord)
+    uint32_t mode;        // 0 = ring, 1 = streamed file
+    uint64_t recordCount; // Records in this file
+    uint64_t lostCount;   // Records overwritten (ring) or not written (I/O error)
+};
+
+struct EventRecord
+{
+    uint64_t time;   // Simulation time (ns)
+    uint32_t node;   // Node ID
+    uint32_t sensor; // Sensor ID (0 = unknown), or reading count for EVENT_AP_BATCH
+    uint32_t zone;   // Zone ID (0 = none)
+    uint16_t bytes;  // Payload size, saturated at 65535
+    uint8_t type;    // EventType
+    uint8_t reserved;
+};
+
+static_assert(sizeof(EventLogFileHeader) == 40, "unexpected event log header layout");
+static_assert(sizeof(EventRecord) == 24, "unexpected event record layout");
+
+class EventLog : public SimpleRefCount<EventLog>
+{
+  public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+    enum Mode
+    {
+        RING = 0,
+        STREAM = 1
+    };
+
+    /**
+     * Open the log (aborts if the file cannot be created)
+     * @param path Output file
+     * @param mode Ring buffer or chunked file
+     * @param capacity Ring size, or chunk size in file mode (records)
+     */
+    EventLog(const std::string& path, Mode mode, uint32_t capacity)
+        : m_path(path),
+          m_mode(mode),
+          m_buffer(capacity > 0 ? capacity : 1),
+          m_next(0),
+          m_recorded(0),
+          m_written(0),
+          m_lost(0),
+          m_file(nullptr)
+    {
+        m_file = std::fopen(path.c_str(), "wb");
+        NS_ABORT_MSG_IF(!m_file, "Cannot create event log " << path);
+        // Placeholder; the counts are filled in by Close()
+        WriteHeader();
+    }
+
+    ~EventLog()
+    {
+        Close();
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    /**
+     * Append one record (no allocation, no formatting)
+     * @param type Event type
+     * @param node Node ID
+     * @param sensor Sensor ID, or reading count for EVENT_AP_BATCH
+     * @param zone Zone ID
+     * @param bytes Payload size
+     */
+    void Record(EventType type, uint32_t node, uint32_t sensor, uint32_t zone, uint32_t bytes)
+    {
+        EventRecord& record = m_buffer[m_next];
+        record.time = static_cast<uint64_t>(Simulator::Now().GetNanoSeconds());
+        record.node = node;
+        record.sensor = sensor;
+        record.zone = zone;
+        record.bytes = static_cast<uint16_t>(bytes < UINT16_MAX ? bytes : UINT16_MAX);
+        record.type = type;
+        record.reserved = 0;
+        m_recorded++;
+        if (++m_next == m_buffer.size())
+        {
+            m_next = 0;
+            if (m_mode == STREAM)
+            {
+                WriteRecords(m_buffer.data(), m_buffer.size());
+            }
+        }
+    }
+
+    /**
+     * Write the buffered records and the final header, then close the file
+     * Safe to call more than once.
+     */
+    void Close(void)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        if (m_mode == STREAM)
+        {
+            WriteRecords(m_buffer.data(), m_next);
+        }
+        else if (m_recorded >= m_buffer.size())
+        {
+            // Full ring (m_next has wrapped): the oldest record sits at m_next
+            m_lost = m_recorded - m_buffer.size();
+            WriteRecords(m_buffer.data() + m_next, m_buffer.size() - m_next);
+            WriteRecords(m_buffer.data(), m_next);
+        }
+        else
+        {
+            WriteRecords(m_buffer.data(), m_next);
+        }
+        std::fseek(m_file, 0, SEEK_SET);
+        WriteHeader();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    /** @return Records appended so far */
+    uint64_t GetRecordCount(void) const
+    {
+        return m_recorded;
+    }
+
+    /** @return Output file */
+    const std::string& GetPath(void) const
+    {
+        return m_path;
+    }
+
+  private:
+    void WriteRecords(const EventRecord* records, std::size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        std::size_t written = std::fwrite(records, sizeof(EventRecord), count, m_file);
+        m_written += written;
+        m_lost += count - written;
+    }
+
+    void WriteHeader(void)
+    {
+        EventLogFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "EVENTLOG", 8);
+        header.byteOrder = BYTE_ORDER_TAG;
+        header.version = VERSION;
+        header.recordSize = sizeof(EventRecord);
+        header.mode = m_mode;
+        header.recordCount = m_written;
+        header.lostCount = m_lost;
+        std::fwrite(&header, sizeof(header), 1, m_file);
+    }
+
+    std::string m_path;
+    Mode m_mode;
+    std::vector<EventRecord> m_buffer; // Ring, or the chunk being filled
+    std::size_t m_next;                // Next slot in m_buffer
+    uint64_t m_recorded;
+    uint64_t m_written;
+    uint64_t m_lost;
+    std::FILE* m_file;
+};
+
+/**
+ * Parse a --eventLogMode value (aborts on unknown names)
+ * @param name "ring" or "file"
+ * @return Event log mode
+ */
+inline EventLog::Mode
+ParseEventLogMode(const std::string& name)
+{
+    if (name == "ring")
+    {
+        return EventLog::RING;
+    }
+    if (name == "file")
+    {
+        return EventLog::STREAM;
+    }
+    NS_ABORT_MSG("Unknown event log mode " << name << " (use ring or file)");
+    return EventLog::RING;
+}
+
+} // namespace ns3
+
+#endif /* EVENT_LOG_H */
@@ -0,0 +1,399 @@
+/*
+ * Flow Metrics Collector
+ *
+ * Application-level replacement for the end-of-run FlowMonitor XML: sensors
+ * report what they send, gateways what they receive, and the collector keeps
+ * per-flow (sensor -> gateway) and per-zone counters plus latency histograms
+ * in memory sized once from the fleet. Every --metricsInterval of simulated
+ * time it appends one snapshot of the window to a CSV file:
+ *
+ *   windowEnd,zone,readingsSent,readingsReceived,bytesReceived,throughputKbps,
+ *   co2MeanPpm,latencyMeanMs,latencyP50Ms,latencyP99Ms,latencyMaxMs
+ *
+ * with one "all" row per window and one row per zone that saw traffic in it
+ * (zone 0 is the single-tier network). Percentiles come from the site-wide
+ * window histogram, so zone rows leave them empty. Windows are closed
+ * lazily by the first record past their end and by Close(), so the
+ * collector schedules no events of its own. The file is flushed after each
+ * window, so it can be tailed during the run, and the same rows can go to a
+ * TelemetryStream (see telemetry-stream.h). Per-flow totals, CO2 included,
+ * are written once, at the end, by WriteFlows().
+ *
+ * Each process only sees its own nodes: in distributed runs every rank
+ * writes its own file, the sensor ranks the sent side, rank 0 the received
+ * side.
+ */
+
+#ifndef FLOW_METRICS_COLLECTOR_H
+#define FLOW_METRICS_COLLECTOR_H
+
+#include "latency-histogram.h"
+#include "telemetry-stream.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class FlowMetricsCollector : public SimpleRefCount<FlowMetricsCollector>
+{
+  public:
+    /**
+     * Open the window file (aborts if it cannot be created)
+     * @param path Window snapshot file
+     * @param window Snapshot period in simulated time
+     * @param sensors Highest sensor ID (flows are indexed by sensor)
+     * @param zones Highest zone ID
+     */
+    FlowMetricsCollector(const std::string& path, Time window, uint32_t sensors, uint32_t zones)
+        : m_path(path),
+          m_window(window),
+          m_windowEnd(window),
+          m_flows(sensors + 1),
+          m_zones(zones + 1),
+          m_zoneTouched(zones + 1, false),
+          m_windowsWritten(0)
+    {
+        NS_ABORT_MSG_IF(!window.IsStrictlyPositive(), "The metrics window must be positive");
+        m_touched.reserve(zones + 1);
+        m_file = std::fopen(path.c_str(), "w");
+        NS_ABORT_MSG_IF(!m_file, "Cannot create metrics file " << path);
+        std::fprintf(m_file,
+                     "windowEnd,zone,readingsSent,readingsReceived,bytesReceived,throughputKbps,"
+                     "co2MeanPpm,latencyMeanMs,latencyP50Ms,latencyP99Ms,latencyMaxMs\n");
+    }
+
+    ~FlowMetricsCollector()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+        }
+    }
+
+    FlowMetricsCollector(const FlowMetricsCollector&) = delete;
+    FlowMetricsCollector& operator=(const FlowMetricsCollector&) = delete;
+
+    /**
+     * Also send every window row to a live listener
+     * @param stream Telemetry stream (null = off)
+     */
+    void SetStream(Ptr<TelemetryStream> stream)
+    {
+        m_stream = stream;
+    }
+
+    /**
+     * Account readings handed to a sensor socket
+     * @param sensorId Sensor ID
+     * @param zoneId Zone of the sensor
+     * @param readings Readings in the datagram
+     */
+    void RecordSend(uint32_t sensorId, uint32_t zoneId, uint32_t readings)
+    {
+        Advance();
+        if (sensorId < m_flows.size())
+        {
+            FlowCounters& flow = m_flows[sensorId];
+            if (flow.sent == 0)
+            {
+                flow.firstSend = Simulator::Now();
+            }
+            flow.sent += readings;
+            flow.zone = zoneId;
+        }
+        Touch(zoneId).sent += readings;
+        m_site.sent += readings;
+    }
+
+    /**
+     * Account a reading recorded by a gateway
+     * @param sensorId Sensor ID
+     * @param zoneId Zone of the sensor
+     * @param bytes Bytes the reading took on the wire
+     * @param latency Time from the reading to its reception
+     * @param co2Ppm CO2 level of the reading
+     */
+    void RecordReceive(uint32_t sensorId,
+                       uint32_t zoneId,
+                       uint32_t bytes,
+                       Time latency,
+                       double co2Ppm)
+    {
+        Advance();
+        double seconds = latency.GetSeconds();
+        if (sensorId < m_flows.size())
+        {
+            FlowCounters& flow = m_flows[sensorId];
+            if (flow.received == 0)
+            {
+                flow.firstReceive = Simulator::Now();
+            }
+            flow.received++;
+            flow.bytes += bytes;
+            flow.latencySum += seconds;
+            flow.lastReceive = Simulator::Now();
+            flow.zone = zoneId;
+            flow.co2Sum += co2Ppm;
+            flow.co2Min = std::min(flow.co2Min, co2Ppm);
+            flow.co2Max = std::max(flow.co2Max, co2Ppm);
+        }
+        WindowCounters& zone = Touch(zoneId);
+        zone.Receive(bytes, seconds, co2Ppm);
+        m_site.Receive(bytes, seconds, co2Ppm);
+        m_windowLatency.Add(latency);
+        m_runLatency.Add(latency);
+    }
+
+    /**
+     * Write the windows up to now (call once the run is over) and close the file
+     * Later records only update the per-flow totals.
+     */
+    void Close(void)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        Advance();
+        if (Simulator::Now() > m_windowEnd - m_window)
+        {
+            // Partial last window, stamped with the time it was closed
+            WriteWindow(Simulator::Now(), Simulator::Now() - (m_windowEnd - m_window));
+        }
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    /**
+     * Per-flow totals: sensorId,zone,readingsSent,readingsReceived,bytesReceived,
+     * throughputKbps,meanLatencyMs,co2MeanPpm,co2MinPpm,co2MaxPpm (flows
+     * without traffic are skipped, CO2 is empty for flows without receptions)
+     * @param path Output file
+     * @return false if the file could not be written
+     */
+    bool WriteFlows(const std::string& path) const
+    {
+        std::FILE* out = std::fopen(path.c_str(), "w");
+        if (!out)
+        {
+            return false;
+        }
+        std::fprintf(out,
+                     "sensorId,zone,readingsSent,readingsReceived,bytesReceived,throughputKbps,"
+                     "meanLatencyMs,co2MeanPpm,co2MinPpm,co2MaxPpm\n");
+        for (uint32_t id = 0; id < m_flows.size(); ++id)
+        {
+            const FlowCounters& flow = m_flows[id];
+            if (flow.sent == 0 && flow.received == 0)
+            {
+                continue;
+            }
+            // From the first send (first reception if the sender ran elsewhere) to the last
+            // reception; a flow received in a single instant has no span
+            Time first = flow.sent > 0 ? flow.firstSend : flow.firstReceive;
+            double span = (flow.lastReceive - first).GetSeconds();
+            double throughput =
+                (flow.received > 0 && span > 0) ? flow.bytes * 8.0 / span / 1000.0 : 0.0;
+            double latency = flow.received > 0 ? flow.latencySum / flow.received * 1000.0 : 0.0;
+            std::fprintf(out,
+                         "%u,%u,%llu,%llu,%llu,%.3f,%.3f,",
+                         id,
+                         flow.zone,
+                         static_cast<unsigned long long>(flow.sent),
+                         static_cast<unsigned long long>(flow.received),
+                         static_cast<unsigned long long>(flow.bytes),
+                         throughput,
+                         latency);
+            if (flow.received > 0)
+            {
+                std::fprintf(out,
+                             "%.2f,%.2f,%.2f\n",
+                             flow.co2Sum / flow.received,
+                             flow.co2Min,
+                             flow.co2Max);
+            }
+            else
+            {
+                std::fprintf(out, ",,\n");
+            }
+        }
+        return std::fclose(out) == 0;
+    }
+
+    /** @return Window snapshot file */
+    const std::string& GetPath(void) const
+    {
+        return m_path;
+    }
+
+    /** @return Windows written so far */
+    uint64_t GetWindowsWritten(void) const
+    {
+        return m_windowsWritten;
+    }
+
+    /** @return Latencies of every received reading of the run */
+    const LatencyHistogram& GetLatency(void) const
+    {
+        return m_runLatency;
+    }
+
+  private:
+    struct FlowCounters
+    {
+        uint64_t sent = 0;
+        uint64_t received = 0;
+        uint64_t bytes = 0;
+        double latencySum = 0.0; // s
+        Time firstSend;
+        Time firstReceive;
+        Time lastReceive;
+        uint32_t zone = 0;
+        double co2Sum = 0.0; // ppm
+        double co2Min = std::numeric_limits<double>::infinity();
+        double co2Max = -std::numeric_limits<double>::infinity();
+    };
+
+    struct WindowCounters
+    {
+        uint64_t sent = 0;
+        uint64_t received = 0;
+        uint64_t bytes = 0;
+        double latencySum = 0.0; // s
+        double latencyMax = 0.0;
+        double co2Sum = 0.0; // ppm
+
+        void Receive(uint32_t size, double latency, double co2)
+        {
+            received++;
+            bytes += size;
+            latencySum += latency;
+            latencyMax = std::max(latencyMax, latency);
+            co2Sum += co2;
+        }
+    };
+
+    WindowCounters& Touch(uint32_t zoneId)
+    {
+        if (zoneId >= m_zones.size())
+        {
+            zoneId = 0;
+        }
+        if (!m_zoneTouched[zoneId])
+        {
+            m_zoneTouched[zoneId] = true;
+            m_touched.push_back(zoneId);
+        }
+        return m_zones[zoneId];
+    }
+
+    /** Write every window that ended before now */
+    void Advance(void)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        while (Simulator::Now() >= m_windowEnd)
+        {
+            WriteWindow(m_windowEnd, m_window);
+            m_windowEnd += m_window;
+        }
+    }
+
+    void WriteWindow(Time end, Time length)
+    {
+        double t = end.GetSeconds();
+        double seconds = length.GetSeconds();
+        WriteRow(t, seconds, nullptr, m_site, true);
+        m_site = WindowCounters();
+        m_windowLatency.Reset();
+        for (uint32_t zoneId : m_touched)
+        {
+            WriteRow(t, seconds, &zoneId, m_zones[zoneId], false);
+            m_zones[zoneId] = WindowCounters();
+            m_zoneTouched[zoneId] = false;
+        }
+        m_touched.clear();
+        m_windowsWritten++;
+        std::fflush(m_file);
+        if (m_stream)
+        {
+            m_stream->Flush();
+        }
+    }
+
+    /** Format one row on the stack, then hand it to the file and the stream */
+    void WriteRow(double time,
+                  double seconds,
+                  const uint32_t* zoneId,
+                  const WindowCounters& c,
+                  bool percentiles)
+    {
+        char row[256];
+        int size = zoneId ? std::snprintf(row, sizeof(row), "%.3f,%u,", time, *zoneId)
+                          : std::snprintf(row, sizeof(row), "%.3f,all,", time);
+        double throughput = seconds > 0 ? c.bytes * 8.0 / seconds / 1000.0 : 0.0;
+        double mean = c.received > 0 ? c.latencySum / c.received * 1000.0 : 0.0;
+        size += std::snprintf(row + size,
+                              sizeof(row) - size,
+                              "%llu,%llu,%llu,%.3f,",
+                              static_cast<unsigned long long>(c.sent),
+                              static_cast<unsigned long long>(c.received),
+                              static_cast<unsigned long long>(c.bytes),
+                              throughput);
+        if (c.received > 0)
+        {
+            size += std::snprintf(row + size, sizeof(row) - size, "%.2f,", c.co2Sum / c.received);
+        }
+        else
+        {
+            size += std::snprintf(row + size, sizeof(row) - size, ",");
+        }
+        size += std::snprintf(row + size, sizeof(row) - size, "%.3f,", mean);
+        if (percentiles)
+        {
+            size += std::snprintf(row + size,
+                                  sizeof(row) - size,
+                                  "%.3f,%.3f,",
+                                  m_windowLatency.GetQuantile(0.5) * 1000.0,
+                                  m_windowLatency.GetQuantile(0.99) * 1000.0);
+        }
+        else
+        {
+            size += std::snprintf(row + size, sizeof(row) - size, ",,");
+        }
+        size += std::snprintf(row + size, sizeof(row) - size, "%.3f\n", c.latencyMax * 1000.0);
+        std::fwrite(row, 1, size, m_file);
+        if (m_stream)
+        {
+            m_stream->Append(row, size);
+        }
+    }
+
+    std::string m_path;
+    std::FILE* m_file;
+    Time m_window;
+    Time m_windowEnd; // End of the open window
+    std::vector<FlowCounters> m_flows;  // Indexed by sensor ID, whole run
+    std::vector<WindowCounters> m_zones; // Indexed by zone ID, open window
+    std::vector<bool> m_zoneTouched;
+    std::vector<uint32_t> m_touched; // Zones with traffic in the open window
+    WindowCounters m_site;           // Open window, all zones
+    LatencyHistogram m_windowLatency;
+    LatencyHistogram m_runLatency;
+    uint64_t m_windowsWritten;
+    Ptr<TelemetryStream> m_stream; // Null unless rows are streamed
+};
+
+} // namespace ns3
+
+#endif /* FLOW_METRICS_COLLECTOR_H */
@@ -0,0 +1,468 @@
+/*
+ * Gateway Shards
+ *
+ * Spreads the backbone traffic of the zone APs over M main gateways
+ * (--gateways). Each AP picks the gateway of a datagram on a consistent
+ * hash ring: every gateway owns --shardPoints points on a 32-bit ring, and
+ * a key belongs to the first point at or after its hash. The key is the
+ * zone (--shardBy=zone, one gateway per AP) or the sending sensor
+ * (--shardBy=sensor, the AP splits its traffic and keeps one batch per
+ * gateway). Sensors are keyed on their address: it identifies a sensor as
+ * well as its ID does, and the AP knows it for every payload, text and
+ * undecoded sensor batches included.
+ *
+ * With --failover every gateway sends a heartbeat to every AP each
+ * --heartbeatMs, paced evenly over the period. An AP that has not heard
+ * from a gateway for --heartbeatMisses periods skips its points on the
+ * ring, so only the keys of the lost gateway move, each to the next live
+ * gateway clockwise; the next heartbeat brings it back. What an AP sends
+ * to a gateway before it notices the loss is lost with the gateway.
+ *
+ * Heartbeat datagrams carry HEARTBEAT_SIZE zero bytes to --heartbeatPort;
+ * the AP tells the gateways apart by their source address.
+ */
+
+#ifndef GATEWAY_SHARDS_H
+#define GATEWAY_SHARDS_H
+
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+enum class ShardKey
+{
+    ZONE,
+    SENSOR
+};
+
+/**
+ * Parse a --shardBy value (aborts on unknown names)
+ * @param name "zone" or "sensor"
+ * @return Key the APs hash
+ */
+inline ShardKey
+ParseShardKey(const std::string& name)
+{
+    if (name == "zone")
+    {
+        return ShardKey::ZONE;
+    }
+    if (name == "sensor")
+    {
+        return ShardKey::SENSOR;
+    }
+    NS_ABORT_MSG("Unknown shard key " << name << " (use zone or sensor)");
+    return ShardKey::SENSOR;
+}
+
+/**
+ * Settings of the gateway selection, shared by the gateways and the APs
+ */
+struct ShardConfig
+{
+    ShardKey key = ShardKey::SENSOR;
+    uint32_t points = 64; // Ring points per gateway
+    bool failover = false;
+    Time heartbeatInterval = MilliSeconds(500);
+    uint32_t heartbeatMisses = 3; // Silent periods before an AP gives up on a gateway
+};
+
+/**
+ * Sharding work of a run, shared by every gateway and AP: the heartbeat
+ * traffic, and how often APs moved keys off a silent gateway and back
+ */
+struct ShardStats : public SimpleRefCount<ShardStats>
+{
+    uint64_t heartbeatsSent = 0;
+    uint64_t heartbeatsReceived = 0;
+    uint64_t failovers = 0;  // Times an AP gave up on a gateway
+    uint64_t recoveries = 0; // Times an AP took a gateway back
+    uint64_t rerouted = 0;   // Datagrams sent past the gateway their key belongs to
+
+    /**
+     * Print the heartbeat and failover counters
+     * @param os Output stream
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "  Heartbeats: " << heartbeatsSent << " sent, " << heartbeatsReceived
+           << " received\n";
+        os << "  Failovers: " << failovers << " (" << recoveries << " recoveries), " << rerouted
+           << " datagrams rerouted\n";
+    }
+
+    /**
+     * Add the failover metrics to a run summary
+     * @param summary Run summary
+     */
+    void AddMetrics(RunSummary& summary) const
+    {
+        summary.AddMetric("heartbeatsSent", heartbeatsSent);
+        summary.AddMetric("heartbeatsReceived", heartbeatsReceived);
+        summary.AddMetric("gatewayFailovers", failovers);
+        summary.AddMetric("gatewayRecoveries", recoveries);
+        summary.AddMetric("reroutedDatagrams", rerouted);
+    }
+};
+
+/**
+ * Consistent hash ring of the gateways, built once and shared by the APs
+ */
+class GatewayRing : public SimpleRefCount<GatewayRing>
+{
+  public:
+    /**
+     * @param gateways Number of gateways
+     * @param points Ring points per gateway; more points even out the shares
+     */
+    GatewayRing(uint32_t gateways, uint32_t points)
+        : m_gatewayCount(gateways)
+    {
+        NS_ABORT_MSG_IF(gateways == 0, "The ring needs at least one gateway");
+        NS_ABORT_MSG_IF(points == 0, "Every gateway needs a point on the ring");
+        m_points.reserve(static_cast<size_t>(gateways) * points);
+        for (uint32_t g = 0; g < gateways; ++g)
+        {
+            for (uint32_t p = 0; p < points; ++p)
+            {
+                uint32_t id[2] = {g, p};
+                m_points.push_back({Hash32(reinterpret_cast<const char*>(id), sizeof(id)), g});
+            }
+        }
+        std::sort(m_points.begin(), m_points.end(), [](const Point& a, const Point& b) {
+            return a.hash < b.hash || (a.hash == b.hash && a.gateway < b.gateway);
+        });
+    }
+
+    /** @return Number of gateways */
+    uint32_t GetGatewayCount(void) const
+    {
+        return m_gatewayCount;
+    }
+
+    /** @return Points of all gateways */
+    uint32_t GetPointCount(void) const
+    {
+        return m_points.size();
+    }
+
+    /**
+     * @param key Zone ID or sensor address
+     * @return Index of the first point at or after the key's hash
+     */
+    uint32_t Find(uint32_t key) const
+    {
+        uint32_t hash = Hash32(reinterpret_cast<const char*>(&key), sizeof(key));
+        auto it = std::lower_bound(m_points.begin(),
+                                   m_points.end(),
+                                   hash,
+                                   [](const Point& point, uint32_t h) { return point.hash < h; });
+        return (it == m_points.end()) ? 0 : it - m_points.begin();
+    }
+
+    /**
+     * @param point Point index (wraps around)
+     * @return Gateway owning the point
+     */
+    uint32_t GetGateway(uint32_t point) const
+    {
+        return m_points[point % m_points.size()].gateway;
+    }
+
+    /**
+     * @param gateway Gateway index
+     * @return Fraction of the hash space the gateway owns (its fair share is 1 / M)
+     */
+    double GetShare(uint32_t gateway) const
+    {
+        if (m_points.size() == 1)
+        {
+            return 1.0;
+        }
+        // A point owns the arc from its predecessor; the first one also owns the wrap-around
+        uint64_t owned = 0;
+        uint32_t previous = m_points.back().hash;
+        for (const Point& point : m_points)
+        {
+            if (point.gateway == gateway)
+            {
+                owned += static_cast<uint32_t>(point.hash - previous);
+            }
+            previous = point.hash;
+        }
+        return owned / 4294967296.0;
+    }
+
+  private:
+    struct Point
+    {
+        uint32_t hash;
+        uint32_t gateway;
+    };
+
+    uint32_t m_gatewayCount;
+    std::vector<Point> m_points; // Sorted by hash
+};
+
+/**
+ * Gateway selection of one AP: ring lookup plus, with failover, the
+ * liveness the gateways' heartbeats tell
+ */
+class GatewaySelector
+{
+  public:
+    GatewaySelector()
+        : m_zoneId(0)
+    {
+    }
+
+    /**
+     * @param gateways Address of every gateway as the AP reaches it, in gateway order
+     * @param port Backbone port of the gateways
+     * @param zoneId Zone of the AP, the key with --shardBy=zone
+     * @param ring Ring of the gateways
+     * @param config Key and failover settings
+     * @param stats Counters shared by all gateways and APs (null = off)
+     */
+    void Setup(const std::vector<Ipv4Address>& gateways,
+               uint16_t port,
+               uint32_t zoneId,
+               Ptr<const GatewayRing> ring,
+               const ShardConfig& config,
+               Ptr<ShardStats> stats)
+    {
+        NS_ABORT_MSG_IF(gateways.size() != ring->GetGatewayCount(),
+                        "The ring and the AP disagree on the number of gateways");
+        m_gatewayAddresses = gateways;
+        m_gateways.clear();
+        for (const Ipv4Address& gateway : gateways)
+        {
+            m_gateways.push_back(InetSocketAddress(gateway, port));
+        }
+        m_zoneId = zoneId;
+        m_ring = ring;
+        m_config = config;
+        m_stats = stats;
+        m_lastHeard.assign(gateways.size(), Time(0));
+        m_down.assign(gateways.size(), false);
+    }
+
+    /** @return true once Setup() gave the selector a ring */
+    bool IsEnabled(void) const
+    {
+        return bool(m_ring);
+    }
+
+    /** @return Number of gateways */
+    uint32_t GetGatewayCount(void) const
+    {
+        return m_gateways.size();
+    }
+
+    /**
+     * @param gateway Gateway index
+     * @return Backbone address and port of the gateway
+     */
+    const Address& GetAddress(uint32_t gateway) const
+    {
+        return m_gateways[gateway];
+    }
+
+    /**
+     * Listen for heartbeats (failover only); every gateway counts as heard from now
+     * @param socket UDP socket of the AP for the heartbeats
+     * @param port Heartbeat port
+     */
+    void Start(Ptr<Socket> socket, uint16_t port)
+    {
+        std::fill(m_lastHeard.begin(), m_lastHeard.end(), Simulator::Now());
+        m_socket = socket;
+        m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), port));
+        m_socket->SetRecvCallback(MakeCallback(&GatewaySelector::HandleHeartbeat, this));
+    }
+
+    void Stop(void)
+    {
+        if (m_socket)
+        {
+            m_socket->Close();
+        }
+    }
+
+    /**
+     * Pick the gateway of a datagram
+     * @param sensor Address of the sensor that sent it, the key with --shardBy=sensor
+     * @return Gateway index: the owner of the key, or with failover the first live
+     *         gateway after it on the ring (the owner if none is live)
+     */
+    uint32_t Select(const Address& sensor)
+    {
+        uint32_t key = m_config.key == ShardKey::ZONE
+                           ? m_zoneId
+                           : InetSocketAddress::ConvertFrom(sensor).GetIpv4().Get();
+        uint32_t point = m_ring->Find(key);
+        uint32_t owner = m_ring->GetGateway(point);
+        if (!m_config.failover)
+        {
+            return owner;
+        }
+        for (uint32_t step = 0; step < m_ring->GetPointCount(); ++step)
+        {
+            uint32_t gateway = m_ring->GetGateway(point + step);
+            if (IsAlive(gateway))
+            {
+                if (gateway != owner && m_stats)
+                {
+                    m_stats->rerouted++;
+                }
+                return gateway;
+            }
+        }
+        return owner;
+    }
+
+  private:
+    void HandleHeartbeat(Ptr<Socket> socket)
+    {
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from)))
+        {
+            Ipv4Address source = InetSocketAddress::ConvertFrom(from).GetIpv4();
+            for (uint32_t g = 0; g < m_gatewayAddresses.size(); ++g)
+            {
+                if (m_gatewayAddresses[g] != source)
+                {
+                    continue;
+                }
+                m_lastHeard[g] = Simulator::Now();
+                if (m_stats)
+                {
+                    m_stats->heartbeatsReceived++;
+                    if (m_down[g])
+                    {
+                        m_stats->recoveries++;
+                    }
+                }
+                m_down[g] = false;
+                break;
+            }
+        }
+    }
+
+    /** A gateway is down once it missed the configured number of heartbeats */
+    bool IsAlive(uint32_t gateway)
+    {
+        if (Simulator::Now() - m_lastHeard[gateway] <=
+            m_config.heartbeatInterval * static_cast<int64_t>(m_config.heartbeatMisses))
+        {
+            return true;
+        }
+        if (!m_down[gateway])
+        {
+            m_down[gateway] = true;
+            if (m_stats)
+            {
+                m_stats->failovers++;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Ipv4Address> m_gatewayAddresses;
+    std::vector<Address> m_gateways; // With the backbone port
+    uint32_t m_zoneId;
+    Ptr<const GatewayRing> m_ring;
+    ShardConfig m_config;
+    Ptr<ShardStats> m_stats;
+    Ptr<Socket> m_socket; // Null unless failover is on
+    std::vector<Time> m_lastHeard;
+    std::vector<bool> m_down; // Noticed as down, until the next heartbeat
+};
+
+/**
+ * Heartbeats of one gateway: one datagram per AP and interval, spaced evenly
+ * so that a large site does not burst the gateway's link queue
+ */
+class HeartbeatSender
+{
+  public:
+    static constexpr uint32_t HEARTBEAT_SIZE = 8; //!< UDP payload of a heartbeat
+
+    HeartbeatSender()
+        : m_next(0)
+    {
+    }
+
+    /**
+     * @param socket UDP socket the heartbeats are sent from
+     * @param destinations Heartbeat address and port of every AP
+     * @param interval Time between two heartbeats to the same AP
+     * @param stats Counters shared by all gateways and APs (null = off)
+     */
+    void Setup(Ptr<Socket> socket,
+               const std::vector<Address>& destinations,
+               Time interval,
+               Ptr<ShardStats> stats)
+    {
+        NS_ABORT_MSG_IF(destinations.empty(), "Heartbeats need at least one AP");
+        m_socket = socket;
+        m_destinations = destinations;
+        m_spacing = interval / static_cast<int64_t>(destinations.size());
+        m_stats = stats;
+    }
+
+    /** @return true once Setup() gave the sender a socket */
+    bool IsEnabled(void) const
+    {
+        return bool(m_socket);
+    }
+
+    void Start(void)
+    {
+        m_socket->Bind();
+        m_next = 0;
+        Send();
+    }
+
+    /** Stop sending, as a failed gateway does */
+    void Stop(void)
+    {
+        Simulator::Cancel(m_sendEvent);
+        m_socket->Close();
+    }
+
+  private:
+    void Send(void)
+    {
+        if (m_socket->SendTo(Create<Packet>(HEARTBEAT_SIZE), 0, m_destinations[m_next]) > 0 &&
+            m_stats)
+        {
+            m_stats->heartbeatsSent++;
+        }
+        m_next = (m_next + 1) % m_destinations.size();
+        m_sendEvent = Simulator::Schedule(m_spacing, &HeartbeatSender::Send, this);
+    }
+
+    Ptr<Socket> m_socket;
+    std::vector<Address> m_destinations;
+    uint32_t m_next; // Next AP to send to
+    Time m_spacing;
+    EventId m_sendEvent;
+    Ptr<ShardStats> m_stats;
+};
+
+} // namespace ns3
+
+#endif /* GATEWAY_SHARDS_H */
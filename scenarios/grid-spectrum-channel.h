@@ -0,0 +1,349 @@
+/*
+ * Grid Spectrum Channel
+ *
+ * SpectrumChannel that only delivers a transmission to PHYs close enough to
+ * receive it. Stock channels hand every frame to every attached PHY, so a
+ * dense sensor field costs O(N) receive events per frame even though almost
+ * all of them are far below the receiver sensitivity and are dropped.
+ *
+ * Receivers are kept in a uniform grid over their (constant) positions with
+ * one cell per cull radius, so a transmission only visits the 3x3 cells around
+ * the sender. The radius is derived from the propagation loss model: it is the
+ * distance at which a frame sent at MaxTxPower falls below DetectionThreshold.
+ * Within the radius, loss, delay and antenna gains are applied exactly as in
+ * SingleModelSpectrumChannel.
+ *
+ * Assumptions: nodes do not move after the first transmission (the grid is
+ * rebuilt only when PHYs are added or removed), the loss model is
+ * deterministic and decreases with distance, and all PHYs share one spectrum
+ * model (same band and width).
+ */
+
+#ifndef GRID_SPECTRUM_CHANNEL_H
+#define GRID_SPECTRUM_CHANNEL_H
+
+#include "ns3/antenna-module.h"
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/spectrum-module.h"
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class GridSpectrumChannel : public SpectrumChannel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid =
+            TypeId("ns3::GridSpectrumChannel")
+                .SetParent<SpectrumChannel>()
+                .SetGroupName("EcoLedger")
+                .AddConstructor<GridSpectrumChannel>()
+                .AddAttribute("DetectionThreshold",
+                              "Received power (dBm) below which a frame is not delivered",
+                              DoubleValue(-101.0),
+                              MakeDoubleAccessor(&GridSpectrumChannel::m_detectionThreshold),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("MaxTxPower",
+                              "Highest transmit power (dBm) of the attached PHYs",
+                              DoubleValue(16.0206),
+                              MakeDoubleAccessor(&GridSpectrumChannel::m_maxTxPower),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("CullRadius",
+                              "Delivery radius in meters (0 = derive from the loss model)",
+                              DoubleValue(0.0),
+                              MakeDoubleAccessor(&GridSpectrumChannel::m_configuredRadius),
+                              MakeDoubleChecker<double>(0.0));
+        return tid;
+    }
+
+    GridSpectrumChannel()
+        : m_detectionThreshold(-101.0),
+          m_maxTxPower(16.0206),
+          m_configuredRadius(0.0),
+          m_radius(0.0),
+          m_gridDirty(true),
+          m_deliveries(0),
+          m_culled(0)
+    {
+    }
+
+    void AddRx(Ptr<SpectrumPhy> phy) override
+    {
+        m_phys.push_back(phy);
+        m_gridDirty = true;
+    }
+
+    void RemoveRx(Ptr<SpectrumPhy> phy) override
+    {
+        for (auto it = m_phys.begin(); it != m_phys.end(); ++it)
+        {
+            if (*it == phy)
+            {
+                m_phys.erase(it);
+                m_gridDirty = true;
+                return;
+            }
+        }
+    }
+
+    void StartTx(Ptr<SpectrumSignalParameters> txParams) override
+    {
+        NS_ASSERT_MSG(txParams->txPhy, "NULL txPhy");
+        m_txSigParamsTrace(txParams);
+        if (m_gridDirty)
+        {
+            BuildGrid();
+        }
+
+        Ptr<MobilityModel> txMobility = txParams->txPhy->GetMobility();
+        uint64_t delivered = 0;
+        if (!txMobility || m_radius <= 0.0)
+        {
+            // No position or no finite radius: behave like an unculled channel
+            for (const Ptr<SpectrumPhy>& rx : m_phys)
+            {
+                delivered += Deliver(txParams, txMobility, rx) ? 1 : 0;
+            }
+        }
+        else
+        {
+            Vector txPos = txMobility->GetPosition();
+            int64_t cx = CellIndex(txPos.x);
+            int64_t cy = CellIndex(txPos.y);
+            for (int64_t dx = -1; dx <= 1; ++dx)
+            {
+                for (int64_t dy = -1; dy <= 1; ++dy)
+                {
+                    auto cell = m_cells.find(CellKey(cx + dx, cy + dy));
+                    if (cell == m_cells.end())
+                    {
+                        continue;
+                    }
+                    for (const Ptr<SpectrumPhy>& rx : cell->second)
+                    {
+                        delivered += Deliver(txParams, txMobility, rx) ? 1 : 0;
+                    }
+                }
+            }
+            for (const Ptr<SpectrumPhy>& rx : m_unplaced)
+            {
+                delivered += Deliver(txParams, txMobility, rx) ? 1 : 0;
+            }
+        }
+
+        // Every PHY but the sender is a candidate receiver
+        m_deliveries += delivered;
+        if (m_phys.size() > delivered + 1)
+        {
+            m_culled += m_phys.size() - 1 - delivered;
+        }
+    }
+
+    std::size_t GetNDevices(void) const override
+    {
+        return m_phys.size();
+    }
+
+    Ptr<NetDevice> GetDevice(std::size_t i) const override
+    {
+        return m_phys.at(i)->GetDevice();
+    }
+
+    /** @return Delivery radius in meters (0 until the first transmission, or if unbounded) */
+    double GetCullRadius(void) const
+    {
+        return m_radius;
+    }
+
+    /** @return Number of receptions scheduled */
+    uint64_t GetDeliveryCount(void) const
+    {
+        return m_deliveries;
+    }
+
+    /** @return Number of receivers skipped because they were out of range */
+    uint64_t GetCulledCount(void) const
+    {
+        return m_culled;
+    }
+
+  private:
+    /**
+     * Distance at which a MaxTxPower frame drops below DetectionThreshold
+     * @return Radius in meters, or 0 if the loss model never gets there
+     */
+    double DeriveRadius(void) const
+    {
+        if (!m_propagationLoss)
+        {
+            return 0.0;
+        }
+        Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+        Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+        a->SetPosition(Vector(0.0, 0.0, 0.0));
+        auto rxPower = [&](double distance) {
+            b->SetPosition(Vector(distance, 0.0, 0.0));
+            return m_propagationLoss->CalcRxPower(m_maxTxPower, a, b);
+        };
+
+        // Bracket the threshold crossing, then bisect it
+        double inside = 0.0;
+        double outside = 1.0;
+        while (rxPower(outside) >= m_detectionThreshold)
+        {
+            inside = outside;
+            outside *= 2.0;
+            if (outside > 1e7)
+            {
+                return 0.0;
+            }
+        }
+        for (int i = 0; i < 50; ++i)
+        {
+            double mid = 0.5 * (inside + outside);
+            if (rxPower(mid) >= m_detectionThreshold)
+            {
+                inside = mid;
+            }
+            else
+            {
+                outside = mid;
+            }
+        }
+        return outside;
+    }
+
+    void BuildGrid(void)
+    {
+        m_radius = (m_configuredRadius > 0.0) ? m_configuredRadius : DeriveRadius();
+        m_cells.clear();
+        m_unplaced.clear();
+        for (const Ptr<SpectrumPhy>& phy : m_phys)
+        {
+            Ptr<MobilityModel> mobility = phy->GetMobility();
+            if (!mobility || m_radius <= 0.0)
+            {
+                m_unplaced.push_back(phy);
+                continue;
+            }
+            Vector pos = mobility->GetPosition();
+            m_cells[CellKey(CellIndex(pos.x), CellIndex(pos.y))].push_back(phy);
+        }
+        m_gridDirty = false;
+    }
+
+    int64_t CellIndex(double coordinate) const
+    {
+        return static_cast<int64_t>(std::floor(coordinate / m_radius));
+    }
+
+    static uint64_t CellKey(int64_t x, int64_t y)
+    {
+        return (static_cast<uint64_t>(x) << 32) ^ (static_cast<uint64_t>(y) & 0xffffffff);
+    }
+
+    /**
+     * Apply gains and schedule the reception at one PHY (cf. SingleModelSpectrumChannel)
+     * @return true if a reception was scheduled
+     */
+    bool Deliver(Ptr<SpectrumSignalParameters> txParams,
+                 Ptr<MobilityModel> txMobility,
+                 Ptr<SpectrumPhy> rx)
+    {
+        if (rx == txParams->txPhy)
+        {
+            return false;
+        }
+        if (m_filter && m_filter->Filter(txParams, rx))
+        {
+            return false;
+        }
+
+        Ptr<SpectrumSignalParameters> rxParams = txParams->Copy();
+        Time delay = MicroSeconds(0);
+        Ptr<MobilityModel> rxMobility = rx->GetMobility();
+        if (txMobility && rxMobility)
+        {
+            if (m_radius > 0.0 && txMobility->GetDistanceFrom(rxMobility) > m_radius)
+            {
+                return false;
+            }
+
+            double pathLossDb = 0.0;
+            if (rxParams->txAntenna)
+            {
+                Angles txAngles(rxMobility->GetPosition(), txMobility->GetPosition());
+                pathLossDb -= rxParams->txAntenna->GetGainDb(txAngles);
+            }
+            Ptr<AntennaModel> rxAntenna = DynamicCast<AntennaModel>(rx->GetAntenna());
+            if (rxAntenna)
+            {
+                Angles rxAngles(txMobility->GetPosition(), rxMobility->GetPosition());
+                pathLossDb -= rxAntenna->GetGainDb(rxAngles);
+            }
+            if (m_propagationLoss)
+            {
+                pathLossDb -= m_propagationLoss->CalcRxPower(0, txMobility, rxMobility);
+            }
+            if (pathLossDb > m_maxLossDb)
+            {
+                return false;
+            }
+            *(rxParams->psd) *= std::pow(10.0, -pathLossDb / 10.0);
+            if (m_spectrumPropagationLoss)
+            {
+                rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity(rxParams,
+                                                                                     txMobility,
+                                                                                     rxMobility);
+            }
+            if (m_propagationDelay)
+            {
+                delay = m_propagationDelay->GetDelay(txMobility, rxMobility);
+            }
+        }
+
+        Ptr<NetDevice> device = rx->GetDevice();
+        uint32_t context = device ? device->GetNode()->GetId() : Simulator::NO_CONTEXT;
+        Simulator::ScheduleWithContext(context, delay, &GridSpectrumChannel::StartRx, rxParams, rx);
+        return true;
+    }
+
+    static void StartRx(Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
+    {
+        receiver->StartRx(params);
+    }
+
+    void DoDispose(void) override
+    {
+        m_phys.clear();
+        m_cells.clear();
+        m_unplaced.clear();
+        SpectrumChannel::DoDispose();
+    }
+
+    double m_detectionThreshold; // dBm
+    double m_maxTxPower;         // dBm
+    double m_configuredRadius;   // m, 0 = derived
+    double m_radius;             // Effective radius and grid cell size (m)
+    bool m_gridDirty;
+    std::vector<Ptr<SpectrumPhy>> m_phys;                                // All receivers, in AddRx order
+    std::unordered_map<uint64_t, std::vector<Ptr<SpectrumPhy>>> m_cells; // Grid cell -> receivers
+    std::vector<Ptr<SpectrumPhy>> m_unplaced;                            // Receivers without a position
+    uint64_t m_deliveries;
+    uint64_t m_culled;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(GridSpectrumChannel);
+
+} // namespace ns3
+
+#endif /* GRID_SPECTRUM_CHANNEL_H */
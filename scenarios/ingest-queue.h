@@ -0,0 +1,516 @@
+/*
+ * Ingest Queue
+ *
+ * Optional processing model of a gateway: datagrams the gateway receives
+ * wait in a bounded FIFO (--gatewayQueue datagrams) for one of N worker
+ * cores (--gatewayWorkers). A worker holds a datagram for the sum of one
+ * service time per reading it carries, drawn from --gatewayService
+ * (constant, exponential or uniform on [0, 2 x mean]) with mean
+ * --gatewayServiceUs, plus the modeled analytics cost (--analyticsCostUs)
+ * when the analytics stage is on. The gateway records the readings when the worker
+ * finishes, so their latency includes the wait. Without the queue the
+ * gateway processes every datagram the instant it arrives and can never
+ * be the bottleneck.
+ *
+ * When the queue is full, --gatewayPolicy decides:
+ *
+ *   droptail     - the arriving datagram is dropped
+ *   drophead     - the oldest waiting datagram is dropped to make room
+ *   backpressure - the gateway stops reading its socket until a worker
+ *                  frees a slot, so datagrams pile up in the UDP receive
+ *                  buffer (RcvBufSize) and overflow there instead
+ *
+ * A gateway that acknowledges datagrams (--reliable) must not lose one it
+ * has acknowledged: it asks WouldDrop() first and leaves a droptail drop
+ * unacknowledged, so the sensor retransmits it. drophead evicts datagrams
+ * that were acknowledged on arrival, so it cannot be combined with ACKs;
+ * under backpressure the drops happen in the socket, before any ACK.
+ *
+ * The queue reports occupancy (time-weighted mean and peak of the waiting
+ * datagrams), drops on each side and the sojourn time from arrival to
+ * the end of service.
+ */
+
+#ifndef INGEST_QUEUE_H
+#define INGEST_QUEUE_H
+
+#include "co2-batch-header.h"
+#include "latency-histogram.h"
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+enum class IngestPolicy
+{
+    DROP_TAIL,
+    DROP_HEAD,
+    BACKPRESSURE
+};
+
+enum class ServiceDistribution
+{
+    CONSTANT,
+    EXPONENTIAL,
+    UNIFORM
+};
+
+/**
+ * Parse a --gatewayPolicy value (aborts on unknown names)
+ * @param name "droptail", "drophead" or "backpressure"
+ * @return Full-queue policy
+ */
+inline IngestPolicy
+ParseIngestPolicy(const std::string& name)
+{
+    if (name == "droptail")
+    {
+        return IngestPolicy::DROP_TAIL;
+    }
+    if (name == "drophead")
+    {
+        return IngestPolicy::DROP_HEAD;
+    }
+    if (name == "backpressure")
+    {
+        return IngestPolicy::BACKPRESSURE;
+    }
+    NS_ABORT_MSG("Unknown ingest policy " << name << " (use droptail, drophead or backpressure)");
+    return IngestPolicy::DROP_TAIL;
+}
+
+/**
+ * Parse a --gatewayService value (aborts on unknown names)
+ * @param name "constant", "exponential" or "uniform"
+ * @return Service time distribution
+ */
+inline ServiceDistribution
+ParseServiceDistribution(const std::string& name)
+{
+    if (name == "constant")
+    {
+        return ServiceDistribution::CONSTANT;
+    }
+    if (name == "exponential")
+    {
+        return ServiceDistribution::EXPONENTIAL;
+    }
+    if (name == "uniform")
+    {
+        return ServiceDistribution::UNIFORM;
+    }
+    NS_ABORT_MSG("Unknown service distribution " << name
+                                                 << " (use constant, exponential or uniform)");
+    return ServiceDistribution::CONSTANT;
+}
+
+/**
+ * Settings of the ingest pipeline
+ */
+struct IngestConfig
+{
+    uint32_t workers = 1;
+    uint32_t capacity = 1000; // Waiting datagrams, not counting those in service
+    IngestPolicy policy = IngestPolicy::DROP_TAIL;
+    ServiceDistribution distribution = ServiceDistribution::EXPONENTIAL;
+    Time meanService = MicroSeconds(50); // Per reading
+    Time extraService = Seconds(0);      // Fixed per-reading cost added to each draw (analytics)
+};
+
+/**
+ * End-of-run figures of one ingest queue, or of several merged
+ */
+struct IngestReport
+{
+    uint32_t workers = 0;
+    uint32_t capacity = 0;
+    uint64_t arrivals = 0;
+    uint64_t served = 0;
+    uint64_t readingsServed = 0;
+    uint64_t drops = 0;       // At the full queue
+    uint64_t socketDrops = 0; // In the socket receive buffer
+    uint64_t backlog = 0;     // Waiting or in service at the end
+    double meanWaiting = 0.0; // Time-weighted
+    uint32_t peakWaiting = 0;
+    Time busy; // Service time handed out
+    LatencyHistogram sojourn;
+
+    /**
+     * Add another gateway's queue: counters and occupancy add up, the peak
+     * is that of the fullest queue, and the utilization becomes the mean of
+     * all workers
+     * @param other Report to merge
+     */
+    void Merge(const IngestReport& other)
+    {
+        workers += other.workers;
+        capacity += other.capacity;
+        arrivals += other.arrivals;
+        served += other.served;
+        readingsServed += other.readingsServed;
+        drops += other.drops;
+        socketDrops += other.socketDrops;
+        backlog += other.backlog;
+        meanWaiting += other.meanWaiting;
+        peakWaiting = std::max(peakWaiting, other.peakWaiting);
+        busy += other.busy;
+        sojourn.Merge(other.sojourn);
+    }
+
+    /**
+     * @param period Time the gateways were receiving
+     * @return Busy share of the workers
+     */
+    double GetUtilization(Time period) const
+    {
+        return period.IsStrictlyPositive() && workers > 0
+                   ? busy.GetSeconds() / (period.GetSeconds() * workers)
+                   : 0.0;
+    }
+
+    /**
+     * Print the occupancy, drops, sojourn time and worker load
+     * @param os Output stream
+     * @param period Time the gateways were receiving
+     */
+    void Print(std::ostream& os, Time period) const
+    {
+        os << "  Datagrams: " << arrivals << " arrived, " << served << " served (" << readingsServed
+           << " readings), " << backlog << " left at the end\n";
+        os << "  Drops: " << drops << " at the full queue, " << socketDrops
+           << " in the socket buffer\n";
+        os << "  Queue occupancy: mean " << meanWaiting << ", peak " << peakWaiting << " of "
+           << capacity << " datagrams\n";
+        os << "  Sojourn: p50 " << sojourn.GetQuantile(0.5) * 1000.0 << " ms, p99 "
+           << sojourn.GetQuantile(0.99) * 1000.0 << " ms, max " << sojourn.GetMax() * 1000.0
+           << " ms\n";
+        os << "  Worker utilization: " << GetUtilization(period) * 100.0 << "% of " << workers
+           << " cores\n";
+    }
+
+    /**
+     * Add the ingest metrics to a run summary
+     * @param summary Summary of this run
+     * @param period Time the gateways were receiving
+     */
+    void AddMetrics(RunSummary& summary, Time period) const
+    {
+        summary.AddMetric("ingestArrivals", arrivals);
+        summary.AddMetric("ingestServed", served);
+        summary.AddMetric("ingestDrops", drops);
+        summary.AddMetric("ingestSocketDrops", socketDrops);
+        summary.AddMetric("ingestBacklog", backlog);
+        summary.AddMetric("ingestQueueMean", meanWaiting);
+        summary.AddMetric("ingestQueuePeak", peakWaiting);
+        summary.AddMetric("ingestSojournP50Ms", sojourn.GetQuantile(0.5) * 1000.0);
+        summary.AddMetric("ingestSojournP99Ms", sojourn.GetQuantile(0.99) * 1000.0);
+        summary.AddMetric("ingestSojournMaxMs", sojourn.GetMax() * 1000.0);
+        summary.AddMetric("ingestUtilization", GetUtilization(period));
+    }
+};
+
+class IngestQueue : public SimpleRefCount<IngestQueue>
+{
+  public:
+    /** Processing of a datagram once a worker is done with it */
+    typedef Callback<void, Ptr<Packet>, Address> ProcessCallback;
+
+    /**
+     * @param config Workers, capacity, policy and service time
+     */
+    IngestQueue(const IngestConfig& config)
+        : m_config(config),
+          m_ring(config.capacity),
+          m_head(0),
+          m_waiting(0),
+          m_busyWorkers(0),
+          m_arrivals(0),
+          m_served(0),
+          m_readingsServed(0),
+          m_drops(0),
+          m_socketDrops(0),
+          m_peakWaiting(0),
+          m_waitingIntegral(0.0)
+    {
+        NS_ABORT_MSG_IF(config.workers == 0, "The ingest pipeline needs at least one worker");
+        NS_ABORT_MSG_IF(config.capacity == 0, "The ingest queue needs room for one datagram");
+        NS_ABORT_MSG_IF(config.meanService.IsNegative(), "The ingest service time must not be negative");
+        if (config.distribution == ServiceDistribution::EXPONENTIAL)
+        {
+            m_exponential = CreateObject<ExponentialRandomVariable>();
+        }
+        else if (config.distribution == ServiceDistribution::UNIFORM)
+        {
+            m_uniform = CreateObject<UniformRandomVariable>();
+        }
+    }
+
+    /**
+     * @param process Called with each datagram when its service ends
+     * @param resume Called when a worker frees a slot under backpressure, so the
+     *        gateway reads its socket again
+     */
+    void SetHandlers(ProcessCallback process, Callback<void> resume)
+    {
+        m_process = process;
+        m_resume = resume;
+    }
+
+    /**
+     * Count the datagrams the socket's receive buffer overflows on (backpressure)
+     * @param socket UDP socket of the gateway
+     */
+    void WatchSocket(Ptr<Socket> socket)
+    {
+        socket->TraceConnectWithoutContext("Drop", MakeCallback(&IngestQueue::SocketDrop, this));
+    }
+
+    /**
+     * Bind the service time variable to a fixed stream
+     * @param stream Stream index to use
+     * @return Number of streams consumed
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        if (m_exponential)
+        {
+            m_exponential->SetStream(stream);
+        }
+        if (m_uniform)
+        {
+            m_uniform->SetStream(stream);
+        }
+        return 1;
+    }
+
+    /** @return True if the gateway should leave datagrams in its socket for now */
+    bool IsBlocking(void) const
+    {
+        return m_config.policy == IngestPolicy::BACKPRESSURE && m_busyWorkers == m_config.workers &&
+               m_waiting == m_config.capacity;
+    }
+
+    /** @return True if Enqueue() would drop the next datagram (droptail, queue full) */
+    bool WouldDrop(void) const
+    {
+        return m_config.policy == IngestPolicy::DROP_TAIL && m_busyWorkers == m_config.workers &&
+               m_waiting == m_config.capacity;
+    }
+
+    /**
+     * Hand a received datagram to the pipeline
+     * @param packet Datagram
+     * @param from Sender
+     */
+    void Enqueue(Ptr<Packet> packet, Address from)
+    {
+        m_arrivals++;
+        if (m_busyWorkers < m_config.workers)
+        {
+            Serve(packet, from, Simulator::Now());
+            return;
+        }
+        UpdateWaiting();
+        if (m_waiting == m_config.capacity)
+        {
+            // Under backpressure the gateway stops reading before this happens
+            m_drops++;
+            if (m_config.policy != IngestPolicy::DROP_HEAD)
+            {
+                return;
+            }
+            m_ring[m_head] = Item();
+            m_head = (m_head + 1) % m_config.capacity;
+            m_waiting--;
+        }
+        Item& item = m_ring[(m_head + m_waiting) % m_config.capacity];
+        item.packet = packet;
+        item.from = from;
+        item.arrived = Simulator::Now();
+        m_waiting++;
+        m_peakWaiting = std::max(m_peakWaiting, m_waiting);
+    }
+
+    /** @return Datagrams waiting or in service */
+    uint32_t GetBacklog(void) const
+    {
+        return m_waiting + m_busyWorkers;
+    }
+
+    /** @return Datagrams dropped by a full queue */
+    uint64_t GetDrops(void) const
+    {
+        return m_drops;
+    }
+
+    /** @return Datagrams the gateway socket dropped (receive buffer full) */
+    uint64_t GetSocketDrops(void) const
+    {
+        return m_socketDrops;
+    }
+
+    /** @return Time from arrival to the end of service of every served datagram */
+    const LatencyHistogram& GetSojourn(void) const
+    {
+        return m_sojourn;
+    }
+
+    /** @return Figures of the run so far, to print or merge with other gateways' */
+    IngestReport GetReport(void) const
+    {
+        IngestReport report;
+        report.workers = m_config.workers;
+        report.capacity = m_config.capacity;
+        report.arrivals = m_arrivals;
+        report.served = m_served;
+        report.readingsServed = m_readingsServed;
+        report.drops = m_drops;
+        report.socketDrops = m_socketDrops;
+        report.backlog = GetBacklog();
+        report.meanWaiting = GetMeanWaiting();
+        report.peakWaiting = m_peakWaiting;
+        report.busy = m_busy;
+        report.sojourn = m_sojourn;
+        return report;
+    }
+
+    /**
+     * Print the occupancy, drops, sojourn time and worker load
+     * @param os Output stream
+     * @param period Time the gateway was receiving
+     */
+    void Print(std::ostream& os, Time period) const
+    {
+        GetReport().Print(os, period);
+    }
+
+    /**
+     * Add the ingest metrics to a run summary
+     * @param summary Summary of this run
+     * @param period Time the gateway was receiving
+     */
+    void AddMetrics(RunSummary& summary, Time period) const
+    {
+        GetReport().AddMetrics(summary, period);
+    }
+
+  private:
+    struct Item
+    {
+        Ptr<Packet> packet;
+        Address from;
+        Time arrived;
+    };
+
+    void Serve(Ptr<Packet> packet, Address from, Time arrived)
+    {
+        uint32_t readings = 1;
+        if (CO2BatchHeader::IsBatchPayload(packet))
+        {
+            CO2BatchHeader header;
+            packet->PeekHeader(header);
+            readings = std::max<uint32_t>(header.GetCount(), 1);
+        }
+        Time service = Seconds(0);
+        for (uint32_t i = 0; i < readings; ++i)
+        {
+            service += DrawService() + m_config.extraService;
+        }
+        m_busyWorkers++;
+        m_busy += service;
+        m_readingsServed += readings;
+        Simulator::Schedule(service, &IngestQueue::Finish, this, packet, from, arrived);
+    }
+
+    void Finish(Ptr<Packet> packet, Address from, Time arrived)
+    {
+        m_busyWorkers--;
+        m_served++;
+        m_sojourn.Add(Simulator::Now() - arrived);
+        // A full queue under backpressure means the gateway stopped reading its socket
+        bool blocked = m_config.policy == IngestPolicy::BACKPRESSURE && m_waiting == m_config.capacity;
+        if (m_waiting > 0)
+        {
+            UpdateWaiting();
+            Item next = m_ring[m_head];
+            m_ring[m_head] = Item();
+            m_head = (m_head + 1) % m_config.capacity;
+            m_waiting--;
+            Serve(next.packet, next.from, next.arrived);
+        }
+        m_process(packet, from);
+        if (blocked)
+        {
+            m_resume();
+        }
+    }
+
+    Time DrawService(void)
+    {
+        double mean = m_config.meanService.GetSeconds();
+        switch (m_config.distribution)
+        {
+        case ServiceDistribution::EXPONENTIAL:
+            return Seconds(m_exponential->GetValue(mean, 0));
+        case ServiceDistribution::UNIFORM:
+            return Seconds(m_uniform->GetValue(0.0, 2.0 * mean));
+        default:
+            return m_config.meanService;
+        }
+    }
+
+    void SocketDrop(Ptr<const Packet> /* packet */)
+    {
+        m_socketDrops++;
+    }
+
+    /** Integrate the waiting count up to now (call before it changes) */
+    void UpdateWaiting(void)
+    {
+        Time now = Simulator::Now();
+        m_waitingIntegral += m_waiting * (now - m_waitingUpdated).GetSeconds();
+        m_waitingUpdated = now;
+    }
+
+    /** @return Time-weighted mean of the waiting datagrams since the start of the run */
+    double GetMeanWaiting(void) const
+    {
+        double elapsed = Simulator::Now().GetSeconds();
+        double integral =
+            m_waitingIntegral + m_waiting * (Simulator::Now() - m_waitingUpdated).GetSeconds();
+        return elapsed > 0 ? integral / elapsed : 0.0;
+    }
+
+    IngestConfig m_config;
+    std::vector<Item> m_ring; // Waiting datagrams, m_head first
+    uint32_t m_head;
+    uint32_t m_waiting;
+    uint32_t m_busyWorkers;
+    ProcessCallback m_process;
+    Callback<void> m_resume;
+    Ptr<ExponentialRandomVariable> m_exponential; // Null unless the service is exponential
+    Ptr<UniformRandomVariable> m_uniform;         // Null unless the service is uniform
+    uint64_t m_arrivals;
+    uint64_t m_served;
+    uint64_t m_readingsServed;
+    uint64_t m_drops;
+    uint64_t m_socketDrops;
+    uint32_t m_peakWaiting;
+    double m_waitingIntegral; // Datagrams x seconds
+    Time m_waitingUpdated;
+    Time m_busy; // Service time handed out, including services in progress
+    LatencyHistogram m_sojourn;
+};
+
+} // namespace ns3
+
+#endif /* INGEST_QUEUE_H */
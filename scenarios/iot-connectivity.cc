@@ -28,243 +28,140 @@
 #include "ns3/network-module.h"
 #include "ns3/wifi-module.h"
 
+#ifdef __linux__
+// Only built on Linux; needed by --emulate
+#include "ns3/fd-net-device-module.h"
+#endif
+
+#include "alloc-counter.h"
+#include "carbon-analytics.h"
+#include "carbon-stats.h"
+#include "co2-batch-codec.h"
+#include "co2-batch-header.h"
+#include "co2-reading-header.h"
+#include "co2-sensor-app.h"
+#include "co2-trace.h"
+#include "emission-model.h"
+#include "event-log.h"
+#include "flow-metrics-collector.h"
+#include "ingest-queue.h"
+#include "realtime-lag-monitor.h"
+#include "reliable-delivery.h"
+#include "run-profiler.h"
+#include "run-summary.h"
+#include "sensor-tick-scheduler.h"
+#include "star-simple-channel.h"
+#include "telemetry-stream.h"
+#include "tracing-profile.h"
+#include "wifi-airtime.h"
+#include "wifi-config.h"
+#include "wifi-medium.h"
+
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("EcoLedgerCarbonTrading");
 
-// Global variables for tracking carbon data
-std::map<uint32_t, double> totalCO2BySensor;      // Track total CO2 per sensor
-std::map<uint32_t, uint32_t> packetCountBySensor; // Track packets per sensor
-uint32_t totalPacketsReceived = 0;
-uint32_t totalPacketsSent = 0;
-
 /*
- * Custom Application: CO2 Sensor Node
+ * Custom Application: Carbon Trading Gateway
  *
- * This application simulates an IoT CO2 sensor that:
- * - Periodically generates CO2 readings (simulated values)
- * - Packages the data with sensor ID and company information
- * - Transmits data to the gateway via UDP
+ * This application simulates the central data collection gateway that:
+ * - Receives CO2 data from all sensor nodes
+ * - Parses and logs sensor readings
+ * - Aggregates data for carbon trading calculations
+ * - With --reliable, drops duplicates and broadcasts batched ACKs to the
+ *   sensors (see reliable-delivery.h)
  *
- * In a real carbon trading scenario, these sensors would be deployed at:
- * - Manufacturing facilities
- * - Transportation hubs
- * - Energy production sites
- * - Agricultural operations
+ * In a real system, this gateway would:
+ * - Store data in a blockchain ledger for transparency
+ * - Calculate carbon credits/debits
+ * - Generate reports for regulatory compliance
+ * - Enable carbon credit trading between companies
  */
-class CO2SensorApplication : public Application
+class CarbonGatewayApplication : public Application
 {
   public:
-    CO2SensorApplication();
-    virtual ~CO2SensorApplication();
+    CarbonGatewayApplication();
+    virtual ~CarbonGatewayApplication();
+
+    void Setup(Ptr<Socket> socket, uint16_t port);
 
     /**
-     * Setup the sensor application
-     * @param socket UDP socket for transmission
-     * @param gatewayAddress Gateway IP address
-     * @param gatewayPort Gateway listening port
-     * @param sensorId Unique sensor identifier
-     * @param companyId Company/organization identifier
-     * @param baselineCO2 Baseline CO2 level for this sensor location
+     * Carbon accounting records of this gateway
+     * Call Reserve() on it before the run to keep the receive path allocation-free.
      */
-    void Setup(Ptr<Socket> socket,
-               Address gatewayAddress,
-               uint16_t gatewayPort,
-               uint32_t sensorId,
-               uint32_t companyId,
-               double baselineCO2);
+    CarbonStatsStore& GetStats(void);
 
-  private:
-    virtual void StartApplication(void);
-    virtual void StopApplication(void);
+    /** @return Number of datagrams received, including malformed ones */
+    uint32_t GetPacketsReceived(void) const;
+
+    /** @return Mean time from reading to reception at the gateway, in seconds */
+    double GetMeanLatency(void) const;
 
     /**
-     * Generate and send CO2 sensor reading
-     * Simulates reading from physical CO2 sensor and transmitting to gateway
+     * Modeled decoding cost and codec counters of the batch decoder
+     * @param config Decoding cost per reading (the codec comes with each batch)
+     * @param stats Counters shared by all encoders and decoders (null = off)
      */
-    void SendCO2Reading(void);
+    void SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats);
 
     /**
-     * Generate realistic CO2 value
-     * Simulates actual sensor readings with variations
+     * Report receptions to the windowed flow metrics
+     * @param metrics Collector shared by all applications (null = off)
      */
-    double GenerateCO2Value(void);
-
-    Ptr<Socket> m_socket;
-    Address m_gatewayAddress;
-    uint16_t m_gatewayPort;
-    uint32_t m_sensorId;
-    uint32_t m_companyId;
-    double m_baselineCO2; // Baseline CO2 level (ppm)
-    EventId m_sendEvent;
-    Time m_interval; // Time between sensor readings
-    bool m_running;
-};
-
-CO2SensorApplication::CO2SensorApplication()
-    : m_socket(0),
-      m_gatewayPort(0),
-      m_sensorId(0),
-      m_companyId(0),
-      m_baselineCO2(400.0),     // Normal atmospheric CO2 ~400 ppm
-      m_interval(Seconds(5.0)), // Send reading every 5 seconds
-      m_running(false)
-{
-}
-
-CO2SensorApplication::~CO2SensorApplication()
-{
-    m_socket = 0;
-}
-
-void
-CO2SensorApplication::Setup(Ptr<Socket> socket,
-                            Address gatewayAddress,
-                            uint16_t gatewayPort,
-                            uint32_t sensorId,
-                            uint32_t companyId,
-                            double baselineCO2)
-{
-    m_socket = socket;
-    m_gatewayAddress = gatewayAddress;
-    m_gatewayPort = gatewayPort;
-    m_sensorId = sensorId;
-    m_companyId = companyId;
-    m_baselineCO2 = baselineCO2;
-}
-
-void
-CO2SensorApplication::StartApplication(void)
-{
-    m_running = true;
-    m_socket->Bind();
-    m_socket->Connect(m_gatewayAddress);
-
-    NS_LOG_INFO("CO2 Sensor " << m_sensorId << " (Company " << m_companyId << ") started at "
-                              << Simulator::Now().GetSeconds() << "s");
-
-    // Send first reading immediately
-    SendCO2Reading();
-}
-
-void
-CO2SensorApplication::StopApplication(void)
-{
-    m_running = false;
-
-    if (m_sendEvent.IsPending())
-    {
-        Simulator::Cancel(m_sendEvent);
-    }
-
-    if (m_socket)
-    {
-        m_socket->Close();
-    }
+    void SetMetrics(Ptr<FlowMetricsCollector> metrics);
 
-    NS_LOG_INFO("CO2 Sensor " << m_sensorId << " stopped at " << Simulator::Now().GetSeconds()
-                              << "s");
-}
-
-double
-CO2SensorApplication::GenerateCO2Value(void)
-{
-    // Generate realistic CO2 values with random variations
-    // Industrial sites typically have 400-2000 ppm CO2
-    // Add random variation ±50 ppm to simulate real sensor readings
-
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
-    double variation = rand->GetValue(-50.0, 50.0);
-    double co2Value = m_baselineCO2 + variation;
-
-    // Ensure value stays positive and realistic
-    if (co2Value < 300.0)
-    {
-        co2Value = 300.0;
-    }
-    if (co2Value > 3000.0)
-    {
-        co2Value = 3000.0;
-    }
-
-    return co2Value;
-}
-
-void
-CO2SensorApplication::SendCO2Reading(void)
-{
-    /*
-     * Carbon Trading Data Packet Format:
-     * [SensorID:4bytes][CompanyID:4bytes][CO2Value:8bytes][Timestamp:8bytes]
-     *
-     * This packet contains all necessary information for carbon accounting:
-     * - Which sensor detected the emission (location tracking)
-     * - Which company/facility owns the sensor (accountability)
-     * - CO2 level in ppm (carbon footprint data)
-     * - When the reading was taken (temporal tracking)
+    /**
+     * Run every recorded reading through the streaming analytics stage
+     * @param analytics Anomaly detector and window rollups (null = off)
      */
+    void SetAnalytics(Ptr<CarbonAnalytics> analytics);
 
-    double co2Value = GenerateCO2Value();
-    uint64_t timestamp = Simulator::Now().GetMicroSeconds();
-
-    // Create packet with sensor data
-    std::ostringstream oss;
-    oss << "SENSOR:" << m_sensorId << ",COMPANY:" << m_companyId << ",CO2:" << co2Value
-        << ",TIME:" << timestamp;
-
-    std::string data = oss.str();
-    Ptr<Packet> packet = Create<Packet>((uint8_t*)data.c_str(), data.length());
+    /**
+     * Process datagrams through a modeled ingest pipeline instead of instantly
+     * @param queue Bounded queue and workers of this gateway (null = off)
+     */
+    void SetIngestQueue(Ptr<IngestQueue> queue);
 
-    // Transmit to gateway
-    int actual = m_socket->Send(packet);
+    /**
+     * Record receptions in a binary event log
+     * @param log Log shared by all applications (null = off)
+     */
+    void SetEventLog(Ptr<EventLog> log);
 
-    if (actual > 0)
-    {
-        totalPacketsSent++;
-        NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: "
-                            << "Sensor " << m_sensorId << " (Company " << m_companyId << ") "
-                            << "transmitted CO2 reading: " << co2Value << " ppm "
-                            << "[Packet " << totalPacketsSent << " sent to gateway]");
-    }
-    else
-    {
-        NS_LOG_WARN("Sensor " << m_sensorId << " failed to send packet");
-    }
+    /**
+     * Forward every received datagram, unchanged, to an external ingest service
+     * @param socket UDP socket of the gateway node
+     * @param ingest Address of the service
+     */
+    void SetUpstream(Ptr<Socket> socket, Address ingest);
 
-    // Schedule next reading
-    if (m_running)
-    {
-        m_sendEvent = Simulator::Schedule(m_interval, &CO2SensorApplication::SendCO2Reading, this);
-    }
-}
+    /** @return Datagrams forwarded to the ingest service */
+    uint64_t GetUpstreamSent(void) const;
 
-/*
- * Custom Application: Carbon Trading Gateway
- *
- * This application simulates the central data collection gateway that:
- * - Receives CO2 data from all sensor nodes
- * - Parses and logs sensor readings
- * - Aggregates data for carbon trading calculations
- * - Sends acknowledgments back to sensors
- *
- * In a real system, this gateway would:
- * - Store data in a blockchain ledger for transparency
- * - Calculate carbon credits/debits
- * - Generate reports for regulatory compliance
- * - Enable carbon credit trading between companies
- */
-class CarbonGatewayApplication : public Application
-{
-  public:
-    CarbonGatewayApplication();
-    virtual ~CarbonGatewayApplication();
+    /** @return Datagrams the upstream socket refused */
+    uint64_t GetUpstreamFailed(void) const;
 
-    void Setup(Ptr<Socket> socket, uint16_t port);
+    /**
+     * Acknowledge sequenced datagrams and drop their duplicates
+     * @param ackSocket UDP socket the ACKs are broadcast from
+     * @param ackDestination Broadcast address and ACK port of the sensor subnet
+     * @param nSensors Number of sensors (IDs 1 to nSensors)
+     * @param config ACK delay
+     * @param stats Counters shared by all senders and receivers (null = off)
+     */
+    void SetReliability(Ptr<Socket> ackSocket,
+                        Address ackDestination,
+                        uint32_t nSensors,
+                        const ReliabilityConfig& config,
+                        Ptr<ReliabilityStats> stats);
 
   private:
     virtual void StartApplication(void);
@@ -276,6 +173,9 @@ class CarbonGatewayApplication : public Application
      */
     void HandleRead(Ptr<Socket> socket);
 
+    /** Read the socket again once the ingest queue has room (backpressure) */
+    void ResumeRead(void);
+
     /**
      * Parse and process CO2 sensor data packet
      * Extracts sensor info and logs for carbon accounting
@@ -283,25 +183,58 @@ class CarbonGatewayApplication : public Application
     void ProcessCO2Data(Ptr<Packet> packet, Address from);
 
     /**
-     * Send acknowledgment back to sensor
-     * Confirms data receipt for reliability
+     * Process a CO2BatchHeader datagram from a batching sensor
+     */
+    void ProcessBatch(Ptr<Packet> packet, Address from);
+
+    /**
+     * Account one decoded reading
+     * @param bytes Bytes the reading took on the wire (for the event log)
+     * @param decodeDelay Modeled time until the reading was decoded
      */
-    void SendAcknowledgment(Ptr<Socket> socket, Address to, uint32_t sensorId);
+    void RecordReading(uint32_t sensorId,
+                       uint32_t companyId,
+                       double co2Value,
+                       uint64_t timestamp,
+                       uint32_t bytes,
+                       Time decodeDelay,
+                       Address from);
 
     Ptr<Socket> m_socket;
     uint16_t m_port;
     Address m_local;
+    CarbonStatsStore m_stats;
+    uint32_t m_packetsReceived;
+    double m_latencySum; // s, over m_latencyCount readings
+    uint64_t m_latencyCount;
+    CO2BatchDecoder m_decoder;
+    Ptr<FlowMetricsCollector> m_metrics; // Null unless the tracing profile collects metrics
+    Ptr<CarbonAnalytics> m_analytics;    // Null unless --analytics is set
+    AnalyticsCore m_analyticsCore;       // Analytics CPU when there are no ingest workers
+    Ptr<IngestQueue> m_ingestQueue;      // Null unless --gatewayWorkers is set
+    Ptr<EventLog> m_eventLog;            // Null unless --eventLog is set
+    Ptr<Socket> m_upstream;              // Null unless --emulate is set
+    Address m_ingest;
+    uint64_t m_upstreamSent;
+    uint64_t m_upstreamFailed;
+    AckBatcher m_acks; // Disabled unless --reliable is set
 };
 
 CarbonGatewayApplication::CarbonGatewayApplication()
     : m_socket(0),
-      m_port(0)
+      m_port(0),
+      m_packetsReceived(0),
+      m_latencySum(0.0),
+      m_latencyCount(0),
+      m_upstreamSent(0),
+      m_upstreamFailed(0)
 {
 }
 
 CarbonGatewayApplication::~CarbonGatewayApplication()
 {
     m_socket = 0;
+    m_upstream = 0;
 }
 
 void
@@ -311,6 +244,87 @@ CarbonGatewayApplication::Setup(Ptr<Socket> socket, uint16_t port)
     m_port = port;
 }
 
+CarbonStatsStore&
+CarbonGatewayApplication::GetStats(void)
+{
+    return m_stats;
+}
+
+uint32_t
+CarbonGatewayApplication::GetPacketsReceived(void) const
+{
+    return m_packetsReceived;
+}
+
+double
+CarbonGatewayApplication::GetMeanLatency(void) const
+{
+    return m_latencyCount > 0 ? m_latencySum / m_latencyCount : 0.0;
+}
+
+void
+CarbonGatewayApplication::SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+{
+    m_decoder.SetCodec(config, stats);
+}
+
+void
+CarbonGatewayApplication::SetMetrics(Ptr<FlowMetricsCollector> metrics)
+{
+    m_metrics = metrics;
+}
+
+void
+CarbonGatewayApplication::SetAnalytics(Ptr<CarbonAnalytics> analytics)
+{
+    m_analytics = analytics;
+}
+
+void
+CarbonGatewayApplication::SetIngestQueue(Ptr<IngestQueue> queue)
+{
+    m_ingestQueue = queue;
+    m_ingestQueue->SetHandlers(MakeCallback(&CarbonGatewayApplication::ProcessCO2Data, this),
+                               MakeCallback(&CarbonGatewayApplication::ResumeRead, this));
+    m_ingestQueue->WatchSocket(m_socket);
+}
+
+void
+CarbonGatewayApplication::SetEventLog(Ptr<EventLog> log)
+{
+    m_eventLog = log;
+}
+
+void
+CarbonGatewayApplication::SetUpstream(Ptr<Socket> socket, Address ingest)
+{
+    m_upstream = socket;
+    m_ingest = ingest;
+}
+
+uint64_t
+CarbonGatewayApplication::GetUpstreamSent(void) const
+{
+    return m_upstreamSent;
+}
+
+uint64_t
+CarbonGatewayApplication::GetUpstreamFailed(void) const
+{
+    return m_upstreamFailed;
+}
+
+void
+CarbonGatewayApplication::SetReliability(Ptr<Socket> ackSocket,
+                                         Address ackDestination,
+                                         uint32_t nSensors,
+                                         const ReliabilityConfig& config,
+                                         Ptr<ReliabilityStats> stats)
+{
+    m_acks.Setup(ackSocket, ackDestination, 0, config, stats);
+    m_acks.Reserve(1, nSensors);
+}
+
 void
 CarbonGatewayApplication::StartApplication(void)
 {
@@ -318,6 +332,15 @@ CarbonGatewayApplication::StartApplication(void)
     InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), m_port);
     m_socket->Bind(local);
     m_socket->SetRecvCallback(MakeCallback(&CarbonGatewayApplication::HandleRead, this));
+    if (m_upstream)
+    {
+        m_upstream->Bind();
+        m_upstream->Connect(m_ingest);
+    }
+    if (m_acks.IsEnabled())
+    {
+        m_acks.Start();
+    }
 
     NS_LOG_INFO("Carbon Trading Gateway started on port " << m_port << " at time "
                                                           << Simulator::Now().GetSeconds() << "s");
@@ -332,22 +355,31 @@ CarbonGatewayApplication::StopApplication(void)
         m_socket->Close();
         m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
+    if (m_upstream)
+    {
+        m_upstream->Close();
+    }
+    if (m_acks.IsEnabled())
+    {
+        m_acks.Stop();
+    }
 
     NS_LOG_INFO("Carbon Trading Gateway stopped at " << Simulator::Now().GetSeconds() << "s");
 
     // Print final carbon accounting summary
     NS_LOG_INFO("=== CARBON TRADING SUMMARY ===");
-    NS_LOG_INFO("Total sensor readings received: " << totalPacketsReceived);
+    NS_LOG_INFO("Total sensor readings received: " << m_stats.GetTotalReadings());
 
-    for (const auto& entry : totalCO2BySensor)
+    const std::vector<RunningStats>& sensors = m_stats.GetSensors();
+    for (uint32_t sensorId = 0; sensorId < sensors.size(); ++sensorId)
     {
-        uint32_t sensorId = entry.first;
-        double totalCO2 = entry.second;
-        uint32_t packetCount = packetCountBySensor[sensorId];
-        double avgCO2 = totalCO2 / packetCount;
-
-        NS_LOG_INFO("Sensor " << sensorId << ": " << packetCount << " readings, "
-                              << "Average CO2 = " << avgCO2 << " ppm");
+        const RunningStats& stats = sensors[sensorId];
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        NS_LOG_INFO("Sensor " << sensorId << ": " << stats.count << " readings, "
+                              << "Average CO2 = " << stats.mean << " ppm");
     }
 }
 
@@ -357,19 +389,53 @@ CarbonGatewayApplication::HandleRead(Ptr<Socket> socket)
     Ptr<Packet> packet;
     Address from;
 
-    while ((packet = socket->RecvFrom(from)))
+    // Under backpressure, datagrams stay in the socket while the ingest queue is full
+    while ((!m_ingestQueue || !m_ingestQueue->IsBlocking()) && (packet = socket->RecvFrom(from)))
     {
         if (packet->GetSize() > 0)
         {
-            totalPacketsReceived++;
-            ProcessCO2Data(packet, from);
-
-            // In a real system, gateway would send acknowledgment
-            // For now, we just log the receipt
+            m_packetsReceived++;
+            if (m_acks.IsEnabled() && m_ingestQueue && m_ingestQueue->WouldDrop())
+            {
+                // Dropped before it is acknowledged, so the sensor sends it again
+                m_ingestQueue->Enqueue(packet, from);
+                continue;
+            }
+            if (m_acks.IsEnabled() && CO2SequenceHeader::IsSequencedPayload(packet) &&
+                !m_acks.Accept(packet))
+            {
+                continue; // Retransmission of a datagram already recorded, or a stray sensor
+            }
+            if (m_upstream)
+            {
+                // The live collector gets the readings exactly as the sensor encoded them
+                if (m_upstream->Send(packet->Copy()) > 0)
+                {
+                    m_upstreamSent++;
+                }
+                else
+                {
+                    m_upstreamFailed++;
+                }
+            }
+            if (m_ingestQueue)
+            {
+                m_ingestQueue->Enqueue(packet, from);
+            }
+            else
+            {
+                ProcessCO2Data(packet, from);
+            }
         }
     }
 }
 
+void
+CarbonGatewayApplication::ResumeRead(void)
+{
+    HandleRead(m_socket);
+}
+
 void
 CarbonGatewayApplication::ProcessCO2Data(Ptr<Packet> packet, Address from)
 {
@@ -391,67 +457,136 @@ CarbonGatewayApplication::ProcessCO2Data(Ptr<Packet> packet, Address from)
      * - Regulatory reporting and compliance verification
      */
 
-    uint8_t buffer[1024];
-    packet->CopyData(buffer, packet->GetSize());
-    buffer[packet->GetSize()] = '\0';
-
-    std::string data((char*)buffer);
+    if (CO2BatchHeader::IsBatchPayload(packet))
+    {
+        ProcessBatch(packet, from);
+        return;
+    }
 
     // Parse sensor data packet
-    uint32_t sensorId = 0;
-    uint32_t companyId = 0;
-    double co2Value = 0.0;
-    uint64_t timestamp = 0;
-
-    size_t sensorPos = data.find("SENSOR:");
-    size_t companyPos = data.find("COMPANY:");
-    size_t co2Pos = data.find("CO2:");
-    size_t timePos = data.find("TIME:");
-
-    if (sensorPos != std::string::npos && companyPos != std::string::npos &&
-        co2Pos != std::string::npos && timePos != std::string::npos)
-    {
-        // Extract values from packet
-        sensorId = std::stoi(data.substr(sensorPos + 7, companyPos - sensorPos - 8));
-        companyId = std::stoi(data.substr(companyPos + 8, co2Pos - companyPos - 9));
-        co2Value = std::stod(data.substr(co2Pos + 4, timePos - co2Pos - 5));
-        timestamp = std::stoull(data.substr(timePos + 5));
-
-        // Update carbon accounting records
-        totalCO2BySensor[sensorId] += co2Value;
-        packetCountBySensor[sensorId]++;
-
-        InetSocketAddress inetFrom = InetSocketAddress::ConvertFrom(from);
-
-        NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: "
-                            << "Gateway received CO2 data from Sensor " << sensorId << " (Company "
-                            << companyId << ") "
-                            << "- CO2 Level: " << co2Value << " ppm "
-                            << "[Source: " << inetFrom.GetIpv4() << "] "
-                            << "[Packet " << totalPacketsReceived << " logged for carbon trading]");
-
-        // In a production system, this data would be:
-        // - Written to blockchain for immutable record
-        // - Forwarded to carbon credit calculation engine
-        // - Used to update company carbon balance
-        // - Made available for carbon trading marketplace
+    uint32_t size = packet->GetSize();
+    CO2ReadingHeader reading;
+    bool valid = false;
+
+    {
+        AllocScope scope(ALLOC_GATEWAY_DECODE);
+        if (CO2ReadingHeader::IsBinaryPayload(packet))
+        {
+            // Binary header: fixed-width fields, no copies or allocations
+            packet->RemoveHeader(reading);
+            valid = true;
+        }
+        else
+        {
+            valid = ParseTextReading(packet, reading);
+        }
+    }
+
+    if (valid)
+    {
+        RecordReading(reading.GetSensorId(),
+                      reading.GetCompanyId(),
+                      reading.GetCo2Ppm(),
+                      reading.GetTimestamp(),
+                      size,
+                      Time(0),
+                      from);
     }
     else
     {
         NS_LOG_WARN("Gateway received malformed packet from "
                     << InetSocketAddress::ConvertFrom(from).GetIpv4());
+        if (m_eventLog)
+        {
+            m_eventLog->Record(EVENT_GATEWAY_MALFORMED, GetNode()->GetId(), 0, 0, size);
+        }
+    }
+}
+
+void
+CarbonGatewayApplication::ProcessBatch(Ptr<Packet> packet, Address from)
+{
+    uint32_t count = m_decoder.Decode(packet);
+    if (m_decoder.IsTruncated())
+    {
+        uint32_t announced = m_decoder.GetHeader().GetCount();
+        NS_LOG_WARN("Gateway received truncated batch from "
+                    << InetSocketAddress::ConvertFrom(from).GetIpv4() << " (" << announced
+                    << " readings announced, " << count << " decoded)");
+        if (m_eventLog)
+        {
+            m_eventLog->Record(EVENT_GATEWAY_MALFORMED, GetNode()->GetId(), announced, 0, packet->GetSize());
+        }
+    }
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Readings are decoded one after the other, and share the batch bytes evenly
+    uint32_t bytes = (packet->GetSize() - CO2BatchHeader::SERIALIZED_SIZE) / count;
+    Time decodeCost = m_decoder.GetConfig().decodeCost;
+    const std::vector<CO2ReadingHeader>& readings = m_decoder.GetReadings();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const CO2ReadingHeader& reading = readings[i];
+        RecordReading(reading.GetSensorId(),
+                      reading.GetCompanyId(),
+                      reading.GetCo2Ppm(),
+                      reading.GetTimestamp(),
+                      bytes,
+                      decodeCost * (i + 1),
+                      from);
     }
 }
 
 void
-CarbonGatewayApplication::SendAcknowledgment(Ptr<Socket> socket, Address to, uint32_t sensorId)
+CarbonGatewayApplication::RecordReading(uint32_t sensorId,
+                                        uint32_t companyId,
+                                        double co2Value,
+                                        uint64_t timestamp,
+                                        uint32_t bytes,
+                                        Time decodeDelay,
+                                        Address from)
 {
-    std::ostringstream oss;
-    oss << "ACK:SENSOR:" << sensorId;
-    std::string ack = oss.str();
+    // Update carbon accounting records (no zones in the single-tier network)
+    m_stats.Record(sensorId, 0, companyId, co2Value);
+    if (m_analytics)
+    {
+        m_analytics->Record(sensorId, 0, companyId, co2Value);
+        if (!m_ingestQueue)
+        {
+            // Ingest workers already charged the cost in their service time
+            Time done = m_analyticsCore.Run(Simulator::Now() + decodeDelay,
+                                            m_analytics->GetCostPerReading());
+            decodeDelay = done - Simulator::Now();
+        }
+    }
+    Time latency = Simulator::Now() + decodeDelay - MicroSeconds(timestamp);
+    m_stats.RecordLatency(0, companyId, latency);
+    m_latencySum += latency.GetSeconds();
+    m_latencyCount++;
+    if (m_metrics)
+    {
+        m_metrics->RecordReceive(sensorId, 0, bytes, latency, co2Value);
+    }
+    if (m_eventLog)
+    {
+        m_eventLog->Record(EVENT_GATEWAY_RECEIVE, GetNode()->GetId(), sensorId, 0, bytes);
+    }
 
-    Ptr<Packet> ackPacket = Create<Packet>((uint8_t*)ack.c_str(), ack.length());
-    socket->SendTo(ackPacket, 0, to);
+    NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: "
+                         << "Gateway received CO2 data from Sensor " << sensorId << " (Company "
+                         << companyId << ") "
+                         << "- CO2 Level: " << co2Value << " ppm "
+                         << "[Source: " << InetSocketAddress::ConvertFrom(from).GetIpv4() << "] "
+                         << "[Packet " << m_packetsReceived << " logged for carbon trading]");
+
+    // In a production system, this data would be:
+    // - Written to blockchain for immutable record
+    // - Forwarded to carbon credit calculation engine
+    // - Used to update company carbon balance
+    // - Made available for carbon trading marketplace
 }
 
 /*
@@ -488,16 +623,263 @@ main(int argc, char* argv[])
     // Enable detailed logging for carbon data flow
     bool verbose = true;
 
+    // Sensor payload encoding: "binary" (CO2ReadingHeader) or "text" (legacy ASCII)
+    std::string payload = "binary";
+
+    // CO2 emission model: uniform, diurnal, shift, ar1 or step
+    std::string emissionModel = "uniform";
+
+    // Recorded CO2 trace to replay instead of the emission model (empty = off)
+    std::string traceFile = "";
+    double traceOffset = 1.0; // Simulation time at which the trace start is replayed
+
+    // Shared sensor tick scheduler: one pending event per (period, phase) bucket
+    // instead of one per sensor
+    bool tickScheduler = false;
+    double tickResolutionMs = 1.0; // Phase slot width of the tick scheduler
+
+    // WiFi channel implementation: yans, spectrum (unculled) or grid (spatially culled)
+    std::string wifiChannel = "yans";
+    double cullThresholdDbm = -101.0; // Grid channel delivery threshold
+
+    // 802.11 standard, band and rate control (see wifi-config.h)
+    std::string wifiStandard = "b";
+    std::string wifiBand = "auto";     // auto = the standard's default band
+    uint16_t channelWidth = 0;         // MHz, 0 = 20 (22 for 802.11b)
+    std::string rateManager = "constant";
+    std::string dataMode = "";         // Constant rate modes, empty = lowest mode of the standard
+    std::string controlMode = "";
+    std::string association = "standard"; // standard (STA/AP handshake) or fast (ad hoc)
+    double warmupS = 1.0;              // First sensor start; the rest follow at 0.5 s steps
+    double startSpreadS = 0.0;         // Spread sensor starts evenly over this instead (0 = off)
+
+    // Real-time emulation: the gateway forwards every sensor datagram to a live ingest
+    // service on the host, through a tap device (needs root, see README)
+    bool emulate = false;
+    std::string tapName = "carbon0";         // Host tap device created for the gateway
+    std::string tapNetwork = "10.3.0.0";     // Tap /24: the gateway is .1, the host .2
+    std::string ingestAddress = "";          // Ingest service, empty = the host end of the tap
+    uint16_t ingestPort = 9100;
+    std::string realtimeMode = "besteffort"; // Realtime scheduler: besteffort or hardlimit
+    double lagLimitMs = 100.0;  // Lag counted as an overrun (hardlimit: aborts the run)
+    double lagSampleMs = 100.0; // Simulation time between lag samples
+
+    // Link model: full 802.11 (wifi) or fixed-delay/loss/rate SimpleNetDevices (abstract)
+    std::string linkModel = "wifi";
+    std::string linkRate = "1Mbps"; // Abstract device rate (matches DsssRate1Mbps)
+    double linkDelayMs = 1.0;       // Abstract one-way delay
+    double linkLossRate = 0.0;      // Abstract frame loss probability
+
+    double intervalS = 5.0;        // Time between readings of each sensor
+    std::string outputPrefix = ""; // Prepended to every output file (e.g. "runs/42/")
+
+    // Sensor-side batching: K binary readings per datagram (1 = one datagram per reading)
+    uint32_t sensorBatchReadings = 1;
+    double sensorBatchAgeS = 0.0; // Send a partial batch this long after its first reading (0 = never)
+    std::string batchCodec = "raw"; // Reading encoding of sensor batches: raw or delta
+    double codecQuantumPpm = 0.01;  // CO2 step of the delta codec (0.01 = lossless)
+    double codecEncodeUs = 0.0;     // Modeled encoding time per reading
+    double codecDecodeUs = 0.0;     // Modeled decoding time per reading
+
+    // Reliable delivery: sequence numbers, batched ACKs and retransmissions (see
+    // reliable-delivery.h)
+    bool reliable = false;
+    double ackDelayMs = 50.0; // Longest wait before the gateway broadcasts pending ACKs
+    double rtoMs = 200.0;     // Retransmission timeout, doubled at each retry
+    uint32_t maxRetries = 4;  // Retransmissions before a datagram is abandoned
+    uint16_t ackPort = 9002;  // Sensor port of the ACK broadcasts
+
+    // Inline analytics at the gateway: anomaly flags and windowed credit rollups (see
+    // carbon-analytics.h)
+    bool analytics = false;
+    double analyticsWindowS = 60.0; // Tumbling window length
+    double ewmaAlpha = 0.1;         // Weight of the newest reading in the anomaly baseline
+    double anomalySigma = 4.0;      // Deviations from the baseline that flag a reading
+    double anomalyPpm = 0.0;        // Absolute anomaly limit (0 = none)
+    double creditCapPpm = 1000.0;   // Emission cap of the credit balance
+    double analyticsCostUs = 0.0;   // Modeled CPU time per reading
+
+    // Gateway processing model: bounded queue in front of worker cores (see ingest-queue.h)
+    uint32_t gatewayWorkers = 0;                // Worker cores (0 = instant processing)
+    uint32_t gatewayQueue = 1000;               // Datagrams waiting for a worker
+    std::string gatewayPolicy = "droptail";     // Full queue: droptail, drophead or backpressure
+    std::string gatewayService = "exponential"; // Service time distribution per reading
+    double gatewayServiceUs = 50.0;             // Mean service time per reading
+
+    // Run artifacts: none, metrics, debug or full (see tracing-profile.h)
+    std::string tracing = "full";
+    double traceStart = 0.0;    // Trace window start (s)
+    double traceStop = 0.0;     // Trace window end (s), 0 = end of the run
+    uint32_t traceSensors = 1;  // Sensors with IP-level traces (first N), plus the gateway
+    double metricsIntervalS = 1.0; // Flow metrics snapshot period (s), metrics profile and up
+    // Live copy of the flow metrics rows over UDP (see telemetry-stream.h; 0 = off)
+    uint16_t telemetryPort = 0;
+    std::string telemetryHost = "127.0.0.1";
+
+    // Binary per-packet event log (see event-log.h; empty = off)
+    std::string eventLog = "";
+    std::string eventLogMode = "ring";    // ring (newest records) or file (everything)
+    uint32_t eventLogCapacity = 1 << 20; // Ring size, or chunk size in file mode (records)
+
     // Parse command line arguments
     CommandLine cmd;
     cmd.AddValue("nSensors", "Number of CO2 sensor nodes", nSensors);
     cmd.AddValue("time", "Simulation time in seconds", simulationTime);
     cmd.AddValue("verbose", "Enable verbose logging", verbose);
+    cmd.AddValue("payload", "Sensor payload format (binary or text)", payload);
+    cmd.AddValue("emissionModel",
+                 "CO2 emission model (uniform, diurnal, shift, ar1, step)",
+                 emissionModel);
+    cmd.AddValue("traceFile", "Binary CO2 trace to replay (see tools/co2_trace_convert.py)", traceFile);
+    cmd.AddValue("traceOffset", "Simulation time (s) at which the trace starts", traceOffset);
+    cmd.AddValue("tickScheduler", "Drive sensors from a shared tick scheduler", tickScheduler);
+    cmd.AddValue("tickResolutionMs", "Tick scheduler phase resolution in milliseconds", tickResolutionMs);
+    cmd.AddValue("wifiChannel", "WiFi channel model (yans, spectrum or grid)", wifiChannel);
+    cmd.AddValue("cullThresholdDbm", "Received power below which the grid channel culls frames", cullThresholdDbm);
+    cmd.AddValue("wifiStandard", "WiFi standard (b, g, n, ac or ax)", wifiStandard);
+    cmd.AddValue("wifiBand", "WiFi band in GHz (auto, 2.4, 5 or 6)", wifiBand);
+    cmd.AddValue("channelWidth", "WiFi channel width in MHz (0 = standard default)", channelWidth);
+    cmd.AddValue("rateManager", "WiFi rate control (constant, minstrel or ideal)", rateManager);
+    cmd.AddValue("dataMode", "Constant rate data mode (empty = lowest mode)", dataMode);
+    cmd.AddValue("controlMode", "Constant rate control mode (empty = dataMode)", controlMode);
+    cmd.AddValue("association", "WiFi association (standard or fast: ad hoc, pre-filled ARP)", association);
+    cmd.AddValue("warmupS", "Start time of the first sensor in seconds", warmupS);
+    cmd.AddValue("startSpreadS",
+                 "Spread sensor starts evenly over this many seconds after warmupS instead of the "
+                 "fixed 0.5 s step (0 = fixed step)",
+                 startSpreadS);
+    cmd.AddValue("linkModel", "Sensor link model (wifi or abstract)", linkModel);
+    cmd.AddValue("linkRate", "Abstract link data rate", linkRate);
+    cmd.AddValue("linkDelayMs", "Abstract link delay in milliseconds", linkDelayMs);
+    cmd.AddValue("linkLossRate", "Abstract link frame loss probability", linkLossRate);
+    cmd.AddValue("intervalS", "Seconds between readings of each sensor", intervalS);
+    cmd.AddValue("sensorBatchReadings", "Readings per sensor datagram (1 = no batching)", sensorBatchReadings);
+    cmd.AddValue("sensorBatchAgeS", "Max age of a partial sensor batch in seconds (0 = no limit)", sensorBatchAgeS);
+    cmd.AddValue("batchCodec", "Encoding of batched readings (raw or delta)", batchCodec);
+    cmd.AddValue("codecQuantumPpm", "CO2 quantization step of the delta codec in ppm", codecQuantumPpm);
+    cmd.AddValue("codecEncodeUs", "Modeled batch encoding time per reading in microseconds", codecEncodeUs);
+    cmd.AddValue("codecDecodeUs", "Modeled batch decoding time per reading in microseconds", codecDecodeUs);
+    cmd.AddValue("reliable", "Acknowledge and retransmit sensor datagrams", reliable);
+    cmd.AddValue("ackDelayMs", "Longest wait before pending ACKs are broadcast, in ms", ackDelayMs);
+    cmd.AddValue("rtoMs", "Retransmission timeout in ms (doubled at each retry)", rtoMs);
+    cmd.AddValue("maxRetries", "Retransmissions before a datagram is abandoned", maxRetries);
+    cmd.AddValue("ackPort", "Sensor UDP port of the ACK broadcasts", ackPort);
+    cmd.AddValue("analytics", "Streaming anomaly detection and window rollups at the gateway", analytics);
+    cmd.AddValue("analyticsWindowS", "Tumbling window of the carbon rollups in seconds", analyticsWindowS);
+    cmd.AddValue("ewmaAlpha", "EWMA weight of the newest reading (anomaly baseline)", ewmaAlpha);
+    cmd.AddValue("anomalySigma", "EWMA deviations that flag a reading as anomalous", anomalySigma);
+    cmd.AddValue("anomalyPpm", "CO2 level that always flags a reading (0 = none)", anomalyPpm);
+    cmd.AddValue("creditCapPpm", "Emission cap of the carbon credit balance in ppm", creditCapPpm);
+    cmd.AddValue("analyticsCostUs", "Modeled analytics CPU time per reading in microseconds", analyticsCostUs);
+    cmd.AddValue("gatewayWorkers", "Ingest worker cores at the gateway (0 = instant processing)", gatewayWorkers);
+    cmd.AddValue("gatewayQueue", "Datagrams that can wait for a gateway worker", gatewayQueue);
+    cmd.AddValue("gatewayPolicy", "Full gateway queue policy (droptail, drophead or backpressure)", gatewayPolicy);
+    cmd.AddValue("gatewayService", "Gateway service time distribution (constant, exponential or uniform)", gatewayService);
+    cmd.AddValue("gatewayServiceUs", "Mean gateway service time per reading in microseconds", gatewayServiceUs);
+    cmd.AddValue("outputPrefix", "Prefix of all output files, so parallel runs do not collide", outputPrefix);
+    cmd.AddValue("emulate", "Run in real time and forward gateway traffic to a host service", emulate);
+    cmd.AddValue("tapName", "Host tap device of the gateway (emulation)", tapName);
+    cmd.AddValue("tapNetwork", "Tap /24 base address: gateway .1, host .2 (emulation)", tapNetwork);
+    cmd.AddValue("ingestAddress", "Ingest service address (empty = host end of the tap)", ingestAddress);
+    cmd.AddValue("ingestPort", "Ingest service UDP port", ingestPort);
+    cmd.AddValue("realtimeMode", "Realtime synchronization (besteffort or hardlimit)", realtimeMode);
+    cmd.AddValue("lagLimitMs", "Lag behind wall-clock counted as an overrun, in ms", lagLimitMs);
+    cmd.AddValue("lagSampleMs", "Simulation time between lag samples, in ms", lagSampleMs);
+    cmd.AddValue("tracing", "Tracing profile (none, metrics, debug or full)", tracing);
+    cmd.AddValue("traceStart", "Trace window start in seconds", traceStart);
+    cmd.AddValue("traceStop", "Trace window end in seconds (0 = end of the run)", traceStop);
+    cmd.AddValue("metricsInterval", "Flow metrics snapshot period in seconds", metricsIntervalS);
+    cmd.AddValue("telemetryPort", "UDP port to stream the flow metrics to (0 = off)", telemetryPort);
+    cmd.AddValue("telemetryHost", "IPv4 address of the telemetry listener", telemetryHost);
+    cmd.AddValue("traceSensors", "Number of sensors with IP-level traces (debug/full)", traceSensors);
+    cmd.AddValue("eventLog", "Binary event log file, under outputPrefix (empty = off)", eventLog);
+    cmd.AddValue("eventLogMode", "Event log mode (ring or file)", eventLogMode);
+    cmd.AddValue("eventLogCapacity", "Event log ring size or file chunk size in records", eventLogCapacity);
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_IF(realtimeMode != "besteffort" && realtimeMode != "hardlimit",
+                    "Unknown realtime mode " << realtimeMode << " (use besteffort or hardlimit)");
+    NS_ABORT_MSG_IF(emulate && lagLimitMs <= 0, "lagLimitMs must be positive");
+    if (emulate)
+    {
+#ifdef __linux__
+        // Before any simulator call; real hosts drop packets with the zero default checksum
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+        GlobalValue::Bind("ChecksumEnabled", BooleanValue(true));
+        Config::SetDefault("ns3::RealtimeSimulatorImpl::SynchronizationMode",
+                           StringValue(realtimeMode == "hardlimit" ? "HardLimit" : "BestEffort"));
+        Config::SetDefault("ns3::RealtimeSimulatorImpl::HardLimit",
+                           TimeValue(Seconds(lagLimitMs * 1e-3)));
+#else
+        NS_ABORT_MSG("--emulate needs the fd-net-device module, which ns-3 only builds on Linux");
+#endif
+    }
+
+    PayloadFormat payloadFormat = ParsePayloadFormat(payload);
+    WifiMediumType mediumType = ParseWifiMediumType(wifiChannel);
+    WifiConfig wifiConfig(wifiStandard, wifiBand, channelWidth);
+    wifiConfig.SetRateManager(rateManager, dataMode, controlMode);
+    wifiConfig.SetAssociation(association);
+    NS_ABORT_MSG_IF(warmupS < 0, "warmupS must not be negative");
+    NS_ABORT_MSG_IF(linkModel != "wifi" && linkModel != "abstract", "Unknown link model " << linkModel);
+    NS_ABORT_MSG_IF(nSensors == 0, "At least one sensor is required");
+    NS_ABORT_MSG_IF(intervalS <= 0, "intervalS must be positive");
+    NS_ABORT_MSG_IF(startSpreadS < 0, "startSpreadS must not be negative");
+    NS_ABORT_MSG_IF(sensorBatchReadings > 1 && payloadFormat != PayloadFormat::BINARY,
+                    "Sensor batching needs the binary payload");
+    NS_ABORT_MSG_IF(codecQuantumPpm < 0.01, "codecQuantumPpm must be at least 0.01");
+    NS_ABORT_MSG_IF(codecEncodeUs < 0 || codecDecodeUs < 0, "Codec costs must not be negative");
+    NS_ABORT_MSG_IF(analyticsCostUs < 0, "analyticsCostUs must not be negative");
+    AnalyticsConfig analyticsConfig;
+    analyticsConfig.window = Seconds(analyticsWindowS);
+    analyticsConfig.ewmaAlpha = ewmaAlpha;
+    analyticsConfig.anomalySigma = anomalySigma;
+    analyticsConfig.anomalyPpm = anomalyPpm;
+    analyticsConfig.creditCapPpm = creditCapPpm;
+    analyticsConfig.costPerReading = Seconds(analyticsCostUs * 1e-6);
+    IngestConfig ingestConfig;
+    ingestConfig.workers = gatewayWorkers;
+    ingestConfig.capacity = gatewayQueue;
+    ingestConfig.policy = ParseIngestPolicy(gatewayPolicy);
+    NS_ABORT_MSG_IF(reliable && gatewayWorkers > 0 && ingestConfig.policy == IngestPolicy::DROP_HEAD,
+                    "gatewayPolicy=drophead drops datagrams the gateway already acknowledged; "
+                    "use droptail or backpressure with --reliable");
+    ingestConfig.distribution = ParseServiceDistribution(gatewayService);
+    ingestConfig.meanService = Seconds(gatewayServiceUs * 1e-6);
+    if (analytics)
+    {
+        ingestConfig.extraService = analyticsConfig.costPerReading;
+    }
+    BatchCodecConfig codecConfig;
+    codecConfig.codec = ParseBatchCodec(batchCodec);
+    codecConfig.quantum = static_cast<uint32_t>(std::lround(codecQuantumPpm * 100.0));
+    codecConfig.encodeCost = Seconds(codecEncodeUs * 1e-6);
+    codecConfig.decodeCost = Seconds(codecDecodeUs * 1e-6);
+    NS_ABORT_MSG_IF(ackDelayMs < 0 || rtoMs <= ackDelayMs,
+                    "rtoMs must be longer than ackDelayMs, or every datagram is sent twice");
+    ReliabilityConfig reliabilityConfig;
+    reliabilityConfig.ackDelay = Seconds(ackDelayMs * 1e-3);
+    reliabilityConfig.retransmitTimeout = Seconds(rtoMs * 1e-3);
+    reliabilityConfig.maxRetries = maxRetries;
+    uint32_t sequenceSize = reliable ? CO2SequenceHeader::SERIALIZED_SIZE : 0;
+    NS_ABORT_MSG_IF(sequenceSize + CO2BatchHeader::SERIALIZED_SIZE +
+                            CO2BatchEncoder::GetMaxBodySize(codecConfig.codec, sensorBatchReadings) >
+                        1472,
+                    "sensorBatchReadings does not fit in one UDP datagram");
+    NS_ABORT_MSG_IF(traceStop > 0 && traceStop <= traceStart, "traceStop must be after traceStart");
+    NS_ABORT_MSG_IF(metricsIntervalS <= 0, "metricsInterval must be positive");
+    TracingPlan tracingPlan(ParseTracingProfile(tracing),
+                            Seconds(traceStart),
+                            Seconds(traceStop),
+                            outputPrefix + "carbon-trading");
+    NS_ABORT_MSG_IF(telemetryPort != 0 && !tracingPlan.WantsMetrics(),
+                    "telemetryPort streams the flow metrics: use --tracing=metrics or above");
+    bool abstractLinks = (linkModel == "abstract");
+
     if (verbose)
     {
         LogComponentEnable("EcoLedgerCarbonTrading", LOG_LEVEL_INFO);
+        LogComponentEnable("CO2SensorApplication", LOG_LEVEL_INFO);
     }
 
     NS_LOG_INFO("=================================================");
@@ -506,6 +888,35 @@ main(int argc, char* argv[])
     NS_LOG_INFO("Number of CO2 sensor nodes: " << nSensors);
     NS_LOG_INFO("Simulation duration: " << simulationTime << " seconds");
     NS_LOG_INFO("Gateway port: " << gatewayPort);
+    NS_LOG_INFO("Payload format: " << payload);
+    NS_LOG_INFO("Batch codec: " << batchCodec);
+    NS_LOG_INFO("Emission model: " << (traceFile.empty() ? emissionModel : "trace " + traceFile));
+    NS_LOG_INFO("Link model: " << linkModel);
+    NS_LOG_INFO("Tracing: " << tracing);
+    NS_LOG_INFO("WiFi channel: " << wifiChannel);
+    NS_LOG_INFO("WiFi standard: " << wifiConfig.GetDescription());
+    NS_LOG_INFO("Sensor scheduling: " << (tickScheduler ? "shared tick scheduler" : "per-sensor events"));
+    if (gatewayWorkers > 0)
+    {
+        NS_LOG_INFO("Gateway ingest: " << gatewayWorkers << " workers, " << gatewayQueue
+                                       << " datagrams " << gatewayPolicy << ", " << gatewayService
+                                       << " " << gatewayServiceUs << " us/reading");
+    }
+    if (analytics)
+    {
+        NS_LOG_INFO("Analytics: " << analyticsWindowS << " s windows, cap " << creditCapPpm
+                                  << " ppm, anomalies beyond " << anomalySigma << " sigma");
+    }
+    if (reliable)
+    {
+        NS_LOG_INFO("Reliable delivery: ACKs within " << ackDelayMs << " ms, timeout " << rtoMs
+                                                     << " ms, " << maxRetries << " retries");
+    }
+    if (emulate)
+    {
+        NS_LOG_INFO("Emulation: real time (" << realtimeMode << ", " << lagLimitMs
+                                             << " ms limit), tap " << tapName);
+    }
     NS_LOG_INFO("=================================================");
 
     /*
@@ -514,6 +925,9 @@ main(int argc, char* argv[])
      * ============================================
      */
 
+    // Wall-clock cost of each phase of this run (see run-profiler.h)
+    RunProfiler profiler;
+
     NS_LOG_INFO("Creating network nodes...");
 
     // Create sensor nodes (IoT CO2 sensors)
@@ -543,38 +957,64 @@ main(int argc, char* argv[])
      * - Cost-effective for IoT applications
      */
 
-    NS_LOG_INFO("Configuring WiFi network...");
-
-    // WiFi channel configuration
-    YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
-    YansWifiPhyHelper phy;
-    phy.SetChannel(channel.Create());
+    // WiFi channel configuration (one medium shared by all nodes)
+    WifiMediumHelper medium(mediumType);
+    medium.SetDetectionThreshold(cullThresholdDbm);
+    WifiPhyHelper& phy = medium.GetPhy();
 
-    // WiFi MAC layer configuration
-    WifiHelper wifi;
-    wifi.SetStandard(WIFI_STANDARD_80211b); // Use 802.11b standard
-    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                 "DataMode",
-                                 StringValue("DsssRate1Mbps"),
-                                 "ControlMode",
-                                 StringValue("DsssRate1Mbps"));
+    NetDeviceContainer sensorDevices;
+    NetDeviceContainer gatewayDevice;
+    StarLinkHelper star;
+    Ptr<WifiAirtimeMonitor> airtime; // WiFi only
+    if (abstractLinks)
+    {
+        // Application-tier scale tests: no PHY/MAC, one event per frame
+        NS_LOG_INFO("Configuring abstract links...");
+        star.SetDataRate(DataRate(linkRate));
+        star.SetDelay(Seconds(linkDelayMs * 1e-3));
+        star.SetLossRate(linkLossRate);
+        star.AssignStreams(0);
+
+        NetDeviceContainer starDevices = star.Install(sensorNodes, gatewayNode.Get(0));
+        for (uint32_t i = 0; i < nSensors; ++i)
+        {
+            sensorDevices.Add(starDevices.Get(i));
+        }
+        gatewayDevice.Add(starDevices.Get(nSensors));
+    }
+    else
+    {
+        NS_LOG_INFO("Configuring WiFi network...");
+        medium.SetMedium(medium.CreateMedium());
 
-    WifiMacHelper mac;
-    Ssid ssid = Ssid("EcoLedger-CarbonNet"); // Network name
+        // WiFi MAC layer configuration: standard and rate control, on the band's first channel
+        WifiHelper wifi;
+        wifiConfig.Configure(wifi);
+        phy.Set("ChannelSettings", StringValue(wifiConfig.GetChannelSettings(0)));
 
-    // Configure sensor nodes as WiFi stations
-    mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid), "ActiveProbing", BooleanValue(false));
+        WifiMacHelper mac;
+        Ssid ssid = Ssid("EcoLedger-CarbonNet"); // Network name
 
-    NetDeviceContainer sensorDevices;
-    sensorDevices = wifi.Install(phy, mac, sensorNodes);
+        // Configure sensor nodes as WiFi stations
+        wifiConfig.SetStationMac(mac, ssid);
+        sensorDevices = wifi.Install(phy, mac, sensorNodes);
 
-    // Configure gateway as WiFi access point
-    mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+        // Configure gateway as WiFi access point
+        wifiConfig.SetApMac(mac, ssid);
+        gatewayDevice = wifi.Install(phy, mac, gatewayNode);
 
-    NetDeviceContainer gatewayDevice;
-    gatewayDevice = wifi.Install(phy, mac, gatewayNode);
+        NS_LOG_INFO("WiFi network configured with SSID: EcoLedger-CarbonNet");
 
-    NS_LOG_INFO("WiFi network configured with SSID: EcoLedger-CarbonNet");
+        // Medium usage: every frame on the channel, and what the gateway hears of it
+        airtime = Create<WifiAirtimeMonitor>();
+        airtime->AddTransmitters(sensorDevices);
+        airtime->AddTransmitters(gatewayDevice);
+        airtime->AddReceivers(gatewayDevice);
+        if (reliable)
+        {
+            airtime->AddAckSenders(gatewayDevice, ackPort);
+        }
+    }
 
     /*
      * ============================================
@@ -626,14 +1066,28 @@ main(int argc, char* argv[])
      * This enables network-layer communication for sensor data
      */
 
+    profiler.EndPhase("topology");
     NS_LOG_INFO("Installing Internet stack...");
 
     InternetStackHelper internet;
     internet.Install(allNodes);
 
-    // Assign IP addresses
+    // Assign IP addresses: 10.1.1.0/24 up to 253 sensors, a wider 10.0.0.0 subnet beyond
+    uint32_t hostBits = 8;
+    while ((1u << hostBits) - 2 < nSensors + 1)
+    {
+        hostBits++;
+    }
+    NS_ABORT_MSG_IF(hostBits > 24, "Too many sensors for one subnet");
     Ipv4AddressHelper address;
-    address.SetBase("10.1.1.0", "255.255.255.0");
+    if (hostBits == 8)
+    {
+        address.SetBase("10.1.1.0", "255.255.255.0");
+    }
+    else
+    {
+        address.SetBase(Ipv4Address("10.0.0.0"), Ipv4Mask(~((1u << hostBits) - 1)));
+    }
 
     Ipv4InterfaceContainer sensorInterfaces;
     sensorInterfaces = address.Assign(sensorDevices);
@@ -642,12 +1096,55 @@ main(int argc, char* argv[])
     gatewayInterface = address.Assign(gatewayDevice);
 
     NS_LOG_INFO("IP addresses assigned:");
-    NS_LOG_INFO("  Sensor network: 10.1.1.1 - 10.1.1." << nSensors);
-    NS_LOG_INFO("  Gateway: 10.1.1." << (nSensors + 1));
+    NS_LOG_INFO("  Sensor network: " << sensorInterfaces.GetAddress(0) << " - "
+                                     << sensorInterfaces.GetAddress(nSensors - 1) << " (/"
+                                     << 32 - hostBits << ")");
+    NS_LOG_INFO("  Gateway: " << gatewayInterface.GetAddress(0));
+
+    // Emulation: an FdNetDevice on the gateway, backed by a tap device on the host
+    Address ingest;
+    if (emulate)
+    {
+#ifdef __linux__
+        Ipv4Mask tapMask("255.255.255.0");
+        Ipv4Address hostEnd(Ipv4Address(tapNetwork.c_str()).Get() + 2);
+        TapFdNetDeviceHelper tap;
+        tap.SetDeviceName(tapName);
+        tap.SetTapIpv4Address(hostEnd);
+        tap.SetTapIpv4Mask(tapMask);
+        NetDeviceContainer tapDevice = tap.Install(gatewayNode.Get(0));
+        Ipv4AddressHelper tapAddress(tapNetwork.c_str(), tapMask);
+        Ipv4InterfaceContainer tapInterface = tapAddress.Assign(tapDevice);
+
+        // Anything beyond the tap subnet goes through the host, which has to forward it
+        Ptr<Ipv4> gatewayIpv4 = gatewayNode.Get(0)->GetObject<Ipv4>();
+        Ipv4StaticRoutingHelper().GetStaticRouting(gatewayIpv4)->SetDefaultRoute(
+            hostEnd,
+            gatewayIpv4->GetInterfaceForDevice(tapDevice.Get(0)));
+        Ipv4Address ingestHost =
+            ingestAddress.empty() ? hostEnd : Ipv4Address(ingestAddress.c_str());
+        ingest = InetSocketAddress(ingestHost, ingestPort);
+        NS_LOG_INFO("  Gateway tap: " << tapInterface.GetAddress(0) << " on " << tapName
+                                      << " (host " << hostEnd << "), ingest at " << ingestHost
+                                      << ":" << ingestPort);
+#endif
+    }
 
     // Enable routing
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
+    if (abstractLinks)
+    {
+        // Without this every sensor's first reading would trigger an ARP broadcast
+        PopulateStarArpCaches(gatewayDevice.Get(0), sensorDevices);
+    }
+    else if (wifiConfig.IsFastAssociation())
+    {
+        // Fast association skips ARP too; the star helper only adds sensor <-> gateway entries
+        PopulateStarArpCaches(gatewayDevice.Get(0), sensorDevices);
+    }
+    profiler.EndPhase("addressing");
+
     /*
      * ============================================
      * APPLICATION DEPLOYMENT
@@ -659,18 +1156,121 @@ main(int argc, char* argv[])
     // Get gateway IP address
     Ipv4Address gatewayAddr = gatewayInterface.GetAddress(0);
 
+    // Per-packet records replace the per-packet log lines (decode with tools/decode_event_log.py)
+    Ptr<EventLog> events;
+    if (!eventLog.empty())
+    {
+        events = Create<EventLog>(outputPrefix + eventLog,
+                                  ParseEventLogMode(eventLogMode),
+                                  eventLogCapacity);
+    }
+
+    // Encoders and decoders of every application add up their work here
+    Ptr<BatchCodecStats> codecStats = Create<BatchCodecStats>();
+
+    // Sensor transmissions: readings, and the datagrams carrying them (equal unless
+    // sensors batch). Received-side accounting lives in CarbonGatewayApplication
+    Ptr<SensorSendStats> sendStats = Create<SensorSendStats>();
+
+    // Retransmissions and ACKs of the reliability layer (null unless --reliable)
+    Ptr<ReliabilityStats> reliabilityStats;
+    if (reliable)
+    {
+        reliabilityStats = Create<ReliabilityStats>();
+    }
+
+    // Windowed per-flow statistics (see flow-metrics-collector.h), FlowMonitor's lean replacement
+    Ptr<FlowMetricsCollector> metrics;
+    if (tracingPlan.WantsMetrics())
+    {
+        metrics = Create<FlowMetricsCollector>(outputPrefix + "carbon-trading-metrics.csv",
+                                               Seconds(metricsIntervalS),
+                                               nSensors,
+                                               0);
+    }
+    Ptr<TelemetryStream> telemetry;
+    if (telemetryPort != 0)
+    {
+        telemetry = Create<TelemetryStream>(telemetryHost, telemetryPort);
+        metrics->SetStream(telemetry);
+        NS_LOG_INFO("Streaming flow metrics to " << telemetryHost << ":" << telemetryPort);
+    }
+
+    // Inline gateway analytics (see carbon-analytics.h), windows aligned on the run start
+    Ptr<CarbonAnalytics> carbonAnalytics;
+    if (analytics)
+    {
+        carbonAnalytics =
+            Create<CarbonAnalytics>(outputPrefix + "carbon-trading-windows.csv", analyticsConfig);
+        carbonAnalytics->Start(Seconds(0.0));
+    }
+
     // Create and configure gateway application
     Ptr<Socket> gatewaySocket =
         Socket::CreateSocket(gatewayNode.Get(0), UdpSocketFactory::GetTypeId());
     Ptr<CarbonGatewayApplication> gatewayApp = CreateObject<CarbonGatewayApplication>();
     gatewayApp->Setup(gatewaySocket, gatewayPort);
+    gatewayApp->SetBatchCodec(codecConfig, codecStats);
+    gatewayApp->SetMetrics(metrics);
+    gatewayApp->SetAnalytics(carbonAnalytics);
+    Ptr<IngestQueue> ingestQueue;
+    if (gatewayWorkers > 0)
+    {
+        ingestQueue = Create<IngestQueue>(ingestConfig);
+        gatewayApp->SetIngestQueue(ingestQueue);
+    }
+    gatewayApp->SetEventLog(events);
+    if (emulate)
+    {
+        Ptr<Socket> upstreamSocket =
+            Socket::CreateSocket(gatewayNode.Get(0), UdpSocketFactory::GetTypeId());
+        gatewayApp->SetUpstream(upstreamSocket, ingest);
+    }
+    if (reliable)
+    {
+        // One ACK broadcast covers every sensor heard from since the last one
+        Ptr<Ipv4> gatewayIpv4 = gatewayNode.Get(0)->GetObject<Ipv4>();
+        int32_t wifiInterface = gatewayIpv4->GetInterfaceForDevice(gatewayDevice.Get(0));
+        Ipv4Address broadcast = gatewayIpv4->GetAddress(wifiInterface, 0).GetBroadcast();
+        Ptr<Socket> ackSocket =
+            Socket::CreateSocket(gatewayNode.Get(0), UdpSocketFactory::GetTypeId());
+        gatewayApp->SetReliability(ackSocket,
+                                   InetSocketAddress(broadcast, ackPort),
+                                   nSensors,
+                                   reliabilityConfig,
+                                   reliabilityStats);
+    }
     gatewayNode.Get(0)->AddApplication(gatewayApp);
     gatewayApp->SetStartTime(Seconds(0.0));
     gatewayApp->SetStopTime(Seconds(simulationTime));
 
     NS_LOG_INFO("Gateway application deployed at " << gatewayAddr << ":" << gatewayPort);
 
+    // Three companies, assigned round-robin below
+    const uint32_t nCompanies = 3;
+    gatewayApp->GetStats().Reserve(nSensors, 0, nCompanies);
+    if (carbonAnalytics)
+    {
+        carbonAnalytics->Reserve(nSensors, 0, nCompanies);
+    }
+
+    Ptr<SensorTickScheduler> sensorTicks;
+    if (tickScheduler)
+    {
+        sensorTicks = CreateObject<SensorTickScheduler>();
+        sensorTicks->SetAttribute("Resolution", TimeValue(Seconds(tickResolutionMs * 1e-3)));
+    }
+
     // Create and configure sensor applications
+    // Deterministic RNG streams for the emission models, after the abstract links' loss streams
+    int64_t emissionStream = star.GetNextStream();
+    Ptr<CO2TraceFile> trace;
+    if (!traceFile.empty())
+    {
+        trace = Create<CO2TraceFile>(traceFile);
+        NS_LOG_INFO("Replaying " << trace->GetRecordCount() << " readings of "
+                                 << trace->GetSensorCount() << " recorded sensors");
+    }
     for (uint32_t i = 0; i < nSensors; ++i)
     {
         Ptr<Socket> sensorSocket =
@@ -682,13 +1282,41 @@ main(int argc, char* argv[])
         double baselineCO2 = 400.0 + (i * 100.0);
 
         // Each sensor belongs to a company (for demo, use sensor ID as company ID)
-        uint32_t companyId = (i % 3) + 1; // 3 different companies
+        uint32_t companyId = (i % nCompanies) + 1; // 3 different companies
 
         Address gatewayAddress = InetSocketAddress(gatewayAddr, gatewayPort);
-        sensorApp->Setup(sensorSocket, gatewayAddress, gatewayPort, i + 1, companyId, baselineCO2);
+        sensorApp->Setup(sensorSocket, gatewayAddress, i + 1, companyId, 0, baselineCO2);
+        sensorApp->SetPayloadFormat(payloadFormat);
+        sensorApp->SetInterval(Seconds(intervalS));
+        sensorApp->SetSendStats(sendStats);
+        sensorApp->SetMetrics(metrics);
+        sensorApp->SetEventLog(events);
+        sensorApp->SetBatching(sensorBatchReadings, Seconds(sensorBatchAgeS));
+        sensorApp->SetBatchCodec(codecConfig, codecStats);
+        if (reliable)
+        {
+            Ptr<Socket> ackSocket =
+                Socket::CreateSocket(sensorNodes.Get(i), UdpSocketFactory::GetTypeId());
+            sensorApp->SetReliability(ackSocket, ackPort, reliabilityConfig, reliabilityStats);
+        }
+        if (sensorTicks)
+        {
+            sensorApp->SetTickScheduler(sensorTicks);
+        }
+
+        Ptr<EmissionModel> model = CreateEmissionModel(emissionModel);
+        emissionStream += model->AssignStreams(emissionStream);
+        sensorApp->SetEmissionModel(model);
+        if (trace)
+        {
+            // Recorded sensors are assigned round-robin so any fleet size can replay any trace
+            sensorApp->SetTrace(trace, trace->GetSliceAt(i), Seconds(traceOffset));
+        }
 
         sensorNodes.Get(i)->AddApplication(sensorApp);
-        sensorApp->SetStartTime(Seconds(1.0 + i * 0.5)); // Stagger start times
+        // Fixed stagger by default, an even spread with --startSpreadS
+        sensorApp->SetStartTime(Seconds(startSpreadS > 0 ? warmupS + startSpreadS * i / nSensors
+                                                         : warmupS + i * 0.5));
         sensorApp->SetStopTime(Seconds(simulationTime));
 
         NS_LOG_INFO("Sensor " << (i + 1) << " deployed: "
@@ -696,6 +1324,10 @@ main(int argc, char* argv[])
                               << "Baseline CO2 = " << baselineCO2 << " ppm, "
                               << "IP = " << sensorInterfaces.GetAddress(i));
     }
+    if (ingestQueue)
+    {
+        emissionStream += ingestQueue->AssignStreams(emissionStream);
+    }
 
     /*
      * ============================================
@@ -706,55 +1338,68 @@ main(int argc, char* argv[])
      * Shows node positions, packet transmissions, and network topology
      */
 
-    NS_LOG_INFO("Setting up visualization...");
-
-    AnimationInterface anim("carbon-trading-animation.xml");
-
-    // Set node descriptions
-    anim.UpdateNodeDescription(gatewayNode.Get(0), "Gateway");
-    anim.UpdateNodeColor(gatewayNode.Get(0), 0, 255, 0);        // Green for gateway
-    anim.UpdateNodeSize(gatewayNode.Get(0)->GetId(), 5.0, 5.0); // Larger size
-
-    for (uint32_t i = 0; i < nSensors; ++i)
+    // Only the full profile animates and captures at the WiFi layer; the abstract
+    // link model is meant for scale runs and has neither
+    std::unique_ptr<AnimationInterface> anim;
+    if (tracingPlan.WantsFullTraces() && !abstractLinks)
     {
-        std::ostringstream oss;
-        oss << "CO2_Sensor_" << (i + 1);
-        anim.UpdateNodeDescription(sensorNodes.Get(i), oss.str());
-        anim.UpdateNodeColor(sensorNodes.Get(i), 255, 0, 0); // Red for sensors
-        anim.UpdateNodeSize(sensorNodes.Get(i)->GetId(), 3.0, 3.0);
-    }
+        NS_LOG_INFO("Setting up visualization...");
 
-    anim.EnablePacketMetadata(true);
-    anim.EnableIpv4RouteTracking("carbon-trading-routes.xml",
-                                 Seconds(0),
-                                 Seconds(simulationTime),
-                                 Seconds(1));
+        anim = std::make_unique<AnimationInterface>(outputPrefix + "carbon-trading-animation.xml");
 
-    NS_LOG_INFO("Visualization configured - will generate carbon-trading-animation.xml");
+        // Set node descriptions
+        anim->UpdateNodeDescription(gatewayNode.Get(0), "Gateway");
+        anim->UpdateNodeColor(gatewayNode.Get(0), 0, 255, 0);        // Green for gateway
+        anim->UpdateNodeSize(gatewayNode.Get(0)->GetId(), 5.0, 5.0); // Larger size
 
-    /*
-     * ============================================
-     * PCAP TRACING (Wireshark)
-     * ============================================
-     *
-     * Enable packet capture for detailed network analysis
-     */
-
-    YansWifiPhyHelper phyTrace;
-    phyTrace.SetChannel(channel.Create());
-    phyTrace.EnablePcap("carbon-trading-wifi", gatewayDevice.Get(0), true);
-    phyTrace.EnablePcap("carbon-trading-sensor", sensorDevices.Get(0), true);
-
-    NS_LOG_INFO("PCAP tracing enabled for Wireshark analysis");
+        for (uint32_t i = 0; i < nSensors; ++i)
+        {
+            std::ostringstream oss;
+            oss << "CO2_Sensor_" << (i + 1);
+            anim->UpdateNodeDescription(sensorNodes.Get(i), oss.str());
+            anim->UpdateNodeColor(sensorNodes.Get(i), 255, 0, 0); // Red for sensors
+            anim->UpdateNodeSize(sensorNodes.Get(i)->GetId(), 3.0, 3.0);
+        }
 
-    /*
-     * ============================================
-     * ASCII TRACING
-     * ============================================
-     */
+        anim->EnablePacketMetadata(true);
+        tracingPlan.LimitAnimation(*anim, Seconds(simulationTime));
+        anim->EnableIpv4RouteTracking(outputPrefix + "carbon-trading-routes.xml",
+                                      tracingPlan.GetStart(),
+                                      tracingPlan.GetStop(Seconds(simulationTime)),
+                                      Seconds(1));
+
+        NS_LOG_INFO("Visualization configured - will generate carbon-trading-animation.xml");
+
+        /*
+         * ============================================
+         * PCAP TRACING (Wireshark)
+         * ============================================
+         *
+         * Enable packet capture for detailed network analysis
+         */
+
+        YansWifiPhyHelper phyTrace; // Only used for its pcap helpers
+        phyTrace.EnablePcap(outputPrefix + "carbon-trading-wifi", gatewayDevice.Get(0), true);
+        phyTrace.EnablePcap(outputPrefix + "carbon-trading-sensor", sensorDevices.Get(0), true);
+
+        NS_LOG_INFO("PCAP tracing enabled for Wireshark analysis");
+
+        /*
+         * ============================================
+         * ASCII TRACING
+         * ============================================
+         */
+
+        AsciiTraceHelper ascii;
+        phy.EnableAsciiAll(ascii.CreateFileStream(outputPrefix + "carbon-trading.tr"));
+    }
 
-    AsciiTraceHelper ascii;
-    phy.EnableAsciiAll(ascii.CreateFileStream("carbon-trading.tr"));
+    // IP-level traces of the sampled nodes, inside the trace window (debug and full)
+    tracingPlan.TraceNode(gatewayNode.Get(0));
+    for (uint32_t i = 0; i < std::min(traceSensors, nSensors); ++i)
+    {
+        tracingPlan.TraceNode(sensorNodes.Get(i));
+    }
 
     /*
      * ============================================
@@ -765,7 +1410,20 @@ main(int argc, char* argv[])
      */
 
     FlowMonitorHelper flowmon;
-    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
+    Ptr<FlowMonitor> monitor;
+    if (tracingPlan.WantsFlowMonitor())
+    {
+        monitor = flowmon.InstallAll();
+    }
+
+    // How far the realtime scheduler falls behind wall-clock (see realtime-lag-monitor.h)
+    Ptr<RealtimeLagMonitor> lagMonitor;
+    if (emulate)
+    {
+        lagMonitor =
+            Create<RealtimeLagMonitor>(Seconds(lagSampleMs * 1e-3), Seconds(lagLimitMs * 1e-3));
+        lagMonitor->Start(Seconds(0.0));
+    }
 
     /*
      * ============================================
@@ -778,7 +1436,28 @@ main(int argc, char* argv[])
     NS_LOG_INFO("=================================================");
 
     Simulator::Stop(Seconds(simulationTime));
+    profiler.EndPhase("applications");
     Simulator::Run();
+    double wallSeconds = profiler.EndPhase("run");
+    uint64_t eventCount = Simulator::GetEventCount();
+    if (events)
+    {
+        events->Close();
+    }
+    if (metrics)
+    {
+        metrics->Close();
+    }
+    if (carbonAnalytics)
+    {
+        carbonAnalytics->Close();
+    }
+
+    const CarbonStatsStore& carbonStats = gatewayApp->GetStats();
+    uint64_t totalPacketsReceived = carbonStats.GetTotalReadings();
+    uint64_t totalPacketsSent = sendStats->readings;
+    uint64_t totalFramesSent = sendStats->datagrams;
+    uint64_t activeSensors = sendStats->activeSensors;
 
     NS_LOG_INFO("=================================================");
     NS_LOG_INFO("Simulation completed");
@@ -798,24 +1477,148 @@ main(int argc, char* argv[])
     std::cout << "=================================================\n";
     std::cout << "Number of sensors: " << nSensors << "\n";
     std::cout << "Simulation time: " << simulationTime << " seconds\n";
+    std::cout << "Active sensors: " << activeSensors << " of " << nSensors << "\n";
     std::cout << "Total packets sent: " << totalPacketsSent << "\n";
     std::cout << "Total packets received: " << totalPacketsReceived << "\n";
+    if (carbonStats.GetRejectedReadings() > 0)
+    {
+        std::cout << "Rejected readings (unknown ID): " << carbonStats.GetRejectedReadings() << "\n";
+    }
     std::cout << "Packet delivery ratio: " << deliveryRatio << "%\n";
+    double readingsPerFrame = totalFramesSent > 0 ? (double)totalPacketsSent / totalFramesSent : 0.0;
+    std::cout << "Sensor datagrams sent: " << totalFramesSent << " (" << readingsPerFrame
+              << " readings each)\n";
+    std::cout << "Mean reading latency: " << gatewayApp->GetMeanLatency() * 1000.0 << " ms\n";
+
+    // What the sensor traffic costs the shared channel (fewer frames with batching)
+    if (airtime)
+    {
+        std::cout << "\nMedium Usage:\n";
+        std::cout << "-------------------------------------------------\n";
+        std::cout << "WiFi frames transmitted: " << airtime->GetTxFrames() << " ("
+                  << airtime->GetTxAirtime().GetSeconds() << " s airtime, "
+                  << airtime->GetTxAirtime().GetSeconds() / simulationTime * 100.0
+                  << "% of the run)\n";
+        std::cout << "Gateway medium busy: "
+                  << airtime->GetReceiverUtilization(Seconds(simulationTime)) * 100.0 << "%\n";
+        std::cout << "Gateway frames decoded: " << airtime->GetRxFrames()
+                  << ", failed (collisions): " << airtime->GetRxErrors()
+                  << ", dropped while busy: " << airtime->GetRxDrops() << "\n";
+    }
+    if (codecStats->batchesEncoded > 0)
+    {
+        std::cout << "\nBatch Codec (" << batchCodec << "):\n";
+        std::cout << "-------------------------------------------------\n";
+        codecStats->Print(std::cout);
+    }
+    if (lagMonitor)
+    {
+        std::cout << "\nRealtime Emulation (" << realtimeMode << "):\n";
+        std::cout << "-------------------------------------------------\n";
+        std::cout << "  Datagrams forwarded to ingest: " << gatewayApp->GetUpstreamSent() << " ("
+                  << gatewayApp->GetUpstreamFailed() << " refused)\n";
+        lagMonitor->Print(std::cout);
+    }
+    // The sensors send from the warm-up to the end of the run
+    Time sendingPeriod = Seconds(simulationTime - warmupS);
+    if (reliabilityStats)
+    {
+        std::cout << "\nReliable Delivery:\n";
+        std::cout << "-------------------------------------------------\n";
+        reliabilityStats->Print(std::cout, sendingPeriod);
+        if (airtime)
+        {
+            std::cout << "  ACK airtime: " << airtime->GetAckAirtime().GetSeconds() << " s in "
+                      << airtime->GetAckFrames() << " frames ("
+                      << airtime->GetAckAirtimeShare() * 100.0 << "% of the WiFi airtime)\n";
+        }
+    }
+    if (carbonAnalytics)
+    {
+        std::cout << "\nCarbon Analytics:\n";
+        std::cout << "-------------------------------------------------\n";
+        carbonAnalytics->Print(std::cout, sendingPeriod);
+    }
+    if (ingestQueue)
+    {
+        std::cout << "\nGateway Ingest:\n";
+        std::cout << "-------------------------------------------------\n";
+        ingestQueue->Print(std::cout, sendingPeriod);
+    }
+
+    // Event-queue footprint of sensor scheduling: per-sensor mode keeps one
+    // pending event per running sensor, the tick scheduler one per bucket
+    std::cout << "\nScheduler Benchmark:\n";
+    std::cout << "-------------------------------------------------\n";
+    if (sensorTicks)
+    {
+        std::cout << "Sensor scheduling: shared tick scheduler (" << sensorTicks->GetBucketCount()
+                  << " buckets)\n";
+        std::cout << "Peak pending sensor events: " << sensorTicks->GetPeakPendingEvents() << "\n";
+        std::cout << "Bucket events fired: " << sensorTicks->GetTicksFired() << " ("
+                  << sensorTicks->GetCallbacksInvoked() << " sensor ticks)\n";
+    }
+    else
+    {
+        std::cout << "Sensor scheduling: per-sensor events\n";
+        // Not measured: each running sensor holds exactly one send event
+        std::cout << "Pending sensor events (expected, one per sensor): " << nSensors << "\n";
+    }
+    for (const Ptr<GridSpectrumChannel>& grid : medium.GetGridChannels())
+    {
+        std::cout << "Grid channel: radius " << grid->GetCullRadius() << " m, "
+                  << grid->GetDeliveryCount() << " receptions, " << grid->GetCulledCount()
+                  << " culled\n";
+    }
+    if (abstractLinks)
+    {
+        std::cout << "Abstract links: " << star.GetFramesDropped() << " frames dropped\n";
+    }
+    std::cout << "Events executed: " << eventCount << "\n";
+    std::cout << "Wall-clock time: " << wallSeconds << " s ("
+              << (wallSeconds > 0 ? eventCount / wallSeconds : 0.0) << " events/s)\n";
+
     std::cout << "\nCO2 Statistics by Sensor:\n";
     std::cout << "-------------------------------------------------\n";
 
-    for (const auto& entry : totalCO2BySensor)
+    const std::vector<RunningStats>& sensorStats = carbonStats.GetSensors();
+    for (uint32_t sensorId = 0; sensorId < sensorStats.size(); ++sensorId)
     {
-        uint32_t sensorId = entry.first;
-        double totalCO2 = entry.second;
-        uint32_t packetCount = packetCountBySensor[sensorId];
-        double avgCO2 = totalCO2 / packetCount;
+        const RunningStats& stats = sensorStats[sensorId];
+        if (stats.count == 0)
+        {
+            continue;
+        }
 
-        std::cout << "Sensor " << sensorId << ": " << packetCount << " readings, "
-                  << "Average CO2 = " << std::fixed << std::setprecision(2) << avgCO2 << " ppm\n";
+        std::cout << "Sensor " << sensorId << ": " << stats.count << " readings, "
+                  << "Average CO2 = " << std::fixed << std::setprecision(2) << stats.mean
+                  << " ppm (min " << stats.min << ", max " << stats.max << ", stddev "
+                  << stats.GetStdDev() << ")\n";
     }
 
+    std::cout << "\nCO2 Statistics by Company:\n";
+    std::cout << "-------------------------------------------------\n";
+
+    const std::vector<RunningStats>& companyStats = carbonStats.GetCompanies();
+    for (uint32_t companyId = 1; companyId < companyStats.size(); ++companyId)
+    {
+        const RunningStats& stats = companyStats[companyId];
+        if (stats.count == 0)
+        {
+            continue;
+        }
+
+        std::cout << "Company " << companyId << ": " << stats.count << " readings, "
+                  << "Total CO2 = " << stats.sum << " ppm, Average CO2 = " << stats.mean
+                  << " ppm\n";
+    }
+
+    std::cout << "\nEnd-to-end Latency:\n";
+    std::cout << "-------------------------------------------------\n";
+    carbonStats.PrintLatency(std::cout);
+
     std::cout << "=================================================\n\n";
+    profiler.EndPhase("results");
 
     /*
      * ============================================
@@ -823,38 +1626,55 @@ main(int argc, char* argv[])
      * ============================================
      */
 
-    monitor->CheckForLostPackets();
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
-    std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats();
+    double flowDelaySum = 0.0; // s, over all flows
+    uint64_t flowRxPackets = 0;
+    if (monitor)
+    {
+        monitor->CheckForLostPackets();
+        Ptr<Ipv4FlowClassifier> classifier =
+            DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
+        std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats();
 
-    std::cout << "\n=================================================\n";
-    std::cout << "NETWORK FLOW STATISTICS\n";
-    std::cout << "=================================================\n";
+        std::cout << "\n=================================================\n";
+        std::cout << "NETWORK FLOW STATISTICS\n";
+        std::cout << "=================================================\n";
 
-    for (const auto& flow : stats)
-    {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flow.first);
-        std::cout << "Flow " << flow.first << " (" << t.sourceAddress << " -> "
-                  << t.destinationAddress << ")\n";
-        std::cout << "  Tx Packets: " << flow.second.txPackets << "\n";
-        std::cout << "  Rx Packets: " << flow.second.rxPackets << "\n";
-        std::cout << "  Throughput: "
-                  << flow.second.rxBytes * 8.0 /
-                         (flow.second.timeLastRxPacket.GetSeconds() -
-                          flow.second.timeFirstTxPacket.GetSeconds()) /
-                         1024
-                  << " Kbps\n";
-        std::cout << "  Mean Delay: " << flow.second.delaySum.GetSeconds() / flow.second.rxPackets
-                  << " s\n";
-        std::cout << "-------------------------------------------------\n";
-    }
+        for (const auto& flow : stats)
+        {
+            flowDelaySum += flow.second.delaySum.GetSeconds();
+            flowRxPackets += flow.second.rxPackets;
+            Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flow.first);
+            std::cout << "Flow " << flow.first << " (" << t.sourceAddress << " -> "
+                      << t.destinationAddress << ")\n";
+            std::cout << "  Tx Packets: " << flow.second.txPackets << "\n";
+            std::cout << "  Rx Packets: " << flow.second.rxPackets << "\n";
+            // Flows with no or a single reception have no span to divide by
+            double span = flow.second.timeLastRxPacket.GetSeconds() -
+                          flow.second.timeFirstTxPacket.GetSeconds();
+            double kbps = (flow.second.rxPackets > 0 && span > 0)
+                              ? flow.second.rxBytes * 8.0 / span / 1024
+                              : 0.0;
+            std::cout << "  Throughput: " << kbps << " Kbps\n";
+            double meanDelay = flow.second.rxPackets > 0
+                                   ? flow.second.delaySum.GetSeconds() / flow.second.rxPackets
+                                   : 0.0;
+            std::cout << "  Mean Delay: " << meanDelay << " s\n";
+            std::cout << "-------------------------------------------------\n";
+        }
 
-    monitor->SerializeToXmlFile("carbon-trading-flowmon.xml", true, true);
-    std::cout << "\nFlow monitor data saved to: carbon-trading-flowmon.xml\n";
+        monitor->SerializeToXmlFile(outputPrefix + "carbon-trading-flowmon.xml", true, true);
+        std::cout << "\nFlow monitor data saved to: " << outputPrefix
+                  << "carbon-trading-flowmon.xml\n";
+    }
+    if (metrics && !metrics->WriteFlows(outputPrefix + "carbon-trading-flows.csv"))
+    {
+        NS_LOG_WARN("Could not write " << outputPrefix << "carbon-trading-flows.csv");
+    }
     std::cout << "=================================================\n\n";
+    profiler.EndPhase("flowMonitor");
 
     // Write results to file
-    std::ofstream outFile("carbon_trading_results.txt");
+    std::ofstream outFile(outputPrefix + "carbon_trading_results.txt");
     if (outFile.is_open())
     {
         outFile << "Eco Ledger Carbon Trading Simulation Results\n";
@@ -863,43 +1683,219 @@ main(int argc, char* argv[])
         outFile << "  Number of sensors: " << nSensors << "\n";
         outFile << "  Simulation time: " << simulationTime << " seconds\n\n";
         outFile << "Network Performance:\n";
+        outFile << "  Active sensors: " << activeSensors << " of " << nSensors << "\n";
         outFile << "  Total packets sent: " << totalPacketsSent << "\n";
         outFile << "  Total packets received: " << totalPacketsReceived << "\n";
         outFile << "  Packet delivery ratio: " << deliveryRatio << "%\n\n";
         outFile << "CO2 Monitoring Data:\n";
         outFile << "-------------------------------------------------\n";
 
-        for (const auto& entry : totalCO2BySensor)
+        for (uint32_t sensorId = 0; sensorId < sensorStats.size(); ++sensorId)
         {
-            uint32_t sensorId = entry.first;
-            double totalCO2 = entry.second;
-            uint32_t packetCount = packetCountBySensor[sensorId];
-            double avgCO2 = totalCO2 / packetCount;
+            const RunningStats& stats = sensorStats[sensorId];
+            if (stats.count == 0)
+            {
+                continue;
+            }
 
             outFile << "Sensor " << sensorId << ":\n";
-            outFile << "  Number of readings: " << packetCount << "\n";
-            outFile << "  Average CO2 level: " << avgCO2 << " ppm\n";
-            outFile << "  Total CO2 measured: " << totalCO2 << " ppm\n\n";
+            outFile << "  Number of readings: " << stats.count << "\n";
+            outFile << "  Average CO2 level: " << stats.mean << " ppm\n";
+            outFile << "  Min/Max CO2 level: " << stats.min << " / " << stats.max << " ppm\n";
+            outFile << "  Std deviation: " << stats.GetStdDev() << " ppm\n";
+            outFile << "  Total CO2 measured: " << stats.sum << " ppm\n\n";
         }
 
         outFile << "=================================================\n";
         outFile << "Results saved at: " << Simulator::Now().GetSeconds() << "s\n";
         outFile.close();
 
-        std::cout << "Results also saved to: carbon_trading_results.txt\n";
+        std::cout << "Results also saved to: " << outputPrefix << "carbon_trading_results.txt\n";
     }
 
     std::cout << "\n=================================================\n";
-    std::cout << "VISUALIZATION FILES GENERATED\n";
+    std::cout << "VISUALIZATION FILES GENERATED (tracing profile: " << tracing << ")\n";
     std::cout << "=================================================\n";
-    std::cout << "1. NetAnim visualization: carbon-trading-animation.xml\n";
-    std::cout << "   - Open with NetAnim to see animated network\n";
-    std::cout << "2. Flow monitor: carbon-trading-flowmon.xml\n";
-    std::cout << "3. PCAP files: carbon-trading-wifi-*.pcap\n";
-    std::cout << "   - Open with Wireshark for packet analysis\n";
-    std::cout << "4. ASCII trace: carbon-trading.tr\n";
-    std::cout << "5. Route tracking: carbon-trading-routes.xml\n";
+    if (anim)
+    {
+        std::cout << "- NetAnim visualization: " << outputPrefix << "carbon-trading-animation.xml\n";
+        std::cout << "  Open with NetAnim to see animated network\n";
+        std::cout << "- PCAP files: " << outputPrefix << "carbon-trading-wifi-*.pcap\n";
+        std::cout << "  Open with Wireshark for packet analysis\n";
+        std::cout << "- ASCII trace: " << outputPrefix << "carbon-trading.tr\n";
+        std::cout << "- Route tracking: " << outputPrefix << "carbon-trading-routes.xml\n";
+    }
+    if (monitor)
+    {
+        std::cout << "- Flow monitor: " << outputPrefix << "carbon-trading-flowmon.xml\n";
+    }
+    if (metrics)
+    {
+        std::cout << "- Flow metrics: " << metrics->GetPath() << " ("
+                  << metrics->GetWindowsWritten() << " windows), per-flow totals in "
+                  << outputPrefix << "carbon-trading-flows.csv\n";
+    }
+    if (telemetry)
+    {
+        std::cout << "- Telemetry stream: " << telemetryHost << ":" << telemetryPort << " ("
+                  << telemetry->GetDatagramsSent() << " datagrams, "
+                  << telemetry->GetDatagramsDropped() << " dropped)\n";
+    }
+    if (carbonAnalytics)
+    {
+        std::cout << "- Carbon windows: " << carbonAnalytics->GetPath() << " ("
+                  << carbonAnalytics->GetWindowsClosed() << " windows)\n";
+    }
+    if (events)
+    {
+        std::cout << "- Event log: " << events->GetPath() << " (" << events->GetRecordCount()
+                  << " records, decode with tools/decode_event_log.py)\n";
+    }
+    if (tracingPlan.GetTracedNodes() > 0)
+    {
+        std::cout << "- IP traces of " << tracingPlan.GetTracedNodes() << " nodes ("
+                  << tracingPlan.GetRecordsWritten() << " packets): " << outputPrefix
+                  << "carbon-trading-ip-<node>.pcap, " << outputPrefix << "carbon-trading-ip.tr\n";
+    }
     std::cout << "=================================================\n\n";
+    profiler.EndPhase("output");
+
+    uint64_t peakRssKb = RunProfiler::GetPeakRssKb();
+    double packetsPerSecond = wallSeconds > 0 ? totalPacketsReceived / wallSeconds : 0.0;
+    std::cout << "Run profile (wall-clock):\n";
+    profiler.Print(std::cout);
+    std::cout << "Peak RSS: " << peakRssKb / 1024.0 << " MiB\n";
+    std::cout << "Simulation rate: " << (wallSeconds > 0 ? eventCount / wallSeconds : 0.0)
+              << " events/s, " << packetsPerSecond << " packets received/s\n\n";
+#ifdef CARBON_ALLOC_COUNTER
+    std::cout << "Heap allocations (see alloc-counter.h):\n";
+    AllocCounter::Print(std::cout);
+    std::cout << "\n";
+#endif
+
+    // Machine-readable results for tools/run_sweep.py
+    RunSummary summary("iot-connectivity");
+    summary.AddConfig("nSensors", nSensors);
+    summary.AddConfig("time", simulationTime);
+    summary.AddConfig("intervalS", intervalS);
+    summary.AddConfig("sensorBatchReadings", sensorBatchReadings);
+    summary.AddConfig("sensorBatchAgeS", sensorBatchAgeS);
+    summary.AddConfig("batchCodec", batchCodec);
+    summary.AddConfig("codecQuantumPpm", codecQuantumPpm);
+    summary.AddConfig("payload", payload);
+    summary.AddConfig("emissionModel", traceFile.empty() ? emissionModel : "trace");
+    summary.AddConfig("linkModel", linkModel);
+    summary.AddConfig("wifiChannel", wifiChannel);
+    summary.AddConfig("wifiStandard", wifiStandard);
+    summary.AddConfig("wifiBand", wifiConfig.GetBand());
+    summary.AddConfig("channelWidth", wifiConfig.GetChannelWidth());
+    summary.AddConfig("rateManager", rateManager);
+    summary.AddConfig("association", association);
+    summary.AddConfig("warmupS", warmupS);
+    summary.AddConfig("startSpreadS", startSpreadS);
+    summary.AddConfig("tickScheduler", tickScheduler);
+    summary.AddConfig("tracing", tracing);
+    summary.AddConfig("metricsInterval", metricsIntervalS);
+    summary.AddConfig("telemetryPort", telemetryPort);
+    summary.AddConfig("emulate", emulate);
+    if (emulate)
+    {
+        summary.AddConfig("realtimeMode", realtimeMode);
+        summary.AddConfig("lagLimitMs", lagLimitMs);
+    }
+    summary.AddConfig("reliable", reliable);
+    if (reliable)
+    {
+        summary.AddConfig("ackDelayMs", ackDelayMs);
+        summary.AddConfig("rtoMs", rtoMs);
+        summary.AddConfig("maxRetries", maxRetries);
+    }
+    summary.AddConfig("gatewayWorkers", gatewayWorkers);
+    if (gatewayWorkers > 0)
+    {
+        summary.AddConfig("gatewayQueue", gatewayQueue);
+        summary.AddConfig("gatewayPolicy", gatewayPolicy);
+        summary.AddConfig("gatewayService", gatewayService);
+        summary.AddConfig("gatewayServiceUs", gatewayServiceUs);
+    }
+    summary.AddConfig("analytics", analytics);
+    if (analytics)
+    {
+        summary.AddConfig("analyticsWindowS", analyticsWindowS);
+        summary.AddConfig("ewmaAlpha", ewmaAlpha);
+        summary.AddConfig("anomalySigma", anomalySigma);
+        summary.AddConfig("creditCapPpm", creditCapPpm);
+        summary.AddConfig("analyticsCostUs", analyticsCostUs);
+    }
+    summary.AddConfig("RngSeed", RngSeedManager::GetSeed());
+    summary.AddConfig("RngRun", RngSeedManager::GetRun());
+    summary.AddMetric("activeSensors", activeSensors);
+    summary.AddMetric("packetsSent", totalPacketsSent);
+    summary.AddMetric("packetsReceived", totalPacketsReceived);
+    summary.AddMetric("rejectedReadings", carbonStats.GetRejectedReadings());
+    summary.AddMetric("deliveryRatio", deliveryRatio);
+    summary.AddMetric("framesSent", totalFramesSent);
+    summary.AddMetric("readingsPerFrame", readingsPerFrame);
+    summary.AddMetric("meanLatencyMs", gatewayApp->GetMeanLatency() * 1000.0);
+    if (airtime)
+    {
+        summary.AddMetric("airtimeSeconds", airtime->GetTxAirtime().GetSeconds());
+        summary.AddMetric("wifiTxFrames", airtime->GetTxFrames());
+        summary.AddMetric("receiverBusyPercent",
+                          airtime->GetReceiverUtilization(Seconds(simulationTime)) * 100.0);
+        summary.AddMetric("rxErrors", airtime->GetRxErrors());
+        summary.AddMetric("rxDrops", airtime->GetRxDrops());
+    }
+    if (reliabilityStats)
+    {
+        reliabilityStats->AddMetrics(summary, sendingPeriod);
+        if (airtime)
+        {
+            summary.AddMetric("ackAirtimeSeconds", airtime->GetAckAirtime().GetSeconds());
+            summary.AddMetric("ackAirtimePercent", airtime->GetAckAirtimeShare() * 100.0);
+        }
+    }
+    carbonStats.AddLatencyMetrics(summary);
+    if (carbonAnalytics)
+    {
+        carbonAnalytics->AddMetrics(summary, sendingPeriod);
+    }
+    if (ingestQueue)
+    {
+        ingestQueue->AddMetrics(summary, sendingPeriod);
+    }
+    if (monitor)
+    {
+        summary.AddMetric("meanDelayMs", flowRxPackets > 0 ? flowDelaySum / flowRxPackets * 1000.0 : 0.0);
+    }
+    if (abstractLinks)
+    {
+        summary.AddMetric("framesDropped", star.GetFramesDropped());
+    }
+    codecStats->AddMetrics(summary);
+    if (telemetry)
+    {
+        telemetry->AddMetrics(summary);
+    }
+    if (lagMonitor)
+    {
+        summary.AddMetric("ingestDatagrams", gatewayApp->GetUpstreamSent());
+        summary.AddMetric("ingestRefused", gatewayApp->GetUpstreamFailed());
+        lagMonitor->AddMetrics(summary);
+    }
+    summary.AddMetric("eventCount", eventCount);
+    summary.AddMetric("wallSeconds", wallSeconds);
+    summary.AddMetric("eventsPerSecond", wallSeconds > 0 ? eventCount / wallSeconds : 0.0);
+    summary.AddMetric("packetsPerSecond", packetsPerSecond);
+    summary.AddMetric("peakRssKb", peakRssKb);
+    profiler.AddMetrics(summary);
+#ifdef CARBON_ALLOC_COUNTER
+    AllocCounter::AddMetrics(summary);
+#endif
+    if (!summary.Write(outputPrefix + "summary.json"))
+    {
+        NS_LOG_WARN("Could not write " << outputPrefix << "summary.json");
+    }
 
     Simulator::Destroy();
 
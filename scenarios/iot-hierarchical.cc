@@ -2,10 +2,11 @@
  * Hierarchical WiFi Network for IoT Carbon Trading Platform
  *
  * Network Architecture:
- * - 10 CO2 sensors grouped into 5 pairs (2 sensors per group)
- * - 5 WiFi Access Points (one for each sensor pair)
+ * - 10 CO2 sensors grouped into 5 zones (--sensorsPerZone, default 2)
+ * - 5 WiFi Access Points (one for each zone)
  * - 1 Main Gateway (central coordinator)
- * - Two-tier topology: Sensors → Local APs → Main Gateway
+ * - Two-tier topology: Sensors → Local APs → Main Gateway, or more routing
+ *   tiers in between with --tiers (see tier-topology.h)
  *
  * This simulates a distributed industrial facility with:
  * - Multiple departments/zones (5 zones)
@@ -24,143 +25,65 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/wifi-module.h"
 
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+
+#include <mpi.h>
+#endif
+
+#include "alloc-counter.h"
+#include "carbon-analytics.h"
+#include "carbon-ledger.h"
+#include "carbon-stats.h"
+#include "co2-batch-codec.h"
+#include "co2-batch-header.h"
+#include "co2-reading-header.h"
+#include "co2-sensor-app.h"
+#include "co2-trace.h"
+#include "emission-model.h"
+#include "event-log.h"
+#include "flow-metrics-collector.h"
+#include "gateway-shards.h"
+#include "ingest-queue.h"
+#include "reliable-delivery.h"
+#include "run-profiler.h"
+#include "run-summary.h"
+#include "sensor-tick-scheduler.h"
+#include "star-simple-channel.h"
+#include "telemetry-stream.h"
+#include "tier-topology.h"
+#include "tracing-profile.h"
+#include "wifi-airtime.h"
+#include "wifi-config.h"
+#include "wifi-medium.h"
+
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <map>
+#include <memory>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("HierarchicalCarbonTrading");
 
-// Global tracking variables
-std::map<uint32_t, double> totalCO2BySensor;
-std::map<uint32_t, uint32_t> packetCountBySensor;
-uint32_t totalPacketsReceived = 0;
-uint32_t totalPacketsSent = 0;
-
-/*
- * CO2 Sensor Application (same as before)
- */
-class CO2SensorApplication : public Application
-{
-  public:
-    CO2SensorApplication();
-    virtual ~CO2SensorApplication();
-
-    void Setup(Ptr<Socket> socket,
-               Address apAddress,
-               uint16_t port,
-               uint32_t sensorId,
-               uint32_t zoneId,
-               double baselineCO2);
-
-  private:
-    virtual void StartApplication(void);
-    virtual void StopApplication(void);
-    void SendCO2Reading(void);
-    double GenerateCO2Value(void);
-
-    Ptr<Socket> m_socket;
-    Address m_apAddress;
-    uint16_t m_port;
-    uint32_t m_sensorId;
-    uint32_t m_zoneId;
-    double m_baselineCO2;
-    EventId m_sendEvent;
-    Time m_interval;
-    bool m_running;
-};
-
-CO2SensorApplication::CO2SensorApplication()
-    : m_socket(0),
-      m_port(0),
-      m_sensorId(0),
-      m_zoneId(0),
-      m_baselineCO2(400.0),
-      m_interval(Seconds(5.0)),
-      m_running(false)
-{
-}
-
-CO2SensorApplication::~CO2SensorApplication()
-{
-    m_socket = 0;
-}
-
-void
-CO2SensorApplication::Setup(Ptr<Socket> socket,
-                            Address apAddress,
-                            uint16_t port,
-                            uint32_t sensorId,
-                            uint32_t zoneId,
-                            double baselineCO2)
-{
-    m_socket = socket;
-    m_apAddress = apAddress;
-    m_port = port;
-    m_sensorId = sensorId;
-    m_zoneId = zoneId;
-    m_baselineCO2 = baselineCO2;
-}
-
-void
-CO2SensorApplication::StartApplication(void)
-{
-    m_running = true;
-    m_socket->Bind();
-    m_socket->Connect(m_apAddress);
-    SendCO2Reading();
-}
-
-void
-CO2SensorApplication::StopApplication(void)
-{
-    m_running = false;
-    if (m_sendEvent.IsPending())
-    {
-        Simulator::Cancel(m_sendEvent);
-    }
-    if (m_socket)
-    {
-        m_socket->Close();
-    }
-}
-
-double
-CO2SensorApplication::GenerateCO2Value(void)
-{
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
-    double variation = rand->GetValue(-50.0, 50.0);
-    double co2Value = m_baselineCO2 + variation;
-    return std::max(300.0, std::min(3000.0, co2Value));
-}
-
-void
-CO2SensorApplication::SendCO2Reading(void)
-{
-    double co2Value = GenerateCO2Value();
-    std::ostringstream oss;
-    oss << "SENSOR:" << m_sensorId << ",ZONE:" << m_zoneId << ",CO2:" << co2Value;
-
-    std::string data = oss.str();
-    Ptr<Packet> packet = Create<Packet>((uint8_t*)data.c_str(), data.length());
-
-    if (m_socket->Send(packet) > 0)
-    {
-        totalPacketsSent++;
-        NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: Sensor " << m_sensorId
-                            << " (Zone " << m_zoneId << ") sent CO2: " << co2Value << " ppm");
-    }
-
-    if (m_running)
-    {
-        m_sendEvent = Simulator::Schedule(m_interval, &CO2SensorApplication::SendCO2Reading, this);
-    }
-}
-
 /*
  * Local Access Point Application
  * Receives data from sensors and forwards to main gateway
+ *
+ * With aggregation enabled, binary readings are packed into one
+ * CO2BatchHeader datagram per zone, flushed when the count threshold,
+ * the max-bytes limit or the max-delay timer is reached first, and
+ * encoded with the configured batch codec. Batches from batching sensors
+ * are decoded into the zone batch, or forwarded as they are when
+ * aggregation is off.
+ *
+ * With --reliable the AP is the acknowledging end of the sensors' WiFi
+ * hop: it strips the sequence header, drops duplicates and broadcasts
+ * batched ACKs to its zone (see reliable-delivery.h).
+ *
+ * With several main gateways the AP picks one per datagram on a hash ring
+ * and keeps one batch per gateway (see gateway-shards.h).
  */
 class LocalAPApplication : public Application
 {
@@ -174,11 +97,85 @@ class LocalAPApplication : public Application
                Address gatewayAddress,
                uint32_t zoneId);
 
+    /**
+     * Enable zone-level aggregation before backbone forwarding
+     * @param maxReadings Flush once this many readings are batched (<= 1 disables batching)
+     * @param maxDelay Flush at most this long after the first reading of a batch
+     * @param maxBytes Upper bound on the batch datagram payload size
+     */
+    void SetAggregation(uint32_t maxReadings, Time maxDelay, uint32_t maxBytes);
+
+    /**
+     * Encoding of the zone batches (sensor batches are decoded whatever their codec)
+     * @param config Codec and its modeled cost
+     * @param stats Counters shared by all encoders and decoders (null = off)
+     */
+    void SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats);
+
+    /**
+     * Record receptions and forwards in a binary event log
+     * @param log Log shared by all applications (null = off)
+     */
+    void SetEventLog(Ptr<EventLog> log);
+
+    /**
+     * Acknowledge the zone's sequenced datagrams and drop their duplicates
+     * @param ackSocket UDP socket the ACKs are broadcast from
+     * @param ackDestination Broadcast address and ACK port of the zone subnet
+     * @param firstSensorId ID of the zone's first sensor
+     * @param nSensors Sensors in the zone
+     * @param config ACK delay
+     * @param stats Counters shared by all senders and receivers (null = off)
+     */
+    void SetReliability(Ptr<Socket> ackSocket,
+                        Address ackDestination,
+                        uint32_t firstSensorId,
+                        uint32_t nSensors,
+                        const ReliabilityConfig& config,
+                        Ptr<ReliabilityStats> stats);
+
+    /**
+     * Spread the backbone traffic over several main gateways
+     * @param gateways Address of every gateway, in gateway order
+     * @param ring Ring of the gateways, shared by all APs
+     * @param config Key and failover settings
+     * @param heartbeatSocket UDP socket for the gateways' heartbeats (null without failover)
+     * @param heartbeatPort Port of the heartbeats
+     * @param stats Counters shared by all gateways and APs (null = off)
+     */
+    void SetSharding(const std::vector<Ipv4Address>& gateways,
+                     Ptr<const GatewayRing> ring,
+                     const ShardConfig& config,
+                     Ptr<Socket> heartbeatSocket,
+                     uint16_t heartbeatPort,
+                     Ptr<ShardStats> stats);
+
+    /** @return Readings still waiting in a partial batch when the AP stopped */
+    uint32_t GetReadingsStranded(void) const
+    {
+        return m_readingsStranded;
+    }
+
   private:
     virtual void StartApplication(void);
     virtual void StopApplication(void);
     void HandleRead(Ptr<Socket> socket);
-    void ForwardToGateway(Ptr<Packet> packet);
+    void ForwardToGateway(Ptr<Packet> packet, uint32_t gateway);
+    void AddToBatch(const CO2ReadingHeader& reading, uint32_t gateway);
+    void AddSensorBatch(Ptr<Packet> packet, uint32_t gateway);
+    void FlushBatch(uint32_t gateway);
+    void SendBatch(Ptr<Packet> batch, uint32_t count, uint32_t gateway);
+    /** @return Whether the forward socket took the datagram */
+    bool SendToGateway(Ptr<Packet> packet, uint32_t gateway);
+
+    /**
+     * Readings waiting for one gateway
+     */
+    struct PendingBatch
+    {
+        CO2BatchEncoder encoder;
+        EventId flushEvent;
+    };
 
     Ptr<Socket> m_receiveSocket;
     Ptr<Socket> m_forwardSocket;
@@ -187,6 +184,21 @@ class LocalAPApplication : public Application
     uint32_t m_zoneId;
     uint32_t m_packetsReceived;
     uint32_t m_packetsForwarded;
+
+    // Aggregation state
+    uint32_t m_batchMaxReadings;
+    Time m_batchMaxDelay;
+    uint32_t m_batchMaxBytes;
+    std::vector<PendingBatch> m_batches; // Per gateway
+    CO2BatchDecoder m_sensorBatch;       // Unpacks the batches of batching sensors
+    uint32_t m_batchesForwarded;
+    uint32_t m_readingsStranded;
+
+    Ptr<EventLog> m_eventLog;      // Null unless --eventLog is set
+    AckBatcher m_acks;             // Disabled unless --reliable is set
+    GatewaySelector m_shards;      // Disabled unless --gateways is above 1
+    Ptr<Socket> m_heartbeatSocket; // Null unless --failover is set
+    uint16_t m_heartbeatPort;
 };
 
 LocalAPApplication::LocalAPApplication()
@@ -195,7 +207,14 @@ LocalAPApplication::LocalAPApplication()
       m_receivePort(0),
       m_zoneId(0),
       m_packetsReceived(0),
-      m_packetsForwarded(0)
+      m_packetsForwarded(0),
+      m_batchMaxReadings(1),
+      m_batchMaxDelay(MilliSeconds(100)),
+      m_batchMaxBytes(1472),
+      m_batches(1),
+      m_batchesForwarded(0),
+      m_readingsStranded(0),
+      m_heartbeatPort(0)
 {
 }
 
@@ -217,6 +236,58 @@ LocalAPApplication::Setup(Ptr<Socket> receiveSocket,
     m_zoneId = zoneId;
 }
 
+void
+LocalAPApplication::SetAggregation(uint32_t maxReadings, Time maxDelay, uint32_t maxBytes)
+{
+    m_batchMaxReadings = maxReadings;
+    m_batchMaxDelay = maxDelay;
+    m_batchMaxBytes = maxBytes;
+}
+
+void
+LocalAPApplication::SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+{
+    for (PendingBatch& batch : m_batches)
+    {
+        batch.encoder.SetCodec(config, stats);
+    }
+    m_sensorBatch.SetCodec(config, stats);
+}
+
+void
+LocalAPApplication::SetEventLog(Ptr<EventLog> log)
+{
+    m_eventLog = log;
+}
+
+void
+LocalAPApplication::SetReliability(Ptr<Socket> ackSocket,
+                                   Address ackDestination,
+                                   uint32_t firstSensorId,
+                                   uint32_t nSensors,
+                                   const ReliabilityConfig& config,
+                                   Ptr<ReliabilityStats> stats)
+{
+    m_acks.Setup(ackSocket, ackDestination, m_zoneId, config, stats);
+    m_acks.Reserve(firstSensorId, nSensors);
+}
+
+void
+LocalAPApplication::SetSharding(const std::vector<Ipv4Address>& gateways,
+                                Ptr<const GatewayRing> ring,
+                                const ShardConfig& config,
+                                Ptr<Socket> heartbeatSocket,
+                                uint16_t heartbeatPort,
+                                Ptr<ShardStats> stats)
+{
+    uint16_t port = InetSocketAddress::ConvertFrom(m_gatewayAddress).GetPort();
+    m_shards.Setup(gateways, port, m_zoneId, ring, config, stats);
+    // The new batches inherit the codec of the first one
+    m_batches.resize(gateways.size(), m_batches[0]);
+    m_heartbeatSocket = heartbeatSocket;
+    m_heartbeatPort = heartbeatPort;
+}
+
 void
 LocalAPApplication::StartApplication(void)
 {
@@ -225,7 +296,23 @@ LocalAPApplication::StartApplication(void)
     m_receiveSocket->SetRecvCallback(MakeCallback(&LocalAPApplication::HandleRead, this));
 
     m_forwardSocket->Bind();
-    m_forwardSocket->Connect(m_gatewayAddress);
+    if (!m_shards.IsEnabled())
+    {
+        m_forwardSocket->Connect(m_gatewayAddress);
+    }
+
+    for (PendingBatch& batch : m_batches)
+    {
+        batch.encoder.Clear();
+    }
+    if (m_acks.IsEnabled())
+    {
+        m_acks.Start();
+    }
+    if (m_heartbeatSocket)
+    {
+        m_shards.Start(m_heartbeatSocket, m_heartbeatPort);
+    }
 
     NS_LOG_INFO("Local AP Zone " << m_zoneId << " started on port " << m_receivePort);
 }
@@ -233,6 +320,14 @@ LocalAPApplication::StartApplication(void)
 void
 LocalAPApplication::StopApplication(void)
 {
+    // The gateways stop at the same instant, so a partial batch sent now could never be
+    // received; count its readings instead of losing them silently
+    for (PendingBatch& pending : m_batches)
+    {
+        pending.flushEvent.Cancel();
+        m_readingsStranded += pending.encoder.GetCount();
+    }
+
     if (m_receiveSocket)
     {
         m_receiveSocket->Close();
@@ -241,8 +336,15 @@ LocalAPApplication::StopApplication(void)
     {
         m_forwardSocket->Close();
     }
+    if (m_acks.IsEnabled())
+    {
+        m_acks.Stop();
+    }
+    m_shards.Stop();
     NS_LOG_INFO("Local AP Zone " << m_zoneId << ": Received=" << m_packetsReceived
-                                 << ", Forwarded=" << m_packetsForwarded);
+                                 << ", Forwarded=" << m_packetsForwarded
+                                 << ", Batches=" << m_batchesForwarded
+                                 << ", Stranded=" << m_readingsStranded);
 }
 
 void
@@ -256,28 +358,147 @@ LocalAPApplication::HandleRead(Ptr<Socket> socket)
         if (packet->GetSize() > 0)
         {
             m_packetsReceived++;
-            NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: AP Zone " << m_zoneId
-                                << " received packet from sensor");
-            ForwardToGateway(packet);
+            NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: AP Zone " << m_zoneId
+                                 << " received packet from sensor");
+            if (m_eventLog)
+            {
+                m_eventLog->Record(EVENT_AP_RECEIVE, GetNode()->GetId(), 0, m_zoneId, packet->GetSize());
+            }
+            if (m_acks.IsEnabled() && CO2SequenceHeader::IsSequencedPayload(packet) &&
+                !m_acks.Accept(packet))
+            {
+                continue; // Retransmission of a datagram already forwarded, or a stray sensor
+            }
+            uint32_t gateway = m_shards.IsEnabled() ? m_shards.Select(from) : 0;
+            if (m_batchMaxReadings > 1 && CO2BatchHeader::IsBatchPayload(packet))
+            {
+                AddSensorBatch(packet, gateway);
+            }
+            else if (m_batchMaxReadings > 1 && CO2ReadingHeader::IsBinaryPayload(packet))
+            {
+                CO2ReadingHeader reading;
+                packet->PeekHeader(reading);
+                AddToBatch(reading, gateway);
+            }
+            else
+            {
+                ForwardToGateway(packet, gateway);
+            }
+        }
+    }
+}
+
+void
+LocalAPApplication::AddToBatch(const CO2ReadingHeader& reading, uint32_t gateway)
+{
+    PendingBatch& pending = m_batches[gateway];
+    CO2BatchEncoder& encoder = pending.encoder;
+    // Flush first if this reading would push the datagram past the byte limit
+    uint32_t size =
+        CO2BatchHeader::SERIALIZED_SIZE + encoder.GetSize() + encoder.GetEncodedSize(reading);
+    if (encoder.GetCount() > 0 && size > m_batchMaxBytes)
+    {
+        FlushBatch(gateway);
+    }
+
+    encoder.Append(reading);
+
+    if (encoder.GetCount() == 1)
+    {
+        pending.flushEvent =
+            Simulator::Schedule(m_batchMaxDelay, &LocalAPApplication::FlushBatch, this, gateway);
+    }
+    if (encoder.GetCount() >= m_batchMaxReadings || encoder.GetCount() == UINT16_MAX)
+    {
+        FlushBatch(gateway);
+    }
+}
+
+void
+LocalAPApplication::AddSensorBatch(Ptr<Packet> packet, uint32_t gateway)
+{
+    // A truncated batch keeps its complete readings
+    m_sensorBatch.Decode(packet);
+    for (const CO2ReadingHeader& reading : m_sensorBatch.GetReadings())
+    {
+        AddToBatch(reading, gateway);
+    }
+}
+
+void
+LocalAPApplication::FlushBatch(uint32_t gateway)
+{
+    PendingBatch& pending = m_batches[gateway];
+    if (pending.flushEvent.IsPending())
+    {
+        Simulator::Cancel(pending.flushEvent);
+    }
+    uint32_t count = pending.encoder.GetCount();
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The datagram leaves once the modeled encoding time has passed
+    Time encodeTime = pending.encoder.GetConfig().encodeCost * count;
+    Ptr<Packet> batch = pending.encoder.Finish(m_zoneId);
+    NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: AP Zone " << m_zoneId
+                         << " flushing batch of " << count << " readings (" << batch->GetSize()
+                         << " bytes)");
+    if (encodeTime.IsZero())
+    {
+        SendBatch(batch, count, gateway);
+    }
+    else
+    {
+        Simulator::Schedule(encodeTime, &LocalAPApplication::SendBatch, this, batch, count, gateway);
+    }
+}
+
+void
+LocalAPApplication::SendBatch(Ptr<Packet> batch, uint32_t count, uint32_t gateway)
+{
+    if (SendToGateway(batch, gateway))
+    {
+        m_packetsForwarded += count;
+        m_batchesForwarded++;
+        if (m_eventLog)
+        {
+            m_eventLog->Record(EVENT_AP_BATCH, GetNode()->GetId(), count, m_zoneId, batch->GetSize());
         }
     }
 }
 
 void
-LocalAPApplication::ForwardToGateway(Ptr<Packet> packet)
+LocalAPApplication::ForwardToGateway(Ptr<Packet> packet, uint32_t gateway)
 {
     // Add zone info and forward to main gateway
-    if (m_forwardSocket->Send(packet) > 0)
+    if (SendToGateway(packet, gateway))
     {
         m_packetsForwarded++;
-        NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: AP Zone " << m_zoneId
-                            << " forwarded to main gateway");
+        NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: AP Zone " << m_zoneId
+                             << " forwarded to main gateway");
+        if (m_eventLog)
+        {
+            m_eventLog->Record(EVENT_AP_FORWARD, GetNode()->GetId(), 0, m_zoneId, packet->GetSize());
+        }
     }
 }
 
+bool
+LocalAPApplication::SendToGateway(Ptr<Packet> packet, uint32_t gateway)
+{
+    if (!m_shards.IsEnabled())
+    {
+        return m_forwardSocket->Send(packet) > 0;
+    }
+    return m_forwardSocket->SendTo(packet, 0, m_shards.GetAddress(gateway)) > 0;
+}
+
 /*
  * Main Gateway Application
- * Receives forwarded data from all local APs
+ * Receives forwarded data from all local APs, or from the shards the
+ * APs pick it for when there are several gateways
  */
 class MainGatewayApplication : public Application
 {
@@ -287,19 +508,114 @@ class MainGatewayApplication : public Application
 
     void Setup(Ptr<Socket> socket, uint16_t port);
 
+    /** @return Number of backbone datagrams received (one per HandleRead upcall item) */
+    uint32_t GetDatagramsReceived(void) const;
+
+    /** @return Mean sensor-to-gateway latency of binary readings, in seconds */
+    double GetMeanLatency(void) const;
+
+    /**
+     * Carbon accounting records of this gateway
+     * Call Reserve() on it before the run to keep the receive path allocation-free.
+     */
+    CarbonStatsStore& GetStats(void);
+
+    /**
+     * Modeled decoding cost and codec counters of the batch decoder
+     * @param config Decoding cost per reading (the codec comes with each batch)
+     * @param stats Counters shared by all encoders and decoders (null = off)
+     */
+    void SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats);
+
+    /**
+     * Report readings to the windowed flow metrics
+     * @param metrics Collector shared by all applications (null = off)
+     */
+    void SetMetrics(Ptr<FlowMetricsCollector> metrics);
+
+    /**
+     * Run every recorded reading through the streaming analytics stage
+     * @param analytics Anomaly detector and window rollups (null = off)
+     */
+    void SetAnalytics(Ptr<CarbonAnalytics> analytics);
+
+    /**
+     * Append every recorded reading to the ledger stage
+     * @param ledger Append-only ledger (null = off)
+     */
+    void SetLedger(Ptr<CarbonLedger> ledger);
+
+    /**
+     * Process datagrams through a modeled ingest pipeline instead of instantly
+     * @param queue Bounded queue and workers of this gateway (null = off)
+     */
+    void SetIngestQueue(Ptr<IngestQueue> queue);
+
+    /**
+     * Tell every AP that this gateway is alive, for their failover
+     * @param socket UDP socket the heartbeats are sent from
+     * @param aps Heartbeat address and port of every AP
+     * @param interval Time between two heartbeats to the same AP
+     * @param stats Counters shared by all gateways and APs (null = off)
+     */
+    void SetHeartbeat(Ptr<Socket> socket,
+                      const std::vector<Address>& aps,
+                      Time interval,
+                      Ptr<ShardStats> stats);
+
+    /**
+     * Record readings and malformed datagrams in a binary event log
+     * @param log Log shared by all applications (null = off)
+     */
+    void SetEventLog(Ptr<EventLog> log);
+
   private:
     virtual void StartApplication(void);
     virtual void StopApplication(void);
     void HandleRead(Ptr<Socket> socket);
+    /** Read the socket again once the ingest queue has room (backpressure) */
+    void ResumeRead(void);
+    /** Dispatch one datagram to the batch or single-reading path */
+    void Process(Ptr<Packet> packet, Address from);
     void ProcessData(Ptr<Packet> packet, Address from);
+    void ProcessBatch(Ptr<Packet> packet, Address from);
+    /**
+     * @param bytes Bytes the reading took on the wire
+     * @param decodeDelay Modeled time until the reading was decoded
+     */
+    void ProcessReading(const CO2ReadingHeader& reading,
+                        uint32_t bytes,
+                        Time decodeDelay,
+                        Address from);
+    void RecordReading(uint32_t sensorId,
+                       uint32_t zoneId,
+                       uint32_t companyId,
+                       double co2Value,
+                       uint32_t bytes,
+                       Address from);
 
     Ptr<Socket> m_socket;
     uint16_t m_port;
+    uint32_t m_datagramsReceived;
+    double m_latencySum; // Sum of reading latencies (s)
+    uint64_t m_latencyCount;
+    CarbonStatsStore m_stats;
+    CO2BatchDecoder m_decoder;
+    Ptr<FlowMetricsCollector> m_metrics; // Null unless the tracing profile collects metrics
+    Ptr<CarbonAnalytics> m_analytics;    // Null unless --analytics is set
+    AnalyticsCore m_analyticsCore;       // Analytics CPU when there are no ingest workers
+    Ptr<CarbonLedger> m_ledger;          // Null unless --ledger is set
+    Ptr<IngestQueue> m_ingestQueue;      // Null unless --gatewayWorkers is set
+    Ptr<EventLog> m_eventLog;            // Null unless --eventLog is set
+    HeartbeatSender m_heartbeat;         // Disabled unless --failover is set
 };
 
 MainGatewayApplication::MainGatewayApplication()
     : m_socket(0),
-      m_port(0)
+      m_port(0),
+      m_datagramsReceived(0),
+      m_latencySum(0.0),
+      m_latencyCount(0)
 {
 }
 
@@ -314,12 +630,82 @@ MainGatewayApplication::Setup(Ptr<Socket> socket, uint16_t port)
     m_port = port;
 }
 
+uint32_t
+MainGatewayApplication::GetDatagramsReceived(void) const
+{
+    return m_datagramsReceived;
+}
+
+double
+MainGatewayApplication::GetMeanLatency(void) const
+{
+    return (m_latencyCount > 0) ? m_latencySum / m_latencyCount : 0.0;
+}
+
+CarbonStatsStore&
+MainGatewayApplication::GetStats(void)
+{
+    return m_stats;
+}
+
+void
+MainGatewayApplication::SetBatchCodec(const BatchCodecConfig& config, Ptr<BatchCodecStats> stats)
+{
+    m_decoder.SetCodec(config, stats);
+}
+
+void
+MainGatewayApplication::SetMetrics(Ptr<FlowMetricsCollector> metrics)
+{
+    m_metrics = metrics;
+}
+
+void
+MainGatewayApplication::SetAnalytics(Ptr<CarbonAnalytics> analytics)
+{
+    m_analytics = analytics;
+}
+
+void
+MainGatewayApplication::SetLedger(Ptr<CarbonLedger> ledger)
+{
+    m_ledger = ledger;
+}
+
+void
+MainGatewayApplication::SetIngestQueue(Ptr<IngestQueue> queue)
+{
+    m_ingestQueue = queue;
+    m_ingestQueue->SetHandlers(MakeCallback(&MainGatewayApplication::Process, this),
+                               MakeCallback(&MainGatewayApplication::ResumeRead, this));
+    m_ingestQueue->WatchSocket(m_socket);
+}
+
+void
+MainGatewayApplication::SetHeartbeat(Ptr<Socket> socket,
+                                     const std::vector<Address>& aps,
+                                     Time interval,
+                                     Ptr<ShardStats> stats)
+{
+    m_heartbeat.Setup(socket, aps, interval, stats);
+}
+
+void
+MainGatewayApplication::SetEventLog(Ptr<EventLog> log)
+{
+    m_eventLog = log;
+}
+
 void
 MainGatewayApplication::StartApplication(void)
 {
     InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), m_port);
     m_socket->Bind(local);
     m_socket->SetRecvCallback(MakeCallback(&MainGatewayApplication::HandleRead, this));
+    if (m_heartbeat.IsEnabled())
+    {
+        m_heartbeat.Start();
+    }
     NS_LOG_INFO("Main Gateway started on port " << m_port);
 }
 
@@ -330,7 +716,13 @@ MainGatewayApplication::StopApplication(void)
     {
         m_socket->Close();
     }
-    NS_LOG_INFO("Main Gateway: Total packets received = " << totalPacketsReceived);
+    if (m_heartbeat.IsEnabled())
+    {
+        m_heartbeat.Stop();
+    }
+    // The shared ledger is sealed once by main at the end of the run, not by each
+    // gateway: a failed gateway would otherwise cut a partial block at failure time
+    NS_LOG_INFO("Main Gateway: Total packets received = " << m_stats.GetTotalReadings());
 }
 
 void
@@ -339,44 +731,167 @@ MainGatewayApplication::HandleRead(Ptr<Socket> socket)
     Ptr<Packet> packet;
     Address from;
 
-    while ((packet = socket->RecvFrom(from)))
+    // Under backpressure, datagrams stay in the socket while the ingest queue is full
+    while ((!m_ingestQueue || !m_ingestQueue->IsBlocking()) && (packet = socket->RecvFrom(from)))
     {
         if (packet->GetSize() > 0)
         {
-            totalPacketsReceived++;
-            ProcessData(packet, from);
+            m_datagramsReceived++;
+            if (m_ingestQueue)
+            {
+                m_ingestQueue->Enqueue(packet, from);
+            }
+            else
+            {
+                Process(packet, from);
+            }
         }
     }
 }
 
+void
+MainGatewayApplication::ResumeRead(void)
+{
+    HandleRead(m_socket);
+}
+
+void
+MainGatewayApplication::Process(Ptr<Packet> packet, Address from)
+{
+    if (CO2BatchHeader::IsBatchPayload(packet))
+    {
+        ProcessBatch(packet, from);
+    }
+    else
+    {
+        ProcessData(packet, from);
+    }
+}
+
 void
 MainGatewayApplication::ProcessData(Ptr<Packet> packet, Address from)
 {
-    uint8_t buffer[1024];
-    packet->CopyData(buffer, packet->GetSize());
-    buffer[packet->GetSize()] = '\0';
-    std::string data((char*)buffer);
+    uint32_t size = packet->GetSize();
+    CO2ReadingHeader reading;
+    bool valid = false;
+    {
+        AllocScope scope(ALLOC_GATEWAY_DECODE);
+        if (CO2ReadingHeader::IsBinaryPayload(packet))
+        {
+            packet->RemoveHeader(reading);
+            size = CO2ReadingHeader::SERIALIZED_SIZE;
+            valid = true;
+        }
+        else
+        {
+            valid = ParseTextReading(packet, reading);
+        }
+    }
 
-    // Parse: SENSOR:X,ZONE:Y,CO2:Z
-    size_t sensorPos = data.find("SENSOR:");
-    size_t zonePos = data.find("ZONE:");
-    size_t co2Pos = data.find("CO2:");
+    if (valid)
+    {
+        ProcessReading(reading, size, Time(0), from);
+    }
+    else if (m_eventLog)
+    {
+        m_eventLog->Record(EVENT_GATEWAY_MALFORMED, GetNode()->GetId(), 0, 0, packet->GetSize());
+    }
+}
 
-    if (sensorPos != std::string::npos && zonePos != std::string::npos &&
-        co2Pos != std::string::npos)
+void
+MainGatewayApplication::ProcessBatch(Ptr<Packet> packet, Address from)
+{
+    uint32_t count = m_decoder.Decode(packet);
+    const CO2BatchHeader& batchHeader = m_decoder.GetHeader();
+    if (m_decoder.IsTruncated())
     {
-        uint32_t sensorId = std::stoi(data.substr(sensorPos + 7, zonePos - sensorPos - 8));
-        uint32_t zoneId = std::stoi(data.substr(zonePos + 5, co2Pos - zonePos - 6));
-        double co2Value = std::stod(data.substr(co2Pos + 4));
+        NS_LOG_WARN("Main Gateway received truncated batch from Zone "
+                    << batchHeader.GetZoneId() << " (" << batchHeader.GetCount()
+                    << " readings announced, " << count << " decoded)");
+        if (m_eventLog)
+        {
+            m_eventLog->Record(EVENT_GATEWAY_MALFORMED,
+                               GetNode()->GetId(),
+                               batchHeader.GetCount(),
+                               batchHeader.GetZoneId(),
+                               packet->GetSize());
+        }
+    }
+    if (count == 0)
+    {
+        return;
+    }
 
-        totalCO2BySensor[sensorId] += co2Value;
-        packetCountBySensor[sensorId]++;
+    // Readings are decoded one after the other, and share the batch bytes evenly
+    uint32_t bytes = (packet->GetSize() - CO2BatchHeader::SERIALIZED_SIZE) / count;
+    Time decodeCost = m_decoder.GetConfig().decodeCost;
+    const std::vector<CO2ReadingHeader>& readings = m_decoder.GetReadings();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ProcessReading(readings[i], bytes, decodeCost * (i + 1), from);
+    }
+}
 
-        InetSocketAddress inetFrom = InetSocketAddress::ConvertFrom(from);
-        NS_LOG_INFO("Time " << Simulator::Now().GetSeconds() << "s: Main Gateway received - Sensor "
-                            << sensorId << " (Zone " << zoneId << ") CO2: " << co2Value
-                            << " ppm [Source: " << inetFrom.GetIpv4() << "]");
+void
+MainGatewayApplication::ProcessReading(const CO2ReadingHeader& reading,
+                                       uint32_t bytes,
+                                       Time decodeDelay,
+                                       Address from)
+{
+    if (m_analytics && !m_ingestQueue)
+    {
+        // Ingest workers already charged the cost in their service time
+        Time done = m_analyticsCore.Run(Simulator::Now() + decodeDelay,
+                                        m_analytics->GetCostPerReading());
+        decodeDelay = done - Simulator::Now();
+    }
+    Time latency = Simulator::Now() + decodeDelay - MicroSeconds(reading.GetTimestamp());
+    m_stats.RecordLatency(reading.GetZoneId(), reading.GetCompanyId(), latency);
+    m_latencySum += latency.GetSeconds();
+    m_latencyCount++;
+    if (m_metrics)
+    {
+        m_metrics->RecordReceive(reading.GetSensorId(),
+                                 reading.GetZoneId(),
+                                 bytes,
+                                 latency,
+                                 reading.GetCo2Ppm());
+    }
+    if (m_ledger)
+    {
+        m_ledger->Append(reading);
     }
+
+    RecordReading(reading.GetSensorId(),
+                  reading.GetZoneId(),
+                  reading.GetCompanyId(),
+                  reading.GetCo2Ppm(),
+                  bytes,
+                  from);
+}
+
+void
+MainGatewayApplication::RecordReading(uint32_t sensorId,
+                                      uint32_t zoneId,
+                                      uint32_t companyId,
+                                      double co2Value,
+                                      uint32_t bytes,
+                                      Address from)
+{
+    m_stats.Record(sensorId, zoneId, companyId, co2Value);
+    if (m_analytics)
+    {
+        m_analytics->Record(sensorId, zoneId, companyId, co2Value);
+    }
+    if (m_eventLog)
+    {
+        m_eventLog->Record(EVENT_GATEWAY_RECEIVE, GetNode()->GetId(), sensorId, zoneId, bytes);
+    }
+
+    NS_LOG_LOGIC("Time " << Simulator::Now().GetSeconds() << "s: Main Gateway received - Sensor "
+                         << sensorId << " (Zone " << zoneId << ") CO2: " << co2Value
+                         << " ppm [Source: " << InetSocketAddress::ConvertFrom(from).GetIpv4()
+                         << "]");
 }
 
 /*
@@ -385,22 +900,323 @@ MainGatewayApplication::ProcessData(Ptr<Packet> packet, Address from)
 int
 main(int argc, char* argv[])
 {
-    uint32_t nZones = 5;         // Number of zones (each with 2 sensors and 1 AP)
+    uint32_t nZones = 5;         // Number of zones (each with sensorsPerZone sensors and 1 AP)
     uint32_t sensorsPerZone = 2; // Sensors per zone
+    std::string tiers = "";      // Tier spec, e.g. "building:4,floor:3" (empty = "zone:nZones")
     double simulationTime = 30.0;
     uint16_t sensorPort = 9000;  // Port for sensor → AP communication
     uint16_t gatewayPort = 9001; // Port for AP → Gateway communication
+    uint32_t nCompanies = 3;     // Companies owning sensors (assigned round-robin)
     bool verbose = true;
+    std::string payload = "binary"; // Sensor payload format: binary or text
+    std::string emissionModel = "uniform"; // uniform, diurnal, shift, ar1 or step
+    std::string traceFile = "";            // Recorded CO2 trace to replay (empty = off)
+    double traceOffset = 1.0;              // Simulation time of the trace start
+    uint32_t apBatchReadings = 1;   // Readings per backbone datagram (1 = no aggregation)
+    double apBatchDelayMs = 100.0;  // Max time a reading waits in a partial batch
+    uint32_t apBatchBytes = 1472;   // Max batch datagram payload (fits a 1500-byte MTU)
+    std::string batchCodec = "raw"; // Reading encoding of AP and sensor batches: raw or delta
+    double codecQuantumPpm = 0.01;  // CO2 step of the delta codec (0.01 = lossless)
+    double codecEncodeUs = 0.0;     // Modeled encoding time per reading
+    double codecDecodeUs = 0.0;     // Modeled decoding time per reading
+    bool tickScheduler = false;     // Shared sensor tick scheduler instead of per-sensor events
+    double tickResolutionMs = 1.0;  // Phase slot width of the tick scheduler
+    std::string backbone = "csma";      // AP -> gateway backbone: csma (shared) or p2p (per-AP links)
+    std::string backboneRate = "100Mbps";
+    double backboneDelayMs = 2.0;       // Backbone delay; the MPI lookahead in distributed mode
+    bool distributed = false;           // Partition zones across MPI ranks (needs --backbone=p2p)
+    bool nullMessages = false;          // Null-message instead of granted-time-window synchronization
+    std::string channelPlan = "shared"; // WiFi media: shared, zone or cochannel (see README)
+    uint32_t nFrequencyChannels = 3;    // Frequencies reused round-robin across zones
+    std::string wifiChannel = "yans";   // WiFi channel model: yans, spectrum or grid
+    double cullThresholdDbm = -101.0;   // Grid channel delivery threshold
+    std::string wifiStandard = "b";     // 802.11 standard (see wifi-config.h)
+    std::string wifiBand = "auto";      // auto = the standard's default band
+    uint16_t channelWidth = 0;          // MHz, 0 = 20 (22 for 802.11b)
+    std::string rateManager = "constant"; // WiFi rate control: constant, minstrel or ideal
+    std::string dataMode = "";          // Constant rate modes, empty = lowest mode of the standard
+    std::string controlMode = "";
+    std::string association = "standard"; // standard (STA/AP handshake) or fast (ad hoc)
+    double warmupS = 1.0;               // First sensor start; the rest follow at 0.2 s steps
+    double startSpreadS = 0.0;          // Spread sensor starts evenly over this instead (0 = off)
+    std::string linkModel = "wifi";     // Zone links: wifi or abstract (see README)
+    std::string linkRate = "1Mbps";     // Abstract device rate (matches DsssRate1Mbps)
+    double linkDelayMs = 1.0;           // Abstract one-way delay
+    double linkLossRate = 0.0;          // Abstract frame loss probability
+    double intervalS = 5.0;             // Time between readings of each sensor
+    std::string outputPrefix = "";      // Prepended to every output file (e.g. "runs/42/")
+    uint32_t sensorBatchReadings = 1;   // Readings per sensor datagram (1 = no batching)
+    double sensorBatchAgeS = 0.0;       // Max age of a partial sensor batch (0 = no limit)
+    std::string tracing = "full";       // Run artifacts: none, metrics, debug or full
+    double traceStart = 0.0;            // Trace window start (s)
+    double traceStop = 0.0;             // Trace window end (s), 0 = end of the run
+    uint32_t traceZone = 1;             // Zone with IP-level traces (0 = every zone)
+    uint32_t traceSensors = 1;          // Sensors with IP-level traces in each traced zone
+    double metricsIntervalS = 1.0;      // Flow metrics snapshot period (s), metrics profile and up
+    uint16_t telemetryPort = 0;         // UDP port for live flow metrics rows (0 = off)
+    std::string telemetryHost = "127.0.0.1"; // Telemetry listener (see telemetry-stream.h)
+    bool reliable = false;              // Sequence numbers, zone ACKs and retransmissions
+    double ackDelayMs = 50.0;           // Longest wait before an AP broadcasts pending ACKs
+    double rtoMs = 200.0;               // Retransmission timeout, doubled at each retry
+    uint32_t maxRetries = 4;            // Retransmissions before a datagram is abandoned
+    uint16_t ackPort = 9002;            // Sensor port of the ACK broadcasts
+    bool analytics = false;             // Anomaly flags and windowed credit rollups at the gateway
+    double analyticsWindowS = 60.0;     // Tumbling window length
+    double ewmaAlpha = 0.1;             // Weight of the newest reading in the anomaly baseline
+    double anomalySigma = 4.0;          // Deviations from the baseline that flag a reading
+    double anomalyPpm = 0.0;            // Absolute anomaly limit (0 = none)
+    double creditCapPpm = 1000.0;       // Emission cap of the credit balance
+    double analyticsCostUs = 0.0;       // Modeled CPU time per reading
+    bool ledger = false;                // Append-only ledger stage behind the gateway
+    uint32_t ledgerBlockEntries = 256;  // Seal a block once this many readings wait
+    double ledgerBlockMs = 1000.0;      // ... or this long after its first reading
+    double ledgerBlockCostMs = 5.0;     // Modeled commit time per block
+    double ledgerEntryCostUs = 20.0;    // Modeled commit time per reading
+
+    // Gateway processing model: bounded queue in front of worker cores (see ingest-queue.h)
+    uint32_t gatewayWorkers = 0;        // Ingest worker cores at the gateway (0 = instant processing)
+    uint32_t gatewayQueue = 1000;       // Datagrams waiting for a worker
+    std::string gatewayPolicy = "droptail";     // Full queue: droptail, drophead or backpressure
+    std::string gatewayService = "exponential"; // Service time distribution per reading
+    double gatewayServiceUs = 50.0;     // Mean service time per reading
+
+    // Horizontal ingest: several main gateways behind the root (see gateway-shards.h)
+    uint32_t gateways = 1;              // Main gateways (1 = the root itself)
+    std::string shardBy = "sensor";     // Key the APs hash onto the ring: sensor or zone
+    uint32_t shardPoints = 64;          // Ring points per gateway
+    bool failover = false;              // Gateways send heartbeats, APs skip silent ones
+    double heartbeatMs = 500.0;         // Heartbeat period of every gateway towards every AP
+    uint32_t heartbeatMisses = 3;       // Silent periods before an AP fails over
+    uint16_t heartbeatPort = 9003;      // AP port of the heartbeats
+    uint32_t failGateway = 0;           // Gateway that stops at failAtS (1-based, 0 = none)
+    double failAtS = 15.0;
+
+    // Binary per-packet event log (see event-log.h; empty = off, one file per MPI rank)
+    std::string eventLog = "";
+    std::string eventLogMode = "ring";    // ring (newest records) or file (everything)
+    uint32_t eventLogCapacity = 1 << 20; // Ring size, or chunk size in file mode (records)
 
     CommandLine cmd;
     cmd.AddValue("nZones", "Number of zones", nZones);
+    cmd.AddValue("sensorsPerZone", "Sensors per zone", sensorsPerZone);
+    cmd.AddValue("tiers",
+                 "Aggregation tiers below the gateway, top first (name:fanOut,...); overrides "
+                 "nZones",
+                 tiers);
+    cmd.AddValue("intervalS", "Seconds between readings of each sensor", intervalS);
+    cmd.AddValue("sensorBatchReadings", "Readings per sensor datagram (1 = no batching)", sensorBatchReadings);
+    cmd.AddValue("sensorBatchAgeS", "Max age of a partial sensor batch in seconds (0 = no limit)", sensorBatchAgeS);
     cmd.AddValue("time", "Simulation time", simulationTime);
+    cmd.AddValue("nCompanies", "Number of companies owning sensors", nCompanies);
     cmd.AddValue("verbose", "Enable logging", verbose);
+    cmd.AddValue("payload", "Sensor payload format (binary or text)", payload);
+    cmd.AddValue("emissionModel",
+                 "CO2 emission model (uniform, diurnal, shift, ar1, step)",
+                 emissionModel);
+    cmd.AddValue("traceFile", "Binary CO2 trace to replay (see tools/co2_trace_convert.py)", traceFile);
+    cmd.AddValue("traceOffset", "Simulation time (s) at which the trace starts", traceOffset);
+    cmd.AddValue("apBatchReadings", "Readings per AP backbone datagram (1 = off)", apBatchReadings);
+    cmd.AddValue("apBatchDelayMs", "Max AP batching delay in milliseconds", apBatchDelayMs);
+    cmd.AddValue("apBatchBytes", "Max AP batch datagram payload in bytes", apBatchBytes);
+    cmd.AddValue("batchCodec", "Encoding of batched readings (raw or delta)", batchCodec);
+    cmd.AddValue("codecQuantumPpm", "CO2 quantization step of the delta codec in ppm", codecQuantumPpm);
+    cmd.AddValue("codecEncodeUs", "Modeled batch encoding time per reading in microseconds", codecEncodeUs);
+    cmd.AddValue("codecDecodeUs", "Modeled batch decoding time per reading in microseconds", codecDecodeUs);
+    cmd.AddValue("tickScheduler", "Drive sensors from a shared tick scheduler", tickScheduler);
+    cmd.AddValue("tickResolutionMs", "Tick scheduler phase resolution in milliseconds", tickResolutionMs);
+    cmd.AddValue("backbone", "AP to gateway backbone (csma or p2p)", backbone);
+    cmd.AddValue("backboneRate", "Backbone link data rate", backboneRate);
+    cmd.AddValue("backboneDelayMs", "Backbone link delay in milliseconds (MPI lookahead)", backboneDelayMs);
+    cmd.AddValue("distributed", "Run zones on MPI ranks (requires an MPI build and --backbone=p2p)", distributed);
+    cmd.AddValue("nullMessages", "Use the null-message synchronization algorithm", nullMessages);
+    cmd.AddValue("channelPlan",
+                 "WiFi media: shared (one for all zones), zone (one per zone) or cochannel "
+                 "(one per frequency)",
+                 channelPlan);
+    cmd.AddValue("nFrequencyChannels", "Frequency channels reused across zones (up to the band's plan)", nFrequencyChannels);
+    cmd.AddValue("wifiChannel", "WiFi channel model (yans, spectrum or grid)", wifiChannel);
+    cmd.AddValue("cullThresholdDbm", "Received power below which the grid channel culls frames", cullThresholdDbm);
+    cmd.AddValue("wifiStandard", "WiFi standard (b, g, n, ac or ax)", wifiStandard);
+    cmd.AddValue("wifiBand", "WiFi band in GHz (auto, 2.4, 5 or 6)", wifiBand);
+    cmd.AddValue("channelWidth", "WiFi channel width in MHz (0 = standard default)", channelWidth);
+    cmd.AddValue("rateManager", "WiFi rate control (constant, minstrel or ideal)", rateManager);
+    cmd.AddValue("dataMode", "Constant rate data mode (empty = lowest mode)", dataMode);
+    cmd.AddValue("controlMode", "Constant rate control mode (empty = dataMode)", controlMode);
+    cmd.AddValue("association", "WiFi association (standard or fast: ad hoc, pre-filled ARP)", association);
+    cmd.AddValue("warmupS", "Start time of the first sensor in seconds", warmupS);
+    cmd.AddValue("startSpreadS",
+                 "Spread sensor starts evenly over this many seconds after warmupS instead of the "
+                 "fixed 0.2 s step (0 = fixed step)",
+                 startSpreadS);
+    cmd.AddValue("linkModel", "Sensor-to-AP link model (wifi or abstract)", linkModel);
+    cmd.AddValue("linkRate", "Abstract link data rate", linkRate);
+    cmd.AddValue("linkDelayMs", "Abstract link delay in milliseconds", linkDelayMs);
+    cmd.AddValue("linkLossRate", "Abstract link frame loss probability", linkLossRate);
+    cmd.AddValue("outputPrefix", "Prefix of all output files, so parallel runs do not collide", outputPrefix);
+    cmd.AddValue("tracing", "Tracing profile (none, metrics, debug or full)", tracing);
+    cmd.AddValue("traceStart", "Trace window start in seconds", traceStart);
+    cmd.AddValue("traceStop", "Trace window end in seconds (0 = end of the run)", traceStop);
+    cmd.AddValue("traceZone", "Zone whose AP and sensors get IP-level traces (0 = all)", traceZone);
+    cmd.AddValue("traceSensors", "Sensors with IP-level traces per traced zone", traceSensors);
+    cmd.AddValue("metricsInterval", "Flow metrics snapshot period in seconds", metricsIntervalS);
+    cmd.AddValue("telemetryPort", "UDP port to stream the flow metrics to (0 = off)", telemetryPort);
+    cmd.AddValue("telemetryHost", "IPv4 address of the telemetry listener", telemetryHost);
+    cmd.AddValue("reliable", "Acknowledge and retransmit sensor datagrams at the APs", reliable);
+    cmd.AddValue("ackDelayMs", "Longest wait before pending ACKs are broadcast, in ms", ackDelayMs);
+    cmd.AddValue("rtoMs", "Retransmission timeout in ms (doubled at each retry)", rtoMs);
+    cmd.AddValue("maxRetries", "Retransmissions before a datagram is abandoned", maxRetries);
+    cmd.AddValue("ackPort", "Sensor UDP port of the ACK broadcasts", ackPort);
+    cmd.AddValue("analytics", "Streaming anomaly detection and window rollups at the gateway", analytics);
+    cmd.AddValue("analyticsWindowS", "Tumbling window of the carbon rollups in seconds", analyticsWindowS);
+    cmd.AddValue("ewmaAlpha", "EWMA weight of the newest reading (anomaly baseline)", ewmaAlpha);
+    cmd.AddValue("anomalySigma", "EWMA deviations that flag a reading as anomalous", anomalySigma);
+    cmd.AddValue("anomalyPpm", "CO2 level that always flags a reading (0 = none)", anomalyPpm);
+    cmd.AddValue("creditCapPpm", "Emission cap of the carbon credit balance in ppm", creditCapPpm);
+    cmd.AddValue("analyticsCostUs", "Modeled analytics CPU time per reading in microseconds", analyticsCostUs);
+    cmd.AddValue("ledger", "Commit readings to an append-only ledger behind the gateway", ledger);
+    cmd.AddValue("ledgerBlockEntries", "Readings that seal a ledger block", ledgerBlockEntries);
+    cmd.AddValue("ledgerBlockMs", "Longest wait of a reading for its block to be sealed, in ms", ledgerBlockMs);
+    cmd.AddValue("ledgerBlockCostMs", "Modeled commit time per ledger block in ms", ledgerBlockCostMs);
+    cmd.AddValue("ledgerEntryCostUs", "Modeled commit time per ledger reading in microseconds", ledgerEntryCostUs);
+    cmd.AddValue("gatewayWorkers", "Ingest worker cores at the gateway (0 = instant processing)", gatewayWorkers);
+    cmd.AddValue("gatewayQueue", "Datagrams that can wait for a gateway worker", gatewayQueue);
+    cmd.AddValue("gatewayPolicy", "Full gateway queue policy (droptail, drophead or backpressure)", gatewayPolicy);
+    cmd.AddValue("gatewayService", "Gateway service time distribution (constant, exponential or uniform)", gatewayService);
+    cmd.AddValue("gatewayServiceUs", "Mean gateway service time per reading in microseconds", gatewayServiceUs);
+    cmd.AddValue("gateways", "Main gateways the APs shard their traffic over", gateways);
+    cmd.AddValue("shardBy", "Gateway selection key of the APs (sensor or zone)", shardBy);
+    cmd.AddValue("shardPoints", "Consistent hash ring points per gateway", shardPoints);
+    cmd.AddValue("failover", "Send gateway heartbeats and fail over to live gateways", failover);
+    cmd.AddValue("heartbeatMs", "Gateway heartbeat period in milliseconds", heartbeatMs);
+    cmd.AddValue("heartbeatMisses", "Missed heartbeats before an AP fails over", heartbeatMisses);
+    cmd.AddValue("heartbeatPort", "AP UDP port of the gateway heartbeats", heartbeatPort);
+    cmd.AddValue("failGateway", "Gateway that stops at failAtS (1-based, 0 = none)", failGateway);
+    cmd.AddValue("failAtS", "Time at which failGateway stops, in seconds", failAtS);
+    cmd.AddValue("eventLog", "Binary event log file, under outputPrefix (empty = off)", eventLog);
+    cmd.AddValue("eventLogMode", "Event log mode (ring or file)", eventLogMode);
+    cmd.AddValue("eventLogCapacity", "Event log ring size or file chunk size in records", eventLogCapacity);
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_IF(backbone != "csma" && backbone != "p2p", "Unknown backbone " << backbone);
+    NS_ABORT_MSG_IF(nZones == 0, "At least one zone is required");
+    NS_ABORT_MSG_IF(sensorsPerZone == 0, "At least one sensor per zone is required");
+    // The zones are the nodes of the last tier; a CSMA backbone has one segment per parent
+    TierTopology topology(tiers.empty() ? std::vector<TopologyTier>{{"zone", nZones}}
+                                        : ParseTierSpec(tiers),
+                          sensorsPerZone);
+    nZones = topology.GetLeafCount();
+    NS_ABORT_MSG_IF(intervalS <= 0, "intervalS must be positive");
+    NS_ABORT_MSG_IF(startSpreadS < 0, "startSpreadS must not be negative");
+    NS_ABORT_MSG_IF(traceZone > nZones, "traceZone must be between 0 and nZones");
+    NS_ABORT_MSG_IF(traceStop > 0 && traceStop <= traceStart, "traceStop must be after traceStart");
+    NS_ABORT_MSG_IF(metricsIntervalS <= 0, "metricsInterval must be positive");
+    TracingPlan tracingPlan(ParseTracingProfile(tracing),
+                            Seconds(traceStart),
+                            Seconds(traceStop),
+                            outputPrefix + "hierarchical");
+    NS_ABORT_MSG_IF(telemetryPort != 0 && !tracingPlan.WantsMetrics(),
+                    "telemetryPort streams the flow metrics: use --tracing=metrics or above");
+    // Each rank only sees its own nodes, so no stream would carry the whole run
+    NS_ABORT_MSG_IF(telemetryPort != 0 && distributed,
+                    "telemetryPort is not supported in distributed runs");
+    NS_ABORT_MSG_IF(channelPlan != "shared" && channelPlan != "zone" && channelPlan != "cochannel",
+                    "Unknown channel plan " << channelPlan);
+    WifiConfig wifiConfig(wifiStandard, wifiBand, channelWidth);
+    wifiConfig.SetRateManager(rateManager, dataMode, controlMode);
+    wifiConfig.SetAssociation(association);
+    NS_ABORT_MSG_IF(warmupS < 0, "warmupS must not be negative");
+    NS_ABORT_MSG_IF(nFrequencyChannels < 1 || nFrequencyChannels > wifiConfig.GetChannelCount(),
+                    "nFrequencyChannels must be between 1 and " << wifiConfig.GetChannelCount()
+                                                                << " for " << wifiConfig.GetDescription());
+    NS_ABORT_MSG_IF(linkModel != "wifi" && linkModel != "abstract", "Unknown link model " << linkModel);
+    bool abstractLinks = (linkModel == "abstract");
+
+    // Every rank builds the whole topology but only runs the nodes it owns
+    uint32_t systemId = 0;
+    uint32_t systemCount = 1;
+    if (distributed)
+    {
+#ifdef NS3_MPI
+        // CSMA cannot be split across ranks; p2p links are cut at the AP-gateway boundary
+        NS_ABORT_MSG_IF(backbone != "p2p", "Distributed mode requires --backbone=p2p");
+        NS_ABORT_MSG_IF(backboneDelayMs <= 0, "Distributed mode needs a positive backbone delay (lookahead)");
+        // A wireless medium cannot span ranks: zones keep their own media
+        NS_ABORT_MSG_IF(channelPlan == "cochannel", "Distributed mode does not support --channelPlan=cochannel");
+        channelPlan = "zone";
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue(nullMessages ? "ns3::NullMessageSimulatorImpl"
+                                                   : "ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        systemId = MpiInterface::GetSystemId();
+        systemCount = MpiInterface::GetSize();
+#else
+        NS_ABORT_MSG("Distributed mode requires ns-3 configured with --enable-mpi");
+#endif
+    }
+
+    PayloadFormat payloadFormat = ParsePayloadFormat(payload);
+    WifiMediumType mediumType = ParseWifiMediumType(wifiChannel);
+    NS_ABORT_MSG_IF(sensorBatchReadings > 1 && payloadFormat != PayloadFormat::BINARY,
+                    "Sensor batching needs the binary payload");
+    NS_ABORT_MSG_IF(codecQuantumPpm < 0.01, "codecQuantumPpm must be at least 0.01");
+    NS_ABORT_MSG_IF(codecEncodeUs < 0 || codecDecodeUs < 0, "Codec costs must not be negative");
+    NS_ABORT_MSG_IF(analyticsCostUs < 0, "analyticsCostUs must not be negative");
+    AnalyticsConfig analyticsConfig;
+    analyticsConfig.window = Seconds(analyticsWindowS);
+    analyticsConfig.ewmaAlpha = ewmaAlpha;
+    analyticsConfig.anomalySigma = anomalySigma;
+    analyticsConfig.anomalyPpm = anomalyPpm;
+    analyticsConfig.creditCapPpm = creditCapPpm;
+    analyticsConfig.costPerReading = Seconds(analyticsCostUs * 1e-6);
+    LedgerConfig ledgerConfig;
+    ledgerConfig.blockEntries = ledgerBlockEntries;
+    ledgerConfig.blockInterval = Seconds(ledgerBlockMs * 1e-3);
+    ledgerConfig.blockCost = Seconds(ledgerBlockCostMs * 1e-3);
+    ledgerConfig.entryCost = Seconds(ledgerEntryCostUs * 1e-6);
+    IngestConfig ingestConfig;
+    ingestConfig.workers = gatewayWorkers;
+    ingestConfig.capacity = gatewayQueue;
+    ingestConfig.policy = ParseIngestPolicy(gatewayPolicy);
+    ingestConfig.distribution = ParseServiceDistribution(gatewayService);
+    ingestConfig.meanService = Seconds(gatewayServiceUs * 1e-6);
+    if (analytics)
+    {
+        ingestConfig.extraService = analyticsConfig.costPerReading;
+    }
+    NS_ABORT_MSG_IF(failover && gateways < 2, "Failover needs at least two gateways");
+    NS_ABORT_MSG_IF(heartbeatMs <= 0, "heartbeatMs must be positive");
+    NS_ABORT_MSG_IF(heartbeatMisses < 2,
+                    "heartbeatMisses must be at least 2: the heartbeats are spread over a period");
+    NS_ABORT_MSG_IF(failGateway > gateways, "failGateway must be one of the gateways (or 0)");
+    NS_ABORT_MSG_IF(failGateway > 0 && (failAtS <= 0 || failAtS >= simulationTime),
+                    "failAtS must fall within the run");
+    ShardConfig shardConfig;
+    shardConfig.key = ParseShardKey(shardBy);
+    shardConfig.points = shardPoints;
+    shardConfig.failover = failover;
+    shardConfig.heartbeatInterval = Seconds(heartbeatMs * 1e-3);
+    shardConfig.heartbeatMisses = heartbeatMisses;
+    BatchCodecConfig codecConfig;
+    codecConfig.codec = ParseBatchCodec(batchCodec);
+    codecConfig.quantum = static_cast<uint32_t>(std::lround(codecQuantumPpm * 100.0));
+    codecConfig.encodeCost = Seconds(codecEncodeUs * 1e-6);
+    codecConfig.decodeCost = Seconds(codecDecodeUs * 1e-6);
+    NS_ABORT_MSG_IF(ackDelayMs < 0 || rtoMs <= ackDelayMs,
+                    "rtoMs must be longer than ackDelayMs, or every datagram is sent twice");
+    ReliabilityConfig reliabilityConfig;
+    reliabilityConfig.ackDelay = Seconds(ackDelayMs * 1e-3);
+    reliabilityConfig.retransmitTimeout = Seconds(rtoMs * 1e-3);
+    reliabilityConfig.maxRetries = maxRetries;
+    uint32_t sequenceSize = reliable ? CO2SequenceHeader::SERIALIZED_SIZE : 0;
+    NS_ABORT_MSG_IF(sequenceSize + CO2BatchHeader::SERIALIZED_SIZE +
+                            CO2BatchEncoder::GetMaxBodySize(codecConfig.codec, sensorBatchReadings) >
+                        1472,
+                    "sensorBatchReadings does not fit in one UDP datagram");
+
     if (verbose)
     {
         LogComponentEnable("HierarchicalCarbonTrading", LOG_LEVEL_INFO);
+        LogComponentEnable("CO2SensorApplication", LOG_LEVEL_INFO);
     }
 
     uint32_t totalSensors = nZones * sensorsPerZone;
@@ -408,269 +1224,1118 @@ main(int argc, char* argv[])
     NS_LOG_INFO("=================================================");
     NS_LOG_INFO("Hierarchical WiFi Carbon Trading Network");
     NS_LOG_INFO("=================================================");
+    NS_LOG_INFO("Tiers: " << (tiers.empty() ? "zone:" + std::to_string(nZones) : tiers));
     NS_LOG_INFO("Zones: " << nZones);
     NS_LOG_INFO("Sensors per zone: " << sensorsPerZone);
     NS_LOG_INFO("Total sensors: " << totalSensors);
     NS_LOG_INFO("Total APs: " << nZones);
     NS_LOG_INFO("Simulation time: " << simulationTime << "s");
+    NS_LOG_INFO("Payload format: " << payload);
+    NS_LOG_INFO("Emission model: " << (traceFile.empty() ? emissionModel : "trace " + traceFile));
+    NS_LOG_INFO("AP aggregation: " << apBatchReadings << " readings / " << apBatchDelayMs
+                                   << " ms / " << apBatchBytes << " bytes");
+    NS_LOG_INFO("Batch codec: " << batchCodec);
+    NS_LOG_INFO("Link model: " << linkModel);
+    NS_LOG_INFO("Tracing: " << tracing);
+    NS_LOG_INFO("WiFi channel: " << wifiChannel);
+    NS_LOG_INFO("WiFi standard: " << wifiConfig.GetDescription());
+    NS_LOG_INFO("WiFi channel plan: " << channelPlan << " (" << nFrequencyChannels << " frequencies)");
+    NS_LOG_INFO("Backbone: " << backbone << " (" << backboneRate << ", " << backboneDelayMs << " ms)");
+    if (analytics)
+    {
+        NS_LOG_INFO("Analytics: " << analyticsWindowS << " s windows, cap " << creditCapPpm
+                                  << " ppm, anomalies beyond " << anomalySigma << " sigma");
+    }
+    if (ledger)
+    {
+        NS_LOG_INFO("Ledger: blocks of " << ledgerBlockEntries << " readings or " << ledgerBlockMs
+                                         << " ms, commit " << ledgerBlockCostMs << " ms + "
+                                         << ledgerEntryCostUs << " us/reading");
+    }
+    if (gatewayWorkers > 0)
+    {
+        NS_LOG_INFO("Gateway ingest: " << gatewayWorkers << " workers, " << gatewayQueue
+                                       << " datagrams " << gatewayPolicy << ", " << gatewayService
+                                       << " " << gatewayServiceUs << " us/reading");
+    }
+    if (gateways > 1)
+    {
+        NS_LOG_INFO("Gateways: " << gateways << ", sharded by " << shardBy << " on " << shardPoints
+                                 << " ring points each"
+                                 << (failover ? ", heartbeat failover" : ""));
+    }
+    if (failGateway > 0)
+    {
+        NS_LOG_INFO("Gateway " << failGateway << " stops at " << failAtS << " s");
+    }
+    if (reliable)
+    {
+        NS_LOG_INFO("Reliable delivery: ACKs within " << ackDelayMs << " ms, timeout " << rtoMs
+                                                     << " ms, " << maxRetries << " retries");
+    }
+    if (distributed)
+    {
+        NS_LOG_INFO("Distributed: rank " << systemId << " of " << systemCount);
+    }
     NS_LOG_INFO("=================================================");
 
-    // Create nodes
-    NodeContainer sensorNodes;
-    sensorNodes.Create(totalSensors);
-
-    NodeContainer apNodes;
-    apNodes.Create(nZones);
-
-    NodeContainer mainGateway;
-    mainGateway.Create(1);
-
-    // WiFi setup for each zone (sensors ↔ local AP)
-    InternetStackHelper internet;
-    internet.Install(sensorNodes);
-    internet.Install(apNodes);
-    internet.Install(mainGateway);
-
-    YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
-    YansWifiPhyHelper phy;
-    phy.SetChannel(channel.Create());
+    // Wall-clock cost of each phase of this run (see run-profiler.h); per rank when distributed
+    RunProfiler profiler;
+
+    // Create nodes; zones are spread over the ranks in blocks, the gateways run on rank 0
+    topology.Create(systemCount, gateways);
+    topology.InstallInternet();
+    const NodeContainer& sensorNodes = topology.GetSensors();
+    const NodeContainer& apNodes = topology.GetLeaves();
+    Ptr<Node> mainGateway = topology.GetRoot();
+
+    // Media: "shared" puts every zone on one channel object (each frame reaches
+    // every PHY), "zone" isolates each zone, "cochannel" shares a medium between
+    // the zones on the same frequency
+    WifiMediumHelper media(mediumType);
+    media.SetDetectionThreshold(cullThresholdDbm);
+    WifiPhyHelper& phy = media.GetPhy();
+    Ptr<Channel> sharedMedium;
+    std::vector<Ptr<Channel>> frequencyMedia(nFrequencyChannels);
 
     WifiHelper wifi;
-    wifi.SetStandard(WIFI_STANDARD_80211b);
-    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                 "DataMode",
-                                 StringValue("DsssRate1Mbps"),
-                                 "ControlMode",
-                                 StringValue("DsssRate1Mbps"));
+    wifiConfig.Configure(wifi);
+
+    // Abstract mode: fixed-delay/loss stars instead of WiFi (channel plan ignored)
+    StarLinkHelper star;
+    star.SetDataRate(DataRate(linkRate));
+    star.SetDelay(Seconds(linkDelayMs * 1e-3));
+    star.SetLossRate(linkLossRate);
+    star.AssignStreams(0);
+
+    // Medium usage of the local zones (every WiFi frame, and what the APs hear of it)
+    Ptr<WifiAirtimeMonitor> airtime;
+    if (!abstractLinks)
+    {
+        airtime = Create<WifiAirtimeMonitor>();
+    }
 
-    Ipv4AddressHelper address;
-    MobilityHelper mobility;
+    // Subnet broadcast of each local zone, where its AP sends the ACKs of --reliable
+    std::vector<Ipv4Address> zoneBroadcasts(nZones);
 
-    // Setup each zone: 2 sensors + 1 AP
+    // Setup each zone: its sensors + 1 AP (zone subnets come from the topology)
     for (uint32_t zone = 0; zone < nZones; ++zone)
     {
-        // Get sensor nodes for this zone
-        NodeContainer zoneSensors;
-        for (uint32_t s = 0; s < sensorsPerZone; ++s)
+        if (apNodes.Get(zone)->GetSystemId() != systemId)
         {
-            zoneSensors.Add(sensorNodes.Get(zone * sensorsPerZone + s));
+            continue;
         }
 
+        NodeContainer zoneSensors = topology.GetLeafSensors(zone);
         NodeContainer zoneAP;
         zoneAP.Add(apNodes.Get(zone));
 
-        // WiFi for this zone
-        WifiMacHelper mac;
-        std::ostringstream ssidStr;
-        ssidStr << "Zone" << (zone + 1) << "-Net";
-        Ssid ssid = Ssid(ssidStr.str());
-
-        // Sensors as stations
-        mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid));
-        NetDeviceContainer zoneSensorDevices = wifi.Install(phy, mac, zoneSensors);
-
-        // AP
-        mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
-        NetDeviceContainer zoneAPDevice = wifi.Install(phy, mac, zoneAP);
-
-        // IP addressing for zone (10.1.X.0/24)
-        std::ostringstream baseAddr;
-        baseAddr << "10.1." << (zone + 1) << ".0";
-        address.SetBase(baseAddr.str().c_str(), "255.255.255.0");
-
-        Ipv4InterfaceContainer zoneSensorInterfaces = address.Assign(zoneSensorDevices);
-        Ipv4InterfaceContainer zoneAPInterface = address.Assign(zoneAPDevice);
-
-        // Position nodes for this zone
-        mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-                                      "MinX",
-                                      DoubleValue(zone * 60.0),
-                                      "MinY",
-                                      DoubleValue(0.0),
-                                      "DeltaX",
-                                      DoubleValue(20.0),
-                                      "DeltaY",
-                                      DoubleValue(0.0),
-                                      "GridWidth",
-                                      UintegerValue(sensorsPerZone),
-                                      "LayoutType",
-                                      StringValue("RowFirst"));
-        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-        mobility.Install(zoneSensors);
-
-        // Position AP above sensors
-        Ptr<ListPositionAllocator> apPos = CreateObject<ListPositionAllocator>();
-        apPos->Add(Vector(zone * 60.0 + 10.0, 15.0, 0.0));
-        mobility.SetPositionAllocator(apPos);
-        mobility.Install(zoneAP);
-
-        NS_LOG_INFO("Zone " << (zone + 1) << " configured: " << ssidStr.str() << " at "
-                            << baseAddr.str());
-    }
-
-    // Main backbone network (APs ↔ Main Gateway) using CSMA (Ethernet)
-    CsmaHelper csma;
-    csma.SetChannelAttribute("DataRate", StringValue("100Mbps"));
-    csma.SetChannelAttribute("Delay", TimeValue(MilliSeconds(2)));
-
-    NodeContainer backboneNodes;
-    backboneNodes.Add(apNodes);
-    backboneNodes.Add(mainGateway);
-
-    NetDeviceContainer backboneDevices = csma.Install(backboneNodes);
-
-    address.SetBase("10.2.1.0", "255.255.255.0");
-    Ipv4InterfaceContainer backboneInterfaces = address.Assign(backboneDevices);
-
-    Ipv4InterfaceContainer mainAPInterfaces;
-    for (uint32_t i = 0; i < nZones; ++i)
-    {
-        mainAPInterfaces.Add(backboneInterfaces.Get(i));
-    }
-    Ipv4InterfaceContainer mainGatewayInterface;
-    mainGatewayInterface.Add(backboneInterfaces.Get(nZones));
-
-    // Position main gateway at center-top
-    Ptr<ListPositionAllocator> gwPos = CreateObject<ListPositionAllocator>();
-    gwPos->Add(Vector(120.0, 30.0, 0.0));
-    mobility.SetPositionAllocator(gwPos);
-    mobility.Install(mainGateway);
-
-    // Use static routing to avoid network confusion with multiple WiFi networks
-    Ipv4StaticRoutingHelper staticRouting;
-
-    // Set default routes for sensors to their local AP
-    for (uint32_t zone = 0; zone < nZones; ++zone)
+        NetDeviceContainer zoneSensorDevices;
+        NetDeviceContainer zoneAPDevice;
+        std::ostringstream zoneLink;
+        if (abstractLinks)
+        {
+            // One star per zone with the AP as hub; there is no medium to share
+            NetDeviceContainer starDevices = star.Install(zoneSensors, apNodes.Get(zone));
+            for (uint32_t s = 0; s < sensorsPerZone; ++s)
+            {
+                zoneSensorDevices.Add(starDevices.Get(s));
+            }
+            zoneAPDevice.Add(starDevices.Get(sensorsPerZone));
+            zoneLink << "abstract star";
+        }
+        else
+        {
+            // Frequencies are assigned round-robin, so neighbouring zones differ when K > 1
+            uint32_t frequency = zone % nFrequencyChannels;
+            Ptr<Channel> medium;
+            if (channelPlan == "shared")
+            {
+                // Legacy layout: one medium and one frequency for the whole site
+                frequency = 0;
+                if (!sharedMedium)
+                {
+                    sharedMedium = media.CreateMedium();
+                }
+                medium = sharedMedium;
+            }
+            else if (channelPlan == "cochannel")
+            {
+                if (!frequencyMedia[frequency])
+                {
+                    frequencyMedia[frequency] = media.CreateMedium();
+                }
+                medium = frequencyMedia[frequency];
+            }
+            else
+            {
+                medium = media.CreateMedium();
+            }
+            // Distinct frequencies are placed on separate media, so adjacent-channel
+            // leakage is not modelled
+            media.SetMedium(medium);
+            phy.Set("ChannelSettings", StringValue(wifiConfig.GetChannelSettings(frequency)));
+
+            // WiFi for this zone
+            WifiMacHelper mac;
+            std::string ssidName = "Zone" + std::to_string(zone + 1) + "-Net";
+            Ssid ssid = Ssid(ssidName);
+
+            // Sensors as stations
+            wifiConfig.SetStationMac(mac, ssid);
+            zoneSensorDevices = wifi.Install(phy, mac, zoneSensors);
+
+            // AP
+            wifiConfig.SetApMac(mac, ssid);
+            zoneAPDevice = wifi.Install(phy, mac, zoneAP);
+            airtime->AddTransmitters(zoneSensorDevices);
+            airtime->AddTransmitters(zoneAPDevice);
+            airtime->AddReceivers(zoneAPDevice);
+            if (reliable)
+            {
+                airtime->AddAckSenders(zoneAPDevice, ackPort);
+            }
+            zoneLink << ssidName << ", channel "
+                     << static_cast<uint32_t>(wifiConfig.GetChannelNumber(frequency));
+        }
+
+        // IP addressing for zone
+        Ipv4InterfaceContainer zoneAPInterface =
+            topology.AssignLeaf(zone, zoneSensorDevices, zoneAPDevice);
+        if (abstractLinks || wifiConfig.IsFastAssociation())
+        {
+            // No ARP exchange before the first readings (sensor <-> AP entries only)
+            PopulateStarArpCaches(zoneAPDevice.Get(0), zoneSensorDevices);
+        }
+        Ptr<Ipv4> apIpv4 = apNodes.Get(zone)->GetObject<Ipv4>();
+        int32_t zoneInterface = apIpv4->GetInterfaceForDevice(zoneAPDevice.Get(0));
+        zoneBroadcasts[zone] = apIpv4->GetAddress(zoneInterface, 0).GetBroadcast();
+
+        NS_LOG_INFO("Zone " << (zone + 1) << " configured: " << zoneLink.str() << ", AP at "
+                            << zoneAPInterface.GetAddress(0));
+    }
+
+    // Backbone (every tier node ↔ its parent): a CSMA segment per parent, or a
+    // point-to-point link per node. Only the latter can be cut between MPI ranks.
+    topology.InstallBackbone(backbone, backboneRate, Seconds(backboneDelayMs * 1e-3));
+    if (tracingPlan.WantsFullTraces() && mainGateway->GetSystemId() == systemId)
     {
-        Ptr<Node> ap = apNodes.Get(zone);
-        Ipv4Address apAddr = ap->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+        // Capture one representative link at the gateway rather than one file per node
+        if (backbone == "csma")
+        {
+            CsmaHelper().EnablePcap(outputPrefix + "hierarchical", topology.GetRootDevice(), true);
+        }
+        else
+        {
+            PointToPointHelper().EnablePcap(outputPrefix + "hierarchical",
+                                            topology.GetRootDevice(),
+                                            true);
+        }
+    }
+    topology.InstallMobility();
+    profiler.EndPhase("topology"); // Includes the per-zone address assignment
+
+    // Static routing only (see tier-topology.h): defaults up the tree, block routes down
+    topology.InstallRoutes(systemId);
+
+    profiler.EndPhase("routing");
 
-        for (uint32_t s = 0; s < sensorsPerZone; ++s)
+    // Deploy applications (each rank only on the nodes it simulates)
+
+    // Per-packet records replace the per-packet log lines (decode with tools/decode_event_log.py)
+    Ptr<EventLog> events;
+    if (!eventLog.empty())
+    {
+        std::ostringstream eventPath;
+        eventPath << outputPrefix << eventLog;
+        if (distributed)
         {
-            Ptr<Node> sensor = sensorNodes.Get(zone * sensorsPerZone + s);
-            Ptr<Ipv4StaticRouting> sensorRouting =
-                staticRouting.GetStaticRouting(sensor->GetObject<Ipv4>());
-            sensorRouting->SetDefaultRoute(apAddr, 1);
+            eventPath << ".rank" << systemId;
         }
+        events = Create<EventLog>(eventPath.str(), ParseEventLogMode(eventLogMode), eventLogCapacity);
     }
 
-    // Set default routes for APs to main gateway
-    Ipv4Address gwAddr = mainGatewayInterface.GetAddress(0);
-    for (uint32_t zone = 0; zone < nZones; ++zone)
+    // Encoders and decoders of every rank-local application add up their work here
+    Ptr<BatchCodecStats> codecStats = Create<BatchCodecStats>();
+    // Readings and datagrams sent by the rank-local sensors
+    Ptr<SensorSendStats> sendStats = Create<SensorSendStats>();
+    // Retransmissions and ACKs of the rank-local sensors and APs (null unless --reliable)
+    Ptr<ReliabilityStats> reliabilityStats;
+    if (reliable)
+    {
+        reliabilityStats = Create<ReliabilityStats>();
+    }
+    // Heartbeats and failovers of the rank-local gateways and APs, and the ring every AP
+    // hashes onto (null unless there are several gateways)
+    Ptr<ShardStats> shardStats;
+    Ptr<GatewayRing> gatewayRing;
+    if (gateways > 1)
     {
-        Ptr<Node> ap = apNodes.Get(zone);
-        Ptr<Ipv4StaticRouting> apRouting = staticRouting.GetStaticRouting(ap->GetObject<Ipv4>());
-        apRouting->SetDefaultRoute(gwAddr, 2); // Interface 2 is the CSMA backbone
+        shardStats = Create<ShardStats>();
+        gatewayRing = Create<GatewayRing>(gateways, shardPoints);
     }
 
-    // Deploy applications
-    Ipv4Address gatewayAddr = mainGatewayInterface.GetAddress(0);
+    // Windowed per-flow statistics of this rank's nodes (see flow-metrics-collector.h)
+    std::string rankSuffix = distributed ? "-rank" + std::to_string(systemId) : "";
+    Ptr<FlowMetricsCollector> metrics;
+    if (tracingPlan.WantsMetrics())
+    {
+        metrics = Create<FlowMetricsCollector>(outputPrefix + "hierarchical-metrics" + rankSuffix +
+                                                   ".csv",
+                                               Seconds(metricsIntervalS),
+                                               totalSensors,
+                                               nZones);
+    }
+    Ptr<TelemetryStream> telemetry;
+    if (telemetryPort != 0)
+    {
+        telemetry = Create<TelemetryStream>(telemetryHost, telemetryPort);
+        metrics->SetStream(telemetry);
+        NS_LOG_INFO("Streaming flow metrics to " << telemetryHost << ":" << telemetryPort);
+    }
+
+    // Main gateways, with the inline analytics (see carbon-analytics.h) when enabled; several
+    // gateways share the analytics and ledger stages, but each has its own ingest queue
+    std::vector<Ptr<MainGatewayApplication>> gwApps;
+    Ptr<CarbonAnalytics> carbonAnalytics;
+    Ptr<CarbonLedger> carbonLedger;
+    std::vector<Ptr<IngestQueue>> ingestQueues;
+    if (mainGateway->GetSystemId() == systemId)
+    {
+        if (ledger)
+        {
+            // Sized for every reading the sensors can send
+            carbonLedger = Create<CarbonLedger>(ledgerConfig);
+            carbonLedger->Reserve(totalSensors *
+                                  static_cast<uint64_t>((simulationTime - warmupS) / intervalS + 1));
+        }
+        if (analytics)
+        {
+            carbonAnalytics = Create<CarbonAnalytics>(outputPrefix + "hierarchical-windows.csv",
+                                                      analyticsConfig);
+            carbonAnalytics->Reserve(totalSensors, nZones, nCompanies);
+            carbonAnalytics->Start(Seconds(0.0));
+        }
+        std::vector<Address> apHeartbeats;
+        if (failover)
+        {
+            for (uint32_t zone = 0; zone < nZones; ++zone)
+            {
+                apHeartbeats.push_back(InetSocketAddress(topology.GetLeafAddress(zone), heartbeatPort));
+            }
+        }
+        for (uint32_t g = 0; g < gateways; ++g)
+        {
+            Ptr<Node> gatewayNode = topology.GetGateway(g);
+            Ptr<Socket> gwSocket = Socket::CreateSocket(gatewayNode, UdpSocketFactory::GetTypeId());
+            Ptr<MainGatewayApplication> gwApp = CreateObject<MainGatewayApplication>();
+            gwApp->Setup(gwSocket, gatewayPort);
+            gwApp->GetStats().Reserve(totalSensors, nZones, nCompanies);
+            gwApp->SetBatchCodec(codecConfig, codecStats);
+            gwApp->SetMetrics(metrics);
+            gwApp->SetAnalytics(carbonAnalytics);
+            gwApp->SetLedger(carbonLedger);
+            if (gatewayWorkers > 0)
+            {
+                Ptr<IngestQueue> ingestQueue = Create<IngestQueue>(ingestConfig);
+                gwApp->SetIngestQueue(ingestQueue);
+                ingestQueues.push_back(ingestQueue);
+            }
+            if (failover)
+            {
+                gwApp->SetHeartbeat(Socket::CreateSocket(gatewayNode, UdpSocketFactory::GetTypeId()),
+                                    apHeartbeats,
+                                    Seconds(heartbeatMs * 1e-3),
+                                    shardStats);
+            }
+            gwApp->SetEventLog(events);
+            gatewayNode->AddApplication(gwApp);
+            gwApp->SetStartTime(Seconds(0.0));
+            // A failed gateway stops receiving and sending heartbeats
+            gwApp->SetStopTime(Seconds(g + 1 == failGateway ? failAtS : simulationTime));
+            gwApps.push_back(gwApp);
+        }
+    }
 
-    // Main Gateway
-    Ptr<Socket> gwSocket = Socket::CreateSocket(mainGateway.Get(0), UdpSocketFactory::GetTypeId());
-    Ptr<MainGatewayApplication> gwApp = CreateObject<MainGatewayApplication>();
-    gwApp->Setup(gwSocket, gatewayPort);
-    mainGateway.Get(0)->AddApplication(gwApp);
-    gwApp->SetStartTime(Seconds(0.0));
-    gwApp->SetStopTime(Seconds(simulationTime));
+    // With several gateways every AP reaches each of them at the same address
+    std::vector<Ipv4Address> gatewayAddresses;
+    for (uint32_t g = 0; g < gateways; ++g)
+    {
+        gatewayAddresses.push_back(topology.GetGatewayAddress(g, 0));
+    }
 
     // Local APs
+    std::vector<Ptr<LocalAPApplication>> apApps; // On this rank
     for (uint32_t zone = 0; zone < nZones; ++zone)
     {
+        if (apNodes.Get(zone)->GetSystemId() != systemId)
+        {
+            continue;
+        }
+
         Ptr<Socket> apRecvSocket =
             Socket::CreateSocket(apNodes.Get(zone), UdpSocketFactory::GetTypeId());
         Ptr<Socket> apFwdSocket =
             Socket::CreateSocket(apNodes.Get(zone), UdpSocketFactory::GetTypeId());
 
         Ptr<LocalAPApplication> apApp = CreateObject<LocalAPApplication>();
-        Address gwAddress = InetSocketAddress(gatewayAddr, gatewayPort);
+        Address gwAddress = InetSocketAddress(topology.GetGatewayAddress(0, zone), gatewayPort);
         apApp->Setup(apRecvSocket, apFwdSocket, sensorPort, gwAddress, zone + 1);
+        apApp->SetAggregation(apBatchReadings, Seconds(apBatchDelayMs * 1e-3), apBatchBytes);
+        apApp->SetBatchCodec(codecConfig, codecStats);
+        apApp->SetEventLog(events);
+        if (reliable)
+        {
+            // One ACK broadcast covers every sensor of the zone heard from since the last one
+            Ptr<Socket> ackSocket =
+                Socket::CreateSocket(apNodes.Get(zone), UdpSocketFactory::GetTypeId());
+            apApp->SetReliability(ackSocket,
+                                  InetSocketAddress(zoneBroadcasts[zone], ackPort),
+                                  zone * sensorsPerZone + 1,
+                                  sensorsPerZone,
+                                  reliabilityConfig,
+                                  reliabilityStats);
+        }
+        if (gatewayRing)
+        {
+            Ptr<Socket> heartbeatSocket;
+            if (failover)
+            {
+                heartbeatSocket = Socket::CreateSocket(apNodes.Get(zone), UdpSocketFactory::GetTypeId());
+            }
+            apApp->SetSharding(gatewayAddresses,
+                               gatewayRing,
+                               shardConfig,
+                               heartbeatSocket,
+                               heartbeatPort,
+                               shardStats);
+        }
 
         apNodes.Get(zone)->AddApplication(apApp);
+        apApps.push_back(apApp);
         apApp->SetStartTime(Seconds(0.0));
         apApp->SetStopTime(Seconds(simulationTime));
     }
 
     // Sensors
+    Ptr<SensorTickScheduler> sensorTicks;
+    if (tickScheduler)
+    {
+        sensorTicks = CreateObject<SensorTickScheduler>();
+        sensorTicks->SetAttribute("Resolution", TimeValue(Seconds(tickResolutionMs * 1e-3)));
+    }
+    // Deterministic RNG streams for the emission models, after the abstract links' loss streams
+    int64_t emissionStream = star.GetNextStream();
+    Ptr<CO2TraceFile> trace;
+    if (!traceFile.empty())
+    {
+        trace = Create<CO2TraceFile>(traceFile);
+        NS_LOG_INFO("Replaying " << trace->GetRecordCount() << " readings of "
+                                 << trace->GetSensorCount() << " recorded sensors");
+    }
+    uint32_t localSensors = 0;
     for (uint32_t i = 0; i < totalSensors; ++i)
     {
         uint32_t zone = i / sensorsPerZone;
-        Ptr<Node> apNode = apNodes.Get(zone);
-        Ipv4Address apAddr = apNode->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+        if (apNodes.Get(zone)->GetSystemId() != systemId)
+        {
+            // Keep the stream numbering identical to a single-process run
+            emissionStream += CreateEmissionModel(emissionModel)->AssignStreams(emissionStream);
+            continue;
+        }
+        localSensors++;
 
         Ptr<Socket> sensorSocket =
             Socket::CreateSocket(sensorNodes.Get(i), UdpSocketFactory::GetTypeId());
         Ptr<CO2SensorApplication> sensorApp = CreateObject<CO2SensorApplication>();
 
         double baselineCO2 = 400.0 + (i * 50.0);
-        Address apAddress = InetSocketAddress(apAddr, sensorPort);
+        Address apAddress = InetSocketAddress(topology.GetLeafAddress(zone), sensorPort);
+
+        sensorApp->Setup(sensorSocket,
+                         apAddress,
+                         i + 1,
+                         (i % nCompanies) + 1,
+                         zone + 1,
+                         baselineCO2);
+        sensorApp->SetPayloadFormat(payloadFormat);
+        sensorApp->SetSendStats(sendStats);
+        sensorApp->SetInterval(Seconds(intervalS));
+        sensorApp->SetMetrics(metrics);
+        sensorApp->SetEventLog(events);
+        sensorApp->SetBatching(sensorBatchReadings, Seconds(sensorBatchAgeS));
+        sensorApp->SetBatchCodec(codecConfig, codecStats);
+        if (reliable)
+        {
+            Ptr<Socket> ackSocket =
+                Socket::CreateSocket(sensorNodes.Get(i), UdpSocketFactory::GetTypeId());
+            sensorApp->SetReliability(ackSocket, ackPort, reliabilityConfig, reliabilityStats);
+        }
+        if (sensorTicks)
+        {
+            sensorApp->SetTickScheduler(sensorTicks);
+        }
 
-        sensorApp->Setup(sensorSocket, apAddress, sensorPort, i + 1, zone + 1, baselineCO2);
+        Ptr<EmissionModel> model = CreateEmissionModel(emissionModel);
+        emissionStream += model->AssignStreams(emissionStream);
+        sensorApp->SetEmissionModel(model);
+        if (trace)
+        {
+            // Recorded sensors are assigned round-robin so any fleet size can replay any trace
+            sensorApp->SetTrace(trace, trace->GetSliceAt(i), Seconds(traceOffset));
+        }
         sensorNodes.Get(i)->AddApplication(sensorApp);
-        sensorApp->SetStartTime(Seconds(1.0 + i * 0.2));
+        // Fixed stagger by default, an even spread with --startSpreadS
+        sensorApp->SetStartTime(Seconds(startSpreadS > 0
+                                            ? warmupS + startSpreadS * i / totalSensors
+                                            : warmupS + i * 0.2));
         sensorApp->SetStopTime(Seconds(simulationTime));
     }
+    for (Ptr<IngestQueue> ingestQueue : ingestQueues)
+    {
+        // Every rank numbers all sensors, so the gateways' streams do not depend on the split
+        emissionStream += ingestQueue->AssignStreams(emissionStream);
+    }
 
-    // NetAnim visualization
-    AnimationInterface anim("hierarchical-carbon-trading.xml");
-
-    // Main Gateway (Blue)
-    anim.UpdateNodeDescription(mainGateway.Get(0), "Main_Gateway");
-    anim.UpdateNodeColor(mainGateway.Get(0), 0, 0, 255);
-    anim.UpdateNodeSize(mainGateway.Get(0)->GetId(), 6.0, 6.0);
-
-    // Local APs (Green)
-    for (uint32_t z = 0; z < nZones; ++z)
+    // IP-level traces of the sampled zones' local nodes, inside the trace window (debug and full)
+    if (mainGateway->GetSystemId() == systemId)
     {
-        std::ostringstream desc;
-        desc << "AP_Zone" << (z + 1);
-        anim.UpdateNodeDescription(apNodes.Get(z), desc.str());
-        anim.UpdateNodeColor(apNodes.Get(z), 0, 200, 0);
-        anim.UpdateNodeSize(apNodes.Get(z)->GetId(), 4.0, 4.0);
+        tracingPlan.TraceNode(mainGateway);
+        for (uint32_t g = 0; gateways > 1 && g < gateways; ++g)
+        {
+            tracingPlan.TraceNode(topology.GetGateway(g));
+        }
+    }
+    for (uint32_t zone = 0; zone < nZones; ++zone)
+    {
+        if ((traceZone != 0 && zone + 1 != traceZone) || apNodes.Get(zone)->GetSystemId() != systemId)
+        {
+            continue;
+        }
+        tracingPlan.TraceNode(apNodes.Get(zone));
+        for (uint32_t s = 0; s < std::min(traceSensors, sensorsPerZone); ++s)
+        {
+            tracingPlan.TraceNode(sensorNodes.Get(zone * sensorsPerZone + s));
+        }
     }
 
-    // Sensors (Red, different shades per zone)
-    for (uint32_t i = 0; i < totalSensors; ++i)
+    // NetAnim and FlowMonitor need every node in one process, so distributed runs skip them;
+    // the animation is part of the full profile only, and abstract-link scale runs skip it
+    std::unique_ptr<AnimationInterface> anim;
+    FlowMonitorHelper flowmon;
+    Ptr<FlowMonitor> monitor;
+    if (tracingPlan.WantsFlowMonitor() && !distributed)
     {
-        uint32_t zone = i / sensorsPerZone;
-        std::ostringstream desc;
-        desc << "Sensor" << (i + 1) << "_Z" << (zone + 1);
-        anim.UpdateNodeDescription(sensorNodes.Get(i), desc.str());
-        anim.UpdateNodeColor(sensorNodes.Get(i), 255, zone * 40, 0);
-        anim.UpdateNodeSize(sensorNodes.Get(i)->GetId(), 2.5, 2.5);
+        monitor = flowmon.InstallAll();
     }
+    if (tracingPlan.WantsFullTraces() && !distributed && !abstractLinks)
+    {
+        // NetAnim visualization
+        anim = std::make_unique<AnimationInterface>(outputPrefix + "hierarchical-carbon-trading.xml");
+        tracingPlan.LimitAnimation(*anim, Seconds(simulationTime));
+
+        // Main Gateway (Blue); with several gateways the root is a router
+        anim->UpdateNodeDescription(mainGateway, gateways > 1 ? "Backbone_Root" : "Main_Gateway");
+        anim->UpdateNodeColor(mainGateway, 0, 0, 255);
+        anim->UpdateNodeSize(mainGateway->GetId(), 6.0, 6.0);
+        for (uint32_t g = 0; gateways > 1 && g < gateways; ++g)
+        {
+            Ptr<Node> gatewayNode = topology.GetGateway(g);
+            anim->UpdateNodeDescription(gatewayNode, "Main_Gateway" + std::to_string(g + 1));
+            anim->UpdateNodeColor(gatewayNode, 0, 0, 255);
+            anim->UpdateNodeSize(gatewayNode->GetId(), 6.0, 6.0);
+        }
+
+        // Routing tiers (Teal)
+        for (uint32_t t = 0; t + 1 < topology.GetTierCount(); ++t)
+        {
+            const NodeContainer& tierNodes = topology.GetTierNodes(t);
+            for (uint32_t j = 0; j < tierNodes.GetN(); ++j)
+            {
+                anim->UpdateNodeDescription(tierNodes.Get(j),
+                                            topology.GetTier(t).name + std::to_string(j + 1));
+                anim->UpdateNodeColor(tierNodes.Get(j), 0, 150, 150);
+                anim->UpdateNodeSize(tierNodes.Get(j)->GetId(), 5.0, 5.0);
+            }
+        }
 
-    // Enable tracing
-    csma.EnablePcap("hierarchical", backboneDevices.Get(nZones), true);
+        // Local APs (Green)
+        for (uint32_t z = 0; z < nZones; ++z)
+        {
+            std::ostringstream desc;
+            desc << "AP_Zone" << (z + 1);
+            anim->UpdateNodeDescription(apNodes.Get(z), desc.str());
+            anim->UpdateNodeColor(apNodes.Get(z), 0, 200, 0);
+            anim->UpdateNodeSize(apNodes.Get(z)->GetId(), 4.0, 4.0);
+        }
 
-    FlowMonitorHelper flowmon;
-    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
+        // Sensors (Red, different shades per zone)
+        for (uint32_t i = 0; i < totalSensors; ++i)
+        {
+            uint32_t zone = i / sensorsPerZone;
+            std::ostringstream desc;
+            desc << "Sensor" << (i + 1) << "_Z" << (zone + 1);
+            anim->UpdateNodeDescription(sensorNodes.Get(i), desc.str());
+            anim->UpdateNodeColor(sensorNodes.Get(i), 255, zone * 40, 0);
+            anim->UpdateNodeSize(sensorNodes.Get(i)->GetId(), 2.5, 2.5);
+        }
+    }
 
     NS_LOG_INFO("Starting simulation...");
     Simulator::Stop(Seconds(simulationTime));
+    profiler.EndPhase("applications");
     Simulator::Run();
+    double wallSeconds = profiler.EndPhase("run");
+    uint64_t peakRssKb = RunProfiler::GetPeakRssKb();
+    uint64_t eventCount = Simulator::GetEventCount();
+    if (events)
+    {
+        events->Close();
+    }
+    std::string flowsPath = outputPrefix + "hierarchical-flows" + rankSuffix + ".csv";
+    if (metrics)
+    {
+        // Every rank writes its own files, before the ranks without the gateway return
+        metrics->Close();
+        if (!metrics->WriteFlows(flowsPath))
+        {
+            NS_LOG_WARN("Could not write " << flowsPath);
+        }
+    }
+    if (carbonAnalytics)
+    {
+        carbonAnalytics->Close();
+    }
+    if (carbonLedger)
+    {
+        // Readings of the open block count as queued, not silently dropped
+        carbonLedger->Seal();
+    }
+
+    // Run-wide counters; in distributed mode each rank only knows its own sensors
+    uint64_t packetsSent = sendStats->readings;
+    uint64_t framesSent = sendStats->datagrams;
+    uint64_t activeSensors = sendStats->activeSensors;
+    // Measured by the tick scheduler; per-sensor mode holds one send event per sensor by design
+    uint64_t peakSensorEvents = sensorTicks ? sensorTicks->GetPeakPendingEvents() : localSensors;
+    uint64_t bucketCount = sensorTicks ? sensorTicks->GetBucketCount() : 0;
+    uint64_t bucketTicks = sensorTicks ? sensorTicks->GetTicksFired() : 0;
+    uint64_t sensorTickCount = sensorTicks ? sensorTicks->GetCallbacksInvoked() : 0;
+    uint64_t apStrandedReadings = 0;
+    for (const Ptr<LocalAPApplication>& apApp : apApps)
+    {
+        apStrandedReadings += apApp->GetReadingsStranded();
+    }
+#ifdef NS3_MPI
+    if (distributed)
+    {
+        // Sum the counters on rank 0, which hosts the gateway and prints the summary
+        uint64_t local[] = {packetsSent, eventCount, peakSensorEvents, bucketCount, bucketTicks, sensorTickCount, framesSent, activeSensors, apStrandedReadings};
+        uint64_t global[9] = {};
+        MPI_Reduce(local, global, 9, MPI_UINT64_T, MPI_SUM, 0, MpiInterface::GetCommunicator());
+        packetsSent = global[0];
+        eventCount = global[1];
+        peakSensorEvents = global[2];
+        bucketCount = global[3];
+        bucketTicks = global[4];
+        sensorTickCount = global[5];
+        framesSent = global[6];
+        activeSensors = global[7];
+        apStrandedReadings = global[8];
+
+        // The run takes as long as the slowest rank, and needs the memory of the largest one
+        double localWall = wallSeconds;
+        MPI_Reduce(&localWall, &wallSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MpiInterface::GetCommunicator());
+        uint64_t localRss = peakRssKb;
+        MPI_Reduce(&localRss, &peakRssKb, 1, MPI_UINT64_T, MPI_MAX, 0, MpiInterface::GetCommunicator());
+
+        // Sensors and APs encode on their ranks, the gateway decodes on rank 0
+        BatchCodecStats& codec = *codecStats;
+        uint64_t localCodec[] = {codec.batchesEncoded, codec.readingsEncoded, codec.rawBytes,
+                                 codec.encodedBytes, codec.batchesDecoded, codec.readingsDecoded};
+        uint64_t globalCodec[6] = {};
+        MPI_Reduce(localCodec, globalCodec, 6, MPI_UINT64_T, MPI_SUM, 0, MpiInterface::GetCommunicator());
+        double localCodecTime[] = {codec.encodeWallSeconds, codec.encodeSimSeconds,
+                                   codec.decodeWallSeconds, codec.decodeSimSeconds};
+        double globalCodecTime[4] = {};
+        MPI_Reduce(localCodecTime, globalCodecTime, 4, MPI_DOUBLE, MPI_SUM, 0, MpiInterface::GetCommunicator());
+        codec.batchesEncoded = globalCodec[0];
+        codec.readingsEncoded = globalCodec[1];
+        codec.rawBytes = globalCodec[2];
+        codec.encodedBytes = globalCodec[3];
+        codec.batchesDecoded = globalCodec[4];
+        codec.readingsDecoded = globalCodec[5];
+        codec.encodeWallSeconds = globalCodecTime[0];
+        codec.encodeSimSeconds = globalCodecTime[1];
+        codec.decodeWallSeconds = globalCodecTime[2];
+        codec.decodeSimSeconds = globalCodecTime[3];
+
+        // Sensors and their APs always share a rank, but each rank only counts its own zones
+        if (reliabilityStats)
+        {
+            ReliabilityStats& rel = *reliabilityStats;
+            uint64_t localRel[] = {rel.datagramsSent, rel.retransmissions, rel.acknowledged,
+                                   rel.abandoned, rel.datagramsAccepted, rel.bytesAccepted,
+                                   rel.duplicates, rel.ackDatagrams, rel.ackBytes, rel.ackEntries,
+                                   rel.outOfRange};
+            uint64_t globalRel[11] = {};
+            MPI_Reduce(localRel, globalRel, 11, MPI_UINT64_T, MPI_SUM, 0, MpiInterface::GetCommunicator());
+            rel.datagramsSent = globalRel[0];
+            rel.retransmissions = globalRel[1];
+            rel.acknowledged = globalRel[2];
+            rel.abandoned = globalRel[3];
+            rel.datagramsAccepted = globalRel[4];
+            rel.bytesAccepted = globalRel[5];
+            rel.duplicates = globalRel[6];
+            rel.ackDatagrams = globalRel[7];
+            rel.ackBytes = globalRel[8];
+            rel.ackEntries = globalRel[9];
+            rel.outOfRange = globalRel[10];
+        }
+
+        // The gateways send heartbeats on rank 0, the APs receive them and fail over on theirs
+        if (shardStats)
+        {
+            ShardStats& shard = *shardStats;
+            uint64_t localShard[] = {shard.heartbeatsSent, shard.heartbeatsReceived, shard.failovers,
+                                     shard.recoveries, shard.rerouted};
+            uint64_t globalShard[5] = {};
+            MPI_Reduce(localShard, globalShard, 5, MPI_UINT64_T, MPI_SUM, 0, MpiInterface::GetCommunicator());
+            shard.heartbeatsSent = globalShard[0];
+            shard.heartbeatsReceived = globalShard[1];
+            shard.failovers = globalShard[2];
+            shard.recoveries = globalShard[3];
+            shard.rerouted = globalShard[4];
+        }
+    }
+#endif
+
+    if (gwApps.empty())
+    {
+        // Ranks without the gateways only contribute to the reductions above
+        Simulator::Destroy();
+#ifdef NS3_MPI
+        if (distributed)
+        {
+            MpiInterface::Disable();
+        }
+#endif
+        return 0;
+    }
+
+    // Each gateway holds the records of its shards; the first one's store takes in the others
+    std::vector<uint64_t> gatewayReadings;
+    uint64_t backboneDatagrams = 0;
+    double latencySum = 0.0;
+    uint64_t latencyCount = 0;
+    for (Ptr<MainGatewayApplication> app : gwApps)
+    {
+        gatewayReadings.push_back(app->GetStats().GetTotalReadings());
+        backboneDatagrams += app->GetDatagramsReceived();
+        uint64_t count = app->GetStats().GetLatency().GetCount();
+        latencySum += app->GetMeanLatency() * count;
+        latencyCount += count;
+    }
+    CarbonStatsStore& carbonStats = gwApps[0]->GetStats();
+    for (uint32_t g = 1; g < gwApps.size(); ++g)
+    {
+        carbonStats.Merge(gwApps[g]->GetStats());
+    }
+    uint64_t totalPacketsReceived = carbonStats.GetTotalReadings();
+    double meanLatency = latencyCount > 0 ? latencySum / latencyCount : 0.0;
+    IngestReport ingestReport;
+    for (Ptr<IngestQueue> ingestQueue : ingestQueues)
+    {
+        ingestReport.Merge(ingestQueue->GetReport());
+    }
 
     NS_LOG_INFO("=================================================");
     NS_LOG_INFO("Simulation Results");
     NS_LOG_INFO("=================================================");
-    NS_LOG_INFO("Total packets sent: " << totalPacketsSent);
+    NS_LOG_INFO("Total packets sent: " << packetsSent);
     NS_LOG_INFO("Total packets received: " << totalPacketsReceived);
     double ratio =
-        (totalPacketsSent > 0) ? (double)totalPacketsReceived / totalPacketsSent * 100.0 : 0.0;
+        (packetsSent > 0) ? (double)totalPacketsReceived / packetsSent * 100.0 : 0.0;
     NS_LOG_INFO("Delivery ratio: " << ratio << "%");
+    NS_LOG_INFO("Backbone datagrams at the gateways: " << backboneDatagrams);
+    NS_LOG_INFO("Mean end-to-end latency: " << meanLatency * 1000.0 << " ms");
     NS_LOG_INFO("=================================================");
+    profiler.EndPhase("results");
 
-    monitor->SerializeToXmlFile("hierarchical-flowmon.xml", true, true);
+    if (monitor)
+    {
+        monitor->SerializeToXmlFile(outputPrefix + "hierarchical-flowmon.xml", true, true);
+    }
+    profiler.EndPhase("flowMonitor");
 
     std::cout << "\n=== HIERARCHICAL NETWORK RESULTS ===\n";
     std::cout << "Total sensors: " << totalSensors << "\n";
     std::cout << "Zones: " << nZones << "\n";
-    std::cout << "Packets sent: " << totalPacketsSent << "\n";
+    if (distributed)
+    {
+        std::cout << "MPI ranks: " << systemCount << "\n";
+    }
+    std::cout << "Active sensors: " << activeSensors << " of " << totalSensors << "\n";
+    std::cout << "Packets sent: " << packetsSent << "\n";
     std::cout << "Packets received: " << totalPacketsReceived << "\n";
+    if (carbonStats.GetRejectedReadings() > 0)
+    {
+        std::cout << "Rejected readings (unknown ID): " << carbonStats.GetRejectedReadings() << "\n";
+    }
     std::cout << "Delivery ratio: " << ratio << "%\n";
-    std::cout << "\nVisualization: hierarchical-carbon-trading.xml\n";
+    if (apStrandedReadings > 0)
+    {
+        std::cout << "Readings left in AP batches at stop: " << apStrandedReadings << "\n";
+    }
+    std::cout << "Backbone datagrams: " << backboneDatagrams << "\n";
+    if (backboneDatagrams > 0)
+    {
+        std::cout << "Readings per datagram: " << (double)totalPacketsReceived / backboneDatagrams
+                  << "\n";
+    }
+    std::cout << "Mean end-to-end latency: " << meanLatency * 1000.0 << " ms\n";
+    double readingsPerFrame = framesSent > 0 ? (double)packetsSent / framesSent : 0.0;
+    std::cout << "Sensor datagrams: " << framesSent << " (" << readingsPerFrame
+              << " readings each)\n";
+    if (airtime)
+    {
+        // Local zones only, like the grid statistics
+        std::cout << "\nZone medium usage:\n";
+        std::cout << "  WiFi frames: " << airtime->GetTxFrames() << " ("
+                  << airtime->GetTxAirtime().GetSeconds() << " s airtime)\n";
+        std::cout << "  Mean AP medium busy: "
+                  << airtime->GetReceiverUtilization(Seconds(simulationTime)) * 100.0 << "%\n";
+        std::cout << "  AP frames decoded: " << airtime->GetRxFrames()
+                  << ", failed (collisions): " << airtime->GetRxErrors()
+                  << ", dropped while busy: " << airtime->GetRxDrops() << "\n";
+    }
+    // The sensors send from the warm-up to the end of the run
+    Time sendingPeriod = Seconds(simulationTime - warmupS);
+    if (reliabilityStats)
+    {
+        std::cout << "\nReliable delivery (sensor -> AP):\n";
+        reliabilityStats->Print(std::cout, sendingPeriod);
+        if (airtime)
+        {
+            std::cout << "  ACK airtime: " << airtime->GetAckAirtime().GetSeconds() << " s in "
+                      << airtime->GetAckFrames() << " frames ("
+                      << airtime->GetAckAirtimeShare() * 100.0 << "% of the zone airtime)\n";
+        }
+    }
+    if (carbonAnalytics)
+    {
+        std::cout << "\nCarbon analytics:\n";
+        carbonAnalytics->Print(std::cout, sendingPeriod);
+    }
+    if (carbonLedger)
+    {
+        std::cout << "\nLedger:\n";
+        carbonLedger->Print(std::cout, sendingPeriod);
+    }
+    if (!ingestQueues.empty())
+    {
+        std::cout << "\nGateway ingest" << (gateways > 1 ? " (all gateways)" : "") << ":\n";
+        ingestReport.Print(std::cout, sendingPeriod);
+    }
+    // Load of each shard against its share of the ring: the hash alone, then the traffic
+    double shardImbalance = 1.0;
+    if (gateways > 1)
+    {
+        std::cout << "\nGateway shards (by " << shardBy << "):\n";
+        uint64_t busiest = *std::max_element(gatewayReadings.begin(), gatewayReadings.end());
+        double fairShare = (double)totalPacketsReceived / gateways;
+        shardImbalance = fairShare > 0 ? busiest / fairShare : 1.0;
+        for (uint32_t g = 0; g < gateways; ++g)
+        {
+            std::cout << "  Gateway " << (g + 1) << ": " << gatewayReadings[g] << " readings ("
+                      << (totalPacketsReceived > 0 ? gatewayReadings[g] * 100.0 / totalPacketsReceived
+                                                   : 0.0)
+                      << "%, ring share " << gatewayRing->GetShare(g) * 100.0 << "%), "
+                      << gwApps[g]->GetDatagramsReceived() << " datagrams";
+            if (g + 1 == failGateway)
+            {
+                std::cout << ", stopped at " << failAtS << " s";
+            }
+            std::cout << "\n";
+        }
+        std::cout << "  Imbalance (busiest / mean): " << shardImbalance << "\n";
+        shardStats->Print(std::cout);
+    }
+    if (codecStats->batchesEncoded > 0 || codecStats->batchesDecoded > 0)
+    {
+        std::cout << "\nBatch codec (" << batchCodec << "):\n";
+        codecStats->Print(std::cout);
+    }
+
+    // Per-sensor mode keeps one pending event per running sensor
+    std::cout << "\nScheduler benchmark:\n";
+    std::cout << "  Sensor scheduling: "
+              << (sensorTicks ? "shared tick scheduler" : "per-sensor events") << "\n";
+    std::cout << (sensorTicks ? "  Peak pending sensor events: "
+                              : "  Pending sensor events (expected, one per sensor): ")
+              << peakSensorEvents << "\n";
+    if (sensorTicks)
+    {
+        std::cout << "  Buckets: " << bucketCount << ", bucket events fired: " << bucketTicks
+                  << " (" << sensorTickCount << " sensor ticks)\n";
+    }
+    if (!media.GetGridChannels().empty())
+    {
+        // Local media only; distributed ranks do not reduce these
+        uint64_t receptions = 0;
+        uint64_t culled = 0;
+        for (const Ptr<GridSpectrumChannel>& grid : media.GetGridChannels())
+        {
+            receptions += grid->GetDeliveryCount();
+            culled += grid->GetCulledCount();
+        }
+        std::cout << "  Grid channels: " << media.GetGridChannels().size() << ", radius "
+                  << media.GetGridChannels().front()->GetCullRadius() << " m, " << receptions
+                  << " receptions, " << culled << " culled\n";
+    }
+    if (abstractLinks)
+    {
+        // Local stars only, like the grid statistics
+        std::cout << "  Abstract links: " << star.GetFramesDropped() << " frames dropped\n";
+    }
+    std::cout << "  Events executed: " << eventCount << "\n";
+    std::cout << "  Wall-clock time: " << wallSeconds << " s ("
+              << (wallSeconds > 0 ? eventCount / wallSeconds : 0.0) << " events/s)\n";
+
+    std::cout << "\nCO2 by zone:\n";
+    const std::vector<RunningStats>& zoneStats = carbonStats.GetZones();
+    for (uint32_t zoneId = 1; zoneId < zoneStats.size(); ++zoneId)
+    {
+        const RunningStats& stats = zoneStats[zoneId];
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        std::cout << "  Zone " << zoneId << ": " << stats.count << " readings, avg "
+                  << std::fixed << std::setprecision(2) << stats.mean << " ppm (min "
+                  << stats.min << ", max " << stats.max << ")\n";
+    }
+
+    std::cout << "CO2 by company:\n";
+    const std::vector<RunningStats>& companyStats = carbonStats.GetCompanies();
+    for (uint32_t companyId = 1; companyId < companyStats.size(); ++companyId)
+    {
+        const RunningStats& stats = companyStats[companyId];
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        std::cout << "  Company " << companyId << ": " << stats.count << " readings, avg "
+                  << std::fixed << std::setprecision(2) << stats.mean << " ppm\n";
+    }
+    std::cout << "End-to-end latency:\n";
+    carbonStats.PrintLatency(std::cout);
+    std::cout << std::defaultfloat;
+    if (anim)
+    {
+        std::cout << "\nVisualization: " << outputPrefix << "hierarchical-carbon-trading.xml\n";
+    }
+    if (tracingPlan.GetTracedNodes() > 0)
+    {
+        // Local nodes only
+        std::cout << "IP traces: " << tracingPlan.GetTracedNodes() << " nodes, "
+                  << tracingPlan.GetRecordsWritten() << " packets (" << outputPrefix
+                  << "hierarchical-ip-<node>.pcap, " << outputPrefix << "hierarchical-ip.tr)\n";
+    }
+    if (metrics)
+    {
+        // This rank's nodes only
+        std::cout << "Flow metrics: " << metrics->GetPath() << " (" << metrics->GetWindowsWritten()
+                  << " windows), per-flow totals in " << flowsPath << "\n";
+    }
+    if (telemetry)
+    {
+        std::cout << "Telemetry stream: " << telemetryHost << ":" << telemetryPort << " ("
+                  << telemetry->GetDatagramsSent() << " datagrams, "
+                  << telemetry->GetDatagramsDropped() << " dropped)\n";
+    }
+    if (carbonAnalytics)
+    {
+        std::cout << "Carbon windows: " << carbonAnalytics->GetPath() << " ("
+                  << carbonAnalytics->GetWindowsClosed() << " windows)\n";
+    }
+    if (events)
+    {
+        // This rank's records only
+        std::cout << "Event log: " << events->GetPath() << " (" << events->GetRecordCount()
+                  << " records, decode with tools/decode_event_log.py)\n";
+    }
+    profiler.EndPhase("output");
+
+    // Phases are rank 0's; the run time and peak RSS are the maxima over all ranks
+    double packetsPerSecond = wallSeconds > 0 ? totalPacketsReceived / wallSeconds : 0.0;
+    std::cout << "\nRun profile (wall-clock):\n";
+    profiler.Print(std::cout);
+    std::cout << "Peak RSS: " << peakRssKb / 1024.0 << " MiB\n";
+    std::cout << "Simulation rate: " << (wallSeconds > 0 ? eventCount / wallSeconds : 0.0)
+              << " events/s, " << packetsPerSecond << " packets received/s\n";
+#ifdef CARBON_ALLOC_COUNTER
+    std::cout << "Heap allocations (see alloc-counter.h, this rank):\n";
+    AllocCounter::Print(std::cout);
+#endif
     std::cout << "=====================================\n";
 
+    // Machine-readable results for tools/run_sweep.py (run-wide counters, rank 0 only)
+    RunSummary summary("iot-hierarchical");
+    summary.AddConfig("nZones", nZones);
+    summary.AddConfig("tiers", tiers.empty() ? "zone:" + std::to_string(nZones) : tiers);
+    summary.AddConfig("sensorsPerZone", sensorsPerZone);
+    summary.AddConfig("time", simulationTime);
+    summary.AddConfig("intervalS", intervalS);
+    summary.AddConfig("sensorBatchReadings", sensorBatchReadings);
+    summary.AddConfig("sensorBatchAgeS", sensorBatchAgeS);
+    summary.AddConfig("payload", payload);
+    summary.AddConfig("emissionModel", traceFile.empty() ? emissionModel : "trace");
+    summary.AddConfig("apBatchReadings", apBatchReadings);
+    summary.AddConfig("batchCodec", batchCodec);
+    summary.AddConfig("codecQuantumPpm", codecQuantumPpm);
+    summary.AddConfig("linkModel", linkModel);
+    summary.AddConfig("wifiChannel", wifiChannel);
+    summary.AddConfig("wifiStandard", wifiStandard);
+    summary.AddConfig("wifiBand", wifiConfig.GetBand());
+    summary.AddConfig("channelWidth", wifiConfig.GetChannelWidth());
+    summary.AddConfig("rateManager", rateManager);
+    summary.AddConfig("association", association);
+    summary.AddConfig("warmupS", warmupS);
+    summary.AddConfig("startSpreadS", startSpreadS);
+    summary.AddConfig("channelPlan", channelPlan);
+    summary.AddConfig("backbone", backbone);
+    summary.AddConfig("tickScheduler", tickScheduler);
+    summary.AddConfig("tracing", tracing);
+    summary.AddConfig("metricsInterval", metricsIntervalS);
+    summary.AddConfig("telemetryPort", telemetryPort);
+    summary.AddConfig("reliable", reliable);
+    if (reliable)
+    {
+        summary.AddConfig("ackDelayMs", ackDelayMs);
+        summary.AddConfig("rtoMs", rtoMs);
+        summary.AddConfig("maxRetries", maxRetries);
+    }
+    summary.AddConfig("analytics", analytics);
+    if (analytics)
+    {
+        summary.AddConfig("analyticsWindowS", analyticsWindowS);
+        summary.AddConfig("ewmaAlpha", ewmaAlpha);
+        summary.AddConfig("anomalySigma", anomalySigma);
+        summary.AddConfig("creditCapPpm", creditCapPpm);
+        summary.AddConfig("analyticsCostUs", analyticsCostUs);
+    }
+    summary.AddConfig("ledger", ledger);
+    if (ledger)
+    {
+        summary.AddConfig("ledgerBlockEntries", ledgerBlockEntries);
+        summary.AddConfig("ledgerBlockMs", ledgerBlockMs);
+        summary.AddConfig("ledgerBlockCostMs", ledgerBlockCostMs);
+        summary.AddConfig("ledgerEntryCostUs", ledgerEntryCostUs);
+    }
+    summary.AddConfig("gatewayWorkers", gatewayWorkers);
+    if (gatewayWorkers > 0)
+    {
+        summary.AddConfig("gatewayQueue", gatewayQueue);
+        summary.AddConfig("gatewayPolicy", gatewayPolicy);
+        summary.AddConfig("gatewayService", gatewayService);
+        summary.AddConfig("gatewayServiceUs", gatewayServiceUs);
+    }
+    summary.AddConfig("gateways", gateways);
+    if (gateways > 1)
+    {
+        summary.AddConfig("shardBy", shardBy);
+        summary.AddConfig("shardPoints", shardPoints);
+        summary.AddConfig("failover", failover);
+        if (failover)
+        {
+            summary.AddConfig("heartbeatMs", heartbeatMs);
+            summary.AddConfig("heartbeatMisses", heartbeatMisses);
+        }
+    }
+    if (failGateway > 0)
+    {
+        summary.AddConfig("failGateway", failGateway);
+        summary.AddConfig("failAtS", failAtS);
+    }
+    summary.AddConfig("mpiRanks", systemCount);
+    summary.AddConfig("RngSeed", RngSeedManager::GetSeed());
+    summary.AddConfig("RngRun", RngSeedManager::GetRun());
+    summary.AddMetric("activeSensors", activeSensors);
+    summary.AddMetric("packetsSent", packetsSent);
+    summary.AddMetric("packetsReceived", totalPacketsReceived);
+    summary.AddMetric("rejectedReadings", carbonStats.GetRejectedReadings());
+    summary.AddMetric("deliveryRatio", ratio);
+    summary.AddMetric("apStrandedReadings", apStrandedReadings);
+    summary.AddMetric("backboneDatagrams", backboneDatagrams);
+    summary.AddMetric("meanLatencyMs", meanLatency * 1000.0);
+    carbonStats.AddLatencyMetrics(summary);
+    if (carbonAnalytics)
+    {
+        carbonAnalytics->AddMetrics(summary, sendingPeriod);
+    }
+    if (carbonLedger)
+    {
+        carbonLedger->AddMetrics(summary, sendingPeriod);
+    }
+    if (!ingestQueues.empty())
+    {
+        ingestReport.AddMetrics(summary, sendingPeriod);
+    }
+    if (gateways > 1)
+    {
+        for (uint32_t g = 0; g < gateways; ++g)
+        {
+            summary.AddMetric("gateway" + std::to_string(g + 1) + "Readings", gatewayReadings[g]);
+        }
+        summary.AddMetric("shardImbalance", shardImbalance);
+        shardStats->AddMetrics(summary);
+    }
+    summary.AddMetric("framesSent", framesSent);
+    summary.AddMetric("readingsPerFrame", readingsPerFrame);
+    if (airtime && !distributed)
+    {
+        summary.AddMetric("airtimeSeconds", airtime->GetTxAirtime().GetSeconds());
+        summary.AddMetric("wifiTxFrames", airtime->GetTxFrames());
+        summary.AddMetric("receiverBusyPercent",
+                          airtime->GetReceiverUtilization(Seconds(simulationTime)) * 100.0);
+        summary.AddMetric("rxErrors", airtime->GetRxErrors());
+        summary.AddMetric("rxDrops", airtime->GetRxDrops());
+    }
+    if (reliabilityStats)
+    {
+        reliabilityStats->AddMetrics(summary, sendingPeriod);
+        if (airtime && !distributed)
+        {
+            summary.AddMetric("ackAirtimeSeconds", airtime->GetAckAirtime().GetSeconds());
+            summary.AddMetric("ackAirtimePercent", airtime->GetAckAirtimeShare() * 100.0);
+        }
+    }
+    codecStats->AddMetrics(summary);
+    if (telemetry)
+    {
+        telemetry->AddMetrics(summary);
+    }
+    summary.AddMetric("eventCount", eventCount);
+    summary.AddMetric("wallSeconds", wallSeconds);
+    summary.AddMetric("eventsPerSecond", wallSeconds > 0 ? eventCount / wallSeconds : 0.0);
+    summary.AddMetric("packetsPerSecond", packetsPerSecond);
+    summary.AddMetric("peakRssKb", peakRssKb);
+    profiler.AddMetrics(summary);
+#ifdef CARBON_ALLOC_COUNTER
+    AllocCounter::AddMetrics(summary);
+#endif
+    if (!summary.Write(outputPrefix + "summary.json"))
+    {
+        NS_LOG_WARN("Could not write " << outputPrefix << "summary.json");
+    }
+
     Simulator::Destroy();
+#ifdef NS3_MPI
+    if (distributed)
+    {
+        MpiInterface::Disable();
+    }
+#endif
     return 0;
 }
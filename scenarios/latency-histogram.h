@@ -0,0 +1,155 @@
+/*
+ * Latency Histogram
+ *
+ * Fixed-size log-linear histogram of latencies in microseconds: values
+ * below 8 us get a bucket each, every power of two above is split into 8
+ * buckets, up to 2^32 us (about 71 minutes; larger values land in the last
+ * bucket). Quantiles are the upper edge of their bucket, so they are at
+ * most 12.5 % above the exact value. A histogram is 2 KiB whatever the
+ * sample count, and recording never allocates.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace ns3
+{
+
+class LatencyHistogram
+{
+  public:
+    static const uint32_t SUB_BUCKETS = 8;   // Buckets per power of two
+    static const uint32_t BUCKET_COUNT = 240; // 8 exact + 29 octaves of 8
+
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    /** Forget every sample */
+    void Reset(void)
+    {
+        m_buckets.fill(0);
+        m_count = 0;
+        m_sumUs = 0.0;
+        m_maxUs = 0;
+    }
+
+    /**
+     * @param latency Sample (negative values count as zero)
+     */
+    void Add(Time latency)
+    {
+        int64_t us = latency.GetMicroSeconds();
+        uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+        m_buckets[GetBucket(value)]++;
+        m_count++;
+        m_sumUs += value;
+        m_maxUs = std::max(m_maxUs, value);
+    }
+
+    /**
+     * Add the samples of another histogram
+     * @param other Histogram to merge
+     */
+    void Merge(const LatencyHistogram& other)
+    {
+        for (uint32_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sumUs += other.m_sumUs;
+        m_maxUs = std::max(m_maxUs, other.m_maxUs);
+    }
+
+    /** @return Number of samples */
+    uint64_t GetCount(void) const
+    {
+        return m_count;
+    }
+
+    /** @return Exact mean in seconds (0 without samples) */
+    double GetMean(void) const
+    {
+        return m_count > 0 ? m_sumUs / m_count * 1e-6 : 0.0;
+    }
+
+    /** @return Exact maximum in seconds */
+    double GetMax(void) const
+    {
+        return m_maxUs * 1e-6;
+    }
+
+    /**
+     * @param q Quantile (0..1], e.g. 0.99
+     * @return Upper edge of the bucket holding the q-quantile, in seconds (0 without samples)
+     */
+    double GetQuantile(double q) const
+    {
+        if (m_count == 0)
+        {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * m_count));
+        rank = std::min(std::max<uint64_t>(rank, 1), m_count);
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= rank)
+            {
+                // The largest sample bounds the last bucket more tightly than its edge
+                return std::min(GetUpperEdge(i), m_maxUs) * 1e-6;
+            }
+        }
+        return GetMax();
+    }
+
+  private:
+    static uint32_t GetBucket(uint64_t us)
+    {
+        if (us < SUB_BUCKETS)
+        {
+            return us;
+        }
+        if ((us >> 32) != 0)
+        {
+            return BUCKET_COUNT - 1;
+        }
+        uint32_t exponent = 3; // Position of the highest set bit
+        while ((us >> (exponent + 1)) != 0)
+        {
+            exponent++;
+        }
+        uint32_t sub = (us >> (exponent - 3)) & (SUB_BUCKETS - 1);
+        return SUB_BUCKETS + (exponent - 3) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t GetUpperEdge(uint32_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return bucket;
+        }
+        uint32_t exponent = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 3;
+        uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> m_buckets;
+    uint64_t m_count;
+    double m_sumUs;
+    uint64_t m_maxUs;
+};
+
+} // namespace ns3
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,164 @@
+/*
+ * Realtime Lag Monitor
+ *
+ * Under RealtimeSimulatorImpl the simulation clock is meant to track the
+ * wall clock. When the fleet generates more events than the host can run
+ * in time, the scheduler falls behind: in BestEffort mode it just runs
+ * late, in HardLimit mode it aborts once the lag exceeds the limit.
+ * Neither reports how far behind it ran, so this monitor samples the lag
+ * (wall-clock time elapsed minus simulation time elapsed since its first
+ * sample) every --lagSampleMs of simulation time. It warns, through the
+ * "RealtimeLagMonitor" log component, each time the lag crosses the limit,
+ * and it reports the maximum, the mean and the samples over the limit
+ * ("overruns") at the end.
+ *
+ * The samples are events themselves, so a short period makes the lag it
+ * measures slightly worse.
+ */
+
+#ifndef REALTIME_LAG_MONITOR_H
+#define REALTIME_LAG_MONITOR_H
+
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace ns3
+{
+
+static LogComponent g_realtimeLagMonitorLog("RealtimeLagMonitor", __FILE__);
+
+class RealtimeLagMonitor : public SimpleRefCount<RealtimeLagMonitor>
+{
+  public:
+    /**
+     * @param period Simulation time between samples
+     * @param limit Lag above which a sample counts as an overrun
+     */
+    RealtimeLagMonitor(Time period, Time limit)
+        : NS_LOG_TEMPLATE_DEFINE("RealtimeLagMonitor"),
+          m_period(period),
+          m_limit(limit),
+          m_samples(0),
+          m_overruns(0),
+          m_lagSum(0.0),
+          m_maxLag(0.0),
+          m_behind(false)
+    {
+        NS_ABORT_MSG_IF(!period.IsStrictlyPositive(), "The lag sample period must be positive");
+    }
+
+    /**
+     * Schedule the first sample
+     * @param at Simulation time of the first sample (the origin of both clocks)
+     */
+    void Start(Time at)
+    {
+        Simulator::Schedule(at, &RealtimeLagMonitor::Sample, this);
+    }
+
+    /** @return Samples taken */
+    uint64_t GetSamples(void) const
+    {
+        return m_samples;
+    }
+
+    /** @return Samples whose lag exceeded the limit */
+    uint64_t GetOverruns(void) const
+    {
+        return m_overruns;
+    }
+
+    /** @return Largest lag seen, in seconds (0 if the scheduler never ran late) */
+    double GetMaxLag(void) const
+    {
+        return m_maxLag;
+    }
+
+    /** @return Mean lag over the samples, in seconds (early samples count as 0) */
+    double GetMeanLag(void) const
+    {
+        return m_samples > 0 ? m_lagSum / m_samples : 0.0;
+    }
+
+    /**
+     * Print the lag statistics
+     * @param os Output stream
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "  Lag behind wall-clock: max " << m_maxLag * 1000.0 << " ms, mean "
+           << GetMeanLag() * 1000.0 << " ms\n";
+        os << "  Samples over the " << m_limit.GetMilliSeconds() << " ms limit: " << m_overruns
+           << " of " << m_samples << "\n";
+    }
+
+    /**
+     * Add the lag metrics to a run summary
+     * @param summary Summary of this run
+     */
+    void AddMetrics(RunSummary& summary) const
+    {
+        summary.AddMetric("realtimeMaxLagMs", m_maxLag * 1000.0);
+        summary.AddMetric("realtimeMeanLagMs", GetMeanLag() * 1000.0);
+        summary.AddMetric("realtimeLagSamples", m_samples);
+        summary.AddMetric("realtimeOverruns", m_overruns);
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    void Sample(void)
+    {
+        Clock::time_point wall = Clock::now();
+        Time now = Simulator::Now();
+        if (m_samples == 0)
+        {
+            m_wallOrigin = wall;
+            m_simOrigin = now;
+        }
+        double wallElapsed = std::chrono::duration<double>(wall - m_wallOrigin).count();
+        double lag = std::max(wallElapsed - (now - m_simOrigin).GetSeconds(), 0.0);
+        m_samples++;
+        m_lagSum += lag;
+        m_maxLag = std::max(m_maxLag, lag);
+
+        bool behind = lag > m_limit.GetSeconds();
+        if (behind)
+        {
+            m_overruns++;
+        }
+        if (behind && !m_behind)
+        {
+            NS_LOG_WARN("Realtime scheduler " << lag * 1000.0 << " ms behind wall-clock at "
+                                              << now.GetSeconds() << " s");
+        }
+        else if (!behind && m_behind)
+        {
+            NS_LOG_WARN("Realtime scheduler caught up at " << now.GetSeconds() << " s");
+        }
+        m_behind = behind;
+        Simulator::Schedule(m_period, &RealtimeLagMonitor::Sample, this);
+    }
+
+    NS_LOG_TEMPLATE_DECLARE; // Header-only class: log through g_realtimeLagMonitorLog
+
+    Time m_period;
+    Time m_limit;
+    uint64_t m_samples;
+    uint64_t m_overruns;
+    double m_lagSum; // s
+    double m_maxLag; // s
+    bool m_behind;   // Last sample was over the limit
+    Clock::time_point m_wallOrigin;
+    Time m_simOrigin;
+};
+
+} // namespace ns3
+
+#endif /* REALTIME_LAG_MONITOR_H */
@@ -0,0 +1,744 @@
+/*
+ * Reliable Delivery
+ *
+ * Optional acknowledgment layer over the WiFi hop, where readings are lost
+ * to collisions: sensor -> gateway in the single-tier network, sensor ->
+ * Local AP in the hierarchical one (the backbone is wired). It is off
+ * unless --reliable is set.
+ *
+ * - Sensors prefix every datagram with a CO2SequenceHeader carrying a
+ *   per-sensor sequence number and keep it in a RetransmitWindow until it
+ *   is acknowledged. A datagram still unacknowledged after the
+ *   retransmission timeout is sent again, the timeout doubling at each
+ *   attempt, up to the retry limit; then it is abandoned. The window holds
+ *   WINDOW datagrams, the width of the ACK bitmap: a sensor that gets that
+ *   far ahead abandons its oldest datagram.
+ * - The receiver strips the header, drops duplicates and notes what it got
+ *   in an AckBatcher. At most the ACK delay after the first unacknowledged
+ *   datagram, it broadcasts one CO2AckHeader datagram to the sensor subnet
+ *   with an entry per sensor heard from since the previous one: the
+ *   sequence number up to which everything arrived (cumulative) and a
+ *   bitmap of the WINDOW numbers after it. One ACK frame thus covers a
+ *   whole zone, where per-datagram ACKs would cost one frame each.
+ *
+ * Wire formats (network byte order):
+ *   CO2SequenceHeader (10 bytes): [Magic:1][Version:1][SensorID:4][Sequence:4]
+ *   CO2AckHeader (6 bytes): [Magic:1][Version:1][ZoneID:2][Count:2], followed
+ *   by Count entries [SensorID:4][Cumulative:4][Bitmap:4] sorted by sensor ID
+ *
+ * Both magic bytes are outside the ASCII range and differ from the reading
+ * version and the batch magic, so receivers tell the payloads apart by
+ * peeking one byte. Sequence numbers start at 1 (cumulative 0 = nothing
+ * received yet).
+ */
+
+#ifndef RELIABLE_DELIVERY_H
+#define RELIABLE_DELIVERY_H
+
+#include "co2-batch-codec.h"
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Settings of the reliability layer, shared by senders and receivers
+ */
+struct ReliabilityConfig
+{
+    Time ackDelay = MilliSeconds(50);           // Longest wait before a pending ACK is sent
+    Time retransmitTimeout = MilliSeconds(200); // Before the first retransmission
+    uint32_t maxRetries = 4; // Retransmissions before a datagram is abandoned
+};
+
+/**
+ * Reliability work of a run, shared by every sender and receiver. Sender-side
+ * fields count what sensors saw, receiver-side ones what the ACK batchers
+ * took in and sent back; only the sums over the run are meaningful.
+ */
+struct ReliabilityStats : public SimpleRefCount<ReliabilityStats>
+{
+    uint64_t datagramsSent = 0; // First transmissions of sequenced datagrams
+    uint64_t retransmissions = 0;
+    uint64_t acknowledged = 0;      // Datagrams the senders saw acknowledged
+    uint64_t abandoned = 0;         // Out of retries, or pushed out of a full window
+    uint64_t datagramsAccepted = 0; // First copies at the receivers
+    uint64_t bytesAccepted = 0;     // Their payload, sequence header excluded
+    uint64_t duplicates = 0;
+    uint64_t outOfRange = 0; // Dropped: sensor ID outside the receiver's reserved range
+    uint64_t ackDatagrams = 0;
+    uint64_t ackBytes = 0; // UDP payload of the ACK datagrams
+    uint64_t ackEntries = 0;
+
+    /** @return Retransmissions per first transmission, in percent */
+    double GetRetransmitPercent(void) const
+    {
+        return datagramsSent > 0 ? retransmissions * 100.0 / datagramsSent : 0.0;
+    }
+
+    /**
+     * @param period Time the sensors were sending
+     * @return Unique payload delivered over the WiFi hop, in kbit/s
+     */
+    double GetGoodputKbps(Time period) const
+    {
+        return period.IsStrictlyPositive() ? bytesAccepted * 8.0 / period.GetSeconds() / 1000.0
+                                           : 0.0;
+    }
+
+    /**
+     * Print the delivery, retransmission and ACK counters
+     * @param os Output stream
+     * @param period Time the sensors were sending
+     */
+    void Print(std::ostream& os, Time period) const
+    {
+        os << "  Datagrams sent: " << datagramsSent << ", retransmissions: " << retransmissions
+           << " (" << GetRetransmitPercent() << "%), abandoned: " << abandoned << "\n";
+        os << "  Accepted: " << datagramsAccepted << " (" << duplicates
+           << " duplicates, " << outOfRange << " out of range dropped), goodput " << GetGoodputKbps(period) << " kbps\n";
+        os << "  ACK datagrams: " << ackDatagrams << " (" << ackEntries << " entries, "
+           << ackBytes << " bytes), acknowledged: " << acknowledged << "\n";
+    }
+
+    /**
+     * Add the reliability metrics to a run summary
+     * @param summary Run summary
+     * @param period Time the sensors were sending
+     */
+    void AddMetrics(RunSummary& summary, Time period) const
+    {
+        summary.AddMetric("reliableDatagrams", datagramsSent);
+        summary.AddMetric("retransmissions", retransmissions);
+        summary.AddMetric("retransmitPercent", GetRetransmitPercent());
+        summary.AddMetric("abandonedDatagrams", abandoned);
+        summary.AddMetric("duplicateDatagrams", duplicates);
+        summary.AddMetric("outOfRangeDatagrams", outOfRange);
+        summary.AddMetric("goodputKbps", GetGoodputKbps(period));
+        summary.AddMetric("ackDatagrams", ackDatagrams);
+        summary.AddMetric("ackBytes", ackBytes);
+    }
+};
+
+class CO2SequenceHeader : public Header
+{
+  public:
+    static constexpr uint8_t MAGIC = 0xA5;          //!< Identifies a sequenced datagram
+    static constexpr uint8_t VERSION = 1;           //!< Current wire format version
+    static constexpr uint32_t SERIALIZED_SIZE = 10; //!< Bytes on the wire
+
+    CO2SequenceHeader()
+        : m_version(VERSION),
+          m_sensorId(0),
+          m_sequence(0)
+    {
+    }
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::CO2SequenceHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<CO2SequenceHeader>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId(void) const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize(void) const override
+    {
+        return SERIALIZED_SIZE;
+    }
+
+    void Serialize(Buffer::Iterator start) const override
+    {
+        start.WriteU8(MAGIC);
+        start.WriteU8(m_version);
+        start.WriteHtonU32(m_sensorId);
+        start.WriteHtonU32(m_sequence);
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override
+    {
+        start.ReadU8(); // Magic, checked by IsSequencedPayload()
+        m_version = start.ReadU8();
+        m_sensorId = start.ReadNtohU32();
+        m_sequence = start.ReadNtohU32();
+        return SERIALIZED_SIZE;
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "seq v=" << static_cast<uint32_t>(m_version) << " sensor=" << m_sensorId
+           << " seq=" << m_sequence;
+    }
+
+    /**
+     * Check whether a packet starts with a sequence header
+     * @param packet Received packet
+     * @return true if the first byte is the sequence magic
+     */
+    static bool IsSequencedPayload(Ptr<const Packet> packet)
+    {
+        uint8_t first = 0;
+        return packet->GetSize() >= SERIALIZED_SIZE && packet->CopyData(&first, 1) == 1 &&
+               first == MAGIC;
+    }
+
+    void SetSensorId(uint32_t sensorId)
+    {
+        m_sensorId = sensorId;
+    }
+
+    uint32_t GetSensorId(void) const
+    {
+        return m_sensorId;
+    }
+
+    void SetSequence(uint32_t sequence)
+    {
+        m_sequence = sequence;
+    }
+
+    uint32_t GetSequence(void) const
+    {
+        return m_sequence;
+    }
+
+  private:
+    uint8_t m_version;
+    uint32_t m_sensorId;
+    uint32_t m_sequence; // Per sensor, from 1
+};
+
+/**
+ * Acknowledgment state of one sensor as carried in a CO2AckHeader entry
+ */
+struct AckEntry
+{
+    uint32_t sensorId = 0;
+    uint32_t cumulative = 0; // Everything up to here was received
+    uint32_t bitmap = 0;     // Bit i: cumulative + 1 + i was received
+};
+
+class CO2AckHeader : public Header
+{
+  public:
+    static constexpr uint8_t MAGIC = 0xAC;     //!< Identifies an ACK datagram
+    static constexpr uint8_t VERSION = 1;      //!< Current wire format version
+    static constexpr uint32_t PREFIX_SIZE = 6; //!< Bytes before the entries
+    static constexpr uint32_t ENTRY_SIZE = 12; //!< Bytes per entry
+    static constexpr uint32_t MAX_SIZE = 1472; //!< Largest ACK datagram (one frame)
+    static constexpr uint32_t MAX_ENTRIES = (MAX_SIZE - PREFIX_SIZE) / ENTRY_SIZE;
+
+    CO2AckHeader()
+        : m_version(VERSION),
+          m_zoneId(0)
+    {
+    }
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::CO2AckHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<CO2AckHeader>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId(void) const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize(void) const override
+    {
+        return PREFIX_SIZE + ENTRY_SIZE * m_entries.size();
+    }
+
+    void Serialize(Buffer::Iterator start) const override
+    {
+        start.WriteU8(MAGIC);
+        start.WriteU8(m_version);
+        start.WriteHtonU16(m_zoneId);
+        start.WriteHtonU16(m_entries.size());
+        for (const AckEntry& entry : m_entries)
+        {
+            start.WriteHtonU32(entry.sensorId);
+            start.WriteHtonU32(entry.cumulative);
+            start.WriteHtonU32(entry.bitmap);
+        }
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override
+    {
+        start.ReadU8(); // Magic, checked by IsAckPayload()
+        m_version = start.ReadU8();
+        m_zoneId = start.ReadNtohU16();
+        m_entries.resize(start.ReadNtohU16());
+        for (AckEntry& entry : m_entries)
+        {
+            entry.sensorId = start.ReadNtohU32();
+            entry.cumulative = start.ReadNtohU32();
+            entry.bitmap = start.ReadNtohU32();
+        }
+        return GetSerializedSize();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "ack v=" << static_cast<uint32_t>(m_version) << " zone=" << m_zoneId
+           << " entries=" << m_entries.size();
+    }
+
+    /**
+     * Check whether a packet starts with an ACK header
+     * @param packet Received packet
+     * @return true if the first byte is the ACK magic
+     */
+    static bool IsAckPayload(Ptr<const Packet> packet)
+    {
+        uint8_t first = 0;
+        return packet->GetSize() >= PREFIX_SIZE && packet->CopyData(&first, 1) == 1 &&
+               first == MAGIC;
+    }
+
+    /**
+     * Look up the entry of one sensor without deserializing the others
+     * (binary search over the sorted entries, on a stack copy of the payload)
+     * @param packet Received ACK datagram
+     * @param sensorId Sensor to look for
+     * @param entry Its entry, if found
+     * @return false if the datagram has no entry for the sensor
+     */
+    static bool FindEntry(Ptr<const Packet> packet, uint32_t sensorId, AckEntry& entry)
+    {
+        std::array<uint8_t, MAX_SIZE> data;
+        uint32_t size = packet->CopyData(data.data(), data.size());
+        if (size < PREFIX_SIZE || data[0] != MAGIC)
+        {
+            return false;
+        }
+        uint32_t count = batchcodec::ReadBigEndian(data.data() + 4, 2);
+        count = std::min(count, (size - PREFIX_SIZE) / ENTRY_SIZE);
+        uint32_t low = 0;
+        uint32_t high = count;
+        while (low < high)
+        {
+            uint32_t mid = (low + high) / 2;
+            const uint8_t* at = data.data() + PREFIX_SIZE + mid * ENTRY_SIZE;
+            uint32_t id = batchcodec::ReadBigEndian(at, 4);
+            if (id == sensorId)
+            {
+                entry.sensorId = id;
+                entry.cumulative = batchcodec::ReadBigEndian(at + 4, 4);
+                entry.bitmap = batchcodec::ReadBigEndian(at + 8, 4);
+                return true;
+            }
+            if (id < sensorId)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return false;
+    }
+
+    void SetZoneId(uint16_t zoneId)
+    {
+        m_zoneId = zoneId;
+    }
+
+    uint16_t GetZoneId(void) const
+    {
+        return m_zoneId;
+    }
+
+    /** @return Entries, to fill before serializing (at most MAX_ENTRIES, sorted by sensor) */
+    std::vector<AckEntry>& GetEntries(void)
+    {
+        return m_entries;
+    }
+
+    const std::vector<AckEntry>& GetEntries(void) const
+    {
+        return m_entries;
+    }
+
+  private:
+    uint8_t m_version;
+    uint16_t m_zoneId;
+    std::vector<AckEntry> m_entries;
+};
+
+/**
+ * Sender side: the datagrams of one sensor that wait for an acknowledgment
+ */
+class RetransmitWindow
+{
+  public:
+    static const uint32_t WINDOW = 32; // Width of the ACK bitmap
+
+    RetransmitWindow()
+        : m_nextSequence(1)
+    {
+    }
+
+    /**
+     * @param config Retransmission timeout and retry limit
+     * @param stats Counters shared by all senders and receivers (null = off)
+     */
+    void SetConfig(const ReliabilityConfig& config, Ptr<ReliabilityStats> stats)
+    {
+        m_config = config;
+        m_stats = stats;
+    }
+
+    /**
+     * Start tracking a datagram, abandoning the oldest one if the window is full
+     * @param packet Datagram without its sequence header
+     * @return Sequence number assigned to it
+     */
+    uint32_t Push(Ptr<Packet> packet)
+    {
+        uint32_t sequence = m_nextSequence++;
+        Slot& slot = m_slots[sequence % WINDOW];
+        if (slot.packet)
+        {
+            Abandon(slot);
+        }
+        slot.packet = packet;
+        slot.sequence = sequence;
+        slot.attempts = 0;
+        slot.deadline = Simulator::Now() + m_config.retransmitTimeout;
+        if (m_stats)
+        {
+            m_stats->datagramsSent++;
+        }
+        return sequence;
+    }
+
+    /**
+     * Release the datagrams an ACK entry covers
+     * @param entry Entry of this sensor
+     */
+    void Acknowledge(const AckEntry& entry)
+    {
+        for (Slot& slot : m_slots)
+        {
+            if (!slot.packet)
+            {
+                continue;
+            }
+            uint32_t offset = slot.sequence - entry.cumulative - 1; // Wraps when covered
+            if (slot.sequence <= entry.cumulative ||
+                (offset < WINDOW && (entry.bitmap >> offset) & 1))
+            {
+                slot.packet = nullptr;
+                if (m_stats)
+                {
+                    m_stats->acknowledged++;
+                }
+            }
+        }
+    }
+
+    /**
+     * Take the next datagram whose timeout expired, abandoning those out of retries
+     * @param sequence Its sequence number
+     * @return Datagram to send again, null when none is due
+     */
+    Ptr<Packet> NextRetransmission(uint32_t& sequence)
+    {
+        Time now = Simulator::Now();
+        for (Slot& slot : m_slots)
+        {
+            if (!slot.packet || slot.deadline > now)
+            {
+                continue;
+            }
+            if (slot.attempts >= m_config.maxRetries)
+            {
+                Abandon(slot);
+                continue;
+            }
+            slot.attempts++;
+            // Exponential backoff: the timeout doubles at each attempt
+            slot.deadline = now + m_config.retransmitTimeout * (int64_t(1) << slot.attempts);
+            if (m_stats)
+            {
+                m_stats->retransmissions++;
+            }
+            sequence = slot.sequence;
+            return slot.packet;
+        }
+        return nullptr;
+    }
+
+    /** @return Earliest timeout of the pending datagrams (Time::Max() if none) */
+    Time GetNextDeadline(void) const
+    {
+        Time next = Time::Max();
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.packet)
+            {
+                next = std::min(next, slot.deadline);
+            }
+        }
+        return next;
+    }
+
+  private:
+    struct Slot
+    {
+        Ptr<Packet> packet; // Null when free
+        uint32_t sequence = 0;
+        uint32_t attempts = 0; // Retransmissions so far
+        Time deadline;
+    };
+
+    void Abandon(Slot& slot)
+    {
+        slot.packet = nullptr;
+        if (m_stats)
+        {
+            m_stats->abandoned++;
+        }
+    }
+
+    ReliabilityConfig m_config;
+    Ptr<ReliabilityStats> m_stats;
+    std::array<Slot, WINDOW> m_slots; // Indexed by sequence % WINDOW
+    uint32_t m_nextSequence;
+};
+
+/**
+ * Receiver side: duplicate detection and batched ACKs for the sensors of
+ * one zone (or of the single-tier network)
+ */
+class AckBatcher
+{
+  public:
+    AckBatcher()
+        : m_zoneId(0),
+          m_firstSensorId(0)
+    {
+    }
+
+    /**
+     * @param socket Socket the ACKs are sent from (broadcast allowed)
+     * @param destination Broadcast address and ACK port of the sensor subnet
+     * @param zoneId Zone carried in the ACKs (0 in the single-tier network)
+     * @param config ACK delay
+     * @param stats Counters shared by all senders and receivers (null = off)
+     */
+    void Setup(Ptr<Socket> socket,
+               Address destination,
+               uint32_t zoneId,
+               const ReliabilityConfig& config,
+               Ptr<ReliabilityStats> stats)
+    {
+        m_socket = socket;
+        m_destination = destination;
+        m_zoneId = zoneId;
+        m_config = config;
+        m_stats = stats;
+    }
+
+    /** @return true once Setup() gave the batcher a socket */
+    bool IsEnabled(void) const
+    {
+        return bool(m_socket);
+    }
+
+    /**
+     * Size the state of the sensors this receiver hears, so a zone AP holds
+     * its own zone rather than the whole fleet. Call before the first
+     * Accept(): the table never grows, and datagrams from IDs outside the
+     * range are dropped and counted.
+     * @param firstSensorId Lowest expected sensor ID
+     * @param nSensors Number of sensors, with consecutive IDs from firstSensorId
+     */
+    void Reserve(uint32_t firstSensorId, uint32_t nSensors)
+    {
+        m_firstSensorId = firstSensorId;
+        m_sensors.assign(nSensors, SensorState());
+        m_pending.reserve(nSensors);
+        m_ack.GetEntries().reserve(CO2AckHeader::MAX_ENTRIES);
+    }
+
+    void Start(void)
+    {
+        m_socket->SetAllowBroadcast(true);
+        m_socket->Bind();
+        m_socket->Connect(m_destination);
+    }
+
+    /** Send what is pending, then close the socket */
+    void Stop(void)
+    {
+        Flush();
+        m_socket->Close();
+    }
+
+    /**
+     * Strip the sequence header of a received datagram and note it for the next ACK
+     * @param packet Sequenced datagram, readings only on return
+     * @return false if it is a duplicate or from a sensor outside the reserved
+     *         range, to be dropped
+     */
+    bool Accept(Ptr<Packet> packet)
+    {
+        CO2SequenceHeader header;
+        packet->RemoveHeader(header);
+        uint32_t sensorId = header.GetSensorId();
+        // The ID comes off the wire: never let it size the table
+        if (sensorId < m_firstSensorId || sensorId - m_firstSensorId >= m_sensors.size())
+        {
+            if (m_stats)
+            {
+                m_stats->outOfRange++;
+            }
+            return false;
+        }
+        SensorState& state = m_sensors[sensorId - m_firstSensorId];
+        // Duplicates are acknowledged again: the ACK that covered them may have been lost
+        if (!state.pending)
+        {
+            state.pending = true;
+            m_pending.push_back(sensorId);
+        }
+        if (!m_flushEvent.IsPending())
+        {
+            m_flushEvent = Simulator::Schedule(m_config.ackDelay, &AckBatcher::Flush, this);
+        }
+
+        bool fresh = Mark(state, header.GetSequence());
+        if (m_stats)
+        {
+            if (fresh)
+            {
+                m_stats->datagramsAccepted++;
+                m_stats->bytesAccepted += packet->GetSize();
+            }
+            else
+            {
+                m_stats->duplicates++;
+            }
+        }
+        return fresh;
+    }
+
+  private:
+    struct SensorState
+    {
+        uint32_t cumulative = 0;
+        uint32_t bitmap = 0;  // Bit i: cumulative + 1 + i was received
+        bool pending = false; // Owes this sensor an ACK entry
+    };
+
+    static bool Mark(SensorState& state, uint32_t sequence)
+    {
+        const uint32_t window = RetransmitWindow::WINDOW;
+        if (sequence <= state.cumulative)
+        {
+            return false;
+        }
+        if (sequence > state.cumulative + window)
+        {
+            // The sender abandoned what is missing below its window
+            uint32_t shift = sequence - state.cumulative - window;
+            state.bitmap = shift < window ? state.bitmap >> shift : 0;
+            state.cumulative += shift;
+        }
+        uint32_t bit = sequence - state.cumulative - 1;
+        if ((state.bitmap >> bit) & 1)
+        {
+            return false;
+        }
+        state.bitmap |= uint32_t(1) << bit;
+        while (state.bitmap & 1)
+        {
+            state.cumulative++;
+            state.bitmap >>= 1;
+        }
+        return true;
+    }
+
+    void Flush(void)
+    {
+        if (m_flushEvent.IsPending())
+        {
+            Simulator::Cancel(m_flushEvent);
+        }
+        if (m_pending.empty())
+        {
+            return;
+        }
+        // Sorted, so every sensor can binary-search for its entry
+        std::sort(m_pending.begin(), m_pending.end());
+        std::vector<AckEntry>& entries = m_ack.GetEntries();
+        m_ack.SetZoneId(m_zoneId);
+        for (size_t i = 0; i < m_pending.size(); ++i)
+        {
+            SensorState& state = m_sensors[m_pending[i] - m_firstSensorId];
+            state.pending = false;
+            AckEntry entry;
+            entry.sensorId = m_pending[i];
+            entry.cumulative = state.cumulative;
+            entry.bitmap = state.bitmap;
+            entries.push_back(entry);
+            if (entries.size() == CO2AckHeader::MAX_ENTRIES || i + 1 == m_pending.size())
+            {
+                SendAck();
+            }
+        }
+        m_pending.clear();
+    }
+
+    void SendAck(void)
+    {
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(m_ack);
+        uint32_t size = packet->GetSize();
+        uint32_t entries = m_ack.GetEntries().size();
+        m_ack.GetEntries().clear();
+        if (m_socket->Send(packet) > 0 && m_stats)
+        {
+            m_stats->ackDatagrams++;
+            m_stats->ackBytes += size;
+            m_stats->ackEntries += entries;
+        }
+    }
+
+    Ptr<Socket> m_socket; // Null unless --reliable is set
+    Address m_destination;
+    uint32_t m_zoneId;
+    ReliabilityConfig m_config;
+    Ptr<ReliabilityStats> m_stats;
+    uint32_t m_firstSensorId;
+    std::vector<SensorState> m_sensors; // Indexed by sensor ID - m_firstSensorId
+    std::vector<uint32_t> m_pending;    // Sensors owed an entry in the next ACK
+    CO2AckHeader m_ack;                 // Entries of the ACK being built
+    EventId m_flushEvent;
+};
+
+} // namespace ns3
+
+#endif /* RELIABLE_DELIVERY_H */
@@ -0,0 +1,139 @@
+/*
+ * Run Profiler
+ *
+ * Wall-clock cost of the phases of a scenario's main() (topology
+ * construction, addressing, application setup, Simulator::Run, post-run
+ * statistics and output), plus the process' peak resident set size. Phases
+ * are consecutive laps: EndPhase("x") closes phase "x", which started at the
+ * previous EndPhase() or at construction.
+ *
+ * The results go into the run's summary.json (see run-summary.h) as
+ * <phase>Seconds metrics, so parameter sweeps aggregate them like any other
+ * metric.
+ */
+
+#ifndef RUN_PROFILER_H
+#define RUN_PROFILER_H
+
+#include "run-summary.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class RunProfiler
+{
+  public:
+    RunProfiler()
+        : m_start(Clock::now()),
+          m_lap(m_start)
+    {
+    }
+
+    /**
+     * Close the current phase
+     * @param name Phase name (a metric key prefix, e.g. "topology")
+     * @return Seconds spent in the phase
+     */
+    double EndPhase(const std::string& name)
+    {
+        Clock::time_point now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - m_lap).count();
+        m_lap = now;
+        m_phases.emplace_back(name, seconds);
+        return seconds;
+    }
+
+    /**
+     * @param name Phase name
+     * @return Seconds spent in the phase (0 if it was never closed)
+     */
+    double GetPhaseSeconds(const std::string& name) const
+    {
+        for (const auto& phase : m_phases)
+        {
+            if (phase.first == name)
+            {
+                return phase.second;
+            }
+        }
+        return 0.0;
+    }
+
+    /** @return Seconds from construction to the last EndPhase() */
+    double GetTotalSeconds(void) const
+    {
+        return std::chrono::duration<double>(m_lap - m_start).count();
+    }
+
+    /** @return Peak resident set size of this process so far (KiB, 0 if unknown) */
+    static uint64_t GetPeakRssKb(void)
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024; // Bytes on macOS
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+    }
+
+    /**
+     * Print one line per phase with its share of the total
+     * @param os Output stream
+     */
+    void Print(std::ostream& os) const
+    {
+        double total = GetTotalSeconds();
+        std::ios::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+        os << std::fixed << std::setprecision(3);
+        for (const auto& phase : m_phases)
+        {
+            os << "  " << std::left << std::setw(14) << phase.first << std::right
+               << std::setw(10) << phase.second << " s (" << std::setprecision(1)
+               << (total > 0 ? phase.second / total * 100.0 : 0.0) << "%)\n"
+               << std::setprecision(3);
+        }
+        os << "  " << std::left << std::setw(14) << "total" << std::right << std::setw(10)
+           << total << " s\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    /**
+     * Add <phase>Seconds and totalSeconds metrics
+     * @param summary Run summary
+     */
+    void AddMetrics(RunSummary& summary) const
+    {
+        for (const auto& phase : m_phases)
+        {
+            summary.AddMetric(phase.first + "Seconds", phase.second);
+        }
+        summary.AddMetric("totalSeconds", GetTotalSeconds());
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point m_start;
+    Clock::time_point m_lap; // End of the last closed phase
+    std::vector<std::pair<std::string, double>> m_phases;
+};
+
+} // namespace ns3
+
+#endif /* RUN_PROFILER_H */
@@ -0,0 +1,156 @@
+/*
+ * Run Summary
+ *
+ * Machine-readable result file of one scenario run (<outputPrefix>summary.json),
+ * so parameter sweeps (tools/run_sweep.py) can merge replications without
+ * scraping stdout. The file holds the scenario name, the configuration the
+ * run was started with and its scalar metrics:
+ *
+ *   {"scenario": "...", "config": {"nSensors": 10, ...}, "metrics": {"deliveryRatio": 99.5, ...}}
+ *
+ * Keys keep their insertion order. Non-finite numbers are written as null.
+ */
+
+#ifndef RUN_SUMMARY_H
+#define RUN_SUMMARY_H
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class RunSummary
+{
+  public:
+    explicit RunSummary(const std::string& scenario)
+        : m_scenario(scenario)
+    {
+    }
+
+    /**
+     * Record a configuration value
+     * @param key Parameter name (the command-line flag)
+     * @param value Number, bool or string
+     */
+    template <typename T>
+    void AddConfig(const std::string& key, const T& value)
+    {
+        m_config.emplace_back(key, Encode(value));
+    }
+
+    /**
+     * Record a result
+     * @param key Metric name
+     * @param value Number
+     */
+    template <typename T>
+    void AddMetric(const std::string& key, const T& value)
+    {
+        m_metrics.emplace_back(key, Encode(value));
+    }
+
+    /**
+     * Write the summary as JSON
+     * @param path Output file
+     * @return false if the file could not be written
+     */
+    bool Write(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out.is_open())
+        {
+            return false;
+        }
+        out << "{\n  \"scenario\": " << Quote(m_scenario) << ",\n";
+        WriteSection(out, "config", m_config);
+        out << ",\n";
+        WriteSection(out, "metrics", m_metrics);
+        out << "\n}\n";
+        return out.good();
+    }
+
+  private:
+    typedef std::vector<std::pair<std::string, std::string>> Section; // Key -> encoded value
+
+    static std::string Encode(const std::string& value)
+    {
+        return Quote(value);
+    }
+
+    static std::string Encode(const char* value)
+    {
+        return Quote(value);
+    }
+
+    static std::string Encode(bool value)
+    {
+        return value ? "true" : "false";
+    }
+
+    template <typename T>
+    static std::string Encode(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "RunSummary values must be numbers or strings");
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (!std::isfinite(value))
+            {
+                return "null";
+            }
+        }
+        std::ostringstream oss;
+        oss.precision(17);
+        oss << value;
+        return oss.str();
+    }
+
+    static std::string Quote(const std::string& text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+                quoted += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                quoted += escape;
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+        return quoted + "\"";
+    }
+
+    static void WriteSection(std::ostream& out, const char* name, const Section& section)
+    {
+        out << "  \"" << name << "\": {";
+        for (std::size_t i = 0; i < section.size(); ++i)
+        {
+            out << (i == 0 ? "\n" : ",\n") << "    " << Quote(section[i].first) << ": "
+                << section[i].second;
+        }
+        out << (section.empty() ? "}" : "\n  }");
+    }
+
+    std::string m_scenario;
+    Section m_config;
+    Section m_metrics;
+};
+
+} // namespace ns3
+
+#endif /* RUN_SUMMARY_H */
@@ -0,0 +1,266 @@
+/*
+ * Sensor Tick Scheduler
+ *
+ * Shared periodic scheduler for large sensor fleets. Without it, every
+ * CO2SensorApplication keeps its own pending Simulator event, so the event
+ * queue holds one entry per sensor. The tick scheduler groups sensors into
+ * buckets by (period, phase) and keeps a single pending event per bucket;
+ * when it fires, every sensor due in that slot is ticked in turn.
+ *
+ * Phases are quantized to the scheduler resolution: sensor-specific offsets
+ * coarser than the resolution (such as the staggered start times) are kept
+ * exactly, finer ones are rounded down to the slot start.
+ */
+
+#ifndef SENSOR_TICK_SCHEDULER_H
+#define SENSOR_TICK_SCHEDULER_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class SensorTickScheduler : public Object
+{
+  public:
+    /**
+     * Identifies a registration so that it can be removed again
+     */
+    struct Handle
+    {
+        uint32_t bucket = UINT32_MAX;
+        uint32_t slot = UINT32_MAX;
+
+        bool IsValid(void) const
+        {
+            return bucket != UINT32_MAX;
+        }
+    };
+
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid = TypeId("ns3::SensorTickScheduler")
+                                .SetParent<Object>()
+                                .SetGroupName("EcoLedger")
+                                .AddConstructor<SensorTickScheduler>()
+                                .AddAttribute("Resolution",
+                                              "Width of a phase slot; sensors in one slot share an event",
+                                              TimeValue(MilliSeconds(1)),
+                                              MakeTimeAccessor(&SensorTickScheduler::m_resolution),
+                                              MakeTimeChecker());
+        return tid;
+    }
+
+    SensorTickScheduler()
+        : m_ticksFired(0),
+          m_callbacksInvoked(0),
+          m_activeMembers(0),
+          m_pendingEvents(0),
+          m_peakPendingEvents(0)
+    {
+    }
+
+    /**
+     * Register a periodic callback
+     * @param period Tick period
+     * @param firstTick Earliest time of the first tick (must not be in the past)
+     * @param callback Invoked once per period from then on
+     * @return Handle for Unregister()
+     */
+    Handle Register(Time period, Time firstTick, Callback<void> callback)
+    {
+        NS_ASSERT_MSG(period.IsStrictlyPositive(), "Tick period must be positive");
+
+        int64_t resolution = std::max<int64_t>(m_resolution.GetTimeStep(), 1);
+        int64_t phase = firstTick.GetTimeStep() % period.GetTimeStep();
+        phase -= phase % resolution;
+        std::pair<int64_t, int64_t> key(period.GetTimeStep(), phase);
+
+        auto it = m_bucketIndex.find(key);
+        if (it == m_bucketIndex.end())
+        {
+            it = m_bucketIndex.emplace(key, static_cast<uint32_t>(m_buckets.size())).first;
+            m_buckets.emplace_back();
+            m_buckets.back().period = period;
+            m_buckets.back().phase = TimeStep(phase);
+        }
+
+        Handle handle;
+        handle.bucket = it->second;
+        Bucket& bucket = m_buckets[handle.bucket];
+
+        Member member;
+        member.callback = callback;
+        member.firstDue = firstTick - TimeStep(firstTick.GetTimeStep() % resolution);
+        member.active = true;
+        if (!bucket.freeSlots.empty())
+        {
+            handle.slot = bucket.freeSlots.back();
+            bucket.freeSlots.pop_back();
+            bucket.members[handle.slot] = member;
+        }
+        else
+        {
+            handle.slot = static_cast<uint32_t>(bucket.members.size());
+            bucket.members.push_back(member);
+        }
+        bucket.activeCount++;
+        m_activeMembers++;
+
+        if (!bucket.event.IsPending())
+        {
+            ScheduleBucket(handle.bucket, member.firstDue);
+        }
+        return handle;
+    }
+
+    /**
+     * Stop ticking a registered callback
+     * @param handle Handle returned by Register() (invalidated on return)
+     */
+    void Unregister(Handle& handle)
+    {
+        if (!handle.IsValid())
+        {
+            return;
+        }
+        Bucket& bucket = m_buckets[handle.bucket];
+        Member& member = bucket.members[handle.slot];
+        if (member.active)
+        {
+            member.active = false;
+            member.callback = Callback<void>();
+            bucket.freeSlots.push_back(handle.slot);
+            bucket.activeCount--;
+            m_activeMembers--;
+            if (bucket.activeCount == 0 && bucket.event.IsPending())
+            {
+                Simulator::Cancel(bucket.event);
+                m_pendingEvents--;
+            }
+        }
+        handle = Handle();
+    }
+
+    /** @return Number of (period, phase) buckets created so far */
+    uint32_t GetBucketCount(void) const
+    {
+        return static_cast<uint32_t>(m_buckets.size());
+    }
+
+    /** @return Number of callbacks currently registered */
+    uint32_t GetActiveMembers(void) const
+    {
+        return m_activeMembers;
+    }
+
+    /** @return Number of bucket events executed */
+    uint64_t GetTicksFired(void) const
+    {
+        return m_ticksFired;
+    }
+
+    /** @return Number of sensor callbacks driven by those events */
+    uint64_t GetCallbacksInvoked(void) const
+    {
+        return m_callbacksInvoked;
+    }
+
+    /** @return Largest number of bucket events pending at once */
+    uint32_t GetPeakPendingEvents(void) const
+    {
+        return m_peakPendingEvents;
+    }
+
+  private:
+    struct Member
+    {
+        Callback<void> callback;
+        Time firstDue; // Member is skipped by ticks before this time
+        bool active = false;
+    };
+
+    struct Bucket
+    {
+        Time period;
+        Time phase;
+        std::vector<Member> members;
+        std::vector<uint32_t> freeSlots; // Slots of unregistered members, reused first
+        uint32_t activeCount = 0;
+        EventId event;
+    };
+
+    void ScheduleBucket(uint32_t index, Time earliest)
+    {
+        Bucket& bucket = m_buckets[index];
+        // Next slot time >= earliest with the bucket's phase
+        int64_t period = bucket.period.GetTimeStep();
+        int64_t t = earliest.GetTimeStep();
+        int64_t next = t - (t % period) + bucket.phase.GetTimeStep();
+        if (next < t)
+        {
+            next += period;
+        }
+        bucket.event = Simulator::Schedule(TimeStep(next) - Simulator::Now(),
+                                           &SensorTickScheduler::Fire,
+                                           this,
+                                           index);
+        m_pendingEvents++;
+        m_peakPendingEvents = std::max(m_peakPendingEvents, m_pendingEvents);
+    }
+
+    void Fire(uint32_t index)
+    {
+        m_pendingEvents--;
+        m_ticksFired++;
+        Time now = Simulator::Now();
+
+        // Index-based loop: callbacks may register or unregister members
+        for (uint32_t slot = 0; slot < m_buckets[index].members.size(); ++slot)
+        {
+            Member& member = m_buckets[index].members[slot];
+            if (member.active && member.firstDue <= now)
+            {
+                Callback<void> callback = member.callback;
+                m_callbacksInvoked++;
+                callback();
+            }
+        }
+
+        Bucket& bucket = m_buckets[index];
+        if (bucket.activeCount > 0 && !bucket.event.IsPending())
+        {
+            ScheduleBucket(index, now + TimeStep(1));
+        }
+    }
+
+    void DoDispose(void) override
+    {
+        for (Bucket& bucket : m_buckets)
+        {
+            Simulator::Cancel(bucket.event);
+        }
+        m_buckets.clear();
+        m_bucketIndex.clear();
+        Object::DoDispose();
+    }
+
+    Time m_resolution;
+    std::vector<Bucket> m_buckets;
+    std::map<std::pair<int64_t, int64_t>, uint32_t> m_bucketIndex; // (period, phase) -> bucket
+    uint64_t m_ticksFired;
+    uint64_t m_callbacksInvoked;
+    uint32_t m_activeMembers;
+    uint32_t m_pendingEvents;
+    uint32_t m_peakPendingEvents;
+};
+
+} // namespace ns3
+
+#endif /* SENSOR_TICK_SCHEDULER_H */
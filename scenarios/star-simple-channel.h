@@ -0,0 +1,301 @@
+/*
+ * Star Simple Channel
+ *
+ * Abstract link model for application-tier scale tests (--linkModel=abstract).
+ * It replaces the 802.11 PHY/MAC with SimpleNetDevices on a star: one hub
+ * (the gateway or a zone's Local AP) and any number of leaves (sensors).
+ * A frame costs one scheduled event, after a fixed delay, with a fixed loss
+ * probability. The rate limit is the DataRate of the SimpleNetDevices.
+ *
+ * Leaves only reach the hub. The hub reaches leaves by MAC address through
+ * an index, so a unicast frame never visits the other devices. Stock
+ * SimpleChannel delivers every frame to every device. ARP broadcasts would
+ * still fan out, so PopulateStarArpCaches() fills the caches up front.
+ */
+
+#ifndef STAR_SIMPLE_CHANNEL_H
+#define STAR_SIMPLE_CHANNEL_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+class StarSimpleChannel : public SimpleChannel
+{
+  public:
+    static TypeId GetTypeId(void)
+    {
+        static TypeId tid =
+            TypeId("ns3::StarSimpleChannel")
+                .SetParent<SimpleChannel>()
+                .SetGroupName("EcoLedger")
+                .AddConstructor<StarSimpleChannel>()
+                .AddAttribute("LinkDelay",
+                              "One-way delay of every frame (replaces SimpleChannel's Delay)",
+                              TimeValue(MilliSeconds(1)),
+                              MakeTimeAccessor(&StarSimpleChannel::m_linkDelay),
+                              MakeTimeChecker())
+                .AddAttribute("LossRate",
+                              "Probability that a frame is lost",
+                              DoubleValue(0.0),
+                              MakeDoubleAccessor(&StarSimpleChannel::m_lossRate),
+                              MakeDoubleChecker<double>(0.0, 1.0));
+        return tid;
+    }
+
+    StarSimpleChannel()
+        : m_lossRate(0.0),
+          m_framesDropped(0)
+    {
+        m_loss = CreateObject<UniformRandomVariable>();
+    }
+
+    /**
+     * Select the hub; every other device attached to the channel is a leaf
+     * @param hub Device of the gateway or Local AP
+     */
+    void SetHub(Ptr<SimpleNetDevice> hub)
+    {
+        m_hub = hub;
+    }
+
+    void Add(Ptr<SimpleNetDevice> device) override
+    {
+        SimpleChannel::Add(device);
+        m_byAddress[Mac48Address::ConvertFrom(device->GetAddress())] = device;
+    }
+
+    void Send(Ptr<Packet> p,
+              uint16_t protocol,
+              Mac48Address to,
+              Mac48Address from,
+              Ptr<SimpleNetDevice> sender) override
+    {
+        NS_ASSERT_MSG(m_hub, "StarSimpleChannel has no hub");
+        if (m_lossRate > 0.0 && m_loss->GetValue() < m_lossRate)
+        {
+            m_framesDropped++;
+            return;
+        }
+
+        if (sender != m_hub)
+        {
+            // Leaves never hear each other
+            Deliver(m_hub, p, protocol, to, from);
+            return;
+        }
+
+        if (to.IsBroadcast() || to.IsGroup())
+        {
+            for (const auto& entry : m_byAddress)
+            {
+                if (entry.second != m_hub)
+                {
+                    Deliver(entry.second, p, protocol, to, from);
+                }
+            }
+            return;
+        }
+
+        auto it = m_byAddress.find(to);
+        if (it != m_byAddress.end())
+        {
+            Deliver(it->second, p, protocol, to, from);
+        }
+    }
+
+    /** @return Number of frames dropped by the loss model */
+    uint64_t GetFramesDropped(void) const
+    {
+        return m_framesDropped;
+    }
+
+    /**
+     * Use a fixed RNG stream for the loss model
+     * @param stream First stream index
+     * @return Number of streams used (1)
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        m_loss->SetStream(stream);
+        return 1;
+    }
+
+  private:
+    void Deliver(Ptr<SimpleNetDevice> device,
+                 Ptr<Packet> p,
+                 uint16_t protocol,
+                 Mac48Address to,
+                 Mac48Address from)
+    {
+        Simulator::ScheduleWithContext(device->GetNode()->GetId(),
+                                       m_linkDelay,
+                                       &SimpleNetDevice::Receive,
+                                       device,
+                                       p->Copy(),
+                                       protocol,
+                                       to,
+                                       from);
+    }
+
+    void DoDispose(void) override
+    {
+        m_hub = nullptr;
+        m_byAddress.clear();
+        SimpleChannel::DoDispose();
+    }
+
+    Time m_linkDelay;
+    double m_lossRate;
+    Ptr<UniformRandomVariable> m_loss;
+    Ptr<SimpleNetDevice> m_hub;
+    std::map<Mac48Address, Ptr<SimpleNetDevice>> m_byAddress; // Every device, hub included
+    uint64_t m_framesDropped;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(StarSimpleChannel);
+
+/**
+ * Builds one star of SimpleNetDevices per Install() call
+ */
+class StarLinkHelper
+{
+  public:
+    StarLinkHelper()
+        : m_dataRate("1Mbps"),
+          m_delay(MilliSeconds(1)),
+          m_lossRate(0.0),
+          m_stream(-1)
+    {
+    }
+
+    /** @param rate Device data rate (serializes each device's transmissions) */
+    void SetDataRate(DataRate rate)
+    {
+        m_dataRate = rate;
+    }
+
+    /** @param delay One-way frame delay */
+    void SetDelay(Time delay)
+    {
+        m_delay = delay;
+    }
+
+    /** @param lossRate Frame loss probability */
+    void SetLossRate(double lossRate)
+    {
+        m_lossRate = lossRate;
+    }
+
+    /**
+     * Use fixed RNG streams for the loss models of the stars created from now on
+     * @param stream First stream index (one stream per star)
+     */
+    void AssignStreams(int64_t stream)
+    {
+        m_stream = stream;
+    }
+
+    /**
+     * @return First stream index not used by the stars installed so far (0 if
+     *         streams are unassigned), where the scenario's other RNGs start
+     */
+    int64_t GetNextStream(void) const
+    {
+        return std::max<int64_t>(m_stream, 0);
+    }
+
+    /**
+     * Connect leaves to a hub over a new StarSimpleChannel
+     * @param leaves Sensor nodes
+     * @param hub Gateway or Local AP node
+     * @return Leaf devices in node order, followed by the hub device
+     */
+    NetDeviceContainer Install(const NodeContainer& leaves, Ptr<Node> hub)
+    {
+        Ptr<StarSimpleChannel> channel = CreateObject<StarSimpleChannel>();
+        channel->SetAttribute("LinkDelay", TimeValue(m_delay));
+        channel->SetAttribute("LossRate", DoubleValue(m_lossRate));
+        if (m_stream >= 0)
+        {
+            m_stream += channel->AssignStreams(m_stream);
+        }
+        m_channels.push_back(channel);
+
+        SimpleNetDeviceHelper devices;
+        devices.SetDeviceAttribute("DataRate", DataRateValue(m_dataRate));
+        NetDeviceContainer installed = devices.Install(leaves, channel);
+        NetDeviceContainer hubDevice = devices.Install(hub, channel);
+        channel->SetHub(DynamicCast<SimpleNetDevice>(hubDevice.Get(0)));
+        installed.Add(hubDevice);
+        return installed;
+    }
+
+    /** @return Total frames dropped by the loss models of all stars */
+    uint64_t GetFramesDropped(void) const
+    {
+        uint64_t dropped = 0;
+        for (const Ptr<StarSimpleChannel>& channel : m_channels)
+        {
+            dropped += channel->GetFramesDropped();
+        }
+        return dropped;
+    }
+
+  private:
+    DataRate m_dataRate;
+    Time m_delay;
+    double m_lossRate;
+    int64_t m_stream; // Next stream to assign, -1 = leave the RNG streams unassigned
+    std::vector<Ptr<StarSimpleChannel>> m_channels;
+};
+
+/**
+ * Add permanent ARP entries between a hub and its leaves (after IP assignment)
+ * Unlike NeighborCacheHelper, which links every pair of devices on a channel,
+ * this adds only the hub<->leaf entries, so memory stays linear in the leaves.
+ * @param hub Hub device
+ * @param leaves Leaf devices
+ */
+inline void
+PopulateStarArpCaches(Ptr<NetDevice> hub, const NetDeviceContainer& leaves)
+{
+    auto lookup = [](Ptr<NetDevice> device, Ptr<ArpCache>& cache, Ipv4Address& address) {
+        Ptr<Ipv4L3Protocol> ipv4 = device->GetNode()->GetObject<Ipv4L3Protocol>();
+        int32_t interface = ipv4->GetInterfaceForDevice(device);
+        NS_ABORT_MSG_IF(interface < 0, "Device has no IPv4 interface");
+        cache = ipv4->GetInterface(interface)->GetArpCache();
+        address = ipv4->GetAddress(interface, 0).GetLocal();
+    };
+
+    Ptr<ArpCache> hubCache;
+    Ipv4Address hubAddress;
+    lookup(hub, hubCache, hubAddress);
+    for (uint32_t i = 0; i < leaves.GetN(); ++i)
+    {
+        Ptr<NetDevice> leaf = leaves.Get(i);
+        Ptr<ArpCache> leafCache;
+        Ipv4Address leafAddress;
+        lookup(leaf, leafCache, leafAddress);
+
+        ArpCache::Entry* toHub = leafCache->Add(hubAddress);
+        toHub->SetMacAddress(hub->GetAddress());
+        toHub->MarkAutoGenerated();
+
+        ArpCache::Entry* toLeaf = hubCache->Add(leafAddress);
+        toLeaf->SetMacAddress(leaf->GetAddress());
+        toLeaf->MarkAutoGenerated();
+    }
+}
+
+} // namespace ns3
+
+#endif /* STAR_SIMPLE_CHANNEL_H */
@@ -0,0 +1,146 @@
+/*
+ * Telemetry Stream
+ *
+ * Sends the rows of the windowed flow metrics (see flow-metrics-collector.h)
+ * to a UDP listener on the host as they are written, so a dashboard can
+ * follow a long run without waiting for, or re-reading, its files
+ * (--telemetryPort, --telemetryHost). This is a host socket, not an ns-3
+ * one: it leaves the simulated network alone.
+ *
+ * Each datagram carries whole CSV rows, newline-terminated and without the
+ * header line, packed up to MAX_DATAGRAM_SIZE bytes; a window takes one or
+ * more datagrams. Sends never block: a datagram the host cannot take right
+ * away (no buffer space) is dropped and counted, and nobody listening is
+ * not an error.
+ */
+
+#ifndef TELEMETRY_STREAM_H
+#define TELEMETRY_STREAM_H
+
+#include "run-summary.h"
+
+#include "ns3/core-module.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+class TelemetryStream : public SimpleRefCount<TelemetryStream>
+{
+  public:
+    static constexpr uint32_t MAX_DATAGRAM_SIZE = 1472; //!< Fits a 1500-byte MTU
+
+    /**
+     * Open the socket (aborts on a bad address or if no socket can be created)
+     * @param host IPv4 address of the listener
+     * @param port UDP port of the listener
+     */
+    TelemetryStream(const std::string& host, uint16_t port)
+        : m_size(0),
+          m_datagramsSent(0),
+          m_datagramsDropped(0)
+    {
+        std::memset(&m_peer, 0, sizeof(m_peer));
+        m_peer.sin_family = AF_INET;
+        m_peer.sin_port = htons(port);
+        NS_ABORT_MSG_IF(inet_pton(AF_INET, host.c_str(), &m_peer.sin_addr) != 1,
+                        "Telemetry host " << host << " is not an IPv4 address");
+        m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        NS_ABORT_MSG_IF(m_fd < 0, "Cannot create the telemetry socket: " << std::strerror(errno));
+    }
+
+    ~TelemetryStream()
+    {
+        Flush();
+        close(m_fd);
+    }
+
+    TelemetryStream(const TelemetryStream&) = delete;
+    TelemetryStream& operator=(const TelemetryStream&) = delete;
+
+    /**
+     * Queue one row, sending the pending datagram first if the row does not fit
+     * @param row Row text, newline included
+     * @param size Row length
+     */
+    void Append(const char* row, uint32_t size)
+    {
+        if (size > MAX_DATAGRAM_SIZE)
+        {
+            m_datagramsDropped++;
+            return;
+        }
+        if (m_size + size > MAX_DATAGRAM_SIZE)
+        {
+            Flush();
+        }
+        std::memcpy(m_buffer + m_size, row, size);
+        m_size += size;
+    }
+
+    /**
+     * Send the pending rows, if any
+     */
+    void Flush(void)
+    {
+        if (m_size == 0)
+        {
+            return;
+        }
+        ssize_t sent = sendto(m_fd,
+                              m_buffer,
+                              m_size,
+                              MSG_DONTWAIT,
+                              reinterpret_cast<const sockaddr*>(&m_peer),
+                              sizeof(m_peer));
+        if (sent == static_cast<ssize_t>(m_size))
+        {
+            m_datagramsSent++;
+        }
+        else
+        {
+            m_datagramsDropped++;
+        }
+        m_size = 0;
+    }
+
+    /**
+     * Add the stream counters to a run summary
+     * @param summary Run summary
+     */
+    void AddMetrics(RunSummary& summary) const
+    {
+        summary.AddMetric("telemetryDatagrams", m_datagramsSent);
+        summary.AddMetric("telemetryDropped", m_datagramsDropped);
+    }
+
+    uint64_t GetDatagramsSent(void) const
+    {
+        return m_datagramsSent;
+    }
+
+    uint64_t GetDatagramsDropped(void) const
+    {
+        return m_datagramsDropped;
+    }
+
+  private:
+    int m_fd;
+    sockaddr_in m_peer;
+    char m_buffer[MAX_DATAGRAM_SIZE];
+    uint32_t m_size; // Pending bytes in m_buffer
+    uint64_t m_datagramsSent;
+    uint64_t m_datagramsDropped;
+};
+
+} // namespace ns3
+
+#endif /* TELEMETRY_STREAM_H */
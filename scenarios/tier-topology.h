@@ -0,0 +1,626 @@
+/*
+ * Tier Topology
+ *
+ * Builds the node tree of a multi-tier sensor site from a tier spec such as
+ * "building:4,floor:3": the main gateway at the root, 4 buildings below it
+ * and 3 floors per building. Nodes of the last tier are the zone APs
+ * (leaves), each serving its sensors over a zone network the scenario
+ * builds; the tiers above them only route. A single tier ("zone:5") is the
+ * classic sensors -> local APs -> main gateway layout.
+ *
+ * Nodes are numbered by position: node j of tier t has parent j / fanOut(t)
+ * and covers the leaves [j * span(t), (j + 1) * span(t)). Addresses, routes
+ * and positions are computed from that instead of being formatted or looked
+ * up per node:
+ *
+ *   - zone networks are /24s in 10.0.0.0/8; fan-outs are padded to powers
+ *     of two in the address, so every subtree owns an aligned block that its
+ *     parent reaches with one route
+ *   - backbone links are /30s in 172.16.0.0/12 (p2p, one per node), or /24s
+ *     there (csma, one segment per parent and its children)
+ *   - Ipv4StaticRouting is the only routing protocol of the stack, and every
+ *     node gets a default route up the tree plus one block route per child
+ *   - a single ListPositionAllocator places the whole site
+ *
+ * With more than one main gateway the root only routes: the gateways hang
+ * off it on point-to-point links (/30s in 192.168.0.0/16, at the backbone
+ * rate and delay) and default to it.
+ *
+ * Zones are spread over MPI ranks in contiguous blocks; an aggregation node
+ * runs on the rank of its first zone, the root and the gateways on rank 0.
+ */
+
+#ifndef TIER_TOPOLOGY_H
+#define TIER_TOPOLOGY_H
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * One aggregation tier below the root
+ */
+struct TopologyTier
+{
+    std::string name; // e.g. "building", used in descriptions
+    uint32_t fanOut;  // Nodes of this tier per node of the tier above
+};
+
+/**
+ * Parse a tier spec ("name:fanOut,name:fanOut,...", top tier first)
+ * @param spec Spec from the command line
+ * @return Tiers (aborts on malformed specs)
+ */
+inline std::vector<TopologyTier>
+ParseTierSpec(const std::string& spec)
+{
+    std::vector<TopologyTier> tiers;
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        size_t colon = item.find(':');
+        NS_ABORT_MSG_IF(colon == std::string::npos || colon == 0,
+                        "Tier '" << item << "' is not name:fanOut");
+        char* end = nullptr;
+        unsigned long fanOut = std::strtoul(item.c_str() + colon + 1, &end, 10);
+        NS_ABORT_MSG_IF(end == item.c_str() + colon + 1 || *end != '\0' || fanOut == 0 ||
+                            fanOut > UINT16_MAX,
+                        "Invalid fan-out in tier '" << item << "'");
+        tiers.push_back({item.substr(0, colon), static_cast<uint32_t>(fanOut)});
+    }
+    NS_ABORT_MSG_IF(tiers.empty(), "The tier spec needs at least one tier");
+    return tiers;
+}
+
+class TierTopology
+{
+  public:
+    /**
+     * Lay out the tree (aborts if it does not fit the address plan)
+     * @param tiers Aggregation tiers, top first; the last one holds the zone APs
+     * @param sensorsPerLeaf Sensors of each zone (at most 253, the zone /24)
+     */
+    TierTopology(const std::vector<TopologyTier>& tiers, uint32_t sensorsPerLeaf)
+        : m_tiers(tiers),
+          m_sensorsPerLeaf(sensorsPerLeaf),
+          m_systemCount(1)
+    {
+        NS_ABORT_MSG_IF(tiers.empty(), "The topology needs at least one tier");
+        NS_ABORT_MSG_IF(sensorsPerLeaf == 0 || sensorsPerLeaf > 253,
+                        "Zones hold between 1 and 253 sensors");
+        uint32_t tierCount = tiers.size();
+        m_counts.resize(tierCount);
+        m_firstIndex.resize(tierCount);
+        m_shifts.resize(tierCount);
+        uint64_t count = 1;
+        uint32_t total = 0;
+        for (uint32_t t = 0; t < tierCount; ++t)
+        {
+            count *= tiers[t].fanOut;
+            NS_ABORT_MSG_IF(count > (1u << 20), "The topology has too many nodes");
+            m_counts[t] = count;
+            m_firstIndex[t] = total;
+            total += count;
+        }
+        m_nodeCount = total;
+
+        // Address code of a zone: the child index at every tier, each in its padded bit field
+        uint32_t bits = 0;
+        for (uint32_t t = tierCount; t-- > 0;)
+        {
+            m_shifts[t] = bits;
+            uint32_t width = 0;
+            while ((1u << width) < tiers[t].fanOut)
+            {
+                width++;
+            }
+            bits += width;
+        }
+        NS_ABORT_MSG_IF(bits > 15, "Too many zones for the 10.0.0.0/8 zone networks");
+        m_leafBase = 1u << std::max(bits, 8u);
+        m_uplinks.resize(tierCount);
+        for (uint32_t t = 0; t < tierCount; ++t)
+        {
+            m_uplinks[t].resize(m_counts[t]);
+        }
+    }
+
+    /** @return Number of aggregation tiers (the root excluded) */
+    uint32_t GetTierCount(void) const
+    {
+        return m_tiers.size();
+    }
+
+    /**
+     * @param tier Tier index (0 = below the root)
+     * @return Name and fan-out of the tier
+     */
+    const TopologyTier& GetTier(uint32_t tier) const
+    {
+        return m_tiers[tier];
+    }
+
+    /**
+     * @param tier Tier index
+     * @return Nodes in the tier
+     */
+    uint32_t GetNodeCount(uint32_t tier) const
+    {
+        return m_counts[tier];
+    }
+
+    /** @return Number of zones (nodes of the last tier) */
+    uint32_t GetLeafCount(void) const
+    {
+        return m_counts.back();
+    }
+
+    /** @return Sensors of each zone */
+    uint32_t GetSensorsPerLeaf(void) const
+    {
+        return m_sensorsPerLeaf;
+    }
+
+    /** @return Sensors of the whole site */
+    uint32_t GetSensorCount(void) const
+    {
+        return GetLeafCount() * m_sensorsPerLeaf;
+    }
+
+    /**
+     * @param tier Tier index
+     * @return Zones below each node of the tier
+     */
+    uint32_t GetLeafSpan(uint32_t tier) const
+    {
+        return GetLeafCount() / m_counts[tier];
+    }
+
+    /**
+     * Create the nodes: per zone its sensors then its AP, then the root, then
+     * the routing tiers top down, then the gateways if they are not the root
+     * @param systemCount MPI ranks the zones are spread over
+     * @param gatewayCount Main gateways (1 = the root itself)
+     */
+    void Create(uint32_t systemCount, uint32_t gatewayCount = 1)
+    {
+        NS_ABORT_MSG_IF(gatewayCount == 0, "The site needs a main gateway");
+        NS_ABORT_MSG_IF(gatewayCount > (1u << 14), "Too many gateway links for 192.168.0.0/16");
+        m_systemCount = systemCount;
+        m_nodes.resize(m_tiers.size());
+        uint32_t last = m_tiers.size() - 1;
+        for (uint32_t leaf = 0; leaf < GetLeafCount(); ++leaf)
+        {
+            uint32_t systemId = GetLeafSystemId(leaf);
+            m_sensors.Create(m_sensorsPerLeaf, systemId);
+            m_nodes[last].Create(1, systemId);
+        }
+        m_root.Create(1, 0);
+        for (uint32_t t = 0; t < last; ++t)
+        {
+            for (uint32_t j = 0; j < m_counts[t]; ++j)
+            {
+                m_nodes[t].Create(1, GetLeafSystemId(j * GetLeafSpan(t)));
+            }
+        }
+        if (gatewayCount > 1)
+        {
+            m_gateways.Create(gatewayCount, 0);
+        }
+    }
+
+    /**
+     * Rank that simulates a zone
+     * @param leaf Zone index (0-based)
+     * @return System ID of the zone's sensors and AP
+     */
+    uint32_t GetLeafSystemId(uint32_t leaf) const
+    {
+        return static_cast<uint32_t>(static_cast<uint64_t>(leaf) * m_systemCount / GetLeafCount());
+    }
+
+    /** @return The backbone root, also the main gateway unless there are several */
+    Ptr<Node> GetRoot(void) const
+    {
+        return m_root.Get(0);
+    }
+
+    /** @return Number of main gateways */
+    uint32_t GetGatewayCount(void) const
+    {
+        return std::max<uint32_t>(m_gateways.GetN(), 1);
+    }
+
+    /**
+     * @param gateway Gateway index
+     * @return Node of the main gateway
+     */
+    Ptr<Node> GetGateway(uint32_t gateway) const
+    {
+        return m_gateways.GetN() == 0 ? GetRoot() : m_gateways.Get(gateway);
+    }
+
+    /**
+     * @param tier Tier index
+     * @return Nodes of the tier, in index order
+     */
+    const NodeContainer& GetTierNodes(uint32_t tier) const
+    {
+        return m_nodes[tier];
+    }
+
+    /** @return Zone APs, in zone order */
+    const NodeContainer& GetLeaves(void) const
+    {
+        return m_nodes.back();
+    }
+
+    /** @return All sensors, zone by zone */
+    const NodeContainer& GetSensors(void) const
+    {
+        return m_sensors;
+    }
+
+    /**
+     * @param leaf Zone index
+     * @return Sensors of the zone
+     */
+    NodeContainer GetLeafSensors(uint32_t leaf) const
+    {
+        NodeContainer sensors;
+        for (uint32_t s = 0; s < m_sensorsPerLeaf; ++s)
+        {
+            sensors.Add(m_sensors.Get(leaf * m_sensorsPerLeaf + s));
+        }
+        return sensors;
+    }
+
+    /**
+     * Install IPv4 with static routing only on every node
+     */
+    void InstallInternet(void)
+    {
+        Ipv4StaticRoutingHelper staticRouting;
+        InternetStackHelper internet;
+        internet.SetRoutingHelper(staticRouting);
+        internet.Install(m_sensors);
+        for (const NodeContainer& nodes : m_nodes)
+        {
+            internet.Install(nodes);
+        }
+        internet.Install(m_root);
+        internet.Install(m_gateways);
+    }
+
+    /**
+     * @param leaf Zone index
+     * @return Network of the zone's /24
+     */
+    Ipv4Address GetLeafNetwork(uint32_t leaf) const
+    {
+        return GetBlockNetwork(m_tiers.size() - 1, leaf);
+    }
+
+    /**
+     * @param leaf Zone index
+     * @return Zone-side address of the zone AP, the sensors' next hop
+     */
+    Ipv4Address GetLeafAddress(uint32_t leaf) const
+    {
+        return Ipv4Address(GetLeafNetwork(leaf).Get() + m_sensorsPerLeaf + 1);
+    }
+
+    /**
+     * Address a zone network: the sensors get .1 upwards, the AP the next address
+     * @param leaf Zone index
+     * @param sensorDevices Zone devices of the sensors, in sensor order
+     * @param leafDevice Zone device of the AP
+     * @return Interface of the AP
+     */
+    Ipv4InterfaceContainer AssignLeaf(uint32_t leaf,
+                                      const NetDeviceContainer& sensorDevices,
+                                      const NetDeviceContainer& leafDevice) const
+    {
+        Ipv4AddressHelper address(GetLeafNetwork(leaf), Ipv4Mask(0xffffff00));
+        address.Assign(sensorDevices);
+        return address.Assign(leafDevice);
+    }
+
+    /**
+     * Link every node to its parent and address the links
+     * @param type "p2p" (a link per node) or "csma" (a segment per parent)
+     * @param dataRate Link data rate
+     * @param delay Link delay
+     */
+    void InstallBackbone(const std::string& type, const std::string& dataRate, Time delay)
+    {
+        NS_ABORT_MSG_IF(type != "p2p" && type != "csma", "Unknown backbone " << type);
+        if (type == "p2p")
+        {
+            NS_ABORT_MSG_IF(m_nodeCount > (1u << 18), "Too many p2p links for 172.16.0.0/12");
+            PointToPointHelper p2p;
+            p2p.SetDeviceAttribute("DataRate", StringValue(dataRate));
+            p2p.SetChannelAttribute("Delay", TimeValue(delay));
+            for (uint32_t t = 0; t < m_tiers.size(); ++t)
+            {
+                for (uint32_t j = 0; j < m_counts[t]; ++j)
+                {
+                    NetDeviceContainer link = p2p.Install(m_nodes[t].Get(j), GetParent(t, j));
+                    uint32_t network = BACKBONE_BASE + ((m_firstIndex[t] + j) << 2);
+                    Ipv4AddressHelper address(Ipv4Address(network), Ipv4Mask(0xfffffffc));
+                    Ipv4InterfaceContainer interfaces = address.Assign(link);
+                    m_uplinks[t][j] = {link.Get(0),
+                                       link.Get(1),
+                                       interfaces.GetAddress(0),
+                                       interfaces.GetAddress(1)};
+                }
+            }
+            InstallGatewayLinks(dataRate, delay);
+            return;
+        }
+
+        CsmaHelper csma;
+        csma.SetChannelAttribute("DataRate", StringValue(dataRate));
+        csma.SetChannelAttribute("Delay", TimeValue(delay));
+        // Segment 0 joins the root and the first tier, segment 1 + k joins the k-th
+        // routing node and its children
+        for (uint32_t t = 0; t < m_tiers.size(); ++t)
+        {
+            uint32_t fanOut = m_tiers[t].fanOut;
+            NS_ABORT_MSG_IF(fanOut > 253,
+                            "A CSMA segment holds at most 253 children (tier " << m_tiers[t].name
+                                                                                << ")");
+            uint32_t parents = (t == 0) ? 1 : m_counts[t - 1];
+            for (uint32_t p = 0; p < parents; ++p)
+            {
+                uint32_t segment = (t == 0) ? 0 : 1 + m_firstIndex[t - 1] + p;
+                NS_ABORT_MSG_IF(segment >= (1u << 12), "Too many CSMA segments for 172.16.0.0/12");
+                NodeContainer members;
+                for (uint32_t c = 0; c < fanOut; ++c)
+                {
+                    members.Add(m_nodes[t].Get(p * fanOut + c));
+                }
+                members.Add(GetParent(t, p * fanOut));
+                NetDeviceContainer devices = csma.Install(members);
+                Ipv4AddressHelper address(Ipv4Address(BACKBONE_BASE + (segment << 8)),
+                                          Ipv4Mask(0xffffff00));
+                Ipv4InterfaceContainer interfaces = address.Assign(devices);
+                for (uint32_t c = 0; c < fanOut; ++c)
+                {
+                    m_uplinks[t][p * fanOut + c] = {devices.Get(c),
+                                                    devices.Get(fanOut),
+                                                    interfaces.GetAddress(c),
+                                                    interfaces.GetAddress(fanOut)};
+                }
+            }
+        }
+        InstallGatewayLinks(dataRate, delay);
+    }
+
+    /**
+     * @param leaf Zone index
+     * @return Root address on the backbone link of the zone's top-tier ancestor
+     */
+    Ipv4Address GetRootAddress(uint32_t leaf) const
+    {
+        return m_uplinks[0][leaf / GetLeafSpan(0)].parentAddress;
+    }
+
+    /**
+     * @param gateway Gateway index
+     * @param leaf Zone index
+     * @return Address the zone's AP sends to for the gateway
+     */
+    Ipv4Address GetGatewayAddress(uint32_t gateway, uint32_t leaf) const
+    {
+        return m_gateways.GetN() == 0 ? GetRootAddress(leaf) : m_gatewayLinks[gateway].childAddress;
+    }
+
+    /** @return Root device of the first backbone link (the root's CSMA device) */
+    Ptr<NetDevice> GetRootDevice(void) const
+    {
+        return m_uplinks[0][0].parentDevice;
+    }
+
+    /**
+     * Install the routes of the nodes simulated by this rank: sensors and
+     * routing nodes default to their parent, parents route each child's
+     * address block to it
+     * @param systemId Rank of this process
+     */
+    void InstallRoutes(uint32_t systemId) const
+    {
+        uint32_t last = m_tiers.size() - 1;
+        for (uint32_t leaf = 0; leaf < GetLeafCount(); ++leaf)
+        {
+            if (GetLeafSystemId(leaf) != systemId)
+            {
+                continue;
+            }
+            Ipv4Address next = GetLeafAddress(leaf);
+            for (uint32_t s = 0; s < m_sensorsPerLeaf; ++s)
+            {
+                GetRouting(m_sensors.Get(leaf * m_sensorsPerLeaf + s))->SetDefaultRoute(next, 1);
+            }
+        }
+
+        for (uint32_t t = 0; t <= last; ++t)
+        {
+            for (uint32_t j = 0; j < m_counts[t]; ++j)
+            {
+                const Uplink& uplink = m_uplinks[t][j];
+                Ptr<Node> node = m_nodes[t].Get(j);
+                if (node->GetSystemId() == systemId)
+                {
+                    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+                    GetRouting(node)->SetDefaultRoute(
+                        uplink.parentAddress,
+                        ipv4->GetInterfaceForDevice(uplink.childDevice));
+                }
+                Ptr<Node> parent = GetParent(t, j);
+                if (parent->GetSystemId() == systemId)
+                {
+                    Ptr<Ipv4> ipv4 = parent->GetObject<Ipv4>();
+                    GetRouting(parent)->AddNetworkRouteTo(
+                        GetBlockNetwork(t, j),
+                        Ipv4Mask(~0u << (8 + m_shifts[t])),
+                        uplink.childAddress,
+                        ipv4->GetInterfaceForDevice(uplink.parentDevice));
+                }
+            }
+        }
+
+        // The root reaches the gateway /30s directly
+        for (uint32_t g = 0; g < m_gateways.GetN(); ++g)
+        {
+            Ptr<Node> gateway = m_gateways.Get(g);
+            if (gateway->GetSystemId() == systemId)
+            {
+                const Uplink& link = m_gatewayLinks[g];
+                GetRouting(gateway)->SetDefaultRoute(
+                    link.parentAddress,
+                    gateway->GetObject<Ipv4>()->GetInterfaceForDevice(link.childDevice));
+            }
+        }
+    }
+
+    /**
+     * Place every node with one allocator: zone z's sensors in a row from
+     * x = 60 z, its AP 15 m above them, every routing node above the middle of
+     * its zones, one level (15 m) higher per tier, the root on top and the
+     * gateways in a row above it
+     */
+    void InstallMobility(void)
+    {
+        Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+        for (uint32_t leaf = 0; leaf < GetLeafCount(); ++leaf)
+        {
+            for (uint32_t s = 0; s < m_sensorsPerLeaf; ++s)
+            {
+                positions->Add(Vector(leaf * 60.0 + s * 20.0, 0.0, 0.0));
+            }
+        }
+        uint32_t tierCount = m_tiers.size();
+        for (uint32_t t = 0; t < tierCount; ++t)
+        {
+            uint32_t span = GetLeafSpan(t);
+            for (uint32_t j = 0; j < m_counts[t]; ++j)
+            {
+                double x = ((j * span) + (j * span + span - 1)) * 30.0 + 10.0;
+                positions->Add(Vector(x, 15.0 * (tierCount - t), 0.0));
+            }
+        }
+        double rootX = (GetLeafCount() - 1) * 30.0 + 10.0;
+        positions->Add(Vector(rootX, 15.0 * (tierCount + 1), 0.0));
+        for (uint32_t g = 0; g < m_gateways.GetN(); ++g)
+        {
+            double offset = (g - (m_gateways.GetN() - 1) / 2.0) * 30.0;
+            positions->Add(Vector(rootX + offset, 15.0 * (tierCount + 2), 0.0));
+        }
+
+        MobilityHelper mobility;
+        mobility.SetPositionAllocator(positions);
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(m_sensors);
+        for (const NodeContainer& nodes : m_nodes)
+        {
+            mobility.Install(nodes);
+        }
+        mobility.Install(m_root);
+        mobility.Install(m_gateways);
+    }
+
+  private:
+    static constexpr uint32_t BACKBONE_BASE = 0xac100000; // 172.16.0.0
+    static constexpr uint32_t GATEWAY_BASE = 0xc0a80000;  // 192.168.0.0
+
+    /**
+     * Backbone link from a node to its parent
+     */
+    struct Uplink
+    {
+        Ptr<NetDevice> childDevice;
+        Ptr<NetDevice> parentDevice;
+        Ipv4Address childAddress;
+        Ipv4Address parentAddress;
+    };
+
+    /** Link every gateway to the root, when the root is not the gateway itself */
+    void InstallGatewayLinks(const std::string& dataRate, Time delay)
+    {
+        PointToPointHelper p2p;
+        p2p.SetDeviceAttribute("DataRate", StringValue(dataRate));
+        p2p.SetChannelAttribute("Delay", TimeValue(delay));
+        m_gatewayLinks.resize(m_gateways.GetN());
+        for (uint32_t g = 0; g < m_gateways.GetN(); ++g)
+        {
+            NetDeviceContainer link = p2p.Install(m_gateways.Get(g), m_root.Get(0));
+            Ipv4AddressHelper address(Ipv4Address(GATEWAY_BASE + (g << 2)), Ipv4Mask(0xfffffffc));
+            Ipv4InterfaceContainer interfaces = address.Assign(link);
+            m_gatewayLinks[g] = {link.Get(0),
+                                 link.Get(1),
+                                 interfaces.GetAddress(0),
+                                 interfaces.GetAddress(1)};
+        }
+    }
+
+    Ptr<Node> GetParent(uint32_t tier, uint32_t index) const
+    {
+        return (tier == 0) ? m_root.Get(0) : m_nodes[tier - 1].Get(index / m_tiers[tier].fanOut);
+    }
+
+    /**
+     * First /24 of the address block of a node's subtree
+     * @param tier Tier index
+     * @param index Node index within the tier
+     */
+    Ipv4Address GetBlockNetwork(uint32_t tier, uint32_t index) const
+    {
+        uint32_t code = 0;
+        for (uint32_t t = tier + 1; t-- > 0;)
+        {
+            code |= (index % m_tiers[t].fanOut) << m_shifts[t];
+            index /= m_tiers[t].fanOut;
+        }
+        return Ipv4Address((10u << 24) | ((m_leafBase + code) << 8));
+    }
+
+    static Ptr<Ipv4StaticRouting> GetRouting(Ptr<Node> node)
+    {
+        return DynamicCast<Ipv4StaticRouting>(node->GetObject<Ipv4>()->GetRoutingProtocol());
+    }
+
+    std::vector<TopologyTier> m_tiers;
+    uint32_t m_sensorsPerLeaf;
+    uint32_t m_systemCount;
+    std::vector<uint32_t> m_counts;     // Nodes per tier
+    std::vector<uint32_t> m_firstIndex; // Nodes in the tiers above
+    std::vector<uint32_t> m_shifts;     // Bit position of each tier's child index in a zone code
+    uint32_t m_nodeCount;               // Nodes of all tiers (the root and sensors excluded)
+    uint32_t m_leafBase;                // First zone /24 within 10.0.0.0/8
+
+    NodeContainer m_sensors;
+    std::vector<NodeContainer> m_nodes; // Per tier
+    NodeContainer m_root;
+    NodeContainer m_gateways; // Empty when the root is the only gateway
+    std::vector<std::vector<Uplink>> m_uplinks; // Per tier and node
+    std::vector<Uplink> m_gatewayLinks;         // Per gateway, the gateway as the child
+};
+
+} // namespace ns3
+
+#endif /* TIER_TOPOLOGY_H */
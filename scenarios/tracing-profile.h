@@ -0,0 +1,256 @@
+/*
+ * Tracing Profiles
+ *
+ * Selects which run artifacts the scenarios produce (--tracing), so sweeps
+ * only pay for the writers they need:
+ *
+ *   none    - no flow statistics, trace files or animation (summary and console only)
+ *   metrics - windowed flow metrics (CSV snapshots, see flow-metrics-collector.h)
+ *   debug   - metrics + FlowMonitor and IP-level pcap/ascii traces of the sampled nodes
+ *   full    - debug + NetAnim and the scenario's device-level pcap/ascii traces
+ *
+ * The IP-level traces hook the Ipv4L3Protocol Tx/Rx sources of each sampled
+ * node and only write inside the trace window (--traceStart/--traceStop).
+ * They record every packet with its IPv4 header, so the pcap files
+ * (DLT_RAW, one per node) load in Wireshark whatever the link model. The
+ * window also bounds NetAnim. Device-level captures in "full" cover the
+ * whole run, as they always did.
+ */
+
+#ifndef TRACING_PROFILE_H
+#define TRACING_PROFILE_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/netanim-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+enum class TracingProfile
+{
+    NONE,
+    METRICS,
+    DEBUG,
+    FULL
+};
+
+/**
+ * Parse a --tracing value (aborts on unknown names)
+ * @param name "none", "metrics", "debug" or "full"
+ * @return Tracing profile
+ */
+inline TracingProfile
+ParseTracingProfile(const std::string& name)
+{
+    if (name == "none")
+    {
+        return TracingProfile::NONE;
+    }
+    if (name == "metrics")
+    {
+        return TracingProfile::METRICS;
+    }
+    if (name == "debug")
+    {
+        return TracingProfile::DEBUG;
+    }
+    if (name == "full")
+    {
+        return TracingProfile::FULL;
+    }
+    NS_ABORT_MSG("Unknown tracing profile " << name << " (use none, metrics, debug or full)");
+    return TracingProfile::FULL;
+}
+
+class TracingPlan
+{
+  public:
+    /**
+     * @param profile Selected profile
+     * @param start Trace window start
+     * @param stop Trace window end (zero = end of the run)
+     * @param prefix Prefix of the trace files (the scenario's output prefix and name)
+     */
+    TracingPlan(TracingProfile profile, Time start, Time stop, const std::string& prefix)
+        : m_profile(profile),
+          m_prefix(prefix)
+    {
+        m_window = Create<Window>();
+        m_window->start = start;
+        m_window->stop = stop;
+    }
+
+    /** @return true if the applications report to a FlowMetricsCollector */
+    bool WantsMetrics(void) const
+    {
+        return m_profile != TracingProfile::NONE;
+    }
+
+    /** @return true if FlowMonitor should be installed (probes on every node, XML at the end) */
+    bool WantsFlowMonitor(void) const
+    {
+        return m_profile == TracingProfile::DEBUG || m_profile == TracingProfile::FULL;
+    }
+
+    /** @return true if sampled nodes get IP-level traces */
+    bool WantsNodeTraces(void) const
+    {
+        return m_profile == TracingProfile::DEBUG || m_profile == TracingProfile::FULL;
+    }
+
+    /** @return true for NetAnim and device-level pcap/ascii */
+    bool WantsFullTraces(void) const
+    {
+        return m_profile == TracingProfile::FULL;
+    }
+
+    /** @return Trace window start */
+    Time GetStart(void) const
+    {
+        return m_window->start;
+    }
+
+    /**
+     * @param end End of the run
+     * @return Trace window end
+     */
+    Time GetStop(Time end) const
+    {
+        return m_window->stop.IsZero() ? end : m_window->stop;
+    }
+
+    /**
+     * Restrict an animation to the trace window
+     * @param anim Animation interface
+     * @param end End of the run
+     */
+    void LimitAnimation(AnimationInterface& anim, Time end) const
+    {
+        anim.SetStartTime(GetStart());
+        anim.SetStopTime(GetStop(end));
+    }
+
+    /**
+     * Trace a sampled node: <prefix>-ip-<node>.pcap, plus lines in <prefix>-ip.tr
+     * No-op unless the profile includes node traces.
+     * @param node Node with an IPv4 stack
+     */
+    void TraceNode(Ptr<Node> node)
+    {
+        if (!WantsNodeTraces())
+        {
+            return;
+        }
+        Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+        NS_ABORT_MSG_IF(!ipv4, "Traced node " << node->GetId() << " has no IPv4 stack");
+        if (!m_ascii)
+        {
+            AsciiTraceHelper ascii;
+            m_ascii = ascii.CreateFileStream(m_prefix + "-ip.tr");
+        }
+
+        std::ostringstream file;
+        file << m_prefix << "-ip-" << node->GetId() << ".pcap";
+        PcapHelper pcap;
+        Ptr<NodeTrace> trace = Create<NodeTrace>();
+        trace->window = m_window;
+        trace->nodeId = node->GetId();
+        trace->pcap = pcap.CreateFile(file.str(), std::ios::out, PcapHelper::DLT_RAW);
+        trace->ascii = m_ascii;
+        ipv4->TraceConnectWithoutContext("Tx", MakeBoundCallback(&TracingPlan::IpTx, trace));
+        ipv4->TraceConnectWithoutContext("Rx", MakeBoundCallback(&TracingPlan::IpRx, trace));
+        m_nodes.push_back(trace);
+    }
+
+    /** @return Number of traced nodes */
+    uint32_t GetTracedNodes(void) const
+    {
+        return m_nodes.size();
+    }
+
+    /** @return Packets written to the node traces so far */
+    uint64_t GetRecordsWritten(void) const
+    {
+        uint64_t records = 0;
+        for (const Ptr<NodeTrace>& trace : m_nodes)
+        {
+            records += trace->records;
+        }
+        return records;
+    }
+
+  private:
+    struct Window : public SimpleRefCount<Window>
+    {
+        Time start;
+        Time stop; // Zero = open-ended
+
+        bool IsOpen(void) const
+        {
+            Time now = Simulator::Now();
+            return now >= start && (stop.IsZero() || now < stop);
+        }
+    };
+
+    struct NodeTrace : public SimpleRefCount<NodeTrace>
+    {
+        Ptr<Window> window;
+        uint32_t nodeId = 0;
+        Ptr<PcapFileWrapper> pcap;
+        Ptr<OutputStreamWrapper> ascii;
+        uint64_t records = 0;
+    };
+
+    static void IpTx(Ptr<NodeTrace> trace,
+                     Ptr<const Packet> packet,
+                     Ptr<Ipv4> /* ipv4 */,
+                     uint32_t interface)
+    {
+        Record(trace, 't', packet, interface);
+    }
+
+    static void IpRx(Ptr<NodeTrace> trace,
+                     Ptr<const Packet> packet,
+                     Ptr<Ipv4> /* ipv4 */,
+                     uint32_t interface)
+    {
+        Record(trace, 'r', packet, interface);
+    }
+
+    /**
+     * Write one packet (header included) to the node's pcap and the shared ascii trace
+     * Ascii lines: <t|r> <time s> <node> <interface> <bytes> <source> <destination>
+     */
+    static void Record(Ptr<NodeTrace> trace, char direction, Ptr<const Packet> packet, uint32_t interface)
+    {
+        if (!trace->window->IsOpen())
+        {
+            return;
+        }
+        trace->pcap->Write(Simulator::Now(), packet);
+        Ipv4Header header;
+        packet->PeekHeader(header);
+        *trace->ascii->GetStream() << direction << ' ' << Simulator::Now().GetSeconds() << ' '
+                                   << trace->nodeId << ' ' << interface << ' ' << packet->GetSize()
+                                   << ' ' << header.GetSource() << ' ' << header.GetDestination()
+                                   << '\n';
+        trace->records++;
+    }
+
+    TracingProfile m_profile;
+    std::string m_prefix;
+    Ptr<Window> m_window;
+    Ptr<OutputStreamWrapper> m_ascii; // Shared by all traced nodes
+    std::vector<Ptr<NodeTrace>> m_nodes;
+};
+
+} // namespace ns3
+
+#endif /* TRACING_PROFILE_H */
@@ -0,0 +1,289 @@
+/*
+ * WiFi Airtime Monitor
+ *
+ * Measures what the sensor frames cost the shared medium, so the effect of
+ * sensor-side batching can be quantified:
+ *
+ *   - frames and airtime transmitted by the monitored devices (data, ACKs
+ *     and beacons alike, from the PHY TX state periods)
+ *   - time the receivers (gateway or local APs) spent busy, i.e. receiving
+ *     or sensing a busy medium (channel utilization seen by the sink)
+ *   - frames the receivers failed to decode (RxError: collisions and
+ *     interference) or dropped before decoding (PhyRxDrop, e.g. a preamble
+ *     that arrived while the PHY was already busy)
+ *   - frames and airtime of the reliability ACK broadcasts, told apart from
+ *     the rest of the sinks' traffic by their UDP port
+ *
+ * Only devices of nodes simulated by this process report anything.
+ */
+
+#ifndef WIFI_AIRTIME_H
+#define WIFI_AIRTIME_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+
+#include <cstdint>
+
+namespace ns3
+{
+
+class WifiAirtimeMonitor : public SimpleRefCount<WifiAirtimeMonitor>
+{
+  public:
+    WifiAirtimeMonitor()
+        : m_txFrames(0),
+          m_rxErrors(0),
+          m_rxDrops(0),
+          m_rxFrames(0),
+          m_receivers(0),
+          m_ackPort(0),
+          m_ackFrames(0)
+    {
+    }
+
+    /**
+     * Count the transmissions of these devices (non-WiFi devices are ignored)
+     * @param devices Devices sharing the monitored medium
+     */
+    void AddTransmitters(const NetDeviceContainer& devices)
+    {
+        for (uint32_t i = 0; i < devices.GetN(); ++i)
+        {
+            Ptr<WifiPhy> phy = GetPhy(devices.Get(i));
+            if (phy)
+            {
+                phy->GetState()->TraceConnectWithoutContext(
+                    "State",
+                    MakeCallback(&WifiAirtimeMonitor::TxState, this));
+            }
+        }
+    }
+
+    /**
+     * Track busy time and reception failures of these devices
+     * @param devices Devices the sensor traffic is addressed to
+     */
+    void AddReceivers(const NetDeviceContainer& devices)
+    {
+        for (uint32_t i = 0; i < devices.GetN(); ++i)
+        {
+            Ptr<WifiPhy> phy = GetPhy(devices.Get(i));
+            if (!phy)
+            {
+                continue;
+            }
+            m_receivers++;
+            Ptr<WifiPhyStateHelper> state = phy->GetState();
+            state->TraceConnectWithoutContext("State",
+                                              MakeCallback(&WifiAirtimeMonitor::RxState, this));
+            state->TraceConnectWithoutContext("RxOk", MakeCallback(&WifiAirtimeMonitor::RxOk, this));
+            state->TraceConnectWithoutContext("RxError",
+                                              MakeCallback(&WifiAirtimeMonitor::RxError, this));
+            phy->TraceConnectWithoutContext("PhyRxDrop",
+                                            MakeCallback(&WifiAirtimeMonitor::RxDrop, this));
+        }
+    }
+
+    /**
+     * Measure the airtime of the ACK datagrams these devices send
+     * @param devices Devices sending the ACK broadcasts (gateway or local APs)
+     * @param port Destination UDP port of the ACKs
+     */
+    void AddAckSenders(const NetDeviceContainer& devices, uint16_t port)
+    {
+        m_ackPort = port;
+        for (uint32_t i = 0; i < devices.GetN(); ++i)
+        {
+            Ptr<WifiPhy> phy = GetPhy(devices.Get(i));
+            if (phy)
+            {
+                phy->TraceConnectWithoutContext(
+                    "PhyTxPsduBegin",
+                    MakeBoundCallback(&WifiAirtimeMonitor::PsduTxBegin, this, phy));
+            }
+        }
+    }
+
+    /** @return Frames transmitted by the monitored transmitters */
+    uint64_t GetTxFrames(void) const
+    {
+        return m_txFrames;
+    }
+
+    /** @return Airtime of those frames */
+    Time GetTxAirtime(void) const
+    {
+        return m_txTime;
+    }
+
+    /** @return Time the receivers spent receiving or sensing a busy medium (summed) */
+    Time GetReceiverBusyTime(void) const
+    {
+        return m_busyTime;
+    }
+
+    /**
+     * @param elapsed Observation period
+     * @return Mean fraction of the period a receiver was busy (0..1)
+     */
+    double GetReceiverUtilization(Time elapsed) const
+    {
+        if (m_receivers == 0 || !elapsed.IsStrictlyPositive())
+        {
+            return 0.0;
+        }
+        return m_busyTime.GetSeconds() / (elapsed.GetSeconds() * m_receivers);
+    }
+
+    /** @return Frames the receivers decoded */
+    uint64_t GetRxFrames(void) const
+    {
+        return m_rxFrames;
+    }
+
+    /** @return Frames the receivers could not decode */
+    uint64_t GetRxErrors(void) const
+    {
+        return m_rxErrors;
+    }
+
+    /** @return Frames the receivers dropped before decoding */
+    uint64_t GetRxDrops(void) const
+    {
+        return m_rxDrops;
+    }
+
+    /** @return ACK frames sent by the ACK senders */
+    uint64_t GetAckFrames(void) const
+    {
+        return m_ackFrames;
+    }
+
+    /** @return Airtime of those frames */
+    Time GetAckAirtime(void) const
+    {
+        return m_ackTime;
+    }
+
+    /** @return ACK airtime over the airtime of all monitored transmitters (0..1) */
+    double GetAckAirtimeShare(void) const
+    {
+        return m_txTime.IsStrictlyPositive() ? m_ackTime.GetSeconds() / m_txTime.GetSeconds()
+                                             : 0.0;
+    }
+
+  private:
+    static Ptr<WifiPhy> GetPhy(Ptr<NetDevice> device)
+    {
+        Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice>(device);
+        return wifi ? wifi->GetPhy() : Ptr<WifiPhy>();
+    }
+
+    void TxState(Time /* start */, Time duration, WifiPhyState state)
+    {
+        if (state == WifiPhyState::TX)
+        {
+            m_txFrames++;
+            m_txTime += duration;
+        }
+    }
+
+    static void PsduTxBegin(WifiAirtimeMonitor* monitor,
+                            Ptr<WifiPhy> phy,
+                            WifiConstPsduMap psdus,
+                            WifiTxVector txVector,
+                            double /* txPowerW */)
+    {
+        for (const auto& entry : psdus)
+        {
+            if (monitor->IsAck(entry.second))
+            {
+                monitor->m_ackFrames++;
+                monitor->m_ackTime += WifiPhy::CalculateTxDuration(entry.second->GetSize(),
+                                                                   txVector,
+                                                                   phy->GetPhyBand(),
+                                                                   entry.first);
+            }
+        }
+    }
+
+    /** @return true if the PSDU carries a UDP datagram to the ACK port */
+    bool IsAck(Ptr<const WifiPsdu> psdu) const
+    {
+        for (auto it = psdu->begin(); it != psdu->end(); ++it)
+        {
+            if (!(*it)->GetHeader().IsData())
+            {
+                continue;
+            }
+            Ptr<Packet> packet = (*it)->GetPacket()->Copy();
+            LlcSnapHeader llc;
+            Ipv4Header ip;
+            UdpHeader udp;
+            if (packet->GetSize() < llc.GetSerializedSize() + ip.GetSerializedSize() + 8)
+            {
+                continue;
+            }
+            packet->RemoveHeader(llc);
+            if (llc.GetType() != Ipv4L3Protocol::PROT_NUMBER)
+            {
+                continue;
+            }
+            packet->RemoveHeader(ip);
+            if (ip.GetProtocol() != UdpL4Protocol::PROT_NUMBER)
+            {
+                continue;
+            }
+            packet->PeekHeader(udp);
+            if (udp.GetDestinationPort() == m_ackPort)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RxState(Time /* start */, Time duration, WifiPhyState state)
+    {
+        if (state == WifiPhyState::RX || state == WifiPhyState::CCA_BUSY)
+        {
+            m_busyTime += duration;
+        }
+    }
+
+    void RxOk(Ptr<const Packet> /* packet */,
+              double /* snr */,
+              WifiMode /* mode */,
+              WifiPreamble /* preamble */)
+    {
+        m_rxFrames++;
+    }
+
+    void RxError(Ptr<const Packet> /* packet */, double /* snr */)
+    {
+        m_rxErrors++;
+    }
+
+    void RxDrop(Ptr<const Packet> /* packet */, WifiPhyRxfailureReason /* reason */)
+    {
+        m_rxDrops++;
+    }
+
+    uint64_t m_txFrames;
+    Time m_txTime;
+    Time m_busyTime;
+    uint64_t m_rxErrors;
+    uint64_t m_rxDrops;
+    uint64_t m_rxFrames;
+    uint32_t m_receivers;
+    uint16_t m_ackPort; // 0 unless AddAckSenders() was called
+    uint64_t m_ackFrames;
+    Time m_ackTime;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_AIRTIME_H */
@@ -0,0 +1,355 @@
+/*
+ * WiFi Standard and Rate Control Selection
+ *
+ * Maps the --wifiStandard, --wifiBand, --channelWidth and --rateManager
+ * options of both scenarios onto the WifiHelper and the PHY ChannelSettings
+ * attribute, so zone capacity no longer stops at 802.11b's 1 Mbps:
+ *
+ *   standard  bands        widths (MHz)     lowest mode
+ *   b         2.4          22               DsssRate1Mbps
+ *   g         2.4          20               ErpOfdmRate6Mbps
+ *   n         2.4 (def), 5 20, 40           HtMcs0
+ *   ac        5            20, 40, 80, 160  VhtMcs0
+ *   ax        2.4, 5 (def), 6  20 .. 160    HeMcs0
+ *
+ * Rate managers:
+ *   constant - ConstantRateWifiManager at --dataMode/--controlMode, which
+ *              default to the lowest (most robust) mode of the standard
+ *   minstrel - MinstrelWifiManager for b/g, MinstrelHtWifiManager for n/ac/ax
+ *   ideal    - IdealWifiManager (SNR-driven, an upper bound for adaptation)
+ *
+ * 802.11ah (sub-1 GHz, long-range low-power) has no model in ns-3 mainline, so
+ * requesting it aborts instead of silently running something else.
+ *
+ * The channel plan of a band lists non-overlapping channels first, so
+ * frequency index k of a zone maps to the k-th entry.
+ *
+ * Association (--association):
+ *   standard - StaWifiMac/ApWifiMac: beacons, association handshake, and ARP
+ *              on the first reading
+ *   fast     - AdhocWifiMac on both sides, so stations can send to their AP
+ *              from t = 0 and no beacons are transmitted; the scenarios also
+ *              pre-fill the station <-> AP ARP entries. ns-3 cannot checkpoint
+ *              a running simulation, so this is the cheap way to skip the
+ *              warm-up that every run would otherwise repeat.
+ */
+
+#ifndef WIFI_CONFIG_H
+#define WIFI_CONFIG_H
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class WifiConfig
+{
+  public:
+    /**
+     * Validate a standard/band/width combination (aborts on invalid ones)
+     * @param standard "b", "g", "n", "ac" or "ax" ("ah" is recognized but unsupported)
+     * @param band "auto" (the standard's default), "2.4", "5" or "6" (GHz)
+     * @param channelWidth MHz, 0 for 20 MHz (22 MHz for 802.11b)
+     */
+    WifiConfig(const std::string& standard, const std::string& band, uint16_t channelWidth)
+        : m_name(standard),
+          m_rateManager("constant"),
+          m_fastAssociation(false)
+    {
+        NS_ABORT_MSG_IF(standard == "ah",
+                        "802.11ah is not available in ns-3 mainline (no S1G PHY); use b, g, n, "
+                        "ac or ax");
+        if (standard == "b")
+        {
+            m_standard = WIFI_STANDARD_80211b;
+            m_lowestMode = "DsssRate1Mbps";
+        }
+        else if (standard == "g")
+        {
+            m_standard = WIFI_STANDARD_80211g;
+            m_lowestMode = "ErpOfdmRate6Mbps";
+        }
+        else if (standard == "n")
+        {
+            m_standard = WIFI_STANDARD_80211n;
+            m_lowestMode = "HtMcs0";
+        }
+        else if (standard == "ac")
+        {
+            m_standard = WIFI_STANDARD_80211ac;
+            m_lowestMode = "VhtMcs0";
+        }
+        else if (standard == "ax")
+        {
+            m_standard = WIFI_STANDARD_80211ax;
+            m_lowestMode = "HeMcs0";
+        }
+        else
+        {
+            NS_ABORT_MSG("Unknown WiFi standard " << standard << " (use b, g, n, ac or ax)");
+        }
+
+        m_band = band;
+        if (band == "auto")
+        {
+            m_band = (standard == "ac" || standard == "ax") ? "5" : "2.4";
+        }
+        NS_ABORT_MSG_IF(m_band != "2.4" && m_band != "5" && m_band != "6",
+                        "Unknown WiFi band " << band << " (use auto, 2.4, 5 or 6)");
+        bool bandOk = (m_band == "2.4" && standard != "ac") ||
+                      (m_band == "5" && (standard == "n" || standard == "ac" || standard == "ax")) ||
+                      (m_band == "6" && standard == "ax");
+        NS_ABORT_MSG_IF(!bandOk,
+                        "802.11" << standard << " does not operate in the " << m_band
+                                 << " GHz band");
+
+        m_width = channelWidth;
+        if (m_width == 0)
+        {
+            m_width = (standard == "b") ? 22 : 20;
+        }
+        bool widthOk = false;
+        if (standard == "b")
+        {
+            widthOk = (m_width == 22);
+        }
+        else if (m_band == "2.4" || standard == "n")
+        {
+            widthOk = (m_width == 20 || (m_width == 40 && standard != "g"));
+        }
+        else
+        {
+            widthOk = (m_width == 20 || m_width == 40 || m_width == 80 || m_width == 160);
+        }
+        NS_ABORT_MSG_IF(!widthOk,
+                        "802.11" << standard << " in the " << m_band << " GHz band does not support "
+                                 << m_width << " MHz channels");
+        BuildChannelPlan();
+    }
+
+    /**
+     * Select the rate manager (aborts on unknown names)
+     * @param manager "constant", "minstrel" or "ideal"
+     * @param dataMode Constant data mode, empty for the lowest mode of the standard
+     * @param controlMode Constant control mode, empty for the data mode
+     */
+    void SetRateManager(const std::string& manager,
+                        const std::string& dataMode,
+                        const std::string& controlMode)
+    {
+        NS_ABORT_MSG_IF(manager != "constant" && manager != "minstrel" && manager != "ideal",
+                        "Unknown rate manager " << manager << " (use constant, minstrel or ideal)");
+        NS_ABORT_MSG_IF(manager != "constant" && (!dataMode.empty() || !controlMode.empty()),
+                        "dataMode and controlMode only apply to the constant rate manager");
+        m_rateManager = manager;
+        m_dataMode = dataMode.empty() ? m_lowestMode : dataMode;
+        m_controlMode = controlMode.empty() ? m_dataMode : controlMode;
+    }
+
+    /**
+     * Select how stations join their access point (aborts on unknown modes)
+     * @param mode "standard" or "fast" (see above)
+     */
+    void SetAssociation(const std::string& mode)
+    {
+        NS_ABORT_MSG_IF(mode != "standard" && mode != "fast",
+                        "Unknown association mode " << mode << " (use standard or fast)");
+        m_fastAssociation = (mode == "fast");
+    }
+
+    /** @return true if stations skip the association (ad hoc MACs, pre-filled ARP caches) */
+    bool IsFastAssociation(void) const
+    {
+        return m_fastAssociation;
+    }
+
+    /**
+     * Configure the MAC of the stations (sensors)
+     * @param mac Helper used to install the station devices
+     * @param ssid Network of the access point (ignored by fast association)
+     */
+    void SetStationMac(WifiMacHelper& mac, const Ssid& ssid) const
+    {
+        if (m_fastAssociation)
+        {
+            mac.SetType("ns3::AdhocWifiMac");
+        }
+        else
+        {
+            mac.SetType("ns3::StaWifiMac",
+                        "Ssid",
+                        SsidValue(ssid),
+                        "ActiveProbing",
+                        BooleanValue(false));
+        }
+    }
+
+    /**
+     * Configure the MAC of the access point (gateway or local AP)
+     * @param mac Helper used to install the access point device
+     * @param ssid Network name in the beacons (ignored by fast association)
+     */
+    void SetApMac(WifiMacHelper& mac, const Ssid& ssid) const
+    {
+        if (m_fastAssociation)
+        {
+            mac.SetType("ns3::AdhocWifiMac");
+        }
+        else
+        {
+            mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+        }
+    }
+
+    /**
+     * Set the standard and the rate manager
+     * @param wifi Helper used to install the devices
+     */
+    void Configure(WifiHelper& wifi) const
+    {
+        wifi.SetStandard(m_standard);
+        if (m_rateManager == "constant")
+        {
+            wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                         "DataMode",
+                                         StringValue(m_dataMode),
+                                         "ControlMode",
+                                         StringValue(m_controlMode));
+        }
+        else if (m_rateManager == "minstrel")
+        {
+            bool legacy = (m_standard == WIFI_STANDARD_80211b || m_standard == WIFI_STANDARD_80211g);
+            wifi.SetRemoteStationManager(legacy ? "ns3::MinstrelWifiManager"
+                                                : "ns3::MinstrelHtWifiManager");
+        }
+        else
+        {
+            wifi.SetRemoteStationManager("ns3::IdealWifiManager");
+        }
+    }
+
+    /** @return Band in GHz ("2.4", "5" or "6"), with "auto" resolved */
+    const std::string& GetBand(void) const
+    {
+        return m_band;
+    }
+
+    /** @return Channel width in MHz, with the default resolved */
+    uint16_t GetChannelWidth(void) const
+    {
+        return m_width;
+    }
+
+    /** @return Number of distinct channels of the band at the configured width */
+    uint32_t GetChannelCount(void) const
+    {
+        return m_channels.size();
+    }
+
+    /**
+     * @param index Frequency index (wraps around the channel plan)
+     * @return Channel number
+     */
+    uint8_t GetChannelNumber(uint32_t index) const
+    {
+        return m_channels[index % m_channels.size()];
+    }
+
+    /**
+     * Value of the WifiPhy ChannelSettings attribute
+     * @param index Frequency index (see GetChannelNumber())
+     * @return "{number, width, band, 0}"
+     */
+    std::string GetChannelSettings(uint32_t index) const
+    {
+        std::ostringstream oss;
+        oss << "{" << static_cast<uint32_t>(GetChannelNumber(index)) << ", " << m_width << ", BAND_"
+            << (m_band == "2.4" ? "2_4" : m_band) << "GHZ, 0}";
+        return oss.str();
+    }
+
+    /** @return e.g. "802.11n, 2.4 GHz, 20 MHz, minstrel" (", fast association" appended) */
+    std::string GetDescription(void) const
+    {
+        std::ostringstream oss;
+        oss << "802.11" << m_name << ", " << m_band << " GHz, " << m_width << " MHz, "
+            << m_rateManager;
+        if (m_rateManager == "constant")
+        {
+            oss << " " << m_dataMode;
+        }
+        if (m_fastAssociation)
+        {
+            oss << ", fast association";
+        }
+        return oss.str();
+    }
+
+  private:
+    void BuildChannelPlan(void)
+    {
+        if (m_band == "2.4")
+        {
+            if (m_width == 40)
+            {
+                m_channels = {3, 11};
+            }
+            else
+            {
+                m_channels = {1, 6, 11, 2, 7, 12, 3, 8, 13, 4, 9, 5, 10};
+            }
+        }
+        else if (m_band == "5")
+        {
+            if (m_width == 20)
+            {
+                m_channels = {36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116,
+                              120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165};
+            }
+            else if (m_width == 40)
+            {
+                m_channels = {38, 46, 54, 62, 102, 110, 118, 126, 134, 142, 151, 159};
+            }
+            else if (m_width == 80)
+            {
+                m_channels = {42, 58, 106, 122, 138, 155};
+            }
+            else
+            {
+                m_channels = {50, 114};
+            }
+        }
+        else
+        {
+            // 6 GHz: 20 MHz channels 1, 5, ... 233; a wider channel is numbered after its
+            // centre and must not extend past channel 233
+            uint32_t step = m_width / 5;
+            for (uint32_t number = m_width / 10 - 1; number + (m_width - 20) / 10 <= 233;
+                 number += step)
+            {
+                m_channels.push_back(static_cast<uint8_t>(number));
+            }
+        }
+    }
+
+    std::string m_name; // As given on the command line
+    WifiStandard m_standard;
+    std::string m_band; // "2.4", "5" or "6"
+    uint16_t m_width;   // MHz
+    std::string m_lowestMode;
+    std::string m_rateManager;
+    std::string m_dataMode;
+    std::string m_controlMode;
+    std::vector<uint8_t> m_channels; // Channel plan of the band at m_width
+    bool m_fastAssociation;          // Ad hoc MACs instead of STA/AP
+};
+
+} // namespace ns3
+
+#endif /* WIFI_CONFIG_H */
@@ -0,0 +1,150 @@
+/*
+ * WiFi Medium Selection
+ *
+ * Lets the scenarios pick the channel implementation behind their WiFi PHYs
+ * without duplicating the helper plumbing:
+ *
+ *   yans     - YansWifiChannel (the original setup)
+ *   spectrum - SpectrumWifiPhy on a MultiModelSpectrumChannel (unculled reference)
+ *   grid     - SpectrumWifiPhy on a GridSpectrumChannel (spatially culled)
+ *
+ * All three use the log-distance loss and constant-speed delay models of
+ * YansWifiChannelHelper::Default(), so their results are directly comparable.
+ */
+
+#ifndef WIFI_MEDIUM_H
+#define WIFI_MEDIUM_H
+
+#include "ns3/core-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/spectrum-module.h"
+#include "ns3/wifi-module.h"
+
+#include "grid-spectrum-channel.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+enum class WifiMediumType
+{
+    YANS,
+    SPECTRUM,
+    GRID
+};
+
+/**
+ * Parse a --wifiChannel value (aborts on unknown names)
+ * @param name "yans", "spectrum" or "grid"
+ * @return Medium type
+ */
+inline WifiMediumType
+ParseWifiMediumType(const std::string& name)
+{
+    if (name == "yans")
+    {
+        return WifiMediumType::YANS;
+    }
+    if (name == "spectrum")
+    {
+        return WifiMediumType::SPECTRUM;
+    }
+    if (name == "grid")
+    {
+        return WifiMediumType::GRID;
+    }
+    NS_ABORT_MSG("Unknown WiFi channel " << name << " (use yans, spectrum or grid)");
+    return WifiMediumType::YANS;
+}
+
+class WifiMediumHelper
+{
+  public:
+    explicit WifiMediumHelper(WifiMediumType type)
+        : m_type(type),
+          m_detectionThreshold(-101.0)
+    {
+    }
+
+    /**
+     * Received power below which the grid channel stops delivering frames
+     * @param dbm Threshold in dBm (grid medium only)
+     */
+    void SetDetectionThreshold(double dbm)
+    {
+        m_detectionThreshold = dbm;
+    }
+
+    /**
+     * Create a new, empty medium of the selected type
+     * @return YansWifiChannel or SpectrumChannel
+     */
+    Ptr<Channel> CreateMedium(void)
+    {
+        if (m_type == WifiMediumType::YANS)
+        {
+            return YansWifiChannelHelper::Default().Create();
+        }
+
+        Ptr<SpectrumChannel> medium;
+        if (m_type == WifiMediumType::GRID)
+        {
+            Ptr<GridSpectrumChannel> grid = CreateObject<GridSpectrumChannel>();
+            grid->SetAttribute("DetectionThreshold", DoubleValue(m_detectionThreshold));
+            m_gridChannels.push_back(grid);
+            medium = grid;
+        }
+        else
+        {
+            medium = CreateObject<MultiModelSpectrumChannel>();
+        }
+        medium->AddPropagationLossModel(CreateObject<LogDistancePropagationLossModel>());
+        medium->SetPropagationDelayModel(CreateObject<ConstantSpeedPropagationDelayModel>());
+        return medium;
+    }
+
+    /**
+     * Attach the PHYs installed from now on to a medium
+     * @param medium Medium returned by CreateMedium()
+     */
+    void SetMedium(Ptr<Channel> medium)
+    {
+        if (m_type == WifiMediumType::YANS)
+        {
+            m_yansPhy.SetChannel(DynamicCast<YansWifiChannel>(medium));
+        }
+        else
+        {
+            m_spectrumPhy.AddChannel(DynamicCast<SpectrumChannel>(medium));
+        }
+    }
+
+    /** @return PHY helper to pass to WifiHelper::Install() */
+    WifiPhyHelper& GetPhy(void)
+    {
+        if (m_type == WifiMediumType::YANS)
+        {
+            return m_yansPhy;
+        }
+        return m_spectrumPhy;
+    }
+
+    /** @return Grid channels created so far (for culling statistics) */
+    const std::vector<Ptr<GridSpectrumChannel>>& GetGridChannels(void) const
+    {
+        return m_gridChannels;
+    }
+
+  private:
+    WifiMediumType m_type;
+    double m_detectionThreshold; // dBm
+    YansWifiPhyHelper m_yansPhy;
+    SpectrumWifiPhyHelper m_spectrumPhy;
+    std::vector<Ptr<GridSpectrumChannel>> m_gridChannels;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_MEDIUM_H */
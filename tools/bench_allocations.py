@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Allocation Benchmark
+Runs both scenarios with the text and the binary payload and checks the heap
+allocations charged to the per-reading paths (see scenarios/alloc-counter.h):
+a sensor building the datagram of one reading (sensorEncode) and a gateway
+decoding it (gatewayDecode). The script fails when a path makes more
+allocations per reading than its budget: --max-encode (default 2, the
+Packet object and its Buffer data, both ns-3's) and --max-decode (default 0).
+
+The counter only exists in builds configured with the CARBON_ALLOC_COUNTER
+define, which replaces the global operator new:
+
+  CXXFLAGS="-DCARBON_ALLOC_COUNTER" ./ns3 configure ...
+
+A run without the counter's metrics in its summary.json fails with a hint.
+Results are written to <out>/alloc-results.json.
+
+The scenarios must already be copied into <ns3-dir>/scratch/.
+
+Usage:
+  python tools/bench_allocations.py --ns3-dir ~/ns-3
+  python tools/bench_allocations.py --ns3-dir ~/ns-3 --payloads text --max-encode 1
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+SCENARIOS = ['iot-connectivity', 'iot-hierarchical']
+PAYLOADS = ['text', 'binary']
+SECTIONS = ['sensorEncode', 'gatewayDecode']
+
+
+def run_point(ns3_dir, scenario, payload, time, timeout, prefix, extra):
+    os.makedirs(prefix, exist_ok=True)
+    args = [f"--payload={payload}", f"--time={time}", '--tracing=none',
+            f"--outputPrefix={prefix}", '--verbose=false']
+    program = ' '.join([f"scratch/{scenario}"] + args + ([extra] if extra else []))
+    try:
+        out = subprocess.run(['./ns3', 'run', '--no-build', program], cwd=ns3_dir,
+                             capture_output=True, text=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return 'timeout', {}
+    with open(os.path.join(prefix, 'stdout.txt'), 'w') as log:
+        log.write(out.stdout)
+        log.write(out.stderr)
+    if out.returncode != 0:
+        return 'failed', {}
+    try:
+        with open(os.path.join(prefix, 'summary.json')) as f:
+            metrics = json.load(f)['metrics']
+    except (OSError, ValueError, KeyError):
+        return 'failed', {}
+    if f"{SECTIONS[0]}Calls" not in metrics:
+        return 'no counter', {}
+    return 'ok', {key: metrics[key] for key in metrics
+                  if any(key.startswith(section) for section in SECTIONS)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--ns3-dir', required=True, help='ns-3 root directory')
+    parser.add_argument('--scenario', nargs='+', default=SCENARIOS, choices=SCENARIOS)
+    parser.add_argument('--payloads', nargs='+', default=PAYLOADS, choices=PAYLOADS)
+    parser.add_argument('--time', type=float, default=30.0, help='Simulated seconds per run')
+    parser.add_argument('--max-encode', type=float, default=2.0,
+                        help='Allowed allocations per sensor encode')
+    parser.add_argument('--max-decode', type=float, default=0.0,
+                        help='Allowed allocations per gateway decode')
+    parser.add_argument('--timeout', type=float, default=600, help='Seconds per run')
+    parser.add_argument('--out', default='alloc-results', help='Output directory')
+    parser.add_argument('--extra', default='', help='Additional scenario arguments')
+    args = parser.parse_args()
+
+    ns3_dir = os.path.expanduser(args.ns3_dir)
+    out_dir = os.path.abspath(args.out)
+    subprocess.check_call(['./ns3', 'build'] + [f"scratch/{s}" for s in args.scenario],
+                          cwd=ns3_dir)
+    budgets = {'sensorEncode': args.max_encode, 'gatewayDecode': args.max_decode}
+
+    print(f"{'scenario':>16} {'payload':>7} {'encodes':>9} {'allocs':>7} {'decodes':>9} "
+          f"{'allocs':>7}")
+    results = []
+    failures = []
+    for scenario in args.scenario:
+        for payload in args.payloads:
+            prefix = os.path.join(out_dir, f"{scenario}-{payload}") + os.sep
+            status, metrics = run_point(ns3_dir, scenario, payload, args.time, args.timeout,
+                                        prefix, args.extra)
+            results.append({'scenario': scenario, 'payload': payload, 'status': status,
+                            'metrics': metrics})
+            head = f"{scenario:>16} {payload:>7}"
+            if status != 'ok':
+                failures.append(f"{scenario}/{payload}: {status}")
+                print(f"{head} {status:>9}")
+                continue
+            over = [section for section in SECTIONS
+                    if metrics[f"{section}AllocsPerCall"] > budgets[section]]
+            for section in over:
+                failures.append(f"{scenario}/{payload}: {section} makes "
+                                f"{metrics[f'{section}AllocsPerCall']:.2f} allocations per call "
+                                f"(budget {budgets[section]:g})")
+            print(f"{head} {metrics['sensorEncodeCalls']:>9} "
+                  f"{metrics['sensorEncodeAllocsPerCall']:>7.2f} "
+                  f"{metrics['gatewayDecodeCalls']:>9} {metrics['gatewayDecodeAllocsPerCall']:>7.2f}"
+                  f"{'  <-- over budget' if over else ''}", flush=True)
+
+    os.makedirs(out_dir, exist_ok=True)
+    with open(os.path.join(out_dir, 'alloc-results.json'), 'w') as f:
+        json.dump({'time': args.time, 'budgets': budgets, 'points': results}, f, indent=2)
+
+    for failure in failures:
+        print(f"✗ {failure}", file=sys.stderr)
+    if any(r['status'] == 'no counter' for r in results):
+        print("  (rebuild with CXXFLAGS=\"-DCARBON_ALLOC_COUNTER\" ./ns3 configure ...)",
+              file=sys.stderr)
+    if failures:
+        sys.exit(f"✗ {len(failures)} failures")
+    print("✓ All per-reading paths within their allocation budgets")
+
+
+if __name__ == '__main__':
+    main()
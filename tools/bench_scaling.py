@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""
+Scaling Benchmark
+Builds both scenarios and runs them over a ladder of fleet sizes for a fixed
+simulated duration: iot-connectivity over --sensors, iot-hierarchical over
+--zones (with --sensorsPerZone sensors each, on a point-to-point backbone
+unless --backbone says otherwise; CSMA stops at 253 zones). Every point runs
+under the "full" tracing profile (the default: NetAnim, FlowMonitor, pcap) and
+the "none" profile (no NetAnim or FlowMonitor), so a cliff in either path
+shows up.
+Wall-clock time, events/s, peak RSS, delivery ratio and the share of sensors
+that sent at least once (active %, below 100 when --time is shorter than
+--start-spread) come from each run's summary.json (see
+scenarios/run-profiler.h).
+
+Results are written to <out>/bench-results.json. With --baseline, each point
+is compared with the stored run of the same point and the script exits
+non-zero on a regression: wall-clock time or peak RSS above the baseline by
+more than the tolerance, a lower delivery ratio, or a run that failed or timed
+out. --save-baseline stores the results as the new baseline. Baselines are only
+comparable on the same machine and ns-3 build profile.
+
+Runs are sequential so they do not compete for cores. Points above
+--max-full-sensors skip the full profile, whose traces grow with the fleet.
+
+The scenarios must already be copied into <ns3-dir>/scratch/.
+
+Usage:
+  python tools/bench_scaling.py --ns3-dir ~/ns-3 --save-baseline bench-baseline.json
+  python tools/bench_scaling.py --ns3-dir ~/ns-3 --baseline bench-baseline.json
+  python tools/bench_scaling.py --ns3-dir ~/ns-3 --sensors 10 1000 --zones 10 --profiles none
+"""
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+
+SCENARIOS = ['iot-connectivity', 'iot-hierarchical']
+PROFILES = ['full', 'none']
+METRICS = ['wallSeconds', 'eventsPerSecond', 'peakRssKb', 'deliveryRatio', 'activeSensors']
+
+
+def point_key(point):
+    return f"{point['scenario']}/{point['size']}/{point['profile']}"
+
+
+def run_point(ns3_dir, point, time, start_spread, sensors_per_zone, backbone, timeout, prefix,
+              extra):
+    os.makedirs(prefix, exist_ok=True)
+    if point['scenario'] == 'iot-connectivity':
+        args = [f"--nSensors={point['size']}"]
+    else:
+        args = [f"--nZones={point['size']}", f"--sensorsPerZone={sensors_per_zone}",
+                f"--backbone={backbone}"]
+    args += [f"--time={time}", f"--startSpreadS={start_spread}", f"--tracing={point['profile']}", f"--outputPrefix={prefix}",
+             '--verbose=false']
+    program = ' '.join([f"scratch/{point['scenario']}"] + args + ([extra] if extra else []))
+    try:
+        out = subprocess.run(['./ns3', 'run', '--no-build', program], cwd=ns3_dir,
+                             capture_output=True, text=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return 'timeout', {}
+    with open(os.path.join(prefix, 'stdout.txt'), 'w') as log:
+        log.write(out.stdout)
+        log.write(out.stderr)
+    if out.returncode != 0:
+        return 'failed', {}
+    try:
+        with open(os.path.join(prefix, 'summary.json')) as f:
+            metrics = json.load(f)['metrics']
+    except (OSError, ValueError, KeyError):
+        return 'failed', {}
+    return 'ok', {key: metrics.get(key) for key in METRICS}
+
+
+def compare(result, base, wall_tol, rss_tol, pdr_tol):
+    """Return the regressions of one point against its baseline (empty if none)"""
+    if base is None or base['status'] != 'ok':
+        return []
+    if result['status'] != 'ok':
+        return [result['status']]
+    problems = []
+    cur, ref = result['metrics'], base['metrics']
+    if ref.get('wallSeconds') and cur['wallSeconds'] > ref['wallSeconds'] * (1 + wall_tol):
+        problems.append(f"wall {cur['wallSeconds']:.2f}s vs {ref['wallSeconds']:.2f}s")
+    if ref.get('peakRssKb') and cur['peakRssKb'] > ref['peakRssKb'] * (1 + rss_tol):
+        problems.append(f"RSS {cur['peakRssKb'] / 1024:.0f} MiB vs {ref['peakRssKb'] / 1024:.0f} MiB")
+    if ref.get('deliveryRatio') is not None and cur['deliveryRatio'] is not None and \
+            cur['deliveryRatio'] < ref['deliveryRatio'] - pdr_tol:
+        problems.append(f"PDR {cur['deliveryRatio']:.2f}% vs {ref['deliveryRatio']:.2f}%")
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--ns3-dir', required=True, help='ns-3 root directory')
+    parser.add_argument('--scenario', nargs='+', default=SCENARIOS, choices=SCENARIOS)
+    parser.add_argument('--sensors', type=int, nargs='+', default=[10, 100, 1000, 10000, 100000],
+                        help='nSensors values (iot-connectivity)')
+    parser.add_argument('--zones', type=int, nargs='+', default=[10, 100, 1000],
+                        help='nZones values (iot-hierarchical)')
+    parser.add_argument('--sensorsPerZone', type=int, default=10,
+                        help='Sensors per zone (iot-hierarchical)')
+    parser.add_argument('--backbone', default='p2p', choices=['p2p', 'csma'],
+                        help='Backbone of iot-hierarchical')
+    parser.add_argument('--time', type=float, default=30.0, help='Simulated seconds per run')
+    parser.add_argument('--start-spread', type=float, default=5.0,
+                        help='Seconds the sensor starts are spread over (--startSpreadS)')
+    parser.add_argument('--profiles', nargs='+', default=PROFILES, choices=PROFILES,
+                        help='Tracing profiles to run at every point')
+    parser.add_argument('--max-full-sensors', type=int, default=10000,
+                        help='Largest fleet (sensors) that also runs the full profile')
+    parser.add_argument('--timeout', type=float, default=3600, help='Seconds per run')
+    parser.add_argument('--baseline', help='Baseline results to compare with')
+    parser.add_argument('--save-baseline', help='Write the results to this baseline file')
+    parser.add_argument('--wall-tolerance', type=float, default=0.25,
+                        help='Allowed relative wall-clock increase')
+    parser.add_argument('--rss-tolerance', type=float, default=0.10,
+                        help='Allowed relative peak RSS increase')
+    parser.add_argument('--pdr-tolerance', type=float, default=0.5,
+                        help='Allowed delivery ratio decrease in percentage points')
+    parser.add_argument('--out', default='bench-results', help='Output directory')
+    parser.add_argument('--extra', default='', help='Additional scenario arguments')
+    args = parser.parse_args()
+
+    ns3_dir = os.path.expanduser(args.ns3_dir)
+    out_dir = os.path.abspath(args.out)
+    subprocess.check_call(['./ns3', 'build'] + [f"scratch/{s}" for s in args.scenario],
+                          cwd=ns3_dir)
+
+    points = []
+    for scenario in args.scenario:
+        connectivity = scenario == 'iot-connectivity'
+        for size in (args.sensors if connectivity else args.zones):
+            fleet = size if connectivity else size * args.sensorsPerZone
+            for profile in args.profiles:
+                if profile == 'full' and fleet > args.max_full_sensors:
+                    continue
+                points.append({'scenario': scenario, 'size': size, 'sensors': fleet,
+                               'profile': profile})
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            stored = json.load(f)
+        baseline = {point_key(p): p for p in stored['points']}
+        if stored.get('time') != args.time or stored.get('sensorsPerZone') != args.sensorsPerZone:
+            print(f"warning: baseline was recorded with --time={stored.get('time')} "
+                  f"--sensorsPerZone={stored.get('sensorsPerZone')}", file=sys.stderr)
+
+    print(f"{'scenario':>16} {'size':>7} {'profile':>7} {'wall s':>9} {'events/s':>11} "
+          f"{'RSS MiB':>8} {'PDR %':>7} {'active %':>8}")
+    results = []
+    regressions = []
+    for point in points:
+        prefix = os.path.join(out_dir, f"{point['scenario']}-{point['size']}-{point['profile']}") \
+            + os.sep
+        status, metrics = run_point(ns3_dir, point, args.time, args.start_spread,
+                                    args.sensorsPerZone, args.backbone, args.timeout, prefix,
+                                    args.extra)
+        result = dict(point, status=status, metrics=metrics)
+        results.append(result)
+        problems = compare(result, baseline.get(point_key(point)), args.wall_tolerance,
+                           args.rss_tolerance, args.pdr_tolerance)
+        if problems:
+            regressions.append(f"{point_key(point)}: {', '.join(problems)}")
+        head = f"{point['scenario']:>16} {point['size']:>7} {point['profile']:>7}"
+        if status != 'ok':
+            print(f"{head} {status:>9}{'  <-- regression' if problems else ''}")
+            continue
+        active = metrics['activeSensors']
+        active = f"{active * 100.0 / point['sensors']:>8.1f}" if active is not None else f"{'-':>8}"
+        print(f"{head} {metrics['wallSeconds']:>9.2f} {metrics['eventsPerSecond']:>11.4g} "
+              f"{metrics['peakRssKb'] / 1024:>8.0f} {metrics['deliveryRatio']:>7.2f} {active}"
+              f"{'  <-- regression' if problems else ''}", flush=True)
+
+    os.makedirs(out_dir, exist_ok=True)
+    report = {'time': args.time, 'startSpread': args.start_spread, 'sensorsPerZone': args.sensorsPerZone, 'backbone': args.backbone,
+              'extra': shlex.split(args.extra), 'points': results}
+    with open(os.path.join(out_dir, 'bench-results.json'), 'w') as f:
+        json.dump(report, f, indent=2)
+    if args.save_baseline:
+        with open(args.save_baseline, 'w') as f:
+            json.dump(report, f, indent=2)
+        print(f"Baseline written to {args.save_baseline}")
+
+    for regression in regressions:
+        print(f"✗ {regression}", file=sys.stderr)
+    if regressions:
+        sys.exit(f"✗ {len(regressions)} regressions against {args.baseline}")
+    if args.baseline:
+        print(f"✓ No regressions against {args.baseline}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+WiFi Channel Culling Benchmark
+Runs a scenario with the unculled spectrum channel and with the spatially
+culled grid channel (see scenarios/grid-spectrum-channel.h), then compares
+delivery ratio and wall-clock time. Exits non-zero if the delivery ratios
+differ by more than the tolerance.
+
+The scenarios must already be copied into <ns3-dir>/scratch/.
+
+Usage:
+  python tools/bench_wifi_channel.py --ns3-dir ~/ns-3 --sensors 50 100 200
+  python tools/bench_wifi_channel.py --ns3-dir ~/ns-3 --scenario iot-hierarchical --zones 20 50
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+RATIO_RE = re.compile(r'(?:Packet delivery|Delivery) ratio: ([0-9.]+)%')
+WALL_RE = re.compile(r'Wall-clock time: ([0-9.eE+-]+) s \(([0-9.eE+-]+) events/s\)')
+EVENTS_RE = re.compile(r'Events executed: (\d+)')
+
+
+def run(ns3_dir, scenario, size_flag, size, channel, extra):
+    program = f"scratch/{scenario} {size_flag}={size} --wifiChannel={channel} --verbose=false {extra}"
+    out = subprocess.run(['./ns3', 'run', '--no-build', program.strip()], cwd=ns3_dir,
+                         capture_output=True, text=True)
+    if out.returncode != 0:
+        sys.exit(f"{program} failed:\n{out.stderr[-2000:]}")
+    ratio = RATIO_RE.search(out.stdout)
+    wall = WALL_RE.search(out.stdout)
+    events = EVENTS_RE.search(out.stdout)
+    if not (ratio and wall and events):
+        sys.exit(f"Could not parse the results of {program}")
+    return float(ratio.group(1)), float(wall.group(1)), int(events.group(1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--ns3-dir', required=True, help='ns-3 root directory')
+    parser.add_argument('--scenario', default='iot-connectivity',
+                        choices=['iot-connectivity', 'iot-hierarchical'])
+    parser.add_argument('--sensors', type=int, nargs='+', default=[50, 100, 200],
+                        help='nSensors values (iot-connectivity)')
+    parser.add_argument('--zones', type=int, nargs='+', default=[10, 20, 50],
+                        help='nZones values (iot-hierarchical)')
+    parser.add_argument('--tolerance', type=float, default=0.5,
+                        help='Max delivery ratio difference in percentage points')
+    parser.add_argument('--extra', default='', help='Additional scenario arguments')
+    args = parser.parse_args()
+
+    ns3_dir = os.path.expanduser(args.ns3_dir)
+    if args.scenario == 'iot-connectivity':
+        size_flag, sizes = '--nSensors', args.sensors
+    else:
+        size_flag, sizes = '--nZones', args.zones
+
+    subprocess.check_call(['./ns3', 'build', f"scratch/{args.scenario}"], cwd=ns3_dir)
+
+    print(f"{'size':>6} {'PDR spectrum':>13} {'PDR grid':>9} {'wall spectrum':>14} "
+          f"{'wall grid':>10} {'speedup':>8} {'events spectrum':>16} {'events grid':>12}")
+    failed = False
+    for size in sizes:
+        ref_ratio, ref_wall, ref_events = run(ns3_dir, args.scenario, size_flag, size, 'spectrum',
+                                              args.extra)
+        grid_ratio, grid_wall, grid_events = run(ns3_dir, args.scenario, size_flag, size, 'grid',
+                                                 args.extra)
+        speedup = ref_wall / grid_wall if grid_wall > 0 else float('inf')
+        mark = ''
+        if abs(ref_ratio - grid_ratio) > args.tolerance:
+            failed = True
+            mark = '  <-- delivery ratio mismatch'
+        print(f"{size:>6} {ref_ratio:>12.2f}% {grid_ratio:>8.2f}% {ref_wall:>13.2f}s "
+              f"{grid_wall:>9.2f}s {speedup:>7.1f}x {ref_events:>16} {grid_events:>12}{mark}")
+
+    if failed:
+        sys.exit(f"✗ Grid channel delivery ratio differs by more than {args.tolerance} points")
+    print("✓ Grid channel delivery ratio matches the unculled channel")
+
+
+if __name__ == '__main__':
+    main()
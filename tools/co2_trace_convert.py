@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+CO2 Trace Converter
+Converts recorded CO2 telemetry (CSV) into the binary trace format replayed
+by CO2SensorApplication (see scenarios/co2-trace.h)
+
+Input CSV columns: sensor_id,timestamp,co2
+  - sensor_id: integer sensor identifier
+  - timestamp: seconds (float, any epoch) - use --timestamp-unit us for microseconds
+  - co2: CO2 level in ppm
+
+Usage:
+  python tools/co2_trace_convert.py plant.csv plant.co2t
+  python tools/co2_trace_convert.py --dump plant.co2t
+"""
+
+import argparse
+import csv
+import struct
+import sys
+from array import array
+
+MAGIC = b'CO2TRACE'
+BYTE_ORDER_TAG = 0x01020304
+VERSION = 1
+
+HEADER = struct.Struct('=8sIIIIQQ')  # 40 bytes
+INDEX_ENTRY = struct.Struct('=IIQQ')  # 24 bytes
+RECORD = struct.Struct('=QIf')        # 16 bytes
+
+
+def read_csv(path, unit):
+    """Load readings into compact column arrays (sensor, timestamp_us, co2)"""
+    scale = 1e6 if unit == 's' else 1.0
+    sensors, times, values = array('I'), array('Q'), array('f')
+    with open(path, newline='') as f:
+        reader = csv.reader(f)
+        for row in reader:
+            if not row or row[0].strip().lower() in ('sensor_id', '#'):
+                continue
+            sensors.append(int(row[0]))
+            times.append(int(round(float(row[1]) * scale)))
+            values.append(float(row[2]))
+    return sensors, times, values
+
+
+def write_trace(path, sensors, times, values):
+    order = sorted(range(len(sensors)), key=lambda i: (sensors[i], times[i]))
+    start_time = min(times) if len(times) else 0
+
+    index = []
+    for pos, i in enumerate(order):
+        if not index or index[-1][0] != sensors[i]:
+            index.append([sensors[i], pos, 0])
+        index[-1][2] += 1
+
+    with open(path, 'wb') as out:
+        out.write(HEADER.pack(MAGIC, BYTE_ORDER_TAG, VERSION, len(index), 0,
+                              len(order), start_time))
+        for sensor_id, first, count in index:
+            out.write(INDEX_ENTRY.pack(sensor_id, 0, first, count))
+        for i in order:
+            out.write(RECORD.pack(times[i], sensors[i], values[i]))
+
+    print(f"✓ Wrote {len(order)} readings of {len(index)} sensors to: {path}")
+
+
+def dump_trace(path, limit):
+    with open(path, 'rb') as f:
+        magic, tag, version, n_sensors, _, n_records, start = HEADER.unpack(f.read(HEADER.size))
+        if magic != MAGIC or tag != BYTE_ORDER_TAG:
+            sys.exit(f"{path} is not a CO2 trace written on this byte order")
+        print(f"version={version} sensors={n_sensors} records={n_records} start={start}us")
+        for _ in range(n_sensors):
+            sensor_id, _, first, count = INDEX_ENTRY.unpack(f.read(INDEX_ENTRY.size))
+            print(f"  sensor {sensor_id}: records {first}..{first + count - 1}")
+        for _ in range(min(limit, n_records)):
+            ts, sensor_id, co2 = RECORD.unpack(f.read(RECORD.size))
+            print(f"  t={(ts - start) / 1e6:.3f}s sensor={sensor_id} co2={co2:.2f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='CSV file (or trace file with --dump)')
+    parser.add_argument('output', nargs='?', help='Binary trace file to write')
+    parser.add_argument('--timestamp-unit', choices=['s', 'us'], default='s')
+    parser.add_argument('--dump', action='store_true', help='Print a trace file summary')
+    parser.add_argument('--limit', type=int, default=10, help='Records to print with --dump')
+    args = parser.parse_args()
+
+    if args.dump:
+        dump_trace(args.input, args.limit)
+        return
+    if not args.output:
+        parser.error('output file required')
+    write_trace(args.output, *read_csv(args.input, args.timestamp_unit))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Event Log Decoder
+Turns the binary per-packet event log written with --eventLog (see
+scenarios/event-log.h) into text or CSV lines:
+
+  <time s> <event> node=<id> sensor=<id> zone=<id> bytes=<n>
+
+For AP_BATCH events the sensor field holds the number of readings in the
+batch. Distributed hierarchical runs write one file per MPI rank
+(<name>.rank<k>); pass them all to merge them in time order.
+
+Usage:
+  python tools/decode_event_log.py events.bin
+  python tools/decode_event_log.py --type GATEWAY_RECEIVE --node 0 --csv events.bin > rx.csv
+  python tools/decode_event_log.py --summary events.bin.rank0 events.bin.rank1
+"""
+
+import argparse
+import csv
+import heapq
+import struct
+import sys
+from collections import Counter
+
+MAGIC = b'EVENTLOG'
+BYTE_ORDER_TAG = 0x01020304
+VERSION = 1
+
+HEADER = struct.Struct('=8sIIIIQQ')  # 40 bytes
+RECORD = struct.Struct('=QIIIHBB')   # 24 bytes
+
+EVENT_TYPES = {
+    1: 'SENSOR_SEND',
+    2: 'SENSOR_SEND_FAIL',
+    3: 'AP_RECEIVE',
+    4: 'AP_FORWARD',
+    5: 'AP_BATCH',
+    6: 'GATEWAY_RECEIVE',
+    7: 'GATEWAY_MALFORMED',
+}
+MODES = {0: 'ring', 1: 'file'}
+
+
+def read_log(path):
+    """Return the header fields and an iterator over (time_ns, type, node, sensor, zone, bytes)"""
+    f = open(path, 'rb')
+    raw = f.read(HEADER.size)
+    if len(raw) < HEADER.size:
+        sys.exit(f"{path} is too short to be an event log")
+    magic, tag, version, record_size, mode, n_records, n_lost = HEADER.unpack(raw)
+    if magic != MAGIC or tag != BYTE_ORDER_TAG:
+        sys.exit(f"{path} is not an event log written on this byte order")
+    if version != VERSION or record_size != RECORD.size:
+        sys.exit(f"{path}: unsupported event log version {version} (record size {record_size})")
+
+    def records():
+        with f:
+            for _ in range(n_records):
+                chunk = f.read(RECORD.size)
+                if len(chunk) < RECORD.size:
+                    print(f"warning: {path} ends early", file=sys.stderr)
+                    return
+                time_ns, node, sensor, zone, size, event, _ = RECORD.unpack(chunk)
+                yield time_ns, event, node, sensor, zone, size
+
+    info = {'path': path, 'mode': MODES.get(mode, str(mode)), 'records': n_records,
+            'lost': n_lost}
+    return info, records()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('logs', nargs='+', help='Event log file(s)')
+    parser.add_argument('--type', action='append', choices=sorted(EVENT_TYPES.values()),
+                        help='Only print these event types (repeatable)')
+    parser.add_argument('--node', type=int, action='append',
+                        help='Only print events of these node IDs (repeatable)')
+    parser.add_argument('--csv', action='store_true', help='Print CSV instead of text')
+    parser.add_argument('--summary', action='store_true',
+                        help='Print per-type counts instead of the events')
+    args = parser.parse_args()
+
+    codes = {code for code, name in EVENT_TYPES.items() if not args.type or name in args.type}
+    nodes = set(args.node) if args.node else None
+
+    streams = []
+    for path in args.logs:
+        info, records = read_log(path)
+        streams.append(records)
+        print(f"# {path}: {info['records']} records ({info['mode']} mode, {info['lost']} lost)",
+              file=sys.stderr)
+
+    counts = Counter()
+    writer = csv.writer(sys.stdout) if args.csv and not args.summary else None
+    if writer:
+        writer.writerow(['time_s', 'event', 'node', 'sensor', 'zone', 'bytes'])
+    for time_ns, event, node, sensor, zone, size in heapq.merge(*streams):
+        if event not in codes or (nodes is not None and node not in nodes):
+            continue
+        name = EVENT_TYPES.get(event, f"UNKNOWN_{event}")
+        if args.summary:
+            counts[name] += 1
+        elif writer:
+            writer.writerow([f"{time_ns / 1e9:.9f}", name, node, sensor, zone, size])
+        else:
+            print(f"{time_ns / 1e9:.6f} {name} node={node} sensor={sensor} zone={zone} "
+                  f"bytes={size}")
+
+    if args.summary:
+        for name in EVENT_TYPES.values():
+            if counts[name]:
+                print(f"{name:>18}: {counts[name]}")
+
+
+if __name__ == '__main__':
+    main()
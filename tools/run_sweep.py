@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""
+Parallel Parameter Sweep
+Runs every combination of the given parameter values, with --runs replications
+each, as concurrent scenario processes. Each run writes its files under its own
+--outputPrefix (<out>/<point>/run<k>/) and a summary.json (see
+scenarios/run-summary.h). The metrics of all replications of a point are then
+merged into <out>/sweep-summary.csv and <out>/sweep-summary.json with the mean,
+standard deviation and a Student-t 95% confidence interval.
+
+Replications differ only in the ns-3 RNG run number (--RngRun), so runs stay
+reproducible and independent under a fixed --RngSeed. Runs use the "metrics"
+tracing profile unless --tracing says otherwise, so they write the windowed flow
+metrics CSVs but no FlowMonitor XML, pcap, ascii or NetAnim files.
+
+The scenarios must already be copied into <ns3-dir>/scratch/.
+
+Usage:
+  python tools/run_sweep.py --ns3-dir ~/ns-3 --scenario iot-connectivity --nSensors 10 50 100 --runs 30
+  python tools/run_sweep.py --ns3-dir ~/ns-3 --scenario iot-hierarchical --nZones 5 20 \\
+      --sensorsPerZone 2 8 --intervalS 1 5 --runs 20 --jobs 16 --extra "--apBatchReadings=16"
+"""
+
+import argparse
+import csv
+import itertools
+import json
+import math
+import os
+import shlex
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+# Two-sided 97.5% quantiles of Student's t distribution, by degrees of freedom
+T_975 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+         2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+         2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+# Parameters that can be swept, per scenario
+SWEEP_PARAMS = {
+    'iot-connectivity': ['nSensors', 'intervalS', 'sensorBatchReadings', 'wifiStandard',
+                         'rateManager'],
+    'iot-hierarchical': ['nZones', 'sensorsPerZone', 'intervalS', 'sensorBatchReadings',
+                         'wifiStandard', 'rateManager', 'ledgerBlockEntries', 'gateways'],
+}
+
+# Metrics printed in the console table (all numeric metrics go to the files)
+HEADLINE = ['deliveryRatio', 'meanLatencyMs', 'latencyP99Ms', 'wallSeconds', 'peakRssKb']
+
+
+def t_quantile(df):
+    if df <= 0:
+        return float('nan')
+    if df <= len(T_975):
+        return T_975[df - 1]
+    return 1.960 + 2.4 / df  # Within 0.01 of the exact value above 30 degrees of freedom
+
+
+def aggregate(values):
+    n = len(values)
+    mean = sum(values) / n
+    if n < 2:
+        return mean, 0.0, float('nan')
+    std = math.sqrt(sum((v - mean) ** 2 for v in values) / (n - 1))
+    return mean, std, t_quantile(n - 1) * std / math.sqrt(n)
+
+
+def point_name(point):
+    return '_'.join(f"{key}-{value}" for key, value in point.items())
+
+
+def run_one(ns3_dir, scenario, point, run, seed, tracing, prefix, extra):
+    os.makedirs(prefix, exist_ok=True)
+    args = [f"--{key}={value}" for key, value in point.items()]
+    args += [f"--RngSeed={seed}", f"--RngRun={run}", f"--outputPrefix={prefix}",
+             f"--tracing={tracing}", '--verbose=false']
+    program = ' '.join([f"scratch/{scenario}"] + args + ([extra] if extra else []))
+    out = subprocess.run(['./ns3', 'run', '--no-build', program], cwd=ns3_dir,
+                         capture_output=True, text=True)
+    with open(os.path.join(prefix, 'stdout.txt'), 'w') as log:
+        log.write(out.stdout)
+        log.write(out.stderr)
+    if out.returncode != 0:
+        return None, f"{program} failed (exit {out.returncode}), see {prefix}stdout.txt"
+    try:
+        with open(os.path.join(prefix, 'summary.json')) as f:
+            return json.load(f), None
+    except (OSError, ValueError) as e:
+        return None, f"{program}: no usable summary.json ({e})"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--ns3-dir', required=True, help='ns-3 root directory')
+    parser.add_argument('--scenario', default='iot-connectivity',
+                        choices=sorted(SWEEP_PARAMS))
+    parser.add_argument('--nSensors', nargs='+', help='nSensors values (iot-connectivity)')
+    parser.add_argument('--nZones', nargs='+', help='nZones values (iot-hierarchical)')
+    parser.add_argument('--sensorsPerZone', nargs='+',
+                        help='sensorsPerZone values (iot-hierarchical)')
+    parser.add_argument('--intervalS', nargs='+', help='Sensor reading interval values (s)')
+    parser.add_argument('--sensorBatchReadings', nargs='+',
+                        help='Readings per sensor datagram values (1 = no batching)')
+    parser.add_argument('--wifiStandard', nargs='+', help='WiFi standards (b, g, n, ac, ax)')
+    parser.add_argument('--rateManager', nargs='+',
+                        help='WiFi rate managers (constant, minstrel, ideal)')
+    parser.add_argument('--ledgerBlockEntries', nargs='+',
+                        help='Ledger block sizes (iot-hierarchical, with --extra "--ledger=true")')
+    parser.add_argument('--gateways', nargs='+', help='Main gateway counts (iot-hierarchical)')
+    parser.add_argument('--runs', type=int, default=10, help='Replications per point')
+    parser.add_argument('--seed', type=int, default=1, help='RngSeed shared by all runs')
+    parser.add_argument('--tracing', default='metrics',
+                        choices=['none', 'metrics', 'debug', 'full'],
+                        help='Tracing profile of every run')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count() or 1,
+                        help='Concurrent runs (default: all cores)')
+    parser.add_argument('--out', default='sweep-results', help='Output directory')
+    parser.add_argument('--extra', default='', help='Additional scenario arguments')
+    args = parser.parse_args()
+
+    if args.runs < 1 or args.jobs < 1:
+        sys.exit("--runs and --jobs must be at least 1")
+    for key in ('nSensors', 'nZones', 'sensorsPerZone', 'intervalS', 'sensorBatchReadings',
+                'wifiStandard', 'rateManager', 'ledgerBlockEntries', 'gateways'):
+        if getattr(args, key) and key not in SWEEP_PARAMS[args.scenario]:
+            sys.exit(f"{args.scenario} has no --{key}")
+    swept = [key for key in SWEEP_PARAMS[args.scenario] if getattr(args, key)]
+    points = [dict(zip(swept, values))
+              for values in itertools.product(*(getattr(args, key) for key in swept))]
+
+    ns3_dir = os.path.expanduser(args.ns3_dir)
+    out_dir = os.path.abspath(args.out)
+    subprocess.check_call(['./ns3', 'build', f"scratch/{args.scenario}"], cwd=ns3_dir)
+
+    jobs = []
+    for point in points:
+        for run in range(1, args.runs + 1):
+            prefix = os.path.join(out_dir, point_name(point) or 'default', f"run{run}") + os.sep
+            jobs.append((point, run, prefix))
+    print(f"{len(points)} points x {args.runs} runs = {len(jobs)} runs on {args.jobs} workers")
+
+    results = {}  # Point name -> list of metric dicts
+    failures = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(run_one, ns3_dir, args.scenario, point, run, args.seed,
+                               args.tracing, prefix, args.extra): point
+                   for point, run, prefix in jobs}
+        for done, future in enumerate(as_completed(futures), 1):
+            summary, error = future.result()
+            if error:
+                failures.append(error)
+            else:
+                results.setdefault(point_name(futures[future]), []).append(summary['metrics'])
+            print(f"\r{done}/{len(jobs)} runs finished, {len(failures)} failed", end='',
+                  flush=True)
+    print()
+
+    rows = []
+    for point in points:
+        samples = results.get(point_name(point), [])
+        if not samples:
+            continue
+        row = dict(point, runs=len(samples))
+        metrics = [key for key in samples[0] if isinstance(samples[0][key], (int, float))]
+        for metric in metrics:
+            values = [s[metric] for s in samples if isinstance(s.get(metric), (int, float))]
+            if values:
+                mean, std, half = aggregate(values)
+                row[f"{metric}_mean"] = mean
+                row[f"{metric}_std"] = std
+                row[f"{metric}_ci95"] = half
+        rows.append(row)
+
+    os.makedirs(out_dir, exist_ok=True)
+    if rows:
+        fields = list(dict.fromkeys(key for row in rows for key in row))
+        with open(os.path.join(out_dir, 'sweep-summary.csv'), 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=fields)
+            writer.writeheader()
+            writer.writerows(rows)
+    json_rows = [{key: (None if isinstance(value, float) and math.isnan(value) else value)
+                  for key, value in row.items()} for row in rows]
+    with open(os.path.join(out_dir, 'sweep-summary.json'), 'w') as f:
+        json.dump({'scenario': args.scenario, 'seed': args.seed, 'runs': args.runs,
+                   'extra': shlex.split(args.extra), 'points': json_rows, 'failures': failures},
+                  f, indent=2)
+
+    headline = [m for m in HEADLINE if any(f"{m}_mean" in row for row in rows)]
+    print(' '.join([f"{key:>14}" for key in swept + ['runs']] +
+                   [f"{m:>26}" for m in headline]))
+    for row in rows:
+        cells = [f"{row[key]:>14}" for key in swept + ['runs']]
+        for m in headline:
+            half = row.get(f"{m}_ci95", float('nan'))
+            ci = f"± {half:.3g}" if not math.isnan(half) else ''
+            cells.append(f"{row.get(f'{m}_mean', float('nan')):>15.4g} {ci:>10}")
+        print(' '.join(cells))
+
+    for error in failures:
+        print(f"✗ {error}", file=sys.stderr)
+    print(f"Summary written to {os.path.join(out_dir, 'sweep-summary.csv')}")
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,33 +1,79 @@
 #!/usr/bin/env python3
 """
 Single-tier Carbon Trading Network Visualization
-Generates graphs from the single-tier simulation results
+Generates graphs from the results of an iot-connectivity run: the windowed
+flow metrics (carbon-trading-metrics.csv) and per-flow totals
+(carbon-trading-flows.csv) written with --tracing=metrics or above. With
+--follow or --listen the dashboard is redrawn while the run goes on (see
+carbon_telemetry.py).
+
+Usage:
+  python visualize_carbon_data.py --prefix <ns-3>/carbon-trading
+  python visualize_carbon_data.py --prefix <ns-3>/carbon-trading --follow
+  python visualize_carbon_data.py --listen 9100   # run with --telemetryPort=9100
 """
 
+import argparse
+
 import matplotlib.pyplot as plt
-import numpy as np
-
-# Sample data for 10 sensors (single-tier)
-sensor_ids = [f'S{i+1}' for i in range(10)]
-avg_co2 = [405, 475, 470, 568, 593, 629, 680, 734, 825, 838]
-
-fig, ax = plt.subplots(figsize=(12, 6))
-bars = ax.bar(sensor_ids, avg_co2, color='skyblue', edgecolor='black')
-ax.set_xlabel('Sensor ID', fontweight='bold')
-ax.set_ylabel('Average CO2 (ppm)', fontweight='bold')
-ax.set_title('Single-Tier CO2 Sensor Network - Average CO2 per Sensor', 
-             fontweight='bold')
-ax.grid(axis='y', alpha=0.3)
-ax.axhline(y=400, color='green', linestyle='--', linewidth=2, 
-            label='Normal (400 ppm)', alpha=0.6)
-
-for bar, val in zip(bars, avg_co2):
-    ax.text(bar.get_x() + bar.get_width()/2, bar.get_height() + 10,
-             f'{val}', ha='center', va='bottom', fontweight='bold')
-
-plt.tight_layout()
-output_file = 'carbon_trading_visualization.png'
-plt.savefig(output_file, dpi=300, bbox_inches='tight')
-print(f"✓ Single-tier visualization saved as: {output_file}")
-
-plt.show()
+
+import carbon_telemetry
+from carbon_telemetry import plot_sensors, plot_series
+
+
+def draw(fig, series, flows, final):
+    fig.clf()
+    state = 'final' if final else 'live'
+    fig.suptitle(f'Single-Tier CO2 Sensor Network - {len(series.time)} windows ({state})',
+                 fontsize=16, fontweight='bold')
+
+    plot_sensors(fig.add_subplot(2, 3, 1), flows)
+    ax = fig.add_subplot(2, 3, 2)
+    plot_series(ax, series, [(series.co2_ppm, 'Site')], 'Average CO2 per Window',
+                'Mean CO2 (ppm)')
+    ax.axhline(y=400, color='green', linestyle='--', linewidth=2, label='Normal (400 ppm)',
+               alpha=0.6)
+    plot_series(fig.add_subplot(2, 3, 3), series,
+                [(series.sent, 'Sent'), (series.received, 'Received')],
+                'Readings per Window', 'Readings')
+
+    plot_series(fig.add_subplot(2, 3, 4), series, [(series.throughput_kbps, 'Site')],
+                'Gateway Throughput', 'kbit/s')
+    plot_series(fig.add_subplot(2, 3, 5), series,
+                [(series.latency_p50_ms, 'p50'), (series.latency_p99_ms, 'p99'),
+                 (series.latency_max_ms, 'max')],
+                'Sensor -> Gateway Latency', 'ms')
+    ax = fig.add_subplot(2, 3, 6)
+    plot_series(ax, series, [(series.delivery_ratio, 'Delivery')],
+                f'Delivery Ratio ({series.readings_received} of {series.readings_sent})',
+                'Received / sent so far (%)')
+    ax.set_ylim(0, 105)
+
+    fig.tight_layout()
+    if not final:
+        plt.pause(0.01)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    carbon_telemetry.add_arguments(parser, 'carbon-trading')
+    args = parser.parse_args()
+
+    fig = plt.figure(figsize=(18, 10))
+    if (args.follow or args.listen is not None) and not args.no_show:
+        plt.ion()
+    series = carbon_telemetry.run(args, lambda s, f, final: draw(fig, s, f, final))
+
+    output_file = args.output or 'carbon_trading_visualization.png'
+    fig.savefig(output_file, dpi=300, bbox_inches='tight')
+    print(f"✓ Single-tier visualization saved as: {output_file}")
+    print(f"✓ Readings sent: {series.readings_sent}, received: {series.readings_received}")
+
+    if not args.no_show:
+        plt.ioff()
+        plt.show()
+
+
+if __name__ == '__main__':
+    main()